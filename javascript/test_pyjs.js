@@ -148,3 +148,34 @@ function test_eval_to_json()
 }
 
 
+
+// ---------------------------------------------------------------------------
+// Callable handles
+
+// wraps a python callable: the expression is compiled once by `func`,
+// each `call` is a direct vectorcall with the arguments as atoms.
+// call release() when done (in v8, a FinalizationRegistry can do it).
+function PyFunc(expr)
+{
+	this.handle = pyjs.func(expr);
+}
+
+PyFunc.prototype.call = function()
+{
+	return pyjs.call([this.handle].concat(arrayfromargs(arguments)));
+}
+
+PyFunc.prototype.release = function()
+{
+	pyjs.release(this.handle);
+	this.handle = 0;
+}
+
+function test_func()
+{
+	pyjs.exec("import math");
+	var hypot = new PyFunc("math.hypot");
+	for (var i = 0; i < 5; i++)
+		outlet(0, hypot.call(i, 4.0));
+	hypot.release();
+}
@@ -0,0 +1,42 @@
+// rowgain.cpp
+//
+// min matrix operator which scales and offsets a matrix a row at a time,
+// as an example of calc_row() (see min-api/doc/GuideToThreading.md)
+
+#include "c74_min.h"
+
+#include "rowgain_kernel.h"
+
+using namespace c74::min;
+
+
+class rowgain : public object<rowgain>, public matrix_operator<> {
+public:
+    MIN_DESCRIPTION {"Scale and offset each plane of a matrix: out = in * gain + offset."};
+    MIN_TAGS        {"jitter, demo"};
+    MIN_AUTHOR      {"S. Alireza"};
+    MIN_RELATED     {"jit.op"};
+
+    inlet<>  input  { this, "(matrix) Input", "matrix" };
+    outlet<> output { this, "(matrix) Output", "matrix" };
+
+    attribute<number> gain { this, "gain", 1.0,
+        description {"Multiplier applied to every plane."}
+    };
+
+    attribute<number> offset { this, "offset", 0.0,
+        description {"Value added after the multiplication."}
+    };
+
+    // called once per row, concurrently from the jitter worker threads:
+    // only reads the attributes, so no locking is needed
+
+    template <class matrix_type>
+    void calc_row(const matrix_span<matrix_type>& input, matrix_span<matrix_type>& output, const matrix_info& info, long row)
+    {
+        rowgain::scale_row(input, output, gain, offset);
+    }
+};
+
+
+MIN_EXTERNAL(rowgain);
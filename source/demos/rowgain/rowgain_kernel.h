@@ -0,0 +1,63 @@
+// rowgain_kernel.h
+//
+// row kernel of the rowgain operator: out = in * gain + offset
+//
+// Only depends on c74_min_matrix_span.h, so it can be tested without Max
+// (see tests/test_rowgain.cpp).
+
+#pragma once
+
+#include "c74_min_matrix_span.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rowgain {
+
+using c74::min::matrix_span;
+
+template <class T>
+inline T scale(const T value, const double gain, const double offset)
+{
+    return static_cast<T>(value * gain + offset);
+}
+
+// char matrices are clamped to 0-255 and rounded
+
+template <>
+inline unsigned char scale(const unsigned char value, const double gain, const double offset)
+{
+    const double v = std::round(value * gain + offset);
+    return static_cast<unsigned char>(std::clamp(v, 0.0, 255.0));
+}
+
+template <class T>
+void scale_row(const matrix_span<T>& input, matrix_span<T>& output, const double gain, const double offset)
+{
+    if (input.data() == nullptr) {
+        return;
+    }
+
+    // packed rows of the same layout: one loop the compiler can vectorize
+    if (input.contiguous() && output.contiguous() && input.plane_count() == output.plane_count()) {
+        const T* src = input.data();
+        T*       dst = output.data();
+        const long n = output.width() * output.plane_count();
+
+        for (long i = 0; i < n; ++i) {
+            dst[i] = scale(src[i], gain, offset);
+        }
+        return;
+    }
+
+    // strided rows, or a single input cell (stride 0) repeated across the row
+    const long planes = std::min(input.plane_count(), output.plane_count());
+
+    for (long x = 0; x < output.width(); ++x) {
+        for (long k = 0; k < planes; ++k) {
+            output(x, k) = scale(input(x, k), gain, offset);
+        }
+    }
+}
+
+} // namespace rowgain
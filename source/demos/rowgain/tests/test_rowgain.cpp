@@ -0,0 +1,110 @@
+// test_rowgain.cpp
+//
+// tests the rowgain row kernel against matrix_span rows laid out as
+// matrix_operator passes them to calc_row(): packed, strided and a single
+// repeated input cell (stride 0).
+//
+// g++ -std=c++17 -I.. -I../../../min-api/include -o test_rowgain test_rowgain.cpp && ./test_rowgain
+
+#include "rowgain_kernel.h"
+
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+using c74::min::matrix_span;
+
+
+// 4 cells of 4 planes, packed
+static void test_contiguous()
+{
+    std::vector<float> in(16), out(16, -1.0f);
+    for (int i = 0; i < 16; i++) {
+        in[i] = (float)i;
+    }
+    const matrix_span<float> input(in.data(), 4, 4, 4);
+    matrix_span<float>       output(out.data(), 4, 4, 4);
+
+    assert(input.contiguous() && output.contiguous());
+    rowgain::scale_row(input, output, 2.0, 1.0);
+
+    for (int i = 0; i < 16; i++) {
+        assert(out[i] == 2.0f * i + 1.0f);
+    }
+}
+
+
+// 3 cells of 2 planes, each cell padded to 3 values: padding is untouched
+static void test_strided()
+{
+    std::vector<double> in = { 1, 2, 99, 3, 4, 99, 5, 6, 99 };
+    std::vector<double> out(9, -1.0);
+    const matrix_span<double> input(in.data(), 3, 2, 3);
+    matrix_span<double>       output(out.data(), 3, 2, 3);
+
+    assert(!input.contiguous());
+    rowgain::scale_row(input, output, 10.0, 0.0);
+
+    const std::vector<double> expected = { 10, 20, -1, 30, 40, -1, 50, 60, -1 };
+    assert(out == expected);
+}
+
+
+// one input cell repeated across a row of 5 cells
+static void test_stride_zero()
+{
+    std::vector<int> in = { 1, 2, 3 };
+    std::vector<int> out(15, 0);
+    const matrix_span<int> input(in.data(), 5, 3, 0);
+    matrix_span<int>       output(out.data(), 5, 3, 3);
+
+    rowgain::scale_row(input, output, 1.0, 100.0);
+
+    for (int x = 0; x < 5; x++) {
+        assert(out[x * 3 + 0] == 101);
+        assert(out[x * 3 + 1] == 102);
+        assert(out[x * 3 + 2] == 103);
+    }
+}
+
+
+// char matrices are rounded and clamped
+static void test_char_clamp()
+{
+    std::vector<unsigned char> in = { 0, 100, 200, 255 };
+    std::vector<unsigned char> out(4, 0);
+    const matrix_span<unsigned char> input(in.data(), 1, 4, 4);
+    matrix_span<unsigned char>       output(out.data(), 1, 4, 4);
+
+    rowgain::scale_row(input, output, 1.5, -20.0);
+
+    const std::vector<unsigned char> expected = { 0, 130, 255, 255 };
+    assert(out == expected);
+}
+
+
+// no input matrix: the output is left as is
+static void test_no_input()
+{
+    std::vector<float> out(4, 7.0f);
+    const matrix_span<float> input(nullptr, 1, 0, 0);
+    matrix_span<float>       output(out.data(), 1, 4, 4);
+
+    rowgain::scale_row(input, output, 2.0, 0.0);
+
+    for (float v : out) {
+        assert(v == 7.0f);
+    }
+}
+
+
+int main()
+{
+    test_contiguous();
+    test_strided();
+    test_stride_zero();
+    test_char_clamp();
+    test_no_input();
+    printf("test_rowgain: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,74 @@
+/// @file
+///	@ingroup 	minapi
+///	@copyright	Copyright 2018 The Min-API Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+#pragma once
+
+// No Max dependencies: row kernels written against matrix_span can be unit tested on their own.
+
+namespace c74::min {
+
+/// A row of cells passed to calc_row().
+/// Planes are interleaved: plane k of cell x is at data()[x * stride() + k].
+/// When contiguous() the row is a single run of width() * plane_count() values which can be processed with SIMD.
+/// A stride of 0 means the input has a single cell which is repeated across the row.
+
+template <class matrix_type>
+class matrix_span
+{
+  public:
+    matrix_span(matrix_type* data, const long width, const long plane_count, const long stride)
+        : m_data{ data }
+        , m_width{ width }
+        , m_plane_count{ plane_count }
+        , m_stride{ stride }
+    {
+    }
+
+    /// Pointer to the first plane of the first cell, or nullptr if there is no input matrix.
+    matrix_type* data() const
+    {
+        return m_data;
+    }
+
+    /// Number of cells in the row.
+    long width() const
+    {
+        return m_width;
+    }
+
+    long plane_count() const
+    {
+        return m_plane_count;
+    }
+
+    /// Distance in values between the first planes of neighbouring cells.
+    long stride() const
+    {
+        return m_stride;
+    }
+
+    /// True if the cells of the row are packed without gaps.
+    bool contiguous() const
+    {
+        return m_stride == m_plane_count;
+    }
+
+    matrix_type* cell(const long x) const
+    {
+        return m_data + x * m_stride;
+    }
+
+    matrix_type& operator()(const long x, const long plane) const
+    {
+        return m_data[x * m_stride + plane];
+    }
+
+  private:
+    matrix_type* m_data;
+    long m_width;
+    long m_plane_count;
+    long m_stride;
+};
+
+} // namespace c74::min
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "c74_jitter.h"
+#include "c74_min_matrix_span.h"
 
 namespace c74::min {
 
@@ -148,6 +149,16 @@ class matrix_operator_base
 };
 
 /// Inheriting from matrix_operator extends your class functionality to processing matrices.
+///
+/// By default calc_cell() is called for each cell. A class may instead define
+///
+///		template <class matrix_type>
+///		void calc_row(const matrix_span<matrix_type>& input, matrix_span<matrix_type>& output, const matrix_info& info, long row);
+///
+/// which is called once per row with the whole row of input and output cells, so it can use SIMD or hand a
+/// complete row to another runtime. The iteration direction does not apply to calc_row().
+/// With parallel breakup enabled, rows are spread across the Jitter worker threads, so calc_row() must be safe to
+/// call concurrently. As with calc_cell() positions, the row index is relative to the block a thread is processing.
 template <placeholder matrix_operator_placeholder_type = placeholder::none>
 class matrix_operator : public matrix_operator_base
 {
@@ -442,6 +453,39 @@ void jit_calculate_vector(
     }
 }
 
+// Detect a calc_row() for the matrix type U, which replaces per-cell calc_cell() dispatch.
+
+template <class min_class_type, typename U>
+struct has_calc_row
+{
+    template <typename C>
+    static std::true_type test(decltype(std::declval<C&>().calc_row(std::declval<const matrix_span<U>&>(),
+                                                                     std::declval<matrix_span<U>&>(),
+                                                                     std::declval<const matrix_info&>(), 0L))*);
+
+    template <typename C>
+    static std::false_type test(...);
+
+    static const bool value = is_same<std::true_type, decltype(test<min_class_type>(nullptr))>::value;
+};
+
+template <class min_class_type, typename U>
+typename enable_if<has_calc_row<min_class_type, U>::value>::type jit_calculate_row(
+    minwrap<min_class_type>* self, const matrix_info& info, const long n, const long i, const max::t_jit_op_info* in, max::t_jit_op_info* out)
+{
+    const matrix_span<U> input(in ? static_cast<U*>(in->p) : nullptr, n, in ? info.m_in_info->planecount : 0, in ? in->stride : 0);
+    matrix_span<U>       output(static_cast<U*>(out->p), n, info.m_out_info->planecount, out->stride);
+
+    self->m_min_object.calc_row(input, output, info, i);
+}
+
+template <class min_class_type, typename U>
+typename enable_if<!has_calc_row<min_class_type, U>::value>::type jit_calculate_row(
+    minwrap<min_class_type>* self, const matrix_info& info, const long n, const long i, const max::t_jit_op_info* in, max::t_jit_op_info* out)
+{
+    jit_calculate_vector<min_class_type, U>(self, info, n, i, in, out);
+}
+
 // We also use a C+ template for the loop that wraps the call to jit_simple_vector(),
 // further reducing code duplication in jit_simple_calculate_ndim().
 // The calls into these templates should be inlined by the compiler, eliminating concern about any added function call overhead.
@@ -456,7 +500,7 @@ jit_calculate_ndim_loop(minwrap<min_class_type>* self, const long n, max::t_jit_
             in_opinfo->p = bip + i * in_minfo->dimstride[1];
         }
         out_opinfo->p = bop + i * out_minfo->dimstride[1];
-        jit_calculate_vector<min_class_type, U>(self, info, n, i, in_opinfo, out_opinfo);
+        jit_calculate_row<min_class_type, U>(self, info, n, i, in_opinfo, out_opinfo);
     }
 }
 
@@ -18,10 +18,16 @@
 enum INLETS { I_INPUT, NUM_INLETS };
 enum OUTLETS { O_OUTPUT, NUM_OUTLETS };
 
+#define COBRA_RELOAD_DELAY 100 // ms to wait for file changes to settle
+
 typedef struct _cobra {
     t_object ob;
     t_symbol* name;
     void* outlet;
+    long autoreload;        // reload tracked modules when their files change
+    long threaded;          // run python messages on the interpreter's own thread
+    t_linklist* watchers;   // filewatchers of tracked module files
+    void* reload_clock;     // debounces file change notifications
     pyjs::PythonInterpreter* py;
 } t_cobra;
 
@@ -35,10 +41,16 @@ void cobra_assist(t_cobra* x, void* b, long m, long a, char* s);
 // attr getters / setters
 t_max_err cobra_name_get(t_cobra* x, t_object* attr, long* argc, t_atom** argv);
 t_max_err cobra_name_set(t_cobra* x, t_object* attr, long argc, t_atom* argv);
+t_max_err cobra_threaded_set(t_cobra* x, t_object* attr, long argc, t_atom* argv);
 
 
 // basic methods
 void cobra_bang(t_cobra*);
+void cobra_stats(t_cobra* x);
+void cobra_metrics(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
+void cobra_trace(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
+void cobra_profile(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
+void cobra_memory(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
 
 // core methods
 t_max_err cobra_import(t_cobra* x, t_symbol* s);
@@ -46,8 +58,15 @@ t_max_err cobra_eval(t_cobra* x, t_symbol* s);
 t_max_err cobra_exec(t_cobra* x, t_symbol* s);
 t_max_err cobra_execfile(t_cobra* x, t_symbol* s);
 
+// hot-reload
+t_max_err cobra_reload(t_cobra* x);
+void cobra_reload_task(t_cobra* x);
+void cobra_filechanged(t_cobra* x, char* filename, short path);
+void cobra_watch(t_cobra* x, const std::vector<std::string>& paths);
+
 // extra py methods
 t_max_err cobra_call(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err cobra_bind(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err cobra_assign(t_cobra* x, t_symbol* s, long argc, t_atom* argv); 
 t_max_err cobra_code(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err cobra_anything(t_cobra* x, t_symbol* s, long argc, t_atom* argv);
@@ -73,13 +92,21 @@ void ext_main(void* r)
     class_addmethod(c, (method)cobra_assist,     "assist",   A_CANT,     0);
 
     class_addmethod(c, (method)cobra_bang,       "bang",                 0);
+    class_addmethod(c, (method)cobra_stats,      "stats",    A_NOTHING,  0);
+    class_addmethod(c, (method)cobra_metrics,    "metrics",  A_GIMME,    0);
+    class_addmethod(c, (method)cobra_trace,      "trace",    A_GIMME,    0);
+    class_addmethod(c, (method)cobra_profile,    "profile",  A_GIMME,    0);
+    class_addmethod(c, (method)cobra_memory,     "memory",   A_GIMME,    0);
     class_addmethod(c, (method)cobra_import,     "import",   A_SYM,      0);
     class_addmethod(c, (method)cobra_eval,       "eval",     A_SYM,      0);
     class_addmethod(c, (method)cobra_exec,       "exec",     A_SYM,      0);
     class_addmethod(c, (method)cobra_execfile,   "execfile", A_SYM,      0);
+    class_addmethod(c, (method)cobra_reload,     "reload",   A_NOTHING,  0);
+    class_addmethod(c, (method)cobra_filechanged, "filechanged", A_CANT, 0);
 
     class_addmethod(c, (method)cobra_assign,     "assign",   A_GIMME,    0);
     class_addmethod(c, (method)cobra_call,       "call",     A_GIMME,    0);
+    class_addmethod(c, (method)cobra_bind,       "bind",     A_GIMME,    0);
     class_addmethod(c, (method)cobra_code,       "code",     A_GIMME,    0);
     class_addmethod(c, (method)cobra_pipe,       "pipe",     A_GIMME,    0);
     class_addmethod(c, (method)cobra_anything,   "anything", A_GIMME,    0);
@@ -88,6 +115,15 @@ void ext_main(void* r)
     CLASS_ATTR_SYM(c, "name", 0,   t_cobra, name);
     CLASS_ATTR_BASIC(c, "name", 0);
 
+    CLASS_ATTR_LONG(c, "autoreload", 0, t_cobra, autoreload);
+    CLASS_ATTR_STYLE(c, "autoreload", 0, "onoff");
+    CLASS_ATTR_BASIC(c, "autoreload", 0);
+
+    CLASS_ATTR_LONG(c, "threaded", 0, t_cobra, threaded);
+    CLASS_ATTR_ACCESSORS(c, "threaded", NULL, cobra_threaded_set);
+    CLASS_ATTR_STYLE(c, "threaded", 0, "onoff");
+    CLASS_ATTR_BASIC(c, "threaded", 0);
+
 
     class_register(CLASS_BOX, c); /* CLASS_NOBOX */
     cobra_class = c;
@@ -118,6 +154,8 @@ void cobra_assist(t_cobra* x, void* b, long io, long idx, char* s)
 
 void cobra_free(t_cobra* x)
 {
+    object_free(x->reload_clock);
+    object_free(x->watchers); // stops and frees the filewatchers
     delete x->py;
 }
 
@@ -149,7 +187,13 @@ void* cobra_new(t_symbol* s, long argc, t_atom* argv)
 
         x->name = gensym("");
         x->outlet = bangout((t_object*)x);
+        x->autoreload = 0;
+        x->threaded = 0;
+        x->watchers = linklist_new();
+        linklist_flags(x->watchers, OBJ_FLAG_OBJ);
+        x->reload_clock = clock_new((t_object*)x, (method)cobra_reload_task);
         x->py = new pyjs::PythonInterpreter(cobra_class); // <-- can also be a struct
+        x->py->set_watch_callback((pyjs::py_watch_fn)cobra_watch, x);
 
         attr_args_process(x, argc, argv);
     }
@@ -162,57 +206,167 @@ void cobra_bang(t_cobra* x)
 }
 
 
+t_max_err cobra_threaded_set(t_cobra* x, t_object* attr, long argc, t_atom* argv)
+{
+    if (argc && argv) {
+        x->threaded = atom_getlong(argv) != 0;
+        if (x->threaded) {
+            return x->py->start();
+        }
+        x->py->stop();
+    }
+    return MAX_ERR_NONE;
+}
+
+
+void cobra_stats(t_cobra* x)
+{
+    t_atom atoms[8];
+    pyjs::PyQueueStats stats = x->py->queue_stats();
+
+    atom_setlong(atoms + 0, (t_atom_long)stats.posted);
+    atom_setlong(atoms + 1, (t_atom_long)stats.done);
+    atom_setlong(atoms + 2, (t_atom_long)stats.dropped);
+    atom_setlong(atoms + 3, stats.depth);
+    atom_setlong(atoms + 4, stats.depth_max);
+    atom_setfloat(atoms + 5, stats.wait_last_us);
+    atom_setfloat(atoms + 6, stats.wait_avg_us);
+    atom_setfloat(atoms + 7, stats.wait_max_us);
+    outlet_anything(x->outlet, gensym("stats"), 8, atoms);
+}
+
+
+void cobra_metrics(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
+{
+    metrics_message(x->py->metrics(), x->name, argc, argv, x->outlet);
+}
+
+
+void cobra_trace(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atom;
+    t_symbol* path = trace_message((t_object*)x, "cobra", argc, argv);
+
+    if (path) {
+        atom_setsym(&atom, path);
+        outlet_anything(x->outlet, gensym("trace"), 1, &atom);
+    }
+}
+
+
+void cobra_profile(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atom;
+    t_symbol* path = profile_message((t_object*)x, "cobra", argc, argv);
+
+    if (path) {
+        atom_setsym(&atom, path);
+        outlet_anything(x->outlet, gensym("profile"), 1, &atom);
+    }
+}
+
+
+void cobra_memory(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
+{
+    memstats_message(x->py->memstats(), x->name, argc, argv, x->outlet);
+}
+
+
 t_max_err cobra_import(t_cobra* x, t_symbol* s)
 {
-    return x->py->import(s);
+    return x->py->submit(pyjs::PY_JOB_IMPORT, s, 0, NULL, x->outlet);
 }
 
 
 t_max_err cobra_eval(t_cobra* x, t_symbol* s)
 {
-    return x->py->eval(s, x->outlet);
+    return x->py->submit(pyjs::PY_JOB_EVAL, s, 0, NULL, x->outlet);
 }
 
 
 t_max_err cobra_exec(t_cobra* x, t_symbol* s)
 {
-    return x->py->exec(s);
+    return x->py->submit(pyjs::PY_JOB_EXEC, s, 0, NULL, x->outlet);
 }
 
 
 t_max_err cobra_execfile(t_cobra* x, t_symbol* s)
 {
-    return x->py->execfile(s);
+    return x->py->submit(pyjs::PY_JOB_EXECFILE, s, 0, NULL, x->outlet);
+}
+
+
+t_max_err cobra_reload(t_cobra* x)
+{
+    return x->py->submit(pyjs::PY_JOB_RELOAD, gensym(""), 0, NULL, x->outlet);
+}
+
+
+void cobra_reload_task(t_cobra* x)
+{
+    cobra_reload(x);
+}
+
+
+void cobra_filechanged(t_cobra* x, char* filename, short path)
+{
+    if (x->autoreload) {
+        clock_delay(x->reload_clock, COBRA_RELOAD_DELAY);
+    }
+}
+
+
+void cobra_watch(t_cobra* x, const std::vector<std::string>& paths)
+{
+    char filename[MAX_FILENAME_CHARS];
+    short path_id = 0;
+
+    for (const std::string& path : paths) {
+        if (path_frompathname(path.c_str(), &path_id, filename)) {
+            continue;
+        }
+        void* watcher = filewatcher_new((t_object*)x, path_id, filename);
+        if (watcher) {
+            filewatcher_start(watcher);
+            linklist_append(x->watchers, watcher);
+        }
+    }
 }
 
 
 t_max_err cobra_call(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return x->py->call(s, argc, argv, x->outlet);
+    return x->py->submit(pyjs::PY_JOB_CALL, s, argc, argv, x->outlet);
+}
+
+
+t_max_err cobra_bind(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return x->py->submit(pyjs::PY_JOB_BIND, s, argc, argv, x->outlet);
 }
 
 
 t_max_err cobra_assign(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return x->py->assign(s, argc, argv);
+    return x->py->submit(pyjs::PY_JOB_ASSIGN, s, argc, argv, x->outlet);
 }
 
 
 t_max_err cobra_code(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return x->py->code(s, argc, argv, x->outlet);
+    return x->py->submit(pyjs::PY_JOB_CODE, s, argc, argv, x->outlet);
 }
 
 
 t_max_err cobra_anything(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return x->py->anything(s, argc, argv, x->outlet);
+    return x->py->submit(pyjs::PY_JOB_ANYTHING, s, argc, argv, x->outlet);
 }
 
 
 t_max_err cobra_pipe(t_cobra* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return x->py->pipe(s, argc, argv, x->outlet);
+    return x->py->submit(pyjs::PY_JOB_PIPE, s, argc, argv, x->outlet);
 }
 
 
@@ -50,11 +50,32 @@
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <marshal.h>
 
 // C++ includes for thread safety and RAII
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <memory>
+#include <thread>
 #include <cstdio>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+// lock-free single-producer single-consumer queue (bundled with min-api)
+#include "readerwriterqueue.h"
+
+// per-message latency metrics (shared with other python externals)
+#include "../mamba/metrics.h"
+#include "../mamba/profile.h"
+#include "../mamba/memstats.h"
+#include "../mamba/codecache.h"
 
 namespace pyjs
 {
@@ -67,11 +88,19 @@ namespace pyjs
 #define STR(x) _STR(x)
 #define PY_VER STR(PY_MAJOR_VERSION) "." STR(PY_MINOR_VERSION)
 
+#if PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
 // ---------------------------------------------------------------------------
 // constants
 
 #define PY_MAX_ELEMS 1024
 #define PY_LOG_LEVEL PY_DEBUG
+#define PY_STACK_ARGS 16 // max call args converted on the stack
+#define PY_QUEUE_SIZE 256 // capacity of each job queue of the python thread
+#define PY_JOB_MAX_ATOMS 32 // atoms stored inline in a queued job
+#define PY_QUEUE_WAIT_US 100000 // python thread wakeup period when idle
 
 // ---------------------------------------------------------------------------
 // enums
@@ -84,25 +113,141 @@ enum log_level {
     PY_ERROR, PY_INFO, PY_DEBUG
 };
 
+/**
+ * @brief      message methods which can be run on the python thread
+ */
+enum py_job_kind {
+    PY_JOB_IMPORT,
+    PY_JOB_EVAL,
+    PY_JOB_EXEC,
+    PY_JOB_EXECFILE,
+    PY_JOB_RELOAD,
+    PY_JOB_CALL,
+    PY_JOB_BIND,
+    PY_JOB_ASSIGN,
+    PY_JOB_CODE,
+    PY_JOB_ANYTHING,
+    PY_JOB_PIPE
+};
+
+/**
+ * @brief      outputs sent back from the python thread
+ */
+enum py_result_kind {
+    PY_RESULT_FLOAT,
+    PY_RESULT_LONG,
+    PY_RESULT_ANYTHING,
+    PY_RESULT_LIST,
+    PY_RESULT_WATCH
+};
+
+// ---------------------------------------------------------------------------
+// structs
+
+/**
+ * @brief      a callable resolved once by `bind` and dispatched per message
+ *
+ * `root` is the object the first name segment resolved to; the binding is
+ * stale when the namespace no longer maps `key` to the same object.
+ */
+struct PyBinding {
+    PyObject* key;   //!< interned first segment of the dotted name (owned)
+    PyObject* root;  //!< globals/builtins value of key at bind time (owned, null if stale)
+    PyObject* func;  //!< resolved callable (owned)
+    std::string name; //!< full dotted python name
+};
+
+/**
+ * @brief      a message queued for the python thread
+ *
+ * Symbols are never freed by Max, so the atoms can be copied as is. Up to
+ * PY_JOB_MAX_ATOMS atoms are stored inline, so that queueing a message from
+ * the scheduler or audio thread does not allocate; longer messages are only
+ * accepted from the other threads.
+ */
+struct PyJob {
+    py_job_kind kind;
+    t_symbol* s;                //!< message symbol argument or selector
+    long argc;                  //!< number of message atoms
+    t_atom args[PY_JOB_MAX_ATOMS]; //!< copy of the message atoms
+    std::vector<t_atom> more;   //!< copy of longer messages (argc > PY_JOB_MAX_ATOMS)
+    void* outlet;               //!< outlet for results (may be null)
+    std::chrono::steady_clock::time_point posted; //!< enqueue time
+};
+
+/**
+ * @brief      an output of the python thread, sent out on the main thread
+ *
+ * Only the python thread queues results (other threads send them out
+ * directly), so the atoms may be copied to the heap.
+ */
+struct PyResult {
+    py_result_kind kind;
+    void* outlet;
+    t_symbol* s;                    //!< selector (PY_RESULT_ANYTHING)
+    std::vector<t_atom> atoms;
+    std::vector<std::string> paths; //!< module files to watch (PY_RESULT_WATCH)
+};
+
+/**
+ * @brief      snapshot of the python thread queue counters
+ */
+struct PyQueueStats {
+    uint64_t posted;     //!< jobs enqueued
+    uint64_t done;       //!< jobs run
+    uint64_t dropped;    //!< jobs rejected because a queue was full
+    long depth;          //!< jobs enqueued and not yet run
+    long depth_max;      //!< largest depth seen
+    double wait_last_us; //!< queueing delay of the last job
+    double wait_max_us;  //!< largest queueing delay
+    double wait_avg_us;  //!< mean queueing delay
+};
+
+/**
+ * @brief      receives newly tracked module files on the main thread
+ */
+typedef void (*py_watch_fn)(void* obj, const std::vector<std::string>& paths);
+
 // ---------------------------------------------------------------------------
 // RAII Helpers
 
 /**
  * @brief RAII wrapper for Python GIL state management
+ *
+ * Allocations made under the guard are accounted to `owner` when given
+ * (see memstats.h).
  */
 class GILGuard {
 private:
     PyGILState_STATE m_gstate;
 
 public:
-    GILGuard() : m_gstate(PyGILState_Ensure()) {}
-    ~GILGuard() { PyGILState_Release(m_gstate); }
+    explicit GILGuard(t_memstats* owner = nullptr) : m_gstate(PyGILState_Ensure()) { memstats_enter(owner); }
+    ~GILGuard() { memstats_leave(); PyGILState_Release(m_gstate); }
 
     // Non-copyable
     GILGuard(const GILGuard&) = delete;
     GILGuard& operator=(const GILGuard&) = delete;
 };
 
+/**
+ * @brief RAII marker of a result conversion in the metrics of a job
+ *
+ * Time before the scope is counted as execution, time inside it as
+ * conversion. Does nothing without a span.
+ */
+class ConvertScope {
+private:
+    t_metrics_span* m_span;
+
+public:
+    explicit ConvertScope(t_metrics_span* span) : m_span(span) { metrics_exec(span); }
+    ~ConvertScope() { metrics_convert(m_span); }
+
+    ConvertScope(const ConvertScope&) = delete;
+    ConvertScope& operator=(const ConvertScope&) = delete;
+};
+
 /**
  * @brief RAII wrapper for FILE* handles
  */
@@ -136,6 +281,12 @@ public:
  * All public methods acquire appropriate locks. However, be cautious when
  * calling from Max's scheduler thread vs main thread.
  *
+ * After `start()`, messages passed to `submit()` are run on a python thread
+ * owned by the interpreter: the main thread, the scheduler thread, the audio
+ * thread and any other thread each feed their own lock-free queue, and outputs come back on
+ * a queue drained by a qelem on the main thread. Max threads then never wait
+ * on the mutex or the GIL.
+ *
  * @par Memory Management
  * Uses proper reference counting for Python objects. The interpreter is
  * reference-counted across all instances - first instance initializes,
@@ -154,7 +305,39 @@ class PythonInterpreter
         t_symbol* p_source_name;    //!< base name of python file to execfile
         t_symbol* p_source_path;    //!< full path to python file to execfile
         log_level p_log_level;      //!< object-level log level (error, info, debug)
+        bool p_cache;               //!< bytecode caching of execfile (default: on)
         PyObject* p_globals;        //!< per object 'globals' python namespace (owned reference)
+        PyObject* p_modules;        //!< tracked user modules: name -> file mtime in ns (owned reference)
+        std::vector<std::string> p_watch_pending; //!< newly tracked module files not yet watched
+        std::unordered_map<t_symbol*, PyBinding> p_bindings; //!< selector -> bound python callable
+
+        // Python thread (message-passing mode)
+        std::thread p_thread;                    //!< runs submitted jobs while started
+        std::atomic<bool> p_running;             //!< python thread accepts jobs
+        moodycamel::ReaderWriterQueue<PyJob> p_jobs_main;  //!< main thread -> python thread
+        moodycamel::ReaderWriterQueue<PyJob> p_jobs_timer; //!< scheduler thread -> python thread
+        moodycamel::ReaderWriterQueue<PyJob> p_jobs_audio; //!< audio thread (scheduler in audio interrupt) -> python thread
+        moodycamel::ReaderWriterQueue<PyJob> p_jobs_other; //!< other threads -> python thread
+        std::mutex p_jobs_other_mutex;           //!< serializes producers of p_jobs_other
+        moodycamel::spsc_sema::LightweightSemaphore p_jobs_ready; //!< one count per queued job
+        moodycamel::ReaderWriterQueue<PyResult> p_results; //!< python thread -> main thread
+        void* p_results_qelem;                   //!< drains p_results on the main thread
+        py_watch_fn p_watch_fn;                  //!< receives module files to watch
+        void* p_watch_obj;
+
+        // Python thread counters
+        std::atomic<uint64_t> p_jobs_posted;
+        std::atomic<uint64_t> p_jobs_done;
+        std::atomic<uint64_t> p_jobs_dropped;
+        std::atomic<bool> p_jobs_overflow;       //!< a queue was full on the last submit
+        std::atomic<bool> p_jobs_oversize;       //!< a long message from a realtime thread was dropped
+        std::atomic<long> p_jobs_depth;
+        std::atomic<long> p_jobs_depth_max;
+        std::atomic<uint64_t> p_wait_last_ns;
+        std::atomic<uint64_t> p_wait_max_ns;
+        std::atomic<uint64_t> p_wait_total_ns;
+        t_metrics* p_metrics;                    //!< per-message latency metrics
+        t_memstats* p_memstats;                  //!< memory allocated by this instance
 
         // Thread safety
         mutable std::recursive_mutex m_mutex; //!< recursive mutex for thread-safe access to member variables
@@ -163,6 +346,10 @@ class PythonInterpreter
         static int s_interpreter_count;          //!< reference count for interpreter lifecycle
         static std::mutex s_interpreter_mutex;   //!< mutex for interpreter initialization
         static PyThreadState* s_main_thread_state; //!< main thread state for sub-interpreters
+        static PyObject* s_code_cache;           //!< path -> (hash, size, code) shared by all instances
+        static PyObject* s_reload_ns;            //!< namespace of the hot-reload helper functions
+        static thread_local PythonInterpreter* s_current; //!< interpreter owning the calling python thread
+        static thread_local t_metrics_span* s_span; //!< metrics of the job running on the calling thread
 
     public:
         PythonInterpreter(t_class* c);
@@ -178,6 +365,23 @@ class PythonInterpreter
         void handle_error(char* fmt, ...);
         t_max_err syspath_append(char* path);
 
+        // python thread
+        t_max_err start();
+        void stop();
+        bool is_running();
+        void set_watch_callback(py_watch_fn fn, void* obj);
+        t_max_err submit(py_job_kind kind, t_symbol* s, long argc, t_atom* argv, void* outlet);
+        t_max_err run(py_job_kind kind, t_symbol* s, long argc, t_atom* argv, void* outlet);
+        t_max_err run_job(PyJob& job);
+        void run_loop();
+        void send_result(py_result_kind kind, void* outlet, t_symbol* s, long argc, t_atom* argv);
+        void send_watch();
+        void drain_results();
+        static void results_task(PythonInterpreter* self);
+        PyQueueStats queue_stats();
+        t_metrics* metrics();
+        t_memstats* memstats();
+
         // python <-> atom translation
         PyObject* atoms_to_plist_with_offset(long argc, t_atom* argv, int start_from);
         PyObject* atoms_to_plist(long argc, t_atom* argv); //+
@@ -201,6 +405,16 @@ class PythonInterpreter
         t_max_err exec_pcode(char* pcode);
         t_max_err execfile_path(char* path);
 
+        // bytecode cache helpers
+        PyObject* compile_file(char* path);
+
+        // hot-reload helpers
+        PyObject* reload_func(const char* name);
+        PyObject* reload_snapshot();
+        void reload_track(PyObject* before, const char* name);
+        std::vector<std::string> watch_pending();
+        t_max_err reload();
+
         // core message methods
         t_max_err import(t_symbol* s);
         t_max_err eval(t_symbol* s, void* outlet);
@@ -211,8 +425,16 @@ class PythonInterpreter
         PyObject* eval_text(char* text);
         t_max_err eval_text_to_outlet(long argc, t_atom* argv, int offset, void* outlet);
 
+        // native dispatch helpers
+        PyObject* resolve(const char* name, PyObject** root);
+        t_max_err call_func(PyObject* func, const char* fname, long argc, t_atom* argv, void* outlet);
+        bool is_bound(t_symbol* s);
+        t_max_err call_bound(t_symbol* s, long argc, t_atom* argv, void* outlet);
+        void bind_clear();
+
         // extra message methods
         t_max_err call(t_symbol* s, long argc, t_atom* argv, void* outlet);
+        t_max_err bind(t_symbol* s, long argc, t_atom* argv);
         t_max_err assign(t_symbol* s, long argc, t_atom* argv);
         t_max_err code(t_symbol* s, long argc, t_atom* argv, void* outlet);
         t_max_err anything(t_symbol* s, long argc, t_atom* argv, void* outlet);
@@ -249,6 +471,17 @@ class PythonInterpreter
 int PythonInterpreter::s_interpreter_count = 0;
 std::mutex PythonInterpreter::s_interpreter_mutex;
 PyThreadState* PythonInterpreter::s_main_thread_state = nullptr;
+PyObject* PythonInterpreter::s_code_cache = nullptr;
+PyObject* PythonInterpreter::s_reload_ns = nullptr;
+thread_local PythonInterpreter* PythonInterpreter::s_current = nullptr;
+thread_local t_metrics_span* PythonInterpreter::s_span = nullptr;
+
+// ---------------------------------------------------------------------------
+// hot-reload helper functions: `PY_RELOAD_MODULE` is generated at build time
+// from the hot-reload section of the `py` external's prelude
+// (py/py_prelude.new.py) by py/scripts/py2c.py, and run into `s_reload_ns`
+// on first use.
+#include "py_reload.h"
 
 // ---------------------------------------------------------------------------
 // constructor / destructor methods
@@ -260,13 +493,36 @@ PyThreadState* PythonInterpreter::s_main_thread_state = nullptr;
  * Subsequent instances reuse the existing interpreter.
  */
 PythonInterpreter::PythonInterpreter(t_class* c)
+    : p_running(false),
+      p_jobs_main(PY_QUEUE_SIZE),
+      p_jobs_timer(PY_QUEUE_SIZE),
+      p_jobs_audio(PY_QUEUE_SIZE),
+      p_jobs_other(PY_QUEUE_SIZE),
+      p_results(PY_QUEUE_SIZE),
+      p_jobs_posted(0),
+      p_jobs_done(0),
+      p_jobs_dropped(0),
+      p_jobs_overflow(false),
+      p_jobs_oversize(false),
+      p_jobs_depth(0),
+      p_jobs_depth_max(0),
+      p_wait_last_ns(0),
+      p_wait_max_ns(0),
+      p_wait_total_ns(0)
 {
     this->p_name = symbol_unique();
     this->p_pythonpath = gensym("");
     this->p_source_name = gensym("");
     this->p_source_path = gensym("");
     this->p_log_level = log_level::PY_LOG_LEVEL;
+    this->p_cache = true;
     this->p_globals = nullptr;
+    this->p_modules = nullptr;
+    this->p_results_qelem = qelem_new(this, (method)PythonInterpreter::results_task);
+    this->p_watch_fn = nullptr;
+    this->p_watch_obj = nullptr;
+    this->p_metrics = metrics_new();
+    this->p_memstats = memstats_new(this->p_name);
 
     // Thread-safe interpreter initialization
     {
@@ -305,6 +561,9 @@ PythonInterpreter::PythonInterpreter(t_class* c)
             config.isolated = 0;   // default is disabled
             config.home = python_home;
 
+            // accounting allocator (when enabled) must precede initialization
+            memstats_preinit(0);
+
             PyStatus status = Py_InitializeFromConfig(&config);
             if (PyStatus_Exception(status)) {
                 PyConfig_Clear(&config);
@@ -325,7 +584,7 @@ PythonInterpreter::PythonInterpreter(t_class* c)
 
     // Per-instance Python setup (must acquire GIL)
     {
-        GILGuard gil;
+        GILGuard gil(this->p_memstats);
 
         PyObject* main_mod = PyImport_AddModule(this->p_name->s_name); // borrowed
         if (main_mod == nullptr) {
@@ -347,6 +606,8 @@ PythonInterpreter::PythonInterpreter(t_class* c)
         }
 
         Py_XDECREF(py_name);
+
+        this->p_modules = PyDict_New();
     }
 }
 
@@ -358,9 +619,17 @@ PythonInterpreter::PythonInterpreter(t_class* c)
  */
 PythonInterpreter::~PythonInterpreter()
 {
+    // Jobs still queued are discarded, pending outputs are not sent
+    this->stop();
+    qelem_free(this->p_results_qelem);
+    metrics_free(this->p_metrics);
+    memstats_release(this->p_memstats);
+
     // Clean up per-instance Python objects (requires GIL)
     {
-        GILGuard gil;
+        GILGuard gil(this->p_memstats);
+        this->bind_clear();
+        Py_CLEAR(this->p_modules);
         Py_XDECREF(this->p_globals);
         this->p_globals = nullptr;
     }
@@ -374,6 +643,9 @@ PythonInterpreter::~PythonInterpreter()
         if (s_interpreter_count == 0) {
             // Last instance: finalize Python interpreter
             PyEval_RestoreThread(s_main_thread_state);
+            Py_CLEAR(s_code_cache);
+            Py_CLEAR(s_reload_ns);
+            profile_free();
             if (Py_FinalizeEx() < 0) {
                 post("[py warning] Python finalization returned error");
             }
@@ -459,6 +731,8 @@ void PythonInterpreter::log_error(char* fmt, ...)
 void PythonInterpreter::handle_error(char* fmt, ...)
 {
     if (PyErr_Occurred()) {
+        // count the job as failed, some methods report errors as None
+        metrics_fail(s_span);
 
         // build custom msg
         char msg[PY_MAX_ELEMS];
@@ -519,7 +793,7 @@ void PythonInterpreter::print_atom(int argc, t_atom* argv)
 t_max_err PythonInterpreter::syspath_append(char* path)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     t_max_err err = MAX_ERR_NONE;
     PyObject* os = nullptr;
@@ -826,7 +1100,9 @@ t_max_err PythonInterpreter::handle_float_output(void* outlet, PyObject* pfloat)
         if (float_result == -1.0 && PyErr_Occurred()) {
             goto error;
         }
-        outlet_float(outlet, float_result);
+        t_atom atom;
+        atom_setfloat(&atom, float_result);
+        this->send_result(PY_RESULT_FLOAT, outlet, NULL, 1, &atom);
     }
     Py_XDECREF(pfloat);
     return MAX_ERR_NONE;
@@ -856,7 +1132,9 @@ t_max_err PythonInterpreter::handle_long_output(void* outlet, PyObject* plong)
         if (long_result == -1 && PyErr_Occurred()) {
             goto error;
         }
-        outlet_int(outlet, long_result);
+        t_atom atom;
+        atom_setlong(&atom, long_result);
+        this->send_result(PY_RESULT_LONG, outlet, NULL, 1, &atom);
     }
 
     Py_XDECREF(plong);
@@ -885,7 +1163,7 @@ t_max_err PythonInterpreter::handle_string_output(void* outlet, PyObject* pstrin
         if (unicode_result == NULL) {
             goto error;
         }
-        outlet_anything(outlet, gensym(unicode_result), 0, (t_atom*)NIL);
+        this->send_result(PY_RESULT_ANYTHING, outlet, gensym(unicode_result), 0, NULL);
     }
 
     Py_XDECREF(pstring);
@@ -975,7 +1253,7 @@ t_max_err PythonInterpreter::handle_list_output(void* outlet, PyObject* plist)
             Py_DECREF(item);
         }
 
-        outlet_list(outlet, NULL, i, atoms);
+        this->send_result(PY_RESULT_LIST, outlet, NULL, i, atoms);
         this->log_debug((char*)"end iter op: %d", i);
 
         if (is_dynamic) {
@@ -1067,7 +1345,8 @@ error:
  */
 t_max_err PythonInterpreter::handle_output(void* outlet, PyObject* pval)
 {
-    GILGuard gil;  // Must hold GIL for all Python C API calls
+    GILGuard gil(this->p_memstats); // Must hold GIL for all Python C API calls
+    ConvertScope convert(s_span);
 
     if (pval == NULL) {
         this->log_error((char*)"cannot handle NULL value");
@@ -1107,6 +1386,489 @@ t_max_err PythonInterpreter::handle_output(void* outlet, PyObject* pval)
     }
 }
 
+// ---------------------------------------------------------------------------------------
+// PYTHON THREAD
+
+
+/**
+ * @brief Starts the python thread of this interpreter
+ *
+ * Messages passed to `submit()` are then queued and run on that thread.
+ *
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::start()
+{
+    if (this->p_running) {
+        return MAX_ERR_NONE;
+    }
+    this->p_running = true;
+    try {
+        this->p_thread = std::thread(&PythonInterpreter::run_loop, this);
+    } catch (const std::system_error&) {
+        this->p_running = false;
+        this->log_error((char*)"could not start python thread");
+        return MAX_ERR_GENERIC;
+    }
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Stops and joins the python thread
+ *
+ * Waits for the job in progress to complete; queued jobs are discarded and
+ * counted as dropped.
+ */
+void PythonInterpreter::stop()
+{
+    if (!this->p_thread.joinable()) {
+        return;
+    }
+    this->p_running = false;
+    this->p_jobs_ready.signal();
+    this->p_thread.join();
+
+    PyJob job;
+    while (this->p_jobs_main.try_dequeue(job)
+           || this->p_jobs_timer.try_dequeue(job)
+           || this->p_jobs_audio.try_dequeue(job)
+           || this->p_jobs_other.try_dequeue(job)) {
+        this->p_jobs_depth--;
+        this->p_jobs_dropped++;
+    }
+}
+
+
+/**
+ * @brief Checks if the python thread is running
+ *
+ * @return bool
+ */
+bool PythonInterpreter::is_running()
+{
+    return this->p_running;
+}
+
+
+/**
+ * @brief Sets the function receiving newly tracked module files
+ *
+ * It is called on the main thread after jobs which may import modules.
+ *
+ * @param fn callback (null to disable)
+ * @param obj first callback argument
+ */
+void PythonInterpreter::set_watch_callback(py_watch_fn fn, void* obj)
+{
+    this->p_watch_fn = fn;
+    this->p_watch_obj = obj;
+}
+
+
+/**
+ * @brief Runs a message method, on the python thread if it is running
+ *
+ * Each producer has its own single-producer queue: the main thread, the
+ * scheduler thread, the audio thread (which runs the scheduler when it is
+ * in audio interrupt), and all other threads, which share a queue behind a
+ * mutex. Max threads therefore only ever do a lock-free enqueue. When a
+ * queue is full the message is dropped rather than waited on, as are
+ * messages of more than PY_JOB_MAX_ATOMS atoms from the scheduler and audio
+ * threads, which would need a heap allocation. When the
+ * python thread is not running the message is run directly, without
+ * copying its atoms.
+ *
+ * @param kind message method
+ * @param s symbol argument or selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet object outlet
+ *
+ * @return t_max_err error code (of the queueing if the thread is running)
+ */
+t_max_err PythonInterpreter::submit(py_job_kind kind, t_symbol* s, long argc,
+                                    t_atom* argv, void* outlet)
+{
+    if (!this->p_running) {
+        return this->run(kind, s, argc, argv, outlet);
+    }
+
+    bool main = systhread_ismainthread();
+    bool timer = !main && systhread_istimerthread();
+    bool audio = !main && !timer && isr();
+
+    PyJob job;
+    job.kind = kind;
+    job.s = s;
+    job.argc = argc;
+    if (argc <= PY_JOB_MAX_ATOMS) {
+        std::copy(argv, argv + argc, job.args);
+    } else if (timer || audio) {
+        this->p_jobs_dropped++;
+        if (!this->p_jobs_oversize.exchange(true)) {
+            this->log_error((char*)"dropping messages of more than %d atoms "
+                            "from the scheduler or audio thread", PY_JOB_MAX_ATOMS);
+        }
+        return MAX_ERR_GENERIC;
+    } else {
+        job.more.assign(argv, argv + argc);
+    }
+    job.outlet = outlet;
+    job.posted = std::chrono::steady_clock::now();
+    bool queued = false;
+
+    if (main) {
+        queued = this->p_jobs_main.try_enqueue(std::move(job));
+    } else if (timer) {
+        queued = this->p_jobs_timer.try_enqueue(std::move(job));
+    } else if (audio) {
+        queued = this->p_jobs_audio.try_enqueue(std::move(job));
+    } else {
+        std::lock_guard<std::mutex> lock(this->p_jobs_other_mutex);
+        queued = this->p_jobs_other.try_enqueue(std::move(job));
+    }
+
+    if (!queued) {
+        this->p_jobs_dropped++;
+        if (!this->p_jobs_overflow.exchange(true)) {
+            this->log_error((char*)"python thread queue full: dropping messages");
+        }
+        return MAX_ERR_GENERIC;
+    }
+    this->p_jobs_overflow = false;
+
+    long depth = ++this->p_jobs_depth;
+    long depth_max = this->p_jobs_depth_max;
+    while (depth > depth_max
+           && !this->p_jobs_depth_max.compare_exchange_weak(depth_max, depth)) {
+    }
+    this->p_jobs_posted++;
+    this->p_jobs_ready.signal();
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Metrics message type of a job
+ *
+ * @param kind job kind
+ * @return t_metrics_kind message type
+ */
+static t_metrics_kind py_job_metrics_kind(py_job_kind kind)
+{
+    switch (kind) {
+    case PY_JOB_IMPORT:   return METRICS_IMPORT;
+    case PY_JOB_EVAL:     return METRICS_EVAL;
+    case PY_JOB_EXEC:     return METRICS_EXEC;
+    case PY_JOB_EXECFILE: return METRICS_EXECFILE;
+    case PY_JOB_CALL:     return METRICS_CALL;
+    case PY_JOB_ASSIGN:   return METRICS_ASSIGN;
+    case PY_JOB_CODE:     return METRICS_CODE;
+    case PY_JOB_ANYTHING: return METRICS_ANYTHING;
+    case PY_JOB_PIPE:     return METRICS_PIPE;
+    default:              return METRICS_OTHER;
+    }
+}
+
+
+/**
+ * @brief Runs a message method on the calling thread
+ *
+ * The lock and the GIL are taken here first, so the time the message
+ * waited for them is measured apart from its execution.
+ *
+ * @param kind message method
+ * @param s symbol argument or selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet object outlet
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::run(py_job_kind kind, t_symbol* s, long argc,
+                                 t_atom* argv, void* outlet)
+{
+    t_max_err err = MAX_ERR_GENERIC;
+    t_metrics_span span;
+
+    metrics_begin(&span, py_job_metrics_kind(kind));
+    s_span = &span;
+
+    { // lock and GIL scope
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        GILGuard gil(this->p_memstats);
+        metrics_gil(&span);
+
+        switch (kind) {
+        case PY_JOB_IMPORT:
+            err = this->import(s);
+            break;
+        case PY_JOB_EVAL:
+            err = this->eval(s, outlet);
+            break;
+        case PY_JOB_EXEC:
+            err = this->exec(s);
+            break;
+        case PY_JOB_EXECFILE:
+            err = this->execfile(s);
+            break;
+        case PY_JOB_RELOAD:
+            err = this->reload();
+            break;
+        case PY_JOB_CALL:
+            err = this->call(s, argc, argv, outlet);
+            break;
+        case PY_JOB_BIND:
+            err = this->bind(s, argc, argv);
+            break;
+        case PY_JOB_ASSIGN:
+            err = this->assign(s, argc, argv);
+            break;
+        case PY_JOB_CODE:
+            err = this->code(s, argc, argv, outlet);
+            break;
+        case PY_JOB_ANYTHING:
+            err = this->anything(s, argc, argv, outlet);
+            break;
+        case PY_JOB_PIPE:
+            err = this->pipe(s, argc, argv, outlet);
+            break;
+        }
+        metrics_exec(&span);
+    }
+
+    switch (kind) {
+    case PY_JOB_IMPORT:
+    case PY_JOB_EXEC:
+    case PY_JOB_EXECFILE:
+    case PY_JOB_RELOAD:
+        this->send_watch();
+        break;
+    default:
+        break;
+    }
+
+    s_span = nullptr;
+    metrics_end(this->p_metrics, &span, err == MAX_ERR_NONE);
+    return err;
+}
+
+
+/**
+ * @brief Runs a queued message on the calling thread
+ *
+ * @param job queued message
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::run_job(PyJob& job)
+{
+    t_atom* argv = job.argc > PY_JOB_MAX_ATOMS ? job.more.data() : job.args;
+    return this->run(job.kind, job.s, job.argc, argv, job.outlet);
+}
+
+
+/**
+ * @brief Body of the python thread
+ *
+ * The thread keeps one python thread state for its lifetime, so the
+ * `GILGuard`s of the message methods do not create and destroy one per job.
+ * The GIL is only held while a job runs.
+ */
+void PythonInterpreter::run_loop()
+{
+    s_current = this;
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyThreadState* tstate = PyEval_SaveThread();
+
+    moodycamel::ReaderWriterQueue<PyJob>* queues[] = {
+        &this->p_jobs_main, &this->p_jobs_timer, &this->p_jobs_audio, &this->p_jobs_other
+    };
+    PyJob job;
+
+    while (this->p_running) {
+        if (!this->p_jobs_ready.wait(PY_QUEUE_WAIT_US)) {
+            continue;
+        }
+        for (auto* queue : queues) {
+            if (!queue->try_dequeue(job)) {
+                continue;
+            }
+            this->p_jobs_depth--;
+
+            uint64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - job.posted).count();
+            this->p_wait_last_ns = wait;
+            this->p_wait_total_ns += wait;
+            if (wait > this->p_wait_max_ns) {
+                this->p_wait_max_ns = wait;
+            }
+
+            this->run_job(job);
+            this->p_jobs_done++;
+            break;
+        }
+    }
+
+    PyEval_RestoreThread(tstate);
+    PyGILState_Release(gstate);
+    s_current = nullptr;
+}
+
+
+/**
+ * @brief Sends an output to an outlet
+ *
+ * On the python thread the output is queued for the main thread, elsewhere
+ * it is sent immediately.
+ *
+ * @param kind output type
+ * @param outlet object outlet
+ * @param s selector for PY_RESULT_ANYTHING
+ * @param argc atom count
+ * @param argv atoms
+ */
+void PythonInterpreter::send_result(py_result_kind kind, void* outlet,
+                                    t_symbol* s, long argc, t_atom* argv)
+{
+    if (s_current != this) {
+        switch (kind) {
+        case PY_RESULT_FLOAT:
+            outlet_float(outlet, atom_getfloat(argv));
+            break;
+        case PY_RESULT_LONG:
+            outlet_int(outlet, atom_getlong(argv));
+            break;
+        case PY_RESULT_ANYTHING:
+            outlet_anything(outlet, s, (short)argc, argv);
+            break;
+        case PY_RESULT_LIST:
+            outlet_list(outlet, NULL, (short)argc, argv);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    PyResult result;
+    result.kind = kind;
+    result.outlet = outlet;
+    result.s = s;
+    result.atoms.assign(argv, argv + argc);
+    this->p_results.enqueue(std::move(result));
+    qelem_set(this->p_results_qelem);
+}
+
+
+/**
+ * @brief Passes newly tracked module files to the watch callback
+ */
+void PythonInterpreter::send_watch()
+{
+    if (this->p_watch_fn == nullptr) {
+        return;
+    }
+
+    std::vector<std::string> paths = this->watch_pending();
+    if (paths.empty()) {
+        return;
+    }
+
+    if (s_current != this) {
+        this->p_watch_fn(this->p_watch_obj, paths);
+        return;
+    }
+
+    PyResult result;
+    result.kind = PY_RESULT_WATCH;
+    result.outlet = nullptr;
+    result.s = nullptr;
+    result.paths.swap(paths);
+    this->p_results.enqueue(std::move(result));
+    qelem_set(this->p_results_qelem);
+}
+
+
+/**
+ * @brief Sends out all queued outputs of the python thread (main thread)
+ */
+void PythonInterpreter::drain_results()
+{
+    PyResult result;
+
+    while (this->p_results.try_dequeue(result)) {
+        if (result.kind == PY_RESULT_WATCH) {
+            if (this->p_watch_fn) {
+                this->p_watch_fn(this->p_watch_obj, result.paths);
+            }
+            continue;
+        }
+        this->send_result(result.kind, result.outlet, result.s,
+                          (long)result.atoms.size(), result.atoms.data());
+    }
+}
+
+
+/**
+ * @brief qelem function draining the outputs of the python thread
+ *
+ * @param self interpreter
+ */
+void PythonInterpreter::results_task(PythonInterpreter* self)
+{
+    self->drain_results();
+}
+
+
+/**
+ * @brief Returns the python thread queue counters
+ *
+ * @return PyQueueStats snapshot of the counters
+ */
+PyQueueStats PythonInterpreter::queue_stats()
+{
+    PyQueueStats stats;
+    stats.posted = this->p_jobs_posted;
+    stats.done = this->p_jobs_done;
+    stats.dropped = this->p_jobs_dropped;
+    stats.depth = this->p_jobs_depth;
+    stats.depth_max = this->p_jobs_depth_max;
+    stats.wait_last_us = this->p_wait_last_ns / 1e3;
+    stats.wait_max_us = this->p_wait_max_ns / 1e3;
+    stats.wait_avg_us = stats.done ? this->p_wait_total_ns / 1e3 / stats.done : 0.0;
+    return stats;
+}
+
+
+/**
+ * @brief Returns the per-message latency metrics
+ *
+ * Jobs are measured in `run`, from dequeue (or submit when the python
+ * thread is not running) to the end of the message method.
+ *
+ * @return t_metrics* metrics owned by the interpreter
+ */
+t_metrics* PythonInterpreter::metrics()
+{
+    return this->p_metrics;
+}
+
+
+/**
+ * @brief Returns the memory accounting of the instance
+ *
+ * Allocations are accounted while a `GILGuard` of the instance is held,
+ * i.e. during its jobs (see memstats.h).
+ *
+ * @return t_memstats* accounting record, outlives the interpreter
+ */
+t_memstats* PythonInterpreter::memstats()
+{
+    return this->p_memstats;
+}
+
+
 // ---------------------------------------------------------------------------------------
 // CORE METHOD HELPERS
 
@@ -1120,7 +1882,7 @@ t_max_err PythonInterpreter::handle_output(void* outlet, PyObject* pval)
 t_max_err PythonInterpreter::import_module(char* module)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     PyObject* pmodule = nullptr;
 
@@ -1129,19 +1891,25 @@ t_max_err PythonInterpreter::import_module(char* module)
         return MAX_ERR_GENERIC;
     }
 
+    PyObject* before = this->reload_snapshot();
+
     pmodule = PyImport_ImportModule(module);
     if (pmodule == nullptr) {
+        Py_XDECREF(before);
         this->handle_error((char*)"import %s", module);
         return MAX_ERR_GENERIC;
     }
 
     if (PyDict_SetItemString(this->p_globals, module, pmodule) < 0) {
         Py_DECREF(pmodule);
+        Py_XDECREF(before);
         this->handle_error((char*)"failed to set module in globals");
         return MAX_ERR_GENERIC;
     }
 
     Py_DECREF(pmodule); // Dict took a reference
+    this->reload_track(before, module);
+    Py_XDECREF(before);
     this->log_debug((char*)"imported: %s", module);
     return MAX_ERR_NONE;
 }
@@ -1157,7 +1925,7 @@ t_max_err PythonInterpreter::import_module(char* module)
 PyObject* PythonInterpreter::eval_pcode(char* pcode)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     PyObject* pval = PyRun_String(pcode,
         Py_eval_input, this->p_globals, this->p_globals);
@@ -1181,17 +1949,21 @@ PyObject* PythonInterpreter::eval_pcode(char* pcode)
 t_max_err PythonInterpreter::exec_pcode(char* pcode)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
+    PyObject* before = this->reload_snapshot();
     PyObject* pval = PyRun_String(pcode,
         Py_single_input, this->p_globals, this->p_globals);
 
     if (pval == nullptr) {
+        Py_XDECREF(before);
         this->handle_error((char*)"exec %s", pcode);
         return MAX_ERR_GENERIC;
     }
 
     Py_DECREF(pval);
+    this->reload_track(before, nullptr);
+    Py_XDECREF(before);
     this->log_debug((char*)"exec %s", pcode);
     return MAX_ERR_NONE;
 }
@@ -1206,32 +1978,224 @@ t_max_err PythonInterpreter::exec_pcode(char* pcode)
 t_max_err PythonInterpreter::execfile_path(char* path)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     if (path == nullptr) {
         this->log_error((char*)"execfile_path: path is null");
         return MAX_ERR_GENERIC;
     }
 
-    // RAII file handle
-    FileGuard fhandle(path, "r");
-    if (!fhandle.is_open()) {
-        this->log_error((char*)"could not open file: %s", path);
+    // compiled once, then re-used while the file is unchanged
+    PyObject* co = this->compile_file(path);
+    if (co == nullptr) {
+        this->handle_error((char*)"execfile compile");
         return MAX_ERR_GENERIC;
     }
 
-    PyObject* pval = PyRun_File(fhandle, path, Py_file_input,
-                                this->p_globals, this->p_globals);
+    PyObject* before = this->reload_snapshot();
+    PyObject* pval = PyEval_EvalCode(co, this->p_globals, this->p_globals);
+    Py_DECREF(co);
 
     if (pval == nullptr) {
+        Py_XDECREF(before);
         this->handle_error((char*)"execfile");
         return MAX_ERR_GENERIC;
     }
 
     Py_DECREF(pval);
+    this->reload_track(before, nullptr);
+    Py_XDECREF(before);
     this->log_debug((char*)"executed file: %s", path);
     return MAX_ERR_NONE;
-    // File automatically closed by FileGuard destructor
+}
+
+
+// ---------------------------------------------------------------------------------------
+// HOT-RELOAD HELPERS
+
+/**
+ * @brief Get a hot-reload helper function
+ *
+ * @param name name of function in `PY_RELOAD_MODULE`
+ * @return borrowed reference to function (or nullptr)
+ *
+ * @note requires the GIL. The helpers are defined once and shared.
+ */
+PyObject* PythonInterpreter::reload_func(const char* name)
+{
+    if (s_reload_ns == nullptr) {
+        s_reload_ns = PyDict_New();
+        if (s_reload_ns == nullptr) {
+            return nullptr;
+        }
+        PyDict_SetItemString(s_reload_ns, "__builtins__", PyEval_GetBuiltins());
+        PyObject* pval = PyRun_String(PY_RELOAD_MODULE, Py_file_input,
+                                      s_reload_ns, s_reload_ns);
+        if (pval == nullptr) {
+            Py_CLEAR(s_reload_ns);
+            return nullptr;
+        }
+        Py_DECREF(pval);
+    }
+    return PyDict_GetItemString(s_reload_ns, name); // borrowed
+}
+
+
+/**
+ * @brief Snapshot the names of the currently loaded python modules
+ *
+ * @return new reference to a set of module names (or nullptr)
+ */
+PyObject* PythonInterpreter::reload_snapshot()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    PyObject* pfunc = this->reload_func("__reload_snapshot");
+    PyObject* before = pfunc ? PyObject_CallObject(pfunc, nullptr) : nullptr;
+    if (before == nullptr) {
+        PyErr_Clear(); // tracking is best-effort
+    }
+    return before;
+}
+
+
+/**
+ * @brief Track user modules imported since a snapshot
+ *
+ * @param before set of module names from `reload_snapshot` (may be nullptr)
+ * @param name module to track even if it was already loaded (may be nullptr)
+ *
+ * Files of newly tracked modules are queued for `watch_pending`.
+ */
+void PythonInterpreter::reload_track(PyObject* before, const char* name)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    if (before == nullptr || this->p_modules == nullptr) {
+        return;
+    }
+
+    PyObject* pfunc = this->reload_func("__reload_track");
+    PyObject* pname = name ? PyUnicode_FromString(name) : nullptr;
+    PyObject* paths = nullptr;
+    if (pfunc != nullptr) {
+        paths = PyObject_CallFunctionObjArgs(pfunc, before, this->p_modules,
+                                             pname ? pname : Py_None, nullptr);
+    }
+    if (paths == nullptr) {
+        PyErr_Clear(); // tracking is best-effort
+        Py_XDECREF(pname);
+        return;
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_Size(paths); i++) {
+        const char* path = PyUnicode_AsUTF8(PyList_GET_ITEM(paths, i));
+        if (path != nullptr) {
+            this->p_watch_pending.emplace_back(path);
+        }
+    }
+    Py_DECREF(paths);
+    Py_XDECREF(pname);
+}
+
+
+/**
+ * @brief Take the files of newly tracked modules
+ *
+ * @return paths to be watched by the owning external (e.g. via filewatcher)
+ */
+std::vector<std::string> PythonInterpreter::watch_pending()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::vector<std::string> paths;
+    paths.swap(this->p_watch_pending);
+    return paths;
+}
+
+
+/**
+ * @brief Reload changed tracked modules and their dependents
+ *
+ * @return t_max_err error code
+ *
+ * Only modules whose files changed are reloaded, followed by the tracked
+ * modules which depend on them. Names in globals bound to functions or
+ * classes of reloaded modules are rebound to the new definitions, so setup
+ * code run via `execfile` is not re-executed.
+ */
+t_max_err PythonInterpreter::reload()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    PyObject* pfunc = this->reload_func("__reload");
+    if (pfunc == nullptr || this->p_modules == nullptr) {
+        this->handle_error((char*)"reload helpers unavailable");
+        return MAX_ERR_GENERIC;
+    }
+
+    PyObject* before = this->reload_snapshot();
+    PyObject* reloaded = PyObject_CallFunctionObjArgs(pfunc, this->p_modules,
+                                                      this->p_globals, nullptr);
+    if (reloaded == nullptr) {
+        Py_XDECREF(before);
+        this->handle_error((char*)"reload");
+        return MAX_ERR_GENERIC;
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_Size(reloaded); i++) {
+        this->log_info((char*)"reloaded: %s",
+                       PyUnicode_AsUTF8(PyList_GET_ITEM(reloaded, i)));
+    }
+
+    // reloaded modules keep their identity: force bindings to re-resolve
+    if (PyList_Size(reloaded) > 0) {
+        for (auto& item : this->p_bindings) {
+            Py_CLEAR(item.second.root);
+        }
+    }
+
+    this->reload_track(before, nullptr);
+    Py_XDECREF(before);
+    Py_DECREF(reloaded);
+    return MAX_ERR_NONE;
+}
+
+
+// ---------------------------------------------------------------------------------------
+// BYTECODE CACHE HELPERS
+
+/**
+ * @brief Compile a python source file to a code object, using the cache
+ *
+ * Looks up the in-memory cache (shared by all instances), then the on-disk
+ * cache, both validated by a hash of the source (see mamba/codecache.h),
+ * before compiling from source. Caller must hold the GIL.
+ *
+ * @param path absolute path of python source file
+ * @return PyObject* code object (new reference) or nullptr with exception set
+ */
+PyObject* PythonInterpreter::compile_file(char* path)
+{
+    t_codecache_hit hit;
+    PyObject* co = codecache_compile(&s_code_cache, path, this->p_cache, &hit);
+    if (co == nullptr) {
+        return nullptr;
+    }
+
+    switch (hit) {
+    case CODECACHE_MEMORY:
+        this->log_debug((char*)"bytecode cache hit (memory): %s", path);
+        break;
+    case CODECACHE_DISK:
+        this->log_debug((char*)"bytecode cache hit (disk): %s", path);
+        break;
+    default:
+        this->log_debug((char*)"compiled: %s", path);
+    }
+    return co;
 }
 
 
@@ -1245,7 +2209,7 @@ t_max_err PythonInterpreter::execfile_path(char* path)
 PyObject* PythonInterpreter::eval_text(char* text)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     PyObject* co = nullptr;
     PyObject* pval = nullptr;
@@ -1401,26 +2365,156 @@ t_max_err PythonInterpreter::eval_text_to_outlet(long argc, t_atom* argv, int of
 // EXTRA METHODS
 
 /**
- * @brief Converts a Max list to call a python function with arguments
+ * @brief Resolves a (dotted) python name to a callable
  *
- * @param s symbol
+ * The first segment is looked up in the object's globals, then in builtins;
+ * remaining segments are resolved with getattr.
+ *
+ * @param name python name, e.g. `f` or `math.sin`
+ * @param root if not null, receives the first-segment object (new reference)
+ *
+ * @return PyObject* callable (new reference) or nullptr with error set
+ */
+PyObject* PythonInterpreter::resolve(const char* name, PyObject** root)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    std::string path(name);
+    size_t dot = path.find('.');
+    std::string head = path.substr(0, dot);
+
+    PyObject* obj = PyDict_GetItemString(this->p_globals, head.c_str()); // borrowed
+    if (obj == nullptr) {
+        obj = PyDict_GetItemString(PyEval_GetBuiltins(), head.c_str()); // borrowed
+    }
+    if (obj == nullptr) {
+        PyErr_Format(PyExc_NameError, "name '%s' is not defined", head.c_str());
+        return nullptr;
+    }
+    Py_INCREF(obj);
+    if (root != nullptr) {
+        Py_INCREF(obj);
+        *root = obj;
+    }
+
+    while (dot != std::string::npos) {
+        size_t next = path.find('.', dot + 1);
+        std::string attr = path.substr(dot + 1, next - dot - 1);
+        PyObject* child = PyObject_GetAttrString(obj, attr.c_str());
+        Py_DECREF(obj);
+        if (child == nullptr) {
+            if (root != nullptr) {
+                Py_CLEAR(*root);
+            }
+            return nullptr;
+        }
+        obj = child;
+        dot = next;
+    }
+
+    if (!PyCallable_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "'%s' is not callable", name);
+        Py_DECREF(obj);
+        if (root != nullptr) {
+            Py_CLEAR(*root);
+        }
+        return nullptr;
+    }
+    return obj;
+}
+
+
+/**
+ * @brief Calls a python callable with atoms via vectorcall and outputs the result
+ *
+ * Up to PY_STACK_ARGS arguments are converted into a stack array; if the
+ * callable rejects them with a TypeError, it is retried with all arguments
+ * as a single list.
+ *
+ * @param func python callable (borrowed)
+ * @param fname name used in error messages
  * @param argc atom argument count
  * @param argv atom argument vector
  * @param outlet object outlet
  *
  * @return t_max_err error code
  */
-t_max_err PythonInterpreter::call(t_symbol* s, long argc, t_atom* argv, void* outlet)
+t_max_err PythonInterpreter::call_func(PyObject* func, const char* fname,
+                                       long argc, t_atom* argv, void* outlet)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
-    PyObject* py_callable = nullptr;
-    PyObject* py_argslist = nullptr;
-    PyObject* py_args = nullptr;
+    PyObject* stack[PY_STACK_ARGS + 1];
+    std::vector<PyObject*> heap;
+    PyObject** args = stack + 1; // slot 0 is scratch for ARGUMENTS_OFFSET
     PyObject* pval = nullptr;
+    long nargs = 0;
     t_max_err result = MAX_ERR_GENERIC;
 
+    if (argc > PY_STACK_ARGS) {
+        heap.resize(argc + 1);
+        args = heap.data() + 1;
+    }
+
+    for (; nargs < argc; nargs++) {
+        args[nargs] = this->atom_to_pobject(argv + nargs);
+        if (args[nargs] == nullptr) {
+            this->handle_error((char*)"call %s: argument conversion failed", fname);
+            goto cleanup;
+        }
+    }
+    metrics_convert(s_span);
+
+    pval = PyObject_Vectorcall(func, args,
+                               nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, nullptr);
+
+    // If TypeError, try calling with list as single argument
+    if (pval == nullptr && nargs > 0 && PyErr_ExceptionMatches(PyExc_TypeError)) {
+        PyErr_Clear();
+        PyObject* plist = PyList_New(nargs);
+        if (plist != nullptr) {
+            for (long i = 0; i < nargs; i++) {
+                Py_INCREF(args[i]);
+                PyList_SET_ITEM(plist, i, args[i]);
+            }
+            pval = PyObject_CallFunctionObjArgs(func, plist, nullptr);
+            Py_DECREF(plist);
+        }
+    }
+
+    if (pval == nullptr) {
+        this->handle_error((char*)"call %s failed", fname);
+        goto cleanup;
+    }
+
+    this->handle_output(outlet, pval); // handle_output takes ownership
+    result = MAX_ERR_NONE;
+
+cleanup:
+    for (long i = 0; i < nargs; i++) {
+        Py_DECREF(args[i]);
+    }
+    return result;
+}
+
+
+/**
+ * @brief Converts a Max list to call a python function with arguments
+ *
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet object outlet
+ *
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::call(t_symbol* s, long argc, t_atom* argv, void* outlet)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
     // first atom in argv must be a symbol
     if (argc < 1 || argv->a_type != A_SYM) {
         this->log_error((char*)"call: first argument must be a symbol (callable name)");
@@ -1430,66 +2524,162 @@ t_max_err PythonInterpreter::call(t_symbol* s, long argc, t_atom* argv, void* ou
     char* callable_name = atom_getsym(argv)->s_name;
     this->log_debug((char*)"callable_name: %s", callable_name);
 
-    py_callable = PyRun_String(callable_name, Py_eval_input,
-                               this->p_globals, this->p_globals);
+    PyObject* py_callable = this->resolve(callable_name, nullptr);
     if (py_callable == nullptr) {
-        this->handle_error((char*)"could not evaluate %s", callable_name);
-        goto cleanup;
+        this->handle_error((char*)"could not resolve %s", callable_name);
+        return MAX_ERR_GENERIC;
     }
 
-    if (!PyCallable_Check(py_callable)) {
-        this->log_error((char*)"%s is not callable", callable_name);
-        goto cleanup;
+    t_max_err result = this->call_func(py_callable, callable_name,
+                                       argc - 1, argv + 1, outlet);
+    Py_DECREF(py_callable);
+    return result;
+}
+
+
+/**
+ * @brief Binds a message selector to a pre-resolved python callable
+ *
+ * After `bind <name> <pyfunc>`, a `<name> [args]` message calls `pyfunc`
+ * like `call pyfunc [args]` without re-resolving the name each time.
+ * `bind <name>` removes the binding.
+ *
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::bind(t_symbol* s, long argc, t_atom* argv)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    if (argc < 1 || argv->a_type != A_SYM
+        || (argc > 1 && argv[1].a_type != A_SYM)) {
+        this->log_error((char*)"usage: bind <name> [pyfunc]");
+        return MAX_ERR_GENERIC;
     }
 
-    py_argslist = this->atoms_to_plist_with_offset(argc, argv, 1);
-    if (py_argslist == nullptr) {
-        this->log_error((char*)"atom to py list conversion failed");
-        goto cleanup;
+    t_symbol* selector = atom_getsym(argv);
+
+    auto it = this->p_bindings.find(selector);
+    if (it != this->p_bindings.end()) {
+        Py_XDECREF(it->second.key);
+        Py_XDECREF(it->second.root);
+        Py_XDECREF(it->second.func);
+        this->p_bindings.erase(it);
     }
 
-    this->log_debug((char*)"argc:%ld list size: %d", argc, (int)PyList_Size(py_argslist));
+    if (argc < 2) {
+        this->log_debug((char*)"unbound %s", selector->s_name);
+        return MAX_ERR_NONE;
+    }
 
-    // Try calling with unpacked arguments
-    py_args = PyList_AsTuple(py_argslist);
-    if (py_args == nullptr) {
-        this->log_error((char*)"unable to convert args list to tuple");
-        goto cleanup;
+    const char* fname = atom_getsym(argv + 1)->s_name;
+
+    PyBinding binding;
+    binding.name = fname;
+    binding.func = this->resolve(fname, &binding.root);
+    if (binding.func == nullptr) {
+        this->handle_error((char*)"bind: could not resolve %s", fname);
+        return MAX_ERR_GENERIC;
+    }
+    binding.key = PyUnicode_InternFromString(
+        binding.name.substr(0, binding.name.find('.')).c_str());
+    if (binding.key == nullptr) {
+        Py_DECREF(binding.root);
+        Py_DECREF(binding.func);
+        this->handle_error((char*)"bind: could not intern %s", fname);
+        return MAX_ERR_GENERIC;
     }
 
-    pval = PyObject_CallObject(py_callable, py_args);
-    if (pval != nullptr) {
-        // Success with unpacked arguments
-        this->handle_output(outlet, pval); // handle_output takes ownership
-        result = MAX_ERR_NONE;
-        goto cleanup;
+    this->p_bindings[selector] = binding;
+    this->log_debug((char*)"bound %s -> %s", selector->s_name, fname);
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Checks whether a selector has a bound python callable
+ *
+ * @param s selector
+ * @return bool true if bound
+ */
+bool PythonInterpreter::is_bound(t_symbol* s)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return this->p_bindings.find(s) != this->p_bindings.end();
+}
+
+
+/**
+ * @brief Calls the python callable bound to a selector
+ *
+ * The binding is revalidated with one dict lookup: if the first name segment
+ * no longer maps to the object seen at bind time (e.g. the function was
+ * redefined) or its module was reloaded, the callable is resolved again.
+ * Dotted names are always resolved again, since `mod.f = g` leaves the
+ * first segment unchanged.
+ *
+ * @param s selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet object outlet
+ *
+ * @return t_max_err error code
+ */
+t_max_err PythonInterpreter::call_bound(t_symbol* s, long argc, t_atom* argv,
+                                        void* outlet)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    GILGuard gil(this->p_memstats);
+
+    auto it = this->p_bindings.find(s);
+    if (it == this->p_bindings.end()) {
+        return MAX_ERR_GENERIC;
     }
+    PyBinding& binding = it->second;
 
-    // If TypeError, try calling with list as single argument
-    if (PyErr_ExceptionMatches(PyExc_TypeError)) {
-        PyErr_Clear();
-        Py_XDECREF(py_args);
-        py_args = nullptr;
+    PyObject* current = PyDict_GetItem(this->p_globals, binding.key); // borrowed
+    if (current == nullptr) {
+        current = PyDict_GetItem(PyEval_GetBuiltins(), binding.key); // borrowed
+    }
 
-        pval = PyObject_CallFunctionObjArgs(py_callable, py_argslist, nullptr);
-        if (pval != nullptr) {
-            this->handle_output(outlet, pval); // handle_output takes ownership
-            result = MAX_ERR_NONE;
-            goto cleanup;
+    bool dotted = binding.name.find('.') != std::string::npos;
+    if (binding.root == nullptr || current != binding.root || dotted) {
+        PyObject* root = nullptr;
+        PyObject* func = this->resolve(binding.name.c_str(), &root);
+        if (func == nullptr) {
+            this->handle_error((char*)"%s: bound %s no longer resolves",
+                               s->s_name, binding.name.c_str());
+            return MAX_ERR_GENERIC;
         }
+        if (!dotted) {
+            this->log_debug((char*)"rebound %s -> %s", s->s_name, binding.name.c_str());
+        }
+        Py_XDECREF(binding.root);
+        Py_DECREF(binding.func);
+        binding.root = root;
+        binding.func = func;
     }
 
-    this->handle_error((char*)"call %s failed", callable_name);
+    return this->call_func(binding.func, binding.name.c_str(), argc, argv, outlet);
+}
 
-cleanup:
-    Py_XDECREF(py_callable);
-    Py_XDECREF(py_argslist);
-    Py_XDECREF(py_args);
-    // Note: pval ownership transferred to handle_output if successful
-    if (result != MAX_ERR_NONE) {
-        Py_XDECREF(pval);
+
+/**
+ * @brief Releases all bindings (caller holds the GIL)
+ */
+void PythonInterpreter::bind_clear()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    for (auto& item : this->p_bindings) {
+        Py_XDECREF(item.second.key);
+        Py_XDECREF(item.second.root);
+        Py_XDECREF(item.second.func);
     }
-    return result;
+    this->p_bindings.clear();
 }
 
 /**
@@ -1507,7 +2697,7 @@ cleanup:
 t_max_err PythonInterpreter::assign(t_symbol* s, long argc, t_atom* argv)
 {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    GILGuard gil;
+    GILGuard gil(this->p_memstats);
 
     PyObject* list = nullptr;
 
@@ -1606,6 +2796,22 @@ t_max_err PythonInterpreter::anything(t_symbol* s, long argc, t_atom* argv,
         return MAX_ERR_GENERIC;
     }
 
+    else if (s == gensym("cache")) {
+        if (argc == 0) {
+            this->log_info((char*)"property cache: %d", (int)this->p_cache);
+            return MAX_ERR_NONE;
+        }
+
+        if (argc == 1) {
+            if ((argv)->a_type == A_LONG) {
+                this->log_info((char*)"setting cache to %d", atom_getlong(argv));
+                this->p_cache = atom_getlong(argv) != 0;
+                return MAX_ERR_NONE;
+            }
+        }
+        return MAX_ERR_GENERIC;
+    }
+
     else if (s == gensym("log_level")) {
         if (argc == 0) {
             this->log_info((char*)"property log_level: %d", 
@@ -1623,6 +2829,10 @@ t_max_err PythonInterpreter::anything(t_symbol* s, long argc, t_atom* argv,
         return MAX_ERR_GENERIC;
     }
     
+    else if (this->is_bound(s)) {
+        return this->call_bound(s, argc, argv, outlet);
+    }
+
     else {
 
         // set symbol as first atom in new atoms array
@@ -1724,7 +2934,7 @@ t_max_err PythonInterpreter::pipe(t_symbol* s, long argc, t_atom* argv, void* ou
             if (unicode_result == NULL) {
                 goto error;
             }
-            outlet_anything(outlet, gensym(unicode_result), 0, (t_atom*)NIL);
+            this->send_result(PY_RESULT_ANYTHING, outlet, gensym(unicode_result), 0, NULL);
             Py_XDECREF(pval);
         }
 
@@ -1,145 +1,1096 @@
+/**
+ * @file jmx.c
+ * @brief jupyter kernel endpoint for the embedded python interpreter
+ *
+ * jmx binds the five sockets of the jupyter messaging protocol (shell, iopub,
+ * stdin, control and heartbeat), writes a connection file, and runs
+ * `execute_request`s on a python worker thread so that a notebook or
+ * `jupyter console --existing <file>` can drive a running patch without
+ * blocking the max scheduler.
+ *
+ * threads:
+ *
+ * - the socket thread owns every zmq socket. It answers heartbeats and the
+ *   requests that need no python (`kernel_info`, `comm_info`, `shutdown`,
+ *   `interrupt`) and queues the rest for the worker. It never takes the GIL
+ *   except to raise KeyboardInterrupt in the worker.
+ * - the worker thread runs queued requests with sys.stdout, sys.stderr and
+ *   sys.displayhook redirected to iopub messages.
+ * - the main thread starts/stops both and emits notifications via a qelem.
+ *
+ * every outgoing message (from any thread) is pushed through an inproc pipe
+ * to the socket thread which forwards it to the destination socket, so no
+ * zmq socket is ever shared between threads.
+ */
+
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
-
-#include <uuid/uuid.h>
+#include <sys/stat.h>
 #include <time.h> /* for struct tm, localtime_r */
 #include <sys/time.h> /* for gettimeofday */
 
 #include "ext.h"
 #include "ext_obex.h"
 #include "ext_systhread.h"
-#include "ext_dictionary.h"
-#include "commonsyms.h"
+
+#define PY_IMPLEMENTATION // <-- activate the implementation
+#include "py.h"           // <-- include this
 
 #include <zmq.h>
+#include <sodium.h>
 
 // derived from max-sdk/sources/advanced/simplethread
 
+#define JMX_PROTOCOL_VERSION "5.3"
+#define JMX_DELIM "<IDS|MSG>"
+#define JMX_DELIM_LEN 9
+#define JMX_MAX_FRAMES 32
+#define JMX_SIG_LEN (crypto_auth_hmacsha256_BYTES * 2)
+#define JMX_KEY_MAX 128
+#define JMX_STOP "stop"
+
+// message frames after the delimiter
+#define jmx_req_signature(r) ((r)->frame[(r)->delim + 1])
+#define jmx_req_header(r)    ((r)->frame[(r)->delim + 2])
+#define jmx_req_content(r)   ((r)->frame[(r)->delim + 5])
+
+enum {
+    JMX_SHELL,
+    JMX_IOPUB,
+    JMX_STDIN,
+    JMX_CONTROL,
+    JMX_HB,
+    JMX_NCHANNELS
+};
+
+static const char* jmx_channel_names[JMX_NCHANNELS] = {
+    "shell", "iopub", "stdin", "control", "hb"
+};
+
+
+/**
+ * @brief growable string used to build json
+ */
+typedef struct _jmx_buf {
+    char* data;
+    size_t len;
+    size_t cap;
+    int failed;                             // an allocation failed
+} t_jmx_buf;
+
+
+/**
+ * @brief received multipart message
+ *
+ * frames before `delim` are routing identities; frames are NUL-terminated
+ */
+typedef struct _jmx_request {
+    struct _jmx_request* next;
+    int channel;
+    int nframes;
+    int delim;                              // index of the <IDS|MSG> delimiter
+    char* frame[JMX_MAX_FRAMES];
+    size_t size[JMX_MAX_FRAMES];
+    char* msg_type;
+} t_jmx_request;
+
+
+/**
+ * @brief list queued by python `outlet()` for the main thread
+ */
+typedef struct _jmx_atoms {
+    struct _jmx_atoms* next;
+    long argc;
+    t_atom argv[1];
+} t_jmx_atoms;
+
+
 typedef struct _jmx {
     t_object            x_ob;                   // standard max object
-    t_systhread         x_systhread;            // thread reference
-    t_systhread_mutex   x_mutex;                // mutual exclusion lock for threadsafety
+    t_py*               py;                     // embedded interpreter
+    PyThreadState*      x_tstate;               // main thread state while the GIL is released
+    t_systhread         x_systhread;            // socket thread
+    t_systhread_mutex   x_mutex;                // guards the notifications below
     int                 x_systhread_cancel;     // thread cancel flag
-    void                *x_qelem;               // for message passing between threads
-    void                *x_outlet;              // our outlet
-    int                 x_foo;                  // simple data to pass between threads
-    int                 x_sleeptime;            // how many milliseconds to sleep
+    void*               x_qelem;                // for message passing between threads
+    void*               x_outlet;               // our outlet
+
+    // sockets (owned by the socket thread while it runs)
+    void*               x_ctx;                  // zmq context
+    void*               x_socket[JMX_NCHANNELS];
+    void*               x_pull;                 // socket thread end of the inproc pipe
+    void*               x_push;                 // every other thread's end
+    t_systhread_mutex   x_push_mutex;           // guards x_push
+
+    // connection
+    char                x_transport[16];
+    char                x_ip[64];
+    int                 x_port[JMX_NCHANNELS];
+    char                x_key[JMX_KEY_MAX + 1];
+    size_t              x_keylen;
+    char                x_session[37];          // kernel session id
+    char                x_connection_file[MAX_PATH_CHARS];
+    int                 x_owns_connection_file; // written by us: removed on stop
+
+    // python worker
+    t_systhread         x_worker;
+    t_systhread_mutex   x_job_mutex;
+    t_systhread_cond    x_job_cond;
+    t_jmx_request*      x_job_head;
+    t_jmx_request*      x_job_tail;
+    int                 x_worker_cancel;
+    unsigned long       x_worker_ident;         // python thread id of the worker
+    t_jmx_request*      x_job;                  // request being run (GIL)
+    int                 x_silent;               // suppress iopub output of x_job
+    long                x_execution_count;
+    PyObject*           x_runner;               // _jmx_run helper
+    PyObject*           x_stdout;
+    PyObject*           x_stderr;
+    PyObject*           x_displayhook;
+
+    // notifications for the main thread (x_mutex)
+    t_symbol*           x_state;                // last execution_state
+    int                 x_state_changed;
+    int                 x_shutdown;             // shutdown_request received
+    t_jmx_atoms*        x_atoms_head;
+    t_jmx_atoms*        x_atoms_tail;
 } t_jmx;
 
 
-void jmx_bang(t_jmx *x);
-void jmx_foo(t_jmx *x, long foo);
-void jmx_sleeptime(t_jmx *x, long sleeptime);
-void jmx_stop(t_jmx *x);
-void jmx_cancel(t_jmx *x);
-void *jmx_threadproc(t_jmx *x);
-void jmx_qfn(t_jmx *x);
-void jmx_assist(t_jmx *x, void *b, long m, long a, char *s);
-void jmx_free(t_jmx *x);
-void *jmx_new(void);
+void jmx_bang(t_jmx* x);
+void jmx_start(t_jmx* x, t_symbol* s);
+void jmx_stop(t_jmx* x);
+void jmx_interrupt(t_jmx* x);
+void* jmx_threadproc(t_jmx* x);
+void jmx_qfn(t_jmx* x);
+void jmx_assist(t_jmx* x, void* b, long m, long a, char* s);
+void jmx_free(t_jmx* x);
+void* jmx_new(void);
+
+// kernel
+t_max_err jmx_connection_read(t_jmx* x, const char* path);
+t_max_err jmx_connection_write(t_jmx* x, const char* path);
+t_max_err jmx_bind(t_jmx* x);
+void jmx_dispatch(t_jmx* x, t_jmx_request* req);
+int jmx_forward(t_jmx* x);
+int jmx_emit(t_jmx* x, int channel, const t_jmx_request* parent,
+             const char* msg_type, const char* content);
+void jmx_status(t_jmx* x, const t_jmx_request* parent, const char* state);
+void jmx_uuid(char* out);
+void jmx_timestamp(char* out, size_t size);
 
-void jmx_msg(t_jmx* x);
-t_symbol* get_uuid(void);
-t_symbol* get_timestamp(void);
-void jmx_msg_create(t_jmx* x, const char* username, const char* msg_type, const char* code);
+// python worker
+void jmx_worker_start(t_jmx* x);
+void jmx_worker_stop(t_jmx* x);
+void* jmx_workerproc(t_jmx* x);
+void jmx_submit(t_jmx* x, t_jmx_request* req);
+void jmx_run_job(t_jmx* x, t_jmx_request* req);
+void jmx_execute(t_jmx* x, t_jmx_request* req);
+void jmx_is_complete(t_jmx* x, t_jmx_request* req);
 
-t_class *jmx_class;
+t_class* jmx_class;
 
-void ext_main(void *r)
+
+void ext_main(void* r)
 {
-    t_class *c;
+    t_class* c;
 
     c = class_new("jmx", (method)jmx_new, (method)jmx_free, sizeof(t_jmx), 0L, 0);
 
     class_addmethod(c, (method)jmx_bang,        "bang",         0);
-    class_addmethod(c, (method)jmx_msg,         "msg",          0);
-    class_addmethod(c, (method)jmx_foo,         "foo",          A_DEFLONG, 0);
-    class_addmethod(c, (method)jmx_sleeptime,   "sleeptime",    A_DEFLONG, 0);
-    class_addmethod(c, (method)jmx_cancel,      "cancel",       0);
+    class_addmethod(c, (method)jmx_start,       "start",        A_DEFSYM, 0);
+    class_addmethod(c, (method)jmx_stop,        "stop",         0);
+    class_addmethod(c, (method)jmx_interrupt,   "interrupt",    0);
     class_addmethod(c, (method)jmx_assist,      "assist",       A_CANT, 0);
 
-    class_register(CLASS_BOX,c);
+    class_register(CLASS_BOX, c);
     jmx_class = c;
+}
+
+
+/*--------------------------------------------------------------------------*/
+// json
+
+static void jmx_buf_cat(t_jmx_buf* b, const char* s, size_t n)
+{
+    if (b->failed) {
+        return;
+    }
+    if (b->len + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        char* data;
+        while (cap < b->len + n + 1) {
+            cap *= 2;
+        }
+        if ((data = (char*)realloc(b->data, cap)) == NULL) {
+            b->failed = 1;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
 
-    common_symbols_init();
+static void jmx_buf_puts(t_jmx_buf* b, const char* s)
+{
+    jmx_buf_cat(b, s, strlen(s));
 }
 
-void jmx_bang(t_jmx *x)
+static void jmx_buf_printf(t_jmx_buf* b, const char* fmt, ...)
 {
-    jmx_stop(x);        // kill thread if, any
+    char tmp[512];
+    va_list args;
+    int n;
 
-    // create new thread + begin execution
-    if (x->x_systhread == NULL) {
-        post("starting a new thread");
-        systhread_create((method) jmx_threadproc, x, 0, 0, 0, &x->x_systhread);
+    va_start(args, fmt);
+    n = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    if (n < 0 || n >= (int)sizeof(tmp)) {
+        b->failed = 1;
+        return;
     }
+    jmx_buf_cat(b, tmp, (size_t)n);
 }
 
-void jmx_foo(t_jmx *x, long foo)
+/**
+ * @brief Append `s` as a quoted json string (utf-8 passes through)
+ */
+static void jmx_buf_str(t_jmx_buf* b, const char* s, size_t n)
 {
-    systhread_mutex_lock(x->x_mutex);
-    x->x_foo = (int)foo;    // override our current value
-    systhread_mutex_unlock(x->x_mutex);
+    const char* run = s;
+    const char* end = s + n;
+    char esc[8];
+
+    jmx_buf_cat(b, "\"", 1);
+    for (; s < end; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        jmx_buf_cat(b, run, s - run);
+        switch (c) {
+        case '"':  jmx_buf_cat(b, "\\\"", 2); break;
+        case '\\': jmx_buf_cat(b, "\\\\", 2); break;
+        case '\n': jmx_buf_cat(b, "\\n", 2); break;
+        case '\r': jmx_buf_cat(b, "\\r", 2); break;
+        case '\t': jmx_buf_cat(b, "\\t", 2); break;
+        default:
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            jmx_buf_cat(b, esc, 6);
+        }
+        run = s + 1;
+    }
+    jmx_buf_cat(b, run, end - run);
+    jmx_buf_cat(b, "\"", 1);
 }
 
-void jmx_sleeptime(t_jmx *x, long sleeptime)
+static const char* jmx_json_ws(const char* p)
 {
-    if (sleeptime<10)
-        sleeptime = 10;
-    x->x_sleeptime = (int)sleeptime;    // no need to lock since we are readonly in worker thread
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
 }
 
+/**
+ * @brief Skip one json value
+ *
+ * @return pointer past the value, NULL if malformed
+ */
+static const char* jmx_json_skip(const char* p)
+{
+    int depth = 0;
 
-void jmx_stop(t_jmx *x)
+    p = jmx_json_ws(p);
+    do {
+        switch (*p) {
+        case '\0':
+            return NULL;
+        case '"':
+            for (p++; *p != '"'; p++) {
+                if (*p == '\0' || (*p == '\\' && *++p == '\0')) {
+                    return NULL;
+                }
+            }
+            p++;
+            break;
+        case '{':
+        case '[':
+            depth++;
+            p++;
+            break;
+        case '}':
+        case ']':
+            if (--depth < 0) {
+                return NULL;
+            }
+            p++;
+            break;
+        default:
+            if (depth == 0) { // number, true, false, null
+                while (*p && !strchr(",}] \t\r\n", *p)) {
+                    p++;
+                }
+                return p;
+            }
+            p++;
+        }
+    } while (depth > 0);
+    return p;
+}
+
+/**
+ * @brief Find the value of a top-level key of a json object
+ *
+ * @return pointer to the value, NULL if absent or malformed
+ */
+static const char* jmx_json_find(const char* json, const char* key)
 {
-    unsigned int ret;
+    size_t n = strlen(key);
+    const char* p = jmx_json_ws(json);
+    const char* k;
+    int match;
 
-    if (x->x_systhread) {
-        post("stopping our thread");
-        x->x_systhread_cancel = true;               // tell the thread to stop
-        systhread_join(x->x_systhread, &ret);       // wait for the thread to stop
-        x->x_systhread = NULL;
+    if (*p++ != '{') {
+        return NULL;
+    }
+    while (1) {
+        p = jmx_json_ws(p);
+        if (*p != '"') {
+            return NULL;
+        }
+        k = p + 1;
+        if ((p = jmx_json_skip(p)) == NULL) {
+            return NULL;
+        }
+        match = (size_t)(p - k - 1) == n && memcmp(k, key, n) == 0;
+        p = jmx_json_ws(p);
+        if (*p++ != ':') {
+            return NULL;
+        }
+        p = jmx_json_ws(p);
+        if (match) {
+            return p;
+        }
+        if ((p = jmx_json_skip(p)) == NULL) {
+            return NULL;
+        }
+        p = jmx_json_ws(p);
+        if (*p++ != ',') {
+            return NULL;
+        }
+    }
+}
+
+static int jmx_hex4(const char* p, unsigned* out)
+{
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
     }
+    *out = v;
+    return 0;
 }
 
+/**
+ * @brief Get a top-level string member (unescaped)
+ *
+ * @return new string to be freed with sysmem_freeptr, NULL if absent
+ */
+static char* jmx_json_get_str(const char* json, const char* key)
+{
+    const char* p = jmx_json_find(json, key);
+    const char* end;
+    char* out;
+    char* o;
+    unsigned cp, lo;
 
-void jmx_cancel(t_jmx *x)
+    if (p == NULL || *p != '"' || (end = jmx_json_skip(p)) == NULL) {
+        return NULL;
+    }
+    // unescaping never grows the string
+    if ((out = o = (char*)sysmem_newptr(end - p)) == NULL) {
+        return NULL;
+    }
+    for (p++, end--; p < end; p++) {
+        if (*p != '\\') {
+            *o++ = *p;
+            continue;
+        }
+        switch (*++p) {
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'n': *o++ = '\n'; break;
+        case 'r': *o++ = '\r'; break;
+        case 't': *o++ = '\t'; break;
+        case 'u':
+            if (end - p < 5 || jmx_hex4(p + 1, &cp) < 0) {
+                *o++ = '?';
+                break;
+            }
+            p += 4;
+            if (cp >= 0xd800 && cp < 0xdc00 && end - p >= 7 && p[1] == '\\'
+                && p[2] == 'u' && jmx_hex4(p + 3, &lo) == 0
+                && lo >= 0xdc00 && lo < 0xe000) {
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                p += 6;
+            }
+            if (cp < 0x80) {
+                *o++ = (char)cp;
+            } else if (cp < 0x800) {
+                *o++ = (char)(0xc0 | (cp >> 6));
+                *o++ = (char)(0x80 | (cp & 0x3f));
+            } else if (cp < 0x10000) {
+                *o++ = (char)(0xe0 | (cp >> 12));
+                *o++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+                *o++ = (char)(0x80 | (cp & 0x3f));
+            } else {
+                *o++ = (char)(0xf0 | (cp >> 18));
+                *o++ = (char)(0x80 | ((cp >> 12) & 0x3f));
+                *o++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+                *o++ = (char)(0x80 | (cp & 0x3f));
+            }
+            break;
+        default: // '"', '\\', '/'
+            *o++ = *p;
+        }
+    }
+    *o = '\0';
+    return out;
+}
+
+static long jmx_json_get_long(const char* json, const char* key, long dflt)
 {
-    jmx_stop(x);                                    // kill thread if, any
-    outlet_anything(x->x_outlet, gensym("cancelled"), 0, NULL);
+    const char* p = jmx_json_find(json, key);
+    char* end;
+    long v;
+
+    if (p == NULL) {
+        return dflt;
+    }
+    v = strtol(p, &end, 10);
+    return end == p ? dflt : v;
 }
 
-void* jmx_threadproc(t_jmx* x)
+static int jmx_json_get_bool(const char* json, const char* key, int dflt)
+{
+    const char* p = jmx_json_find(json, key);
+
+    if (p && strncmp(p, "true", 4) == 0) {
+        return 1;
+    }
+    if (p && strncmp(p, "false", 5) == 0) {
+        return 0;
+    }
+    return dflt;
+}
+
+
+/*--------------------------------------------------------------------------*/
+// wire protocol
+
+/**
+ * @brief hex HMAC-SHA256 of header, parent header, metadata and content
+ *
+ * an empty key disables signing (empty signature)
+ */
+static void jmx_sign(t_jmx* x, char* const* parts, const size_t* sizes, char* out)
+{
+    crypto_auth_hmacsha256_state state;
+    unsigned char mac[crypto_auth_hmacsha256_BYTES];
+
+    if (x->x_keylen == 0) {
+        out[0] = '\0';
+        return;
+    }
+    crypto_auth_hmacsha256_init(&state, (const unsigned char*)x->x_key, x->x_keylen);
+    for (int i = 0; i < 4; i++) {
+        crypto_auth_hmacsha256_update(&state, (const unsigned char*)parts[i], sizes[i]);
+    }
+    crypto_auth_hmacsha256_final(&state, mac);
+    sodium_bin2hex(out, JMX_SIG_LEN + 1, mac, sizeof(mac));
+}
+
+static int jmx_verify(t_jmx* x, const t_jmx_request* req)
+{
+    char sig[JMX_SIG_LEN + 1];
+
+    if (x->x_keylen == 0) {
+        return 1;
+    }
+    jmx_sign(x, &req->frame[req->delim + 2], &req->size[req->delim + 2], sig);
+    return req->size[req->delim + 1] == JMX_SIG_LEN
+        && sodium_memcmp(sig, jmx_req_signature(req), JMX_SIG_LEN) == 0;
+}
+
+static void jmx_request_free(t_jmx_request* req)
 {
+    for (int i = 0; i < req->nframes; i++) {
+        sysmem_freeptr(req->frame[i]);
+    }
+    if (req->msg_type) {
+        sysmem_freeptr(req->msg_type);
+    }
+    sysmem_freeptr(req);
+}
 
-    post("Connecting to hello world server…\n");
-    void* context = zmq_ctx_new();
-    void* requester = zmq_socket(context, ZMQ_REQ);
-    zmq_connect(requester, "tcp://localhost:5555");
+/**
+ * @brief Receive a complete multipart message
+ *
+ * frames beyond JMX_MAX_FRAMES (extra buffers) are dropped.
+ *
+ * @return new request, NULL if it is not a jupyter message
+ */
+static t_jmx_request* jmx_recv(void* sock, int channel)
+{
+    t_jmx_request* req = (t_jmx_request*)sysmem_newptrclear(sizeof(t_jmx_request));
+    zmq_msg_t part;
+    int more = 1;
+    int ok = req != NULL;
 
-    int request_nbr = 0;
-    post("request_nbr: %i", request_nbr);
-    for (request_nbr = 0; request_nbr != 10; request_nbr++) {
-        if (x->x_systhread_cancel) {
-            post("cancelling thread process");
+    if (req) {
+        req->channel = channel;
+        req->delim = -1;
+    }
+    while (more) {
+        zmq_msg_init(&part);
+        if (zmq_msg_recv(&part, sock, 0) < 0) {
+            zmq_msg_close(&part);
+            ok = 0;
             break;
         }
-        char buffer[10];
-        post("Sending Hello %d…\n", request_nbr);
-        zmq_send(requester, "Hello", 5, 0);
-        zmq_recv(requester, buffer, 10, 0);
-        post("Received World %d\n", request_nbr);
+        more = zmq_msg_more(&part);
+        if (ok && req->nframes < JMX_MAX_FRAMES) {
+            size_t size = zmq_msg_size(&part);
+            char* frame = (char*)sysmem_newptr(size + 1);
+            if (frame == NULL) {
+                ok = 0;
+            } else {
+                memcpy(frame, zmq_msg_data(&part), size);
+                frame[size] = '\0';
+                if (req->delim < 0 && size == JMX_DELIM_LEN
+                    && memcmp(frame, JMX_DELIM, JMX_DELIM_LEN) == 0) {
+                    req->delim = req->nframes;
+                }
+                req->frame[req->nframes] = frame;
+                req->size[req->nframes++] = size;
+            }
+        }
+        zmq_msg_close(&part);
     }
-    zmq_close(requester);
-    zmq_ctx_destroy(context);
+    if (req && (!ok || req->delim < 0 || req->nframes < req->delim + 6)) {
+        jmx_request_free(req);
+        return NULL;
+    }
+    return req;
+}
+
+static int jmx_send_frame(void* sock, const void* data, size_t size, int more)
+{
+    return zmq_send(sock, data, size, more ? ZMQ_SNDMORE : 0) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Sign a message and queue it for the socket thread (any thread)
+ *
+ * @param x pointer to object struct
+ * @param channel JMX_SHELL/JMX_CONTROL (reply to `parent`) or JMX_IOPUB
+ * @param parent request that caused the message, NULL for none
+ * @param msg_type message type
+ * @param content json object
+ * @return 0 on success
+ */
+int jmx_emit(t_jmx* x, int channel, const t_jmx_request* parent,
+             const char* msg_type, const char* content)
+{
+    t_jmx_buf header = {0};
+    char msg_id[37];
+    char date[40];
+    char sig[JMX_SIG_LEN + 1];
+    char* parts[4];
+    size_t sizes[4];
+    int err = -1;
+
+    jmx_uuid(msg_id);
+    jmx_timestamp(date, sizeof(date));
+    jmx_buf_printf(&header, "{\"msg_id\":\"%s\",\"session\":\"%s\","
+                   "\"username\":\"kernel\",\"date\":\"%s\",\"msg_type\":\"%s\","
+                   "\"version\":\"" JMX_PROTOCOL_VERSION "\"}",
+                   msg_id, x->x_session, date, msg_type);
+    if (header.failed) {
+        goto error;
+    }
+    parts[0] = header.data;
+    parts[1] = parent ? jmx_req_header(parent) : "{}";
+    parts[2] = "{}";
+    parts[3] = (char*)content;
+    for (int i = 0; i < 4; i++) {
+        sizes[i] = strlen(parts[i]);
+    }
+    jmx_sign(x, parts, sizes, sig);
+
+    systhread_mutex_lock(x->x_push_mutex);
+    if (x->x_push == NULL) {
+        systhread_mutex_unlock(x->x_push_mutex);
+        goto error;
+    }
+    err = jmx_send_frame(x->x_push, jmx_channel_names[channel],
+                         strlen(jmx_channel_names[channel]), 1);
+    if (channel == JMX_IOPUB || parent == NULL) {
+        // iopub topic
+        err |= jmx_send_frame(x->x_push, msg_type, strlen(msg_type), 1);
+    } else {
+        for (int i = 0; i < parent->delim; i++) {
+            err |= jmx_send_frame(x->x_push, parent->frame[i], parent->size[i], 1);
+        }
+    }
+    err |= jmx_send_frame(x->x_push, JMX_DELIM, JMX_DELIM_LEN, 1);
+    err |= jmx_send_frame(x->x_push, sig, strlen(sig), 1);
+    for (int i = 0; i < 4; i++) {
+        err |= jmx_send_frame(x->x_push, parts[i], sizes[i], i < 3);
+    }
+    systhread_mutex_unlock(x->x_push_mutex);
+
+error:
+    free(header.data);
+    return err;
+}
+
+/**
+ * @brief Publish the kernel's execution state and notify the main thread
+ */
+void jmx_status(t_jmx* x, const t_jmx_request* parent, const char* state)
+{
+    char content[64];
+
+    snprintf(content, sizeof(content), "{\"execution_state\":\"%s\"}", state);
+    jmx_emit(x, JMX_IOPUB, parent, "status", content);
 
     systhread_mutex_lock(x->x_mutex);
-    x->x_foo++; // fiddle with shared data
+    x->x_state = gensym(state);
+    x->x_state_changed = 1;
     systhread_mutex_unlock(x->x_mutex);
+    qelem_set(x->x_qelem);
+}
+
+/**
+ * @brief Write a random (version 4) uuid
+ *
+ * @param out at least 37 chars
+ */
+void jmx_uuid(char* out)
+{
+    unsigned char b[16];
+    char hex[33];
+
+    randombytes_buf(b, sizeof(b));
+    b[6] = (b[6] & 0x0f) | 0x40;
+    b[8] = (b[8] & 0x3f) | 0x80;
+    sodium_bin2hex(hex, sizeof(hex), b, sizeof(b));
+    snprintf(out, 37, "%.8s-%.4s-%.4s-%.4s-%.12s",
+             hex, hex + 8, hex + 12, hex + 16, hex + 20);
+}
+
+/**
+ * @brief Write an ISO 8601 timestamp with milliseconds and utc offset
+ */
+void jmx_timestamp(char* out, size_t size)
+{
+    struct timeval tv;
+    struct tm tm;
+    char date[24];
+    char zone[8];
+
+    gettimeofday(&tv, NULL);
+    localtime_r(&tv.tv_sec, &tm);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm);
+    strftime(zone, sizeof(zone), "%z", &tm);
+    snprintf(out, size, "%s.%03ld%s", date, (long)tv.tv_usec / 1000, zone);
+}
+
+
+/*--------------------------------------------------------------------------*/
+// connection
+
+/**
+ * @brief Default directory for connection files, like `jupyter --runtime-dir`
+ */
+static void jmx_runtime_dir(char* path, size_t size)
+{
+    const char* env;
+    const char* home = getenv("HOME");
+
+    if (home == NULL) {
+        home = "/tmp";
+    }
+    if ((env = getenv("JUPYTER_RUNTIME_DIR")) && *env) {
+        snprintf(path, size, "%s", env);
+    } else if ((env = getenv("JUPYTER_DATA_DIR")) && *env) {
+        snprintf(path, size, "%s/runtime", env);
+    } else {
+#ifdef __APPLE__
+        snprintf(path, size, "%s/Library/Jupyter/runtime", home);
+#else
+        if ((env = getenv("XDG_DATA_HOME")) && *env) {
+            snprintf(path, size, "%s/jupyter/runtime", env);
+        } else {
+            snprintf(path, size, "%s/.local/share/jupyter/runtime", home);
+        }
+#endif
+    }
+}
+
+static int jmx_mkdirs(char* path)
+{
+    for (char* p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0700);
+            *p = '/';
+        }
+    }
+    return (mkdir(path, 0700) == 0 || errno == EEXIST) ? 0 : -1;
+}
+
+/**
+ * @brief Take transport, ip, key and ports from an existing connection file
+ *
+ * @param x pointer to object struct
+ * @param path connection file
+ * @return t_max_err error code
+ */
+t_max_err jmx_connection_read(t_jmx* x, const char* path)
+{
+    static const char* keys[JMX_NCHANNELS] = {
+        "shell_port", "iopub_port", "stdin_port", "control_port", "hb_port"
+    };
+    FILE* f = NULL;
+    char* json = NULL;
+    char* value = NULL;
+    long size;
+    t_max_err err = MAX_ERR_GENERIC;
 
-    qelem_set(x->x_qelem); // notify main thread using qelem mechanism
+    if ((f = fopen(path, "rb")) == NULL) {
+        error("jmx: cannot open %s", path);
+        goto error;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0 || (json = (char*)sysmem_newptr(size + 1)) == NULL) {
+        goto error;
+    }
+    if (fread(json, 1, size, f) != (size_t)size) {
+        goto error;
+    }
+    json[size] = '\0';
 
-    systhread_sleep(x->x_sleeptime); // sleep a bit
+    if ((value = jmx_json_get_str(json, "signature_scheme")) && *value
+        && strcmp(value, "hmac-sha256") != 0) {
+        error("jmx: unsupported signature scheme %s", value);
+        goto error;
+    }
+    if (value) {
+        sysmem_freeptr(value);
+    }
+    if ((value = jmx_json_get_str(json, "transport"))) {
+        strncpy_zero(x->x_transport, value, sizeof(x->x_transport));
+        sysmem_freeptr(value);
+    }
+    if ((value = jmx_json_get_str(json, "ip"))) {
+        strncpy_zero(x->x_ip, value, sizeof(x->x_ip));
+        sysmem_freeptr(value);
+    }
+    if ((value = jmx_json_get_str(json, "key"))) {
+        strncpy_zero(x->x_key, value, sizeof(x->x_key));
+        x->x_keylen = strlen(x->x_key);
+        sysmem_freeptr(value);
+    }
+    value = NULL;
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        x->x_port[i] = (int)jmx_json_get_long(json, keys[i], 0);
+    }
+    err = MAX_ERR_NONE;
+
+error:
+    if (value) {
+        sysmem_freeptr(value);
+    }
+    if (json) {
+        sysmem_freeptr(json);
+    }
+    if (f) {
+        fclose(f);
+    }
+    return err;
+}
+
+/**
+ * @brief Write the bound ports and key as a connection file (mode 0600)
+ */
+t_max_err jmx_connection_write(t_jmx* x, const char* path)
+{
+    t_jmx_buf json = {0};
+    FILE* f = NULL;
+    int fd = -1;
+    t_max_err err = MAX_ERR_GENERIC;
+
+    jmx_buf_puts(&json, "{\n");
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        jmx_buf_printf(&json, "  \"%s_port\": %d,\n", jmx_channel_names[i], x->x_port[i]);
+    }
+    jmx_buf_puts(&json, "  \"ip\": ");
+    jmx_buf_str(&json, x->x_ip, strlen(x->x_ip));
+    jmx_buf_puts(&json, ",\n  \"key\": ");
+    jmx_buf_str(&json, x->x_key, x->x_keylen);
+    jmx_buf_printf(&json, ",\n  \"transport\": \"%s\",\n"
+                   "  \"signature_scheme\": \"hmac-sha256\",\n"
+                   "  \"kernel_name\": \"jmx\"\n}\n", x->x_transport);
+    if (json.failed) {
+        goto error;
+    }
+
+    // the file holds the signing key: create it private, and never write
+    // through a file (or link) which appeared in the meantime
+    fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 || (f = fdopen(fd, "w")) == NULL) {
+        error("jmx: cannot write %s: %s", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        goto error;
+    }
+    if (fwrite(json.data, 1, json.len, f) == json.len) {
+        err = MAX_ERR_NONE;
+    }
+    fclose(f);
+
+error:
+    free(json.data);
+    return err;
+}
+
+/**
+ * @brief Create the context and sockets, binding unset ports to free ones
+ */
+t_max_err jmx_bind(t_jmx* x)
+{
+    static const int types[JMX_NCHANNELS] = {
+        ZMQ_ROUTER, ZMQ_PUB, ZMQ_ROUTER, ZMQ_ROUTER, ZMQ_REP
+    };
+    char endpoint[128];
+    size_t len;
+    const char* port;
+    int linger = 0;
+    int hwm = 0;
+
+    if (strcmp(x->x_transport, "tcp") != 0) {
+        error("jmx: unsupported transport %s", x->x_transport);
+        return MAX_ERR_GENERIC;
+    }
+
+    x->x_ctx = zmq_ctx_new();
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        x->x_socket[i] = zmq_socket(x->x_ctx, types[i]);
+        zmq_setsockopt(x->x_socket[i], ZMQ_LINGER, &linger, sizeof(linger));
+        if (x->x_port[i] > 0) {
+            snprintf(endpoint, sizeof(endpoint), "tcp://%s:%d", x->x_ip, x->x_port[i]);
+        } else {
+            snprintf(endpoint, sizeof(endpoint), "tcp://%s:*", x->x_ip);
+        }
+        if (zmq_bind(x->x_socket[i], endpoint) != 0) {
+            error("jmx: cannot bind %s socket to %s: %s", jmx_channel_names[i],
+                  endpoint, zmq_strerror(zmq_errno()));
+            return MAX_ERR_GENERIC;
+        }
+        len = sizeof(endpoint);
+        zmq_getsockopt(x->x_socket[i], ZMQ_LAST_ENDPOINT, endpoint, &len);
+        if ((port = strrchr(endpoint, ':'))) {
+            x->x_port[i] = atoi(port + 1);
+        }
+    }
+
+    // inproc pipe: unbounded so no sender ever blocks on the socket thread
+    snprintf(endpoint, sizeof(endpoint), "inproc://jmx-%p", (void*)x);
+    x->x_pull = zmq_socket(x->x_ctx, ZMQ_PULL);
+    x->x_push = zmq_socket(x->x_ctx, ZMQ_PUSH);
+    zmq_setsockopt(x->x_pull, ZMQ_RCVHWM, &hwm, sizeof(hwm));
+    zmq_setsockopt(x->x_push, ZMQ_SNDHWM, &hwm, sizeof(hwm));
+    zmq_setsockopt(x->x_pull, ZMQ_LINGER, &linger, sizeof(linger));
+    zmq_setsockopt(x->x_push, ZMQ_LINGER, &linger, sizeof(linger));
+    if (zmq_bind(x->x_pull, endpoint) != 0 || zmq_connect(x->x_push, endpoint) != 0) {
+        error("jmx: cannot create inproc pipe: %s", zmq_strerror(zmq_errno()));
+        return MAX_ERR_GENERIC;
+    }
+    return MAX_ERR_NONE;
+}
+
+
+/*--------------------------------------------------------------------------*/
+// socket thread
+
+/**
+ * @brief Send a reply to a shell/control request from the socket thread
+ */
+static void jmx_reply(t_jmx* x, const t_jmx_request* req, const char* msg_type,
+                      const char* content)
+{
+    jmx_status(x, req, "busy");
+    jmx_emit(x, req->channel, req, msg_type, content);
+    jmx_status(x, req, "idle");
+}
+
+/**
+ * @brief Handle a request received on the shell or control socket
+ *
+ * @param x pointer to object struct
+ * @param req request (ownership is taken)
+ */
+void jmx_dispatch(t_jmx* x, t_jmx_request* req)
+{
+    const char* type;
+    char* content = NULL;
+
+    if (!jmx_verify(x, req)) {
+        error("jmx: dropping message with invalid signature");
+        jmx_request_free(req);
+        return;
+    }
+    req->msg_type = jmx_json_get_str(jmx_req_header(req), "msg_type");
+    type = req->msg_type ? req->msg_type : "";
+
+    if (strcmp(type, "kernel_info_request") == 0) {
+        jmx_reply(x, req, "kernel_info_reply",
+            "{\"status\":\"ok\",\"protocol_version\":\"" JMX_PROTOCOL_VERSION "\","
+            "\"implementation\":\"jmx\",\"implementation_version\":\"0.1.0\","
+            "\"language_info\":{\"name\":\"python\",\"version\":\"" PY_VERSION "\","
+            "\"mimetype\":\"text/x-python\",\"file_extension\":\".py\","
+            "\"pygments_lexer\":\"ipython3\","
+            "\"codemirror_mode\":{\"name\":\"ipython\",\"version\":3},"
+            "\"nbconvert_exporter\":\"python\"},"
+            "\"banner\":\"jmx: python " PY_VERSION " embedded in Max\","
+            "\"help_links\":[]}");
+    } else if (strcmp(type, "comm_info_request") == 0) {
+        jmx_reply(x, req, "comm_info_reply", "{\"status\":\"ok\",\"comms\":{}}");
+    } else if (strcmp(type, "interrupt_request") == 0) {
+        jmx_interrupt(x);
+        jmx_reply(x, req, "interrupt_reply", "{\"status\":\"ok\"}");
+    } else if (strcmp(type, "shutdown_request") == 0) {
+        content = (char*)(jmx_json_get_bool(jmx_req_content(req), "restart", 0)
+            ? "{\"status\":\"ok\",\"restart\":true}"
+            : "{\"status\":\"ok\",\"restart\":false}");
+        jmx_reply(x, req, "shutdown_reply", content);
+        // the main thread stops the kernel
+        systhread_mutex_lock(x->x_mutex);
+        x->x_shutdown = 1;
+        systhread_mutex_unlock(x->x_mutex);
+        qelem_set(x->x_qelem);
+    } else if (strcmp(type, "execute_request") == 0
+               || strcmp(type, "is_complete_request") == 0) {
+        jmx_submit(x, req);
+        return;
+    } else {
+        post("jmx: ignoring %s on %s", type, jmx_channel_names[req->channel]);
+    }
+    jmx_request_free(req);
+}
+
+/**
+ * @brief Forward one message from the inproc pipe to its socket
+ *
+ * @return 0 when asked to stop
+ */
+int jmx_forward(t_jmx* x)
+{
+    zmq_msg_t part;
+    void* sock = NULL;
+    int more;
+
+    zmq_msg_init(&part);
+    if (zmq_msg_recv(&part, x->x_pull, 0) < 0) {
+        zmq_msg_close(&part);
+        return 1;
+    }
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        if (zmq_msg_size(&part) == strlen(jmx_channel_names[i])
+            && memcmp(zmq_msg_data(&part), jmx_channel_names[i], zmq_msg_size(&part)) == 0) {
+            sock = x->x_socket[i];
+        }
+    }
+    if (sock == NULL && zmq_msg_size(&part) == strlen(JMX_STOP)
+        && memcmp(zmq_msg_data(&part), JMX_STOP, strlen(JMX_STOP)) == 0) {
+        zmq_msg_close(&part);
+        return 0;
+    }
+    more = zmq_msg_more(&part);
+    while (more) {
+        zmq_msg_close(&part);
+        zmq_msg_init(&part);
+        if (zmq_msg_recv(&part, x->x_pull, 0) < 0) {
+            break;
+        }
+        more = zmq_msg_more(&part);
+        // a message to a client that went away is dropped by the router
+        if (sock) {
+            zmq_msg_send(&part, sock, more ? ZMQ_SNDMORE : 0);
+        }
+    }
+    zmq_msg_close(&part);
+    return 1;
+}
+
+/**
+ * @brief Socket thread: heartbeat, control and shell requests, outgoing messages
+ *
+ * @param x pointer to object struct
+ */
+void* jmx_threadproc(t_jmx* x)
+{
+    zmq_pollitem_t items[] = {
+        { x->x_socket[JMX_HB],      0, ZMQ_POLLIN, 0 },
+        { x->x_socket[JMX_CONTROL], 0, ZMQ_POLLIN, 0 },
+        { x->x_socket[JMX_SHELL],   0, ZMQ_POLLIN, 0 },
+        { x->x_pull,                0, ZMQ_POLLIN, 0 },
+    };
+    t_jmx_request* req;
+    zmq_msg_t ping;
+
+    while (!x->x_systhread_cancel) {
+        if (zmq_poll(items, 4, -1) < 0) {
+            if (zmq_errno() == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (items[0].revents & ZMQ_POLLIN) { // echo heartbeats
+            zmq_msg_init(&ping);
+            if (zmq_msg_recv(&ping, x->x_socket[JMX_HB], 0) >= 0) {
+                zmq_msg_send(&ping, x->x_socket[JMX_HB], 0);
+            }
+            zmq_msg_close(&ping);
+        }
+        if ((items[1].revents & ZMQ_POLLIN)
+            && (req = jmx_recv(x->x_socket[JMX_CONTROL], JMX_CONTROL))) {
+            jmx_dispatch(x, req);
+        }
+        if ((items[2].revents & ZMQ_POLLIN)
+            && (req = jmx_recv(x->x_socket[JMX_SHELL], JMX_SHELL))) {
+            jmx_dispatch(x, req);
+        }
+        if ((items[3].revents & ZMQ_POLLIN) && !jmx_forward(x)) {
+            break;
+        }
+    }
 
     x->x_systhread_cancel = false; // reset cancel flag for next time, in case
     // the thread is created again
@@ -148,143 +1099,1000 @@ void* jmx_threadproc(t_jmx* x)
     return NULL;
 }
 
-// triggered by the helper thread
-void jmx_qfn(t_jmx *x)
+
+/*--------------------------------------------------------------------------*/
+// python worker
+
+/**
+ * @brief Build a display mime bundle: repr plus any `_repr_*_` methods
+ *
+ * @return 0 on success, -1 with a python error set
+ */
+static int jmx_mimebundle(PyObject* obj, t_jmx_buf* b)
+{
+    static const struct { const char* method; const char* mime; } reprs[] = {
+        { "_repr_html_",     "text/html" },
+        { "_repr_markdown_", "text/markdown" },
+        { "_repr_svg_",      "image/svg+xml" },
+        { "_repr_latex_",    "text/latex" },
+        { "_repr_json_",     "application/json" },
+        { "_repr_png_",      "image/png" },
+        { "_repr_jpeg_",     "image/jpeg" },
+    };
+    PyObject* repr = NULL;
+    PyObject* rich = NULL;
+    const char* data;
+    Py_ssize_t len;
+
+    if ((repr = PyObject_Repr(obj)) == NULL) {
+        return -1;
+    }
+    if ((data = PyUnicode_AsUTF8AndSize(repr, &len)) == NULL) {
+        Py_DECREF(repr);
+        return -1;
+    }
+    jmx_buf_puts(b, "{\"text/plain\":");
+    jmx_buf_str(b, data, (size_t)len);
+    Py_DECREF(repr);
+
+    for (size_t i = 0; i < sizeof(reprs) / sizeof(reprs[0]); i++) {
+        if (!PyObject_HasAttrString(obj, reprs[i].method)) {
+            continue;
+        }
+        // a failing rich repr falls back to text/plain
+        if ((rich = PyObject_CallMethod(obj, reprs[i].method, NULL)) == NULL) {
+            PyErr_Clear();
+            continue;
+        }
+        if (PyUnicode_Check(rich) && (data = PyUnicode_AsUTF8AndSize(rich, &len))) {
+            jmx_buf_printf(b, ",\"%s\":", reprs[i].mime);
+            if (strcmp(reprs[i].mime, "application/json") == 0) {
+                jmx_buf_cat(b, data, (size_t)len);
+            } else {
+                jmx_buf_str(b, data, (size_t)len);
+            }
+        } else if (PyBytes_Check(rich)) {
+            size_t n = sodium_base64_ENCODED_LEN(PyBytes_GET_SIZE(rich),
+                                                 sodium_base64_VARIANT_ORIGINAL);
+            char* b64 = (char*)sysmem_newptr(n);
+            if (b64) {
+                sodium_bin2base64(b64, n, (const unsigned char*)PyBytes_AS_STRING(rich),
+                                  PyBytes_GET_SIZE(rich), sodium_base64_VARIANT_ORIGINAL);
+                jmx_buf_printf(b, ",\"%s\":", reprs[i].mime);
+                jmx_buf_str(b, b64, strlen(b64));
+                sysmem_freeptr(b64);
+            }
+        }
+        PyErr_Clear();
+        Py_DECREF(rich);
+    }
+    jmx_buf_puts(b, "}");
+    return 0;
+}
+
+/**
+ * @brief Publish `obj` as execute_result (displayhook) or display_data
+ */
+static int jmx_publish_data(t_jmx* x, PyObject* obj, const char* msg_type)
+{
+    t_jmx_buf content = {0};
+
+    if (x->x_silent) {
+        return 0;
+    }
+    jmx_buf_puts(&content, "{\"data\":");
+    if (jmx_mimebundle(obj, &content) < 0) {
+        free(content.data);
+        return -1;
+    }
+    if (strcmp(msg_type, "execute_result") == 0) {
+        jmx_buf_printf(&content, ",\"execution_count\":%ld", x->x_execution_count);
+    }
+    jmx_buf_puts(&content, ",\"metadata\":{},\"transient\":{}}");
+    if (!content.failed) {
+        jmx_emit(x, JMX_IOPUB, x->x_job, msg_type, content.data);
+    }
+    free(content.data);
+    return 0;
+}
+
+/**
+ * @brief `write` method of the stdout and stderr streams
+ */
+static PyObject* jmx_stream_write(t_jmx* x, PyObject* arg, const char* name)
+{
+    t_jmx_buf content = {0};
+    Py_ssize_t len = 0;
+    const char* data = NULL;
+
+    if (!PyUnicode_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "write() argument must be str, not %s",
+                     Py_TYPE(arg)->tp_name);
+        return NULL;
+    }
+    if ((data = PyUnicode_AsUTF8AndSize(arg, &len)) == NULL) {
+        return NULL;
+    }
+    if (len > 0 && !x->x_silent) {
+        jmx_buf_printf(&content, "{\"name\":\"%s\",\"text\":", name);
+        jmx_buf_str(&content, data, (size_t)len);
+        jmx_buf_puts(&content, "}");
+        if (!content.failed) {
+            jmx_emit(x, JMX_IOPUB, x->x_job, "stream", content.data);
+        }
+        free(content.data);
+    }
+    return PyLong_FromSsize_t(PyUnicode_GetLength(arg));
+}
+
+static PyObject* jmx_stdout_write(PyObject* self, PyObject* arg)
+{
+    return jmx_stream_write((t_jmx*)PyCapsule_GetPointer(self, NULL), arg, "stdout");
+}
+
+static PyObject* jmx_stderr_write(PyObject* self, PyObject* arg)
+{
+    return jmx_stream_write((t_jmx*)PyCapsule_GetPointer(self, NULL), arg, "stderr");
+}
+
+static PyObject* jmx_stream_flush(PyObject* self, PyObject* unused)
+{
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief `sys.displayhook` replacement: publishes execute_result
+ */
+static PyObject* jmx_displayhook(PyObject* self, PyObject* obj)
+{
+    t_jmx* x = (t_jmx*)PyCapsule_GetPointer(self, NULL);
+
+    if (obj == Py_None) {
+        Py_RETURN_NONE;
+    }
+    // like the default hook, keep the last result in builtins._
+    if (PyDict_SetItemString(PyEval_GetBuiltins(), "_", obj) != 0) {
+        return NULL;
+    }
+    if (jmx_publish_data(x, obj, "execute_result") < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief `display(*objs)`: publishes display_data for each object
+ */
+static PyObject* jmx_display(PyObject* self, PyObject* args)
 {
-    int myfoo;
+    t_jmx* x = (t_jmx*)PyCapsule_GetPointer(self, NULL);
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(args); i++) {
+        if (jmx_publish_data(x, PyTuple_GET_ITEM(args, i), "display_data") < 0) {
+            return NULL;
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+/**
+ * @brief `outlet(*args)`: sends a list out of the jmx object (main thread)
+ *
+ * ints, floats and strings map to atoms, anything else to its str().
+ */
+static PyObject* jmx_outlet(PyObject* self, PyObject* args)
+{
+    t_jmx* x = (t_jmx*)PyCapsule_GetPointer(self, NULL);
+    Py_ssize_t argc = PyTuple_GET_SIZE(args);
+    t_jmx_atoms* atoms;
+    PyObject* item;
+    PyObject* str;
+    const char* s;
+
+    if (argc == 0) {
+        Py_RETURN_NONE;
+    }
+    atoms = (t_jmx_atoms*)sysmem_newptr(sizeof(t_jmx_atoms) + (argc - 1) * sizeof(t_atom));
+    if (atoms == NULL) {
+        return PyErr_NoMemory();
+    }
+    atoms->next = NULL;
+    atoms->argc = (long)argc;
+    for (Py_ssize_t i = 0; i < argc; i++) {
+        item = PyTuple_GET_ITEM(args, i);
+        if (PyLong_Check(item)) {
+            atom_setlong(&atoms->argv[i], PyLong_AsLong(item));
+        } else if (PyFloat_Check(item)) {
+            atom_setfloat(&atoms->argv[i], PyFloat_AsDouble(item));
+        } else {
+            if ((str = PyObject_Str(item)) == NULL) {
+                sysmem_freeptr(atoms);
+                return NULL;
+            }
+            s = PyUnicode_AsUTF8(str);
+            atom_setsym(&atoms->argv[i], gensym(s ? s : ""));
+            Py_DECREF(str);
+        }
+    }
+    if (PyErr_Occurred()) {
+        sysmem_freeptr(atoms);
+        return NULL;
+    }
 
     systhread_mutex_lock(x->x_mutex);
-    myfoo = x->x_foo;                                                           // access shared data
+    if (x->x_atoms_tail) {
+        x->x_atoms_tail->next = atoms;
+    } else {
+        x->x_atoms_head = atoms;
+    }
+    x->x_atoms_tail = atoms;
     systhread_mutex_unlock(x->x_mutex);
+    qelem_set(x->x_qelem);
 
-    // *never* wrap outlet calls with systhread_mutex_lock()
-    outlet_int(x->x_outlet, myfoo);
+    Py_RETURN_NONE;
 }
 
-void jmx_assist(t_jmx *x, void *b, long m, long a, char *s)
+static PyMethodDef jmx_stdout_def = {"write", jmx_stdout_write, METH_O, NULL};
+static PyMethodDef jmx_stderr_def = {"write", jmx_stderr_write, METH_O, NULL};
+static PyMethodDef jmx_flush_def = {"flush", jmx_stream_flush, METH_NOARGS, NULL};
+static PyMethodDef jmx_displayhook_def = {"displayhook", jmx_displayhook, METH_O, NULL};
+static PyMethodDef jmx_display_def = {"display", jmx_display, METH_VARARGS,
+    "display(*objs): publish rich representations of objects"};
+static PyMethodDef jmx_outlet_def = {"outlet", jmx_outlet, METH_VARARGS,
+    "outlet(*args): send a list out of the jmx object"};
+
+/**
+ * @brief Runs a cell: statements as `exec`, a trailing expression as `single`
+ *
+ * the source is registered with linecache so tracebacks show cell lines.
+ */
+static const char* JMX_RUNNER =
+    "def _jmx_run(code, ns, name):\n"
+    "    import ast, linecache\n"
+    "    linecache.cache[name] = (len(code), None, code.splitlines(True), name)\n"
+    "    tree = ast.parse(code, name, 'exec')\n"
+    "    last = None\n"
+    "    if tree.body and isinstance(tree.body[-1], ast.Expr):\n"
+    "        last = ast.Interactive([tree.body.pop()])\n"
+    "    exec(compile(tree, name, 'exec'), ns)\n"
+    "    if last is not None:\n"
+    "        exec(compile(last, name, 'single'), ns)\n";
+
+
+/**
+ * @brief Create a file-like stream object (requires the GIL)
+ */
+static PyObject* jmx_stream_new(PyObject* capsule, PyMethodDef* write_def)
 {
-    if (m==1)
-        sprintf(s,"bang starts a new thread");
-    else if (m==2)
-        sprintf(s,"report when done/cancelled");
+    PyObject* types = NULL;
+    PyObject* namespace = NULL;
+    PyObject* kwds = NULL;
+    PyObject* write = NULL;
+    PyObject* flush = NULL;
+    PyObject* args = NULL;
+    PyObject* stream = NULL;
+
+    if ((types = PyImport_ImportModule("types")) == NULL) {
+        goto error;
+    }
+    if ((namespace = PyObject_GetAttrString(types, "SimpleNamespace")) == NULL) {
+        goto error;
+    }
+    write = PyCFunction_New(write_def, capsule);
+    flush = PyCFunction_New(&jmx_flush_def, capsule);
+    args = PyTuple_New(0);
+    kwds = Py_BuildValue("{sOsOss}", "write", write, "flush", flush,
+                         "encoding", "utf-8");
+    if (write == NULL || flush == NULL || args == NULL || kwds == NULL) {
+        goto error;
+    }
+    stream = PyObject_Call(namespace, args, kwds);
+
+error:
+    Py_XDECREF(types);
+    Py_XDECREF(namespace);
+    Py_XDECREF(write);
+    Py_XDECREF(flush);
+    Py_XDECREF(args);
+    Py_XDECREF(kwds);
+    return stream;
 }
 
-void jmx_free(t_jmx *x)
+/**
+ * @brief Create the streams, hooks and helpers used by the worker (GIL)
+ *
+ * `display` and `outlet` are added to the kernel's namespace.
+ */
+static t_max_err jmx_worker_init(t_jmx* x)
 {
-    // stop our thread if it is still running
-    jmx_stop(x);
+    PyObject* capsule = NULL;
+    PyObject* helpers = NULL;
+    PyObject* pval = NULL;
+    PyObject* fn = NULL;
+    t_max_err err = MAX_ERR_GENERIC;
 
-    // free our qelem
-    if (x->x_qelem)
-        qelem_free(x->x_qelem);
+    if ((capsule = PyCapsule_New(x, NULL, NULL)) == NULL) {
+        goto error;
+    }
+    x->x_stdout = jmx_stream_new(capsule, &jmx_stdout_def);
+    x->x_stderr = jmx_stream_new(capsule, &jmx_stderr_def);
+    x->x_displayhook = PyCFunction_New(&jmx_displayhook_def, capsule);
+    if (x->x_stdout == NULL || x->x_stderr == NULL || x->x_displayhook == NULL) {
+        goto error;
+    }
+    if ((fn = PyCFunction_New(&jmx_display_def, capsule)) == NULL
+        || PyDict_SetItemString(x->py->p_globals, "display", fn) != 0) {
+        goto error;
+    }
+    Py_CLEAR(fn);
+    if ((fn = PyCFunction_New(&jmx_outlet_def, capsule)) == NULL
+        || PyDict_SetItemString(x->py->p_globals, "outlet", fn) != 0) {
+        goto error;
+    }
 
-    // free out mutex
-    if (x->x_mutex)
-        systhread_mutex_free(x->x_mutex);
+    if ((helpers = PyDict_New()) == NULL
+        || PyDict_SetItemString(helpers, "__builtins__", PyEval_GetBuiltins()) != 0) {
+        goto error;
+    }
+    if ((pval = PyRun_String(JMX_RUNNER, Py_file_input, helpers, helpers)) == NULL) {
+        goto error;
+    }
+    if ((x->x_runner = PyDict_GetItemString(helpers, "_jmx_run")) == NULL) {
+        goto error;
+    }
+    Py_INCREF(x->x_runner);
+    err = MAX_ERR_NONE;
+
+error:
+    Py_XDECREF(capsule);
+    Py_XDECREF(helpers);
+    Py_XDECREF(pval);
+    Py_XDECREF(fn);
+    return err;
 }
 
-void *jmx_new(void)
+
+/**
+ * @brief Start the python worker thread
+ *
+ * @param x pointer to object struct
+ */
+void jmx_worker_start(t_jmx* x)
 {
-    t_jmx *x;
+    if (x->x_worker) {
+        return;
+    }
+    x->x_worker_cancel = false;
+    systhread_create((method)jmx_workerproc, x, 0, 0, 0, &x->x_worker);
+}
 
-    x = (t_jmx *)object_alloc(jmx_class);
-    x->x_outlet = outlet_new(x,NULL);
-    x->x_qelem = qelem_new(x,(method)jmx_qfn);
-    x->x_systhread = NULL;
-    systhread_mutex_new(&x->x_mutex,0);
-    x->x_foo = 0;
-    x->x_sleeptime = 1000;
 
-    return(x);
+/**
+ * @brief Stop the python worker thread
+ *
+ * @param x pointer to object struct
+ *
+ * A running request is interrupted; pending requests are dropped.
+ */
+void jmx_worker_stop(t_jmx* x)
+{
+    unsigned int ret;
+    t_jmx_request* req;
+
+    if (x->x_worker == NULL) {
+        return;
+    }
+
+    systhread_mutex_lock(x->x_job_mutex);
+    x->x_worker_cancel = true;
+    systhread_cond_signal(x->x_job_cond);
+    systhread_mutex_unlock(x->x_job_mutex);
+
+    jmx_interrupt(x);
+    systhread_join(x->x_worker, &ret);
+    x->x_worker = NULL;
+
+    while ((req = x->x_job_head) != NULL) {
+        x->x_job_head = req->next;
+        jmx_request_free(req);
+    }
+    x->x_job_tail = NULL;
+}
+
+
+/**
+ * @brief Queue a shell request for the python worker
+ *
+ * @param x pointer to object struct
+ * @param req request (ownership is taken)
+ */
+void jmx_submit(t_jmx* x, t_jmx_request* req)
+{
+    req->next = NULL;
+
+    systhread_mutex_lock(x->x_job_mutex);
+    if (x->x_job_tail) {
+        x->x_job_tail->next = req;
+    } else {
+        x->x_job_head = req;
+    }
+    x->x_job_tail = req;
+    systhread_cond_signal(x->x_job_cond);
+    systhread_mutex_unlock(x->x_job_mutex);
 }
 
 
-void jmx_msg(t_jmx* x)
+/**
+ * @brief Raise KeyboardInterrupt in the request being run, if any
+ *
+ * @param x pointer to object struct
+ */
+void jmx_interrupt(t_jmx* x)
 {
-    jmx_msg_create(x, "bob", "execute_request", "1 + 1");
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    if (x->x_job && x->x_worker_ident) {
+        PyThreadState_SetAsyncExc(x->x_worker_ident, PyExc_KeyboardInterrupt);
+    }
+    PyGILState_Release(gstate);
 }
 
 
-t_symbol* get_uuid(void)
+/**
+ * @brief Describe the pending python exception as execute_reply/error fields
+ *
+ * clears the exception; appends `"ename":..,"evalue":..,"traceback":[..]`
+ */
+static void jmx_format_error(t_jmx_buf* b)
 {
-    char uuid_str[37];
-    uuid_t uuid;
-    t_symbol* res = NULL;
+    PyObject *ptype, *pvalue, *ptraceback;
+    PyObject* tb = NULL;
+    PyObject* module = NULL;
+    PyObject* lines = NULL;
+    PyObject* str = NULL;
+    const char* s;
+    Py_ssize_t len;
+
+    PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+    PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
+
+    s = ptype ? ((PyTypeObject*)ptype)->tp_name : "Exception";
+    if (strrchr(s, '.')) {
+        s = strrchr(s, '.') + 1;
+    }
+    jmx_buf_puts(b, "\"ename\":");
+    jmx_buf_str(b, s, strlen(s));
+
+    str = pvalue ? PyObject_Str(pvalue) : NULL;
+    s = str ? PyUnicode_AsUTF8AndSize(str, &len) : NULL;
+    jmx_buf_puts(b, ",\"evalue\":");
+    jmx_buf_str(b, s ? s : "", s ? (size_t)len : 0);
+    Py_CLEAR(str);
+    PyErr_Clear();
 
-    uuid_generate_time(uuid);
-    uuid_unparse_lower(uuid, uuid_str);
-    // post("generate uuid=%s\n", uuid_str);
-    res = gensym(uuid_str);
-    uuid_clear(uuid);
-    return res;
+    // hide the _jmx_run frame; syntax errors have no useful frames at all
+    if (ptraceback && !PyErr_GivenExceptionMatches(ptype, PyExc_SyntaxError)) {
+        tb = PyObject_GetAttrString(ptraceback, "tb_next");
+    }
+    if (tb == NULL) {
+        PyErr_Clear();
+        tb = Py_None;
+        Py_INCREF(tb);
+    }
+    jmx_buf_puts(b, ",\"traceback\":[");
+    if ((module = PyImport_ImportModule("traceback"))) {
+        lines = PyObject_CallMethod(module, "format_exception", "OOO",
+                                    ptype, pvalue ? pvalue : Py_None, tb);
+    }
+    if (lines && PyList_Check(lines)) {
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(lines); i++) {
+            if ((s = PyUnicode_AsUTF8AndSize(PyList_GET_ITEM(lines, i), &len))) {
+                jmx_buf_puts(b, i ? "," : "");
+                jmx_buf_str(b, s, (size_t)len);
+            }
+        }
+    }
+    jmx_buf_puts(b, "]");
+    PyErr_Clear();
+
+    Py_XDECREF(lines);
+    Py_XDECREF(module);
+    Py_XDECREF(tb);
+    Py_XDECREF(ptype);
+    Py_XDECREF(pvalue);
+    Py_XDECREF(ptraceback);
 }
 
-t_symbol* get_timestamp(void)
+
+/**
+ * @brief Run an execute_request (worker thread)
+ *
+ * publishes busy, execute_input, output and error on iopub, then the reply
+ * and idle. A failure with `stop_on_error` aborts the queued executions.
+ */
+void jmx_execute(t_jmx* x, t_jmx_request* req)
 {
-    struct timeval tv;
-    struct tm tm;
-    char timestamp[] = "YYYY-MM-ddTHH:mm:ss.SSS+0000";
+    const char* content = jmx_req_content(req);
+    char* code = jmx_json_get_str(content, "code");
+    int silent = jmx_json_get_bool(content, "silent", 0);
+    int store_history = jmx_json_get_bool(content, "store_history", !silent);
+    int stop_on_error = jmx_json_get_bool(content, "stop_on_error", 1);
+    t_jmx_buf reply = {0};
+    t_jmx_buf err = {0};
+    PyObject* saved_stdout = NULL;
+    PyObject* saved_stderr = NULL;
+    PyObject* saved_displayhook = NULL;
+    PyObject* pval = NULL;
+    t_jmx_request* pending = NULL;
+    t_jmx_request* next;
+    char name[32];
+    int failed = 0;
 
-    gettimeofday(&tv, NULL);
-    localtime_r(&tv.tv_sec, &tm);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S.000%z", &tm);
-    sprintf(timestamp + 20, "%03ld%s", (long)tv.tv_usec / 1000, timestamp + 23);
-    // post("ISO 8601 timestamp: %s\n", timestamp);
-    return gensym(timestamp);
+    jmx_status(x, req, "busy");
+    if (store_history && !silent) {
+        x->x_execution_count++;
+    }
+    if (!silent) {
+        t_jmx_buf input = {0};
+        jmx_buf_puts(&input, "{\"code\":");
+        jmx_buf_str(&input, code ? code : "", code ? strlen(code) : 0);
+        jmx_buf_printf(&input, ",\"execution_count\":%ld}", x->x_execution_count);
+        if (!input.failed) {
+            jmx_emit(x, JMX_IOPUB, req, "execute_input", input.data);
+        }
+        free(input.data);
+    }
+    snprintf(name, sizeof(name), "<cell %ld>", x->x_execution_count);
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+
+    saved_stdout = PySys_GetObject("stdout"); // borrowed
+    saved_stderr = PySys_GetObject("stderr"); // borrowed
+    saved_displayhook = PySys_GetObject("displayhook"); // borrowed
+    Py_XINCREF(saved_stdout);
+    Py_XINCREF(saved_stderr);
+    Py_XINCREF(saved_displayhook);
+    PySys_SetObject("stdout", x->x_stdout);
+    PySys_SetObject("stderr", x->x_stderr);
+    PySys_SetObject("displayhook", x->x_displayhook);
+    x->x_job = req;
+    x->x_silent = silent;
+
+    pval = PyObject_CallFunction(x->x_runner, "sOs", code ? code : "",
+                                 x->py->p_globals, name);
+    if (pval == NULL) {
+        failed = 1;
+        jmx_format_error(&err);
+    }
+    Py_XDECREF(pval);
+
+    x->x_job = NULL;
+    x->x_silent = 0;
+    PySys_SetObject("stdout", saved_stdout);
+    PySys_SetObject("stderr", saved_stderr);
+    PySys_SetObject("displayhook", saved_displayhook);
+    Py_XDECREF(saved_stdout);
+    Py_XDECREF(saved_stderr);
+    Py_XDECREF(saved_displayhook);
+
+    PyGILState_Release(gstate);
+
+    if (failed && stop_on_error) {
+        systhread_mutex_lock(x->x_job_mutex);
+        pending = x->x_job_head;
+        x->x_job_head = x->x_job_tail = NULL;
+        systhread_mutex_unlock(x->x_job_mutex);
+    }
+
+    if (failed) {
+        if (!silent && !err.failed) {
+            t_jmx_buf error = {0};
+            jmx_buf_puts(&error, "{");
+            jmx_buf_cat(&error, err.data, err.len);
+            jmx_buf_puts(&error, "}");
+            if (!error.failed) {
+                jmx_emit(x, JMX_IOPUB, req, "error", error.data);
+            }
+            free(error.data);
+        }
+        jmx_buf_printf(&reply, "{\"status\":\"error\",\"execution_count\":%ld,",
+                       x->x_execution_count);
+        jmx_buf_cat(&reply, err.data ? err.data : "", err.len);
+        jmx_buf_puts(&reply, "}");
+    } else {
+        jmx_buf_printf(&reply, "{\"status\":\"ok\",\"execution_count\":%ld,"
+                       "\"user_expressions\":{},\"payload\":[]}",
+                       x->x_execution_count);
+    }
+    if (!reply.failed) {
+        jmx_emit(x, JMX_SHELL, req, "execute_reply", reply.data);
+    }
+    jmx_status(x, req, "idle");
+
+    free(reply.data);
+    free(err.data);
+    if (code) {
+        sysmem_freeptr(code);
+    }
+
+    // requests queued behind a failure were sent before the client saw it
+    for (; pending; pending = next) {
+        next = pending->next;
+        if (strcmp(pending->msg_type, "execute_request") == 0) {
+            jmx_status(x, pending, "busy");
+            jmx_emit(x, JMX_SHELL, pending, "execute_reply", "{\"status\":\"aborted\"}");
+            jmx_status(x, pending, "idle");
+        } else {
+            jmx_run_job(x, pending);
+        }
+        jmx_request_free(pending);
+    }
+}
+
+
+/**
+ * @brief Answer an is_complete_request with codeop (worker thread)
+ */
+void jmx_is_complete(t_jmx* x, t_jmx_request* req)
+{
+    char* code = jmx_json_get_str(jmx_req_content(req), "code");
+    const char* content = "{\"status\":\"unknown\"}";
+    PyObject* codeop = NULL;
+    PyObject* pval = NULL;
+    size_t len = code ? strlen(code) : 0;
+
+    jmx_status(x, req, "busy");
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    if ((codeop = PyImport_ImportModule("codeop"))) {
+        pval = PyObject_CallMethod(codeop, "compile_command", "sss",
+                                   code ? code : "", "<cell>", "single");
+        if (pval == NULL) {
+            content = "{\"status\":\"invalid\"}";
+        } else if (pval == Py_None) {
+            // continuation lines of a block are indented
+            content = (len > 0 && code[len - 1] == ':')
+                ? "{\"status\":\"incomplete\",\"indent\":\"    \"}"
+                : "{\"status\":\"incomplete\",\"indent\":\"\"}";
+        } else {
+            content = "{\"status\":\"complete\"}";
+        }
+    }
+    PyErr_Clear();
+    Py_XDECREF(pval);
+    Py_XDECREF(codeop);
+    PyGILState_Release(gstate);
+
+    jmx_emit(x, JMX_SHELL, req, "is_complete_reply", content);
+    jmx_status(x, req, "idle");
+
+    if (code) {
+        sysmem_freeptr(code);
+    }
+}
+
+
+/**
+ * @brief Run a queued request (worker thread)
+ */
+void jmx_run_job(t_jmx* x, t_jmx_request* req)
+{
+    if (strcmp(req->msg_type, "execute_request") == 0) {
+        jmx_execute(x, req);
+    } else if (strcmp(req->msg_type, "is_complete_request") == 0) {
+        jmx_is_complete(x, req);
+    }
+}
+
+
+/**
+ * @brief Python worker thread: runs queued requests in order
+ *
+ * @param x pointer to object struct
+ */
+void* jmx_workerproc(t_jmx* x)
+{
+    t_jmx_request* req = NULL;
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    x->x_worker_ident = PyThread_get_thread_ident();
+    if (jmx_worker_init(x) != MAX_ERR_NONE) {
+        py_handle_error(x->py, (char*)"jmx worker");
+        systhread_mutex_lock(x->x_job_mutex);
+        x->x_worker_cancel = true;
+        systhread_mutex_unlock(x->x_job_mutex);
+    }
+    PyGILState_Release(gstate);
+
+    while (1) {
+        systhread_mutex_lock(x->x_job_mutex);
+        while (x->x_job_head == NULL && !x->x_worker_cancel) {
+            systhread_cond_wait(x->x_job_cond, x->x_job_mutex);
+        }
+        if (x->x_worker_cancel) {
+            systhread_mutex_unlock(x->x_job_mutex);
+            break;
+        }
+        req = x->x_job_head;
+        x->x_job_head = req->next;
+        if (x->x_job_head == NULL) {
+            x->x_job_tail = NULL;
+        }
+        systhread_mutex_unlock(x->x_job_mutex);
+
+        jmx_run_job(x, req);
+        jmx_request_free(req);
+    }
+
+    gstate = PyGILState_Ensure();
+    Py_CLEAR(x->x_stdout);
+    Py_CLEAR(x->x_stderr);
+    Py_CLEAR(x->x_displayhook);
+    Py_CLEAR(x->x_runner);
+    x->x_worker_ident = 0;
+    PyGILState_Release(gstate);
+
+    systhread_exit(0);
+    return NULL;
 }
 
 
-void jmx_msg_create(t_jmx* x, const char* username, const char* msg_type, const char* code)
+/*--------------------------------------------------------------------------*/
+// max methods
+
+void jmx_bang(t_jmx* x)
 {
-    // header dict
-    t_dictionary* header = dictionary_new();
-    dictionary_appendsym(header, gensym("msg_id"), get_uuid());
-    dictionary_appendsym(header, gensym("session"), get_uuid());
-    dictionary_appendstring(header, gensym("username"), username);
-    dictionary_appendsym(header, gensym("date"), get_timestamp());
-    dictionary_appendstring(header, gensym("msg_type"), msg_type);
-    // dictionary_appendsym(header, gensym("subshell_id"), gensym("shell_id")); // optional
+    jmx_start(x, gensym(""));
+}
 
-    // code dict
-    t_dictionary* content = dictionary_new();
-    t_dictionary* user_expressions = dictionary_new();
-    dictionary_appendstring(content, gensym("code"), code);
-    dictionary_appendlong(content, gensym("silent"), 1);
-    dictionary_appendlong(content, gensym("store_history"), 0);
-    dictionary_appenddictionary(content, gensym("user_expressions"), (t_object*)user_expressions);
-    dictionary_appendlong(content, gensym("allow_stdin"), 0);
-    dictionary_appendlong(content, gensym("stop_on_error"), 1);
 
-    // other empty dicts
-    t_dictionary* parent_header = dictionary_new();
-    t_dictionary* metadata = dictionary_new();
+/**
+ * @brief Start the kernel
+ *
+ * @param x pointer to object struct
+ * @param s connection file: an existing file supplies ports and key, otherwise
+ *          one is written there (default: the jupyter runtime directory)
+ *
+ * outputs `connection <path>`; connect with `jupyter console --existing <path>`
+ */
+void jmx_start(t_jmx* x, t_symbol* s)
+{
+    char dir[MAX_PATH_CHARS];
+    unsigned char key[16];
 
-    // create a msg dictionary
-    t_dictionary* d = dictionary_new();
-    dictionary_appenddictionary(d, gensym("header"), (t_object *)header);
-    dictionary_appenddictionary(d, gensym("parent_header"), (t_object *)parent_header);
-    dictionary_appenddictionary(d, gensym("metadata"), (t_object *)metadata);
-    dictionary_appenddictionary(d, gensym("content"), (t_object *)content);
+    jmx_stop(x);        // kill kernel, if any
 
-    // add empty buffers list
-    dictionary_appendatoms(d, gensym("buffers"), 0, NULL);
+    jmx_uuid(x->x_session);
+    strncpy_zero(x->x_transport, "tcp", sizeof(x->x_transport));
+    strncpy_zero(x->x_ip, "127.0.0.1", sizeof(x->x_ip));
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        x->x_port[i] = 0;
+    }
+    x->x_owns_connection_file = 0;
 
-    // // convert it to json
-    t_object* jsonwriter = (t_object*)object_new(_sym_nobox, _sym_jsonwriter);
-    t_handle json;
-    const char* str;
-    object_method(jsonwriter, _sym_writedictionary, d);
-    object_method(jsonwriter, _sym_getoutput, &json);
-    str = *json;
-    // now str contains our JSON serialization of the t_dictionary d
+    if (s && s->s_name[0] && access(s->s_name, F_OK) == 0) {
+        if (jmx_connection_read(x, s->s_name) != MAX_ERR_NONE) {
+            goto error;
+        }
+        strncpy_zero(x->x_connection_file, s->s_name, sizeof(x->x_connection_file));
+    } else {
+        randombytes_buf(key, sizeof(key));
+        sodium_bin2hex(x->x_key, sizeof(x->x_key), key, sizeof(key));
+        x->x_keylen = strlen(x->x_key);
+        if (s && s->s_name[0]) {
+            strncpy_zero(x->x_connection_file, s->s_name, sizeof(x->x_connection_file));
+        } else {
+            jmx_runtime_dir(dir, sizeof(dir));
+            jmx_mkdirs(dir);
+            snprintf(x->x_connection_file, sizeof(x->x_connection_file),
+                     "%s/kernel-jmx-%.8s.json", dir, x->x_session);
+        }
+    }
+
+    if (jmx_bind(x) != MAX_ERR_NONE) {
+        goto error;
+    }
+    if (!x->x_owns_connection_file && access(x->x_connection_file, F_OK) != 0) {
+        if (jmx_connection_write(x, x->x_connection_file) != MAX_ERR_NONE) {
+            goto error;
+        }
+        x->x_owns_connection_file = 1;
+    }
 
-    post("json: %s", str);
+    x->x_execution_count = 0;
+    jmx_worker_start(x);
+    // the sockets now belong to the socket thread
+    systhread_create((method)jmx_threadproc, x, 0, 0, 0, &x->x_systhread);
+    jmx_status(x, NULL, "starting");
+    jmx_status(x, NULL, "idle");
 
-    // free d and jsonwriter
-    object_free(d);
-    object_free(jsonwriter);
+    t_atom path;
+    atom_setsym(&path, gensym(x->x_connection_file));
+    outlet_anything(x->x_outlet, gensym("connection"), 1, &path);
+    return;
+
+error:
+    jmx_stop(x);
 }
 
 
+/**
+ * @brief Stop the kernel, remove the connection file if we wrote it
+ */
+void jmx_stop(t_jmx* x)
+{
+    unsigned int ret;
 
+    jmx_worker_stop(x);
 
+    if (x->x_systhread) {
+        systhread_mutex_lock(x->x_push_mutex);
+        jmx_send_frame(x->x_push, JMX_STOP, strlen(JMX_STOP), 0);
+        systhread_mutex_unlock(x->x_push_mutex);
+        systhread_join(x->x_systhread, &ret);       // wait for the thread to stop
+        x->x_systhread = NULL;
+    }
+    if (x->x_ctx == NULL) {
+        return;
+    }
+
+    systhread_mutex_lock(x->x_push_mutex);
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        if (x->x_socket[i]) {
+            zmq_close(x->x_socket[i]);
+            x->x_socket[i] = NULL;
+        }
+    }
+    if (x->x_pull) {
+        zmq_close(x->x_pull);
+        x->x_pull = NULL;
+    }
+    if (x->x_push) {
+        zmq_close(x->x_push);
+        x->x_push = NULL;
+    }
+    systhread_mutex_unlock(x->x_push_mutex);
+    zmq_ctx_term(x->x_ctx);
+    x->x_ctx = NULL;
+
+    if (x->x_owns_connection_file) {
+        remove(x->x_connection_file);
+        x->x_owns_connection_file = 0;
+    }
+}
+
+
+// triggered by the socket and worker threads
+void jmx_qfn(t_jmx* x)
+{
+    t_jmx_atoms* atoms;
+    t_jmx_atoms* next;
+    t_symbol* state;
+    int state_changed;
+    int shutdown;
+    t_atom a;
+
+    systhread_mutex_lock(x->x_mutex);
+    atoms = x->x_atoms_head;
+    x->x_atoms_head = x->x_atoms_tail = NULL;
+    state = x->x_state;
+    state_changed = x->x_state_changed;
+    shutdown = x->x_shutdown;
+    x->x_state_changed = 0;
+    x->x_shutdown = 0;
+    systhread_mutex_unlock(x->x_mutex);
+
+    // *never* wrap outlet calls with systhread_mutex_lock()
+    for (; atoms; atoms = next) {
+        next = atoms->next;
+        if (atom_gettype(atoms->argv) == A_SYM) {
+            outlet_anything(x->x_outlet, atom_getsym(atoms->argv),
+                            (short)(atoms->argc - 1), atoms->argv + 1);
+        } else {
+            outlet_list(x->x_outlet, NULL, (short)atoms->argc, atoms->argv);
+        }
+        sysmem_freeptr(atoms);
+    }
+    if (state_changed && state) {
+        atom_setsym(&a, state);
+        outlet_anything(x->x_outlet, gensym("status"), 1, &a);
+    }
+    if (shutdown) {
+        jmx_stop(x);
+        outlet_anything(x->x_outlet, gensym("shutdown"), 0, NULL);
+    }
+}
+
+void jmx_assist(t_jmx* x, void* b, long m, long a, char* s)
+{
+    if (m == 1)
+        sprintf(s, "start [connection-file], stop, interrupt");
+    else if (m == 2)
+        sprintf(s, "connection, status, shutdown; lists from outlet()");
+}
+
+void jmx_free(t_jmx* x)
+{
+    t_jmx_atoms* atoms;
+
+    // stop our threads if they are still running
+    jmx_stop(x);
+
+    while ((atoms = x->x_atoms_head) != NULL) {
+        x->x_atoms_head = atoms->next;
+        sysmem_freeptr(atoms);
+    }
+    systhread_mutex_free(x->x_push_mutex);
+    systhread_mutex_free(x->x_job_mutex);
+    systhread_cond_free(x->x_job_cond);
+
+    // free our qelem
+    if (x->x_qelem)
+        qelem_free(x->x_qelem);
+
+    // free out mutex
+    if (x->x_mutex)
+        systhread_mutex_free(x->x_mutex);
+
+    // cleanup python (finalizing needs the GIL back)
+    if (x->x_tstate) {
+        PyEval_RestoreThread(x->x_tstate);
+    } else {
+        PyGILState_Ensure();
+    }
+    py_free(x->py);
+}
+
+void* jmx_new(void)
+{
+    t_jmx* x;
+
+    if (sodium_init() < 0) {
+        error("jmx: cannot initialize libsodium");
+        return NULL;
+    }
+
+    x = (t_jmx*)object_alloc(jmx_class);
+    x->x_outlet = outlet_new(x, NULL);
+    x->x_qelem = qelem_new(x, (method)jmx_qfn);
+    x->x_systhread = NULL;
+    systhread_mutex_new(&x->x_mutex, 0);
+    systhread_mutex_new(&x->x_push_mutex, 0);
+
+    x->py = py_init(jmx_class); // This is all that is need to init the `py` obj
+
+    // release the GIL taken by initialization so the worker can run python
+    x->x_tstate = PyGILState_Check() ? PyEval_SaveThread() : NULL;
+
+    x->x_ctx = NULL;
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        x->x_socket[i] = NULL;
+    }
+    x->x_pull = NULL;
+    x->x_push = NULL;
+    x->x_keylen = 0;
+    x->x_owns_connection_file = 0;
+    x->x_connection_file[0] = '\0';
+
+    x->x_worker = NULL;
+    systhread_mutex_new(&x->x_job_mutex, 0);
+    systhread_cond_new(&x->x_job_cond, 0);
+    x->x_job_head = NULL;
+    x->x_job_tail = NULL;
+    x->x_worker_cancel = false;
+    x->x_worker_ident = 0;
+    x->x_job = NULL;
+    x->x_silent = 0;
+    x->x_execution_count = 0;
+    x->x_runner = NULL;
+    x->x_stdout = NULL;
+    x->x_stderr = NULL;
+    x->x_displayhook = NULL;
+
+    x->x_state = NULL;
+    x->x_state_changed = 0;
+    x->x_shutdown = 0;
+    x->x_atoms_head = NULL;
+    x->x_atoms_tail = NULL;
+
+    return (x);
+}
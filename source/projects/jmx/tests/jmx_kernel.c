@@ -0,0 +1,53 @@
+/* jmx_kernel.c -- run a jmx kernel outside Max
+ *
+ * Links jmx.c with the fake Max runtime of ../../mamba/tests/fakemax.c,
+ * creates a [jmx] object, sends it `start <connection-file>` and services
+ * its qelem (printing the outlet) until the kernel shuts down or the
+ * timeout expires. jupyter_client/test_jmx_kernel.py drives it:
+ *
+ *     ./jmx_kernel /tmp/kernel-jmx-test.json &
+ *     python3 jupyter_client/test_jmx_kernel.py /tmp/kernel-jmx-test.json --shutdown
+ *
+ * (`make test_kernel` does both)
+ */
+
+#include "../jmx.c"
+
+#define JMX_KERNEL_POLL_MS 20
+#define JMX_KERNEL_TIMEOUT_S 120
+
+
+int main(int argc, char** argv)
+{
+    t_jmx* x;
+    int ok;
+    int polls = JMX_KERNEL_TIMEOUT_S * 1000 / JMX_KERNEL_POLL_MS;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <connection-file>\n", argv[0]);
+        return 2;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    ext_main(NULL);
+    if ((x = (t_jmx*)jmx_new()) == NULL) {
+        return 1;
+    }
+    jmx_start(x, gensym(argv[1]));
+    if (x->x_ctx == NULL) {
+        object_free(x);
+        return 1;
+    }
+
+    // a shutdown_request stops the kernel in jmx_qfn(), which clears x_ctx
+    while (x->x_ctx != NULL && polls-- > 0) {
+        systhread_sleep(JMX_KERNEL_POLL_MS);
+        jmx_qfn(x);
+    }
+    ok = x->x_ctx == NULL;
+    if (!ok) {
+        fprintf(stderr, "jmx_kernel: timed out\n");
+    }
+    object_free(x);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+"""
+exercise a running jmx kernel with jupyter_client
+
+send `start` to a [jmx] object (or run tests/jmx_kernel outside Max) and pass
+the connection file it reports:
+
+    python3 test_jmx_kernel.py ~/Library/Jupyter/runtime/kernel-jmx-xxxxxxxx.json
+
+add `--shutdown` to finish with a shutdown_request. `make test_kernel` in
+tests/ builds jmx_kernel and runs both.
+"""
+import sys
+import time
+
+from jupyter_client.blocking import BlockingKernelClient
+
+
+def run(kc, code, **kwds):
+    """execute code, return (reply content, iopub messages for it)"""
+    msg_id = kc.execute(code, **kwds)
+    reply = kc.get_shell_msg(timeout=10)
+    assert reply['parent_header']['msg_id'] == msg_id, reply
+    msgs = []
+    while True:
+        msg = kc.get_iopub_msg(timeout=10)
+        if msg['parent_header'].get('msg_id') != msg_id:
+            continue
+        msgs.append(msg)
+        if msg['msg_type'] == 'status' and msg['content']['execution_state'] == 'idle':
+            break
+    return reply['content'], msgs
+
+
+def of_type(msgs, msg_type):
+    return [m['content'] for m in msgs if m['msg_type'] == msg_type]
+
+
+def main(connection_file, shutdown=False):
+    kc = BlockingKernelClient(connection_file=connection_file)
+    kc.load_connection_file()
+    kc.start_channels()
+    kc.wait_for_ready(timeout=10)
+
+    # kernel_info_request
+    kc.kernel_info()
+    info = kc.get_shell_msg(timeout=5)['content']
+    assert info['implementation'] == 'jmx', info
+    assert info['language_info']['name'] == 'python', info
+
+    # statements then a trailing expression
+    reply, msgs = run(kc, 'a = 10\nprint("hello", a)\na * 2')
+    assert reply['status'] == 'ok', reply
+    assert of_type(msgs, 'execute_input')[0]['code'].startswith('a = 10')
+    assert ''.join(c['text'] for c in of_type(msgs, 'stream')) == 'hello 10\n'
+    assert of_type(msgs, 'execute_result')[0]['data']['text/plain'] == '20'
+
+    # rich display
+    reply, msgs = run(kc, 'class H:\n    def _repr_html_(self): return "<b>hi</b>"\n'
+                          'display(H(), "é\\n\\"q\\"")')
+    data = of_type(msgs, 'display_data')
+    assert data[0]['data']['text/html'] == '<b>hi</b>', data
+    assert data[1]['data']['text/plain'] == repr('é\n"q"'), data
+
+    # errors
+    reply, msgs = run(kc, 'def f():\n    1/0\nf()')
+    assert reply['status'] == 'error' and reply['ename'] == 'ZeroDivisionError', reply
+    tb = ''.join(of_type(msgs, 'error')[0]['traceback'])
+    assert '<cell' in tb and '1/0' in tb and '_jmx_run' not in tb, tb
+    reply, _ = run(kc, 'def (')
+    assert reply['ename'] == 'SyntaxError', reply
+
+    # silent
+    reply, msgs = run(kc, 'print("quiet"); 42', silent=True)
+    assert reply['status'] == 'ok' and not of_type(msgs, 'stream'), msgs
+
+    # stop_on_error aborts executions queued behind a failure
+    first = kc.execute('import time; time.sleep(0.2); raise ValueError("stop")')
+    second = kc.execute('print("never")')
+    replies = {}
+    while len(replies) < 2:
+        msg = kc.get_shell_msg(timeout=10)
+        replies[msg['parent_header']['msg_id']] = msg['content']['status']
+    assert replies == {first: 'error', second: 'aborted'}, replies
+
+    # is_complete_request
+    for code, status in [('x = 1', 'complete'), ('for i in range(3):', 'incomplete'),
+                         ('x = )', 'invalid')]:
+        kc.is_complete(code)
+        content = kc.get_shell_msg(timeout=5)['content']
+        assert content['status'] == status, (code, content)
+
+    # interrupt_request on the control channel stops a busy loop
+    msg_id = kc.execute('while True: pass')
+    time.sleep(0.5)
+    kc.control_channel.send(kc.session.msg('interrupt_request', {}))
+    assert kc.get_control_msg(timeout=5)['content']['status'] == 'ok'
+    reply = kc.get_shell_msg(timeout=10)
+    assert reply['parent_header']['msg_id'] == msg_id
+    assert reply['content']['ename'] == 'KeyboardInterrupt', reply['content']
+
+    # outlet() reaches the patch
+    reply, _ = run(kc, 'outlet("freq", 440, 0.5)')
+    assert reply['status'] == 'ok', reply
+
+    # heartbeat
+    assert kc.is_alive()
+
+    if shutdown:
+        kc.shutdown()
+        assert kc.get_control_msg(timeout=5)['msg_type'] == 'shutdown_reply'
+
+    kc.stop_channels()
+    print('ok')
+
+
+if __name__ == '__main__':
+    main(sys.argv[1], '--shutdown' in sys.argv[2:])
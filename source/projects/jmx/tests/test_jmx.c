@@ -0,0 +1,215 @@
+/* test_jmx.c -- json helpers and connection file of jmx, run outside Max
+ *
+ * Links jmx.c (included below, to reach its statics) with the fake Max
+ * runtime of ../../mamba/tests/fakemax.c and checks:
+ *
+ *  - jmx_buf_*: growth, formatting and json string escaping
+ *  - jmx_json_*: member lookup over nested values, string unescaping
+ *    (including \u escapes and surrogate pairs), numbers, booleans and
+ *    malformed input
+ *  - jmx_connection_write: a private (0600) file, never written over an
+ *    existing one, which jmx_connection_read reads back
+ *
+ * make test_jmx && ./test_jmx
+ */
+
+#include "../jmx.c"
+
+#include <assert.h>
+
+
+static void test_buf(void)
+{
+    t_jmx_buf b = {0};
+    char big[1000];
+
+    jmx_buf_puts(&b, "ab");
+    jmx_buf_cat(&b, "cdef", 2);
+    jmx_buf_printf(&b, "-%d-%s", 42, "x");
+    assert(strcmp(b.data, "abcd-42-x") == 0 && b.len == 9 && !b.failed);
+
+    // grows past the initial capacity
+    memset(big, 'z', sizeof(big));
+    jmx_buf_cat(&b, big, sizeof(big));
+    assert(b.len == 1009 && b.cap >= 1010 && b.data[1009] == '\0');
+    assert(b.data[8] == 'x' && b.data[9] == 'z' && b.data[1008] == 'z');
+    free(b.data);
+
+    // formatted output which does not fit the scratch buffer fails the buffer
+    b = (t_jmx_buf){0};
+    big[sizeof(big) - 1] = '\0';
+    jmx_buf_printf(&b, "%s", big);
+    assert(b.failed);
+    jmx_buf_puts(&b, "ignored");
+    assert(b.len == 0);
+    free(b.data);
+}
+
+static void test_buf_str(void)
+{
+    t_jmx_buf b = {0};
+    const char s[] = "a\"b\\c\nd\re\tf\x01g\x1f\xc3\xa9";
+
+    jmx_buf_str(&b, s, sizeof(s) - 1);
+    assert(strcmp(b.data,
+                  "\"a\\\"b\\\\c\\nd\\re\\tf\\u0001g\\u001f\xc3\xa9\"") == 0);
+    free(b.data);
+
+    // explicit length: embedded NUL is escaped, the rest is not read
+    b = (t_jmx_buf){0};
+    jmx_buf_str(&b, "x\0yz", 3);
+    assert(strcmp(b.data, "\"x\\u0000y\"") == 0);
+    free(b.data);
+
+    b = (t_jmx_buf){0};
+    jmx_buf_str(&b, "", 0);
+    assert(strcmp(b.data, "\"\"") == 0);
+    free(b.data);
+}
+
+static void test_json_skip(void)
+{
+    const char* p;
+
+    assert(*jmx_json_skip("  \"a\\\"b\" ,") == ' ');
+    assert(*jmx_json_skip("{\"a\": [1, {\"b\": \"}\"}]}, 1") == ',');
+    assert(*jmx_json_skip("-12.5e3}") == '}');
+    p = "true]";
+    assert(jmx_json_skip(p) == p + 4);
+
+    assert(jmx_json_skip("") == NULL);
+    assert(jmx_json_skip("\"open") == NULL);
+    assert(jmx_json_skip("\"esc\\") == NULL);
+    assert(jmx_json_skip("{\"a\": [1, 2}") == NULL);
+    assert(jmx_json_skip("[[1]") == NULL);
+    assert(jmx_json_skip("]") == NULL);
+}
+
+static void test_json_find(void)
+{
+    const char* json = " { \"nested\" : {\"key\": 1, \"list\": [\"key\"]},\n"
+                       "   \"k\\\"ey\": 2, \"key\":\t3 } ";
+    const char* p;
+
+    p = jmx_json_find(json, "key");
+    assert(p && *p == '3');
+    p = jmx_json_find(json, "nested");
+    assert(p && *p == '{');
+    assert(jmx_json_find(json, "list") == NULL);    // not top-level
+    assert(jmx_json_find(json, "ke") == NULL);
+    assert(jmx_json_find(json, "missing") == NULL);
+
+    assert(jmx_json_find("[1]", "a") == NULL);
+    assert(jmx_json_find("{}", "a") == NULL);
+    assert(jmx_json_find("{\"a\" 1}", "a") == NULL);
+    assert(jmx_json_find("{\"b\": 1 \"a\": 2}", "a") == NULL);
+    assert(jmx_json_find("{\"b\": \"open, \"a\": 2", "a") == NULL);
+}
+
+static void test_json_get_str(void)
+{
+    const char* json =
+        "{\"plain\": \"hello\", \"esc\": \"a\\\"b\\\\c\\/d\\n\\r\\t\\b\\f\","
+        " \"u\": \"\\u0041\\u00e9\\u20AC\\ud83d\\ude00\","
+        " \"lone\": \"\\ud83dx\", \"bad\": \"\\u12g4\", \"short\": \"\\u12\","
+        " \"num\": 12, \"empty\": \"\"}";
+    char* s;
+
+    s = jmx_json_get_str(json, "plain");
+    assert(s && strcmp(s, "hello") == 0);
+    sysmem_freeptr(s);
+
+    s = jmx_json_get_str(json, "esc");
+    assert(s && strcmp(s, "a\"b\\c/d\n\r\t\b\f") == 0);
+    sysmem_freeptr(s);
+
+    // 1, 2, 3 and 4 byte utf-8, the last from a surrogate pair
+    s = jmx_json_get_str(json, "u");
+    assert(s && strcmp(s, "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80") == 0);
+    sysmem_freeptr(s);
+
+    // an unpaired surrogate is encoded as is
+    s = jmx_json_get_str(json, "lone");
+    assert(s && strcmp(s, "\xed\xa0\xbdx") == 0);
+    sysmem_freeptr(s);
+
+    s = jmx_json_get_str(json, "bad");
+    assert(s && s[0] == '?');
+    sysmem_freeptr(s);
+
+    s = jmx_json_get_str(json, "short");
+    assert(s && s[0] == '?');
+    sysmem_freeptr(s);
+
+    s = jmx_json_get_str(json, "empty");
+    assert(s && s[0] == '\0');
+    sysmem_freeptr(s);
+
+    assert(jmx_json_get_str(json, "num") == NULL);
+    assert(jmx_json_get_str(json, "missing") == NULL);
+    assert(jmx_json_get_str("{\"a\": \"open}", "a") == NULL);
+}
+
+static void test_json_scalars(void)
+{
+    const char* json = "{\"n\": -42, \"z\": 0, \"s\": \"7\", \"t\": true,"
+                       " \"f\": false, \"x\": null}";
+
+    assert(jmx_json_get_long(json, "n", 1) == -42);
+    assert(jmx_json_get_long(json, "z", 1) == 0);
+    assert(jmx_json_get_long(json, "s", 1) == 1);
+    assert(jmx_json_get_long(json, "missing", 5) == 5);
+
+    assert(jmx_json_get_bool(json, "t", 0) == 1);
+    assert(jmx_json_get_bool(json, "f", 1) == 0);
+    assert(jmx_json_get_bool(json, "x", -1) == -1);
+    assert(jmx_json_get_bool(json, "missing", -1) == -1);
+}
+
+static void test_connection_file(void)
+{
+    t_jmx a = {0};
+    t_jmx b = {0};
+    struct stat st;
+    char path[MAX_PATH_CHARS];
+
+    snprintf(path, sizeof(path), "%s/test_jmx-%d.json", P_tmpdir, (int)getpid());
+    remove(path);
+
+    strncpy_zero(a.x_transport, "tcp", sizeof(a.x_transport));
+    strncpy_zero(a.x_ip, "127.0.0.1", sizeof(a.x_ip));
+    strncpy_zero(a.x_key, "k\"ey\\", sizeof(a.x_key));
+    a.x_keylen = strlen(a.x_key);
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        a.x_port[i] = 5000 + i;
+    }
+
+    assert(jmx_connection_write(&a, path) == MAX_ERR_NONE);
+    assert(stat(path, &st) == 0 && (st.st_mode & 0777) == 0600);
+
+    assert(jmx_connection_read(&b, path) == MAX_ERR_NONE);
+    assert(strcmp(b.x_transport, "tcp") == 0);
+    assert(strcmp(b.x_ip, "127.0.0.1") == 0);
+    assert(strcmp(b.x_key, a.x_key) == 0 && b.x_keylen == a.x_keylen);
+    for (int i = 0; i < JMX_NCHANNELS; i++) {
+        assert(b.x_port[i] == 5000 + i);
+    }
+
+    // an existing file (or link) is never written through
+    assert(jmx_connection_write(&a, path) == MAX_ERR_GENERIC);
+    remove(path);
+}
+
+
+int main(void)
+{
+    test_buf();
+    test_buf_str();
+    test_json_skip();
+    test_json_find();
+    test_json_get_str();
+    test_json_scalars();
+    test_connection_file();
+    printf("test_jmx: all tests passed\n");
+    return 0;
+}
@@ -4,6 +4,11 @@
     Experiment to defer the evaluation of a python function
     via the ITM-based sequencing.
 
+    It also sequences events yielded by a python iterator (typically a
+    generator) on the ITM timeline: events are fetched a lookahead window
+    at a time, in a single GIL acquisition, and fired from the scheduler
+    without calling back into python.
+
 */
 
 #include "ext.h"
@@ -19,6 +24,19 @@
 enum INLETS { I_INPUT, I_DELAY, NUM_INLETS };
 enum OUTLETS { O_PRIMARY_BANG_OUTPUT, O_SECONDARY_BANG_OUTPUT, NUM_OUTLETS };
 
+#define KRAIT_TICKS_PER_BEAT 480 // ITM ticks per quarter note
+#define KRAIT_MAX_EVENTS 128     // capacity of the event ring buffer
+#define KRAIT_MAX_ATOMS 16       // max atoms of an event message
+
+
+// a sequencer event fetched from python
+typedef struct krait_event
+{
+    double ticks;                   /*!< time from the sequence start */
+    long argc;
+    t_atom argv[KRAIT_MAX_ATOMS];   /*!< message (empty: bang) */
+} t_krait_event;
+
 
 // datastructure
 typedef struct krait
@@ -41,6 +59,21 @@ typedef struct krait
     void *c_outlet;
     void *c_outlet2;
 
+    // sequencer
+    PyObject* c_seq;        /*!< python iterator of events (null when exhausted) */
+    t_object *c_seqtime;    /*!< schedules the next event on the ITM timeline */
+    t_object *c_lookahead;  /*!< how far ahead events are fetched */
+    double c_seq_now;       /*!< time of the current tick: sum of the scheduled delays */
+    double c_seq_last;      /*!< time of the last fetched event */
+    PyObject* c_seq_pending; /*!< iterator to start on the next swap (null to stop) */
+    long c_seq_posted;      /*!< a start or stop awaits the swap */
+    t_critical c_seq_lock;  /*!< guards c_seq_pending and c_seq_posted */
+    void *c_seq_clock;      /*!< runs the swap on the scheduler */
+    t_krait_event c_events[KRAIT_MAX_EVENTS]; /*!< fetched, not yet fired events */
+    long c_head;
+    long c_count;
+    long c_running;
+
 } t_krait;
 
 // prototypes
@@ -58,8 +91,21 @@ void krait_stop(t_krait *x);
 void krait_clocktick(t_krait *x);
 
 t_max_err krait_import(t_krait* x, t_symbol* s);
+t_max_err krait_metrics(t_krait* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err krait_trace(t_krait* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err krait_profile(t_krait* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err krait_defer(t_krait* x, t_symbol* s, long argc, t_atom* argv);
 
+// sequencer
+t_max_err krait_sequence(t_krait* x, t_symbol* s, long argc, t_atom* argv);
+void krait_seq_tick(t_krait* x);
+void krait_seq_stop(t_krait* x);
+void krait_seq_post(t_krait* x, PyObject* iter);
+void krait_seq_swap(t_krait* x);
+long krait_seq_fetch(t_krait* x, double horizon);
+void krait_seq_schedule(t_krait* x, double now);
+void krait_seq_output(t_krait* x, t_krait_event* e);
+
 
 static t_class *krait_class = NULL;
 
@@ -78,10 +124,17 @@ void ext_main(void *r)
     class_addmethod(c, (method)krait_inletinfo, "inletinfo",    A_CANT, 0);
 
     class_addmethod(c, (method)krait_import,    "import",       A_SYM,  0);
+    class_addmethod(c, (method)krait_metrics,   "metrics",      A_GIMME, 0);
+    class_addmethod(c, (method)krait_trace,     "trace",        A_GIMME, 0);
+    class_addmethod(c, (method)krait_profile,   "profile",      A_GIMME, 0);
     class_addmethod(c, (method)krait_defer,     "defer",       A_GIMME, 0);
+    class_addmethod(c, (method)krait_sequence,  "sequence",     A_GIMME, 0);
 
     class_time_addattr(c, "delaytime", "Delay Time", TIME_FLAGS_TICKSONLY | TIME_FLAGS_USECLOCK | TIME_FLAGS_TRANSPORT);
     class_time_addattr(c, "quantize", "Quantization", TIME_FLAGS_TICKSONLY);
+    class_time_addattr(c, "lookahead", "Sequencer Lookahead", TIME_FLAGS_TICKSONLY);
+    class_time_addattr(c, "eventtime", "Next Event Time", TIME_FLAGS_TICKSONLY | TIME_FLAGS_USECLOCK | TIME_FLAGS_TRANSPORT);
+    CLASS_ATTR_INVISIBLE(c, "eventtime", 0);
 
     class_register(CLASS_BOX, c);
 
@@ -116,9 +169,21 @@ void *krait_new(t_symbol *s, long argc, t_atom *argv)
     x->c_timeobj = (t_object *) time_new((t_object *)x, gensym("delaytime"), (method)krait_tick, TIME_FLAGS_TICKSONLY | TIME_FLAGS_USECLOCK);
     x->c_quantize = (t_object *) time_new((t_object *)x, gensym("quantize"), NULL, TIME_FLAGS_TICKSONLY);
     x->c_clock = clock_new((t_object *)x, (method)krait_clocktick);
+    x->c_lookahead = (t_object *) time_new((t_object *)x, gensym("lookahead"), NULL, TIME_FLAGS_TICKSONLY);
+    x->c_seqtime = (t_object *) time_new((t_object *)x, gensym("eventtime"), (method)krait_seq_tick, TIME_FLAGS_TICKSONLY | TIME_FLAGS_USECLOCK);
 
     // x->c_name = symbol_unique();
     x->c_func = NULL;
+    x->c_seq = NULL;
+    x->c_seq_now = 0.;
+    x->c_seq_last = 0.;
+    x->c_seq_pending = NULL;
+    x->c_seq_posted = 0;
+    critical_new(&x->c_seq_lock);
+    x->c_seq_clock = clock_new((t_object *)x, (method)krait_seq_swap);
+    x->c_head = 0;
+    x->c_count = 0;
+    x->c_running = 0;
  
     if (attrstart && argv)
         time_setvalue(x->c_timeobj, NULL, 1, argv);
@@ -128,6 +193,8 @@ void *krait_new(t_symbol *s, long argc, t_atom *argv)
     }
     atom_setfloat(&a,0);
     time_setvalue(x->c_quantize, NULL, 1, &a);
+    atom_setfloat(&a, KRAIT_TICKS_PER_BEAT);
+    time_setvalue(x->c_lookahead, NULL, 1, &a);
 
     attr_args_process(x, argc, argv);
 
@@ -143,10 +210,26 @@ void *krait_new(t_symbol *s, long argc, t_atom *argv)
  */
 void krait_free(t_krait *x)
 {
+    freeobject((t_object *)x->c_seq_clock);
+    time_stop(x->c_seqtime);
+    if (x->c_seq != NULL || x->c_seq_pending != NULL) {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_CLEAR(x->c_seq);
+        Py_CLEAR(x->c_seq_pending);
+        PyGILState_Release(gstate);
+    }
+    critical_free(x->c_seq_lock);
+    freeobject(x->c_seqtime);
+    freeobject(x->c_lookahead);
     freeobject(x->c_timeobj);
     freeobject(x->c_quantize);
     freeobject((t_object *) x->c_proxy);
     freeobject((t_object *)x->c_clock);
+    if (x->c_func != NULL) {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_CLEAR(x->c_func);
+        PyGILState_Release(gstate);
+    }
     py_free(x->py); // cleanup python.
 }
 
@@ -158,7 +241,7 @@ void krait_assist(t_krait* x, void* b, long io, long idx, char* s)
     if (io == ASSIST_INLET) {
         switch (idx) {
         case I_INPUT:
-            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: bang Gets Delayed, stop Cancels", idx);
+            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: bang Gets Delayed, sequence Starts, stop Cancels", idx);
             break;
         case I_DELAY:
             snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: Set Delay Time", idx);
@@ -169,10 +252,10 @@ void krait_assist(t_krait* x, void* b, long io, long idx, char* s)
     else if (io == ASSIST_OUTLET) {
         switch (idx) {
         case O_PRIMARY_BANG_OUTPUT:
-            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: Delayed bang", idx);
+            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: Delayed bang, Sequence Events", idx);
             break;
         case O_SECONDARY_BANG_OUTPUT:
-            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: Another Delayed bang", idx);
+            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: Another Delayed bang, bang When Sequence Ends", idx);
             break;
         }
     }
@@ -247,25 +330,31 @@ void krait_anything(t_krait *x, t_symbol *msg, long argc, t_atom *argv)
 /**
  * @brief Calls the python function
  *
+ * The callable is resolved once by `defer`, so each tick is a single
+ * argument-less vectorcall; the function is released after it ran.
+ *
  * @param x pointer to krait object
  */
 void krait_tick(t_krait *x)
 {
     if (x->c_func != NULL) {
-        PyObject* pval = PyObject_CallObject(x->c_func, NULL);
-        if (!PyErr_ExceptionMatches(PyExc_TypeError)) {
-            if (pval == NULL) {
-                error("unable to apply callable(*args)");
-                return;
-            }
-            py_handle_output(x->py, x->c_outlet, pval);
-            // success cleanup
-            Py_XDECREF(x->c_func);
-            outlet_bang(x->c_outlet);
+        t_metrics_span span;
+        metrics_begin(&span, METRICS_SCHED);
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        metrics_gil(&span);
+        PyObject* pval = PyObject_Vectorcall(x->c_func, NULL, 0, NULL);
+        metrics_exec(&span);
+        Py_CLEAR(x->c_func);
+        if (pval == NULL) {
+            py_handle_error(x->py, "unable to apply deferred callable");
+            PyGILState_Release(gstate);
+            metrics_end(x->py->p_metrics, &span, 0);
             return;
         }
-        PyErr_Clear();
-        return;
+        py_handle_output(x->py, x->c_outlet, pval);
+        metrics_convert(&span);
+        PyGILState_Release(gstate);
+        metrics_end(x->py->p_metrics, &span, 1);
     }
     outlet_bang(x->c_outlet);
 }
@@ -304,9 +393,14 @@ void krait_clocktick(t_krait *x)
 void krait_stop(t_krait *x)
 {
     post("stop");
+    krait_seq_stop(x);
     time_stop(x->c_timeobj);
     clock_unset(x->c_clock);
-    x->c_func = NULL; // reset the function
+    if (x->c_func != NULL) { // reset the function
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_CLEAR(x->c_func);
+        PyGILState_Release(gstate);
+    }
 }
 
 /**
@@ -323,6 +417,58 @@ t_max_err krait_import(t_krait* x, t_symbol* s)
 }
 
 
+/**
+ * @brief Outputs the latency metrics of the python calls as a dictionary
+ *
+ * Ticks and sequence fetches are counted as `sched`.
+ *
+ * @param x pointer to krait object
+ * @param s symbol value
+ * @param argc number of arguments
+ * @param argv array of atom values (`reset` to clear the metrics)
+ *
+ * @return t_max_err
+ */
+t_max_err krait_metrics(t_krait* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_metrics(x->py, s, argc, argv, x->c_outlet);
+}
+
+
+/**
+ * @brief Records a Chrome trace of the python calls (see mamba/trace.h)
+ *
+ * Ticks and fetches show up as `sched` spans on the scheduler thread.
+ *
+ * @param x pointer to krait object
+ * @param s symbol value
+ * @param argc number of arguments
+ * @param argv array of atom values (`start [python]`, `stop`, `write [path]`)
+ *
+ * @return t_max_err
+ */
+t_max_err krait_trace(t_krait* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_trace(x->py, (t_object*)x, argc, argv, x->c_outlet);
+}
+
+
+/**
+ * @brief Samples the python stacks for a flamegraph (see mamba/profile.h)
+ *
+ * @param x pointer to krait object
+ * @param s symbol value
+ * @param argc number of arguments
+ * @param argv array of atom values (`start [interval_ms]`, `stop`, `dump [path]`)
+ *
+ * @return t_max_err
+ */
+t_max_err krait_profile(t_krait* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_profile(x->py, (t_object*)x, argc, argv, x->c_outlet);
+}
+
+
 /**
  * @brief Defers the python function
  *
@@ -341,8 +487,14 @@ t_max_err krait_defer(t_krait* x, t_symbol* s, long argc, t_atom* argv)
     char* py_argv = atom_getsym(argv)->s_name;
     post("%s %s", s->s_name, py_argv);
 
+    Py_CLEAR(x->c_func);
     x->c_func = PyRun_String(py_argv, Py_eval_input, x->py->p_globals, x->py->p_globals);
 
+    if (x->c_func != NULL && !PyCallable_Check(x->c_func)) {
+        Py_CLEAR(x->c_func);
+        PyErr_Format(PyExc_TypeError, "'%s' is not callable", py_argv);
+    }
+
     if (x->c_func != NULL) {
         PyGILState_Release(gstate);
         return MAX_ERR_NONE;
@@ -352,3 +504,340 @@ t_max_err krait_defer(t_krait* x, t_symbol* s, long argc, t_atom* argv)
         return MAX_ERR_GENERIC;
     }
 }
+
+
+// ---------------------------------------------------------------------------
+// sequencer
+
+/**
+ * @brief Starts sequencing the events of a python iterator
+ *
+ * The argument is evaluated in the object's namespace. It must give an
+ * iterator (e.g. a generator), an iterable, or a callable returning one.
+ * Each item is an event: a number `beat`, or a sequence
+ * `(beat, atom, ...)`, where `beat` is the event time in quarter notes
+ * from the start of the sequence. Events are output as a bang, a list or
+ * a message from the left outlet; a bang is sent from the right outlet
+ * when the iterator is exhausted.
+ *
+ * The iterator is created on the calling thread and handed to the
+ * scheduler, which starts it (see krait_seq_swap).
+ *
+ * @param x pointer to krait object
+ * @param s symbol value
+ * @param argc number of arguments
+ * @param argv array of atom values
+ *
+ * @return t_max_err
+ */
+t_max_err krait_sequence(t_krait* x, t_symbol* s, long argc, t_atom* argv)
+{
+    PyGILState_STATE gstate;
+    PyObject* pval = NULL;
+    PyObject* iter = NULL;
+    char* py_argv = NULL;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        py_error(x->py, "sequence needs a python expression");
+        return MAX_ERR_GENERIC;
+    }
+    py_argv = atom_getsym(argv)->s_name;
+
+    gstate = PyGILState_Ensure();
+
+    pval = PyRun_String(py_argv, Py_eval_input, x->py->p_globals, x->py->p_globals);
+    if (pval == NULL) {
+        goto error;
+    }
+
+    if (!PyIter_Check(pval) && PyCallable_Check(pval)) {
+        Py_SETREF(pval, PyObject_CallNoArgs(pval));
+        if (pval == NULL) {
+            goto error;
+        }
+    }
+
+    iter = PyObject_GetIter(pval);
+    if (iter == NULL) {
+        goto error;
+    }
+    Py_DECREF(pval);
+    PyGILState_Release(gstate);
+
+    krait_seq_post(x, iter);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x->py, "sequence %s", py_argv);
+    Py_XDECREF(pval);
+    PyGILState_Release(gstate);
+    return MAX_ERR_GENERIC;
+}
+
+
+/**
+ * @brief Fires the due events, refills and schedules the next event
+ *
+ * Called by the `eventtime` time object. Due events are output without
+ * the GIL; python is only entered when the fetched events do not cover
+ * the lookahead window.
+ *
+ * @param x pointer to krait object
+ */
+void krait_seq_tick(t_krait* x)
+{
+    t_krait_event event;
+    double now, horizon;
+
+    if (!x->c_running) {
+        return;
+    }
+
+    // the time scheduled for this tick: ITM ticks do not advance while
+    // the transport is stopped, so they cannot be used as a clock
+    now = x->c_seq_now;
+
+    // all events due at this time are fired in one pass
+    while (x->c_running && x->c_count > 0
+           && x->c_events[x->c_head].ticks <= now) {
+        event = x->c_events[x->c_head];
+        x->c_head = (x->c_head + 1) % KRAIT_MAX_EVENTS;
+        x->c_count--;
+        krait_seq_output(x, &event); // may stop the sequence
+    }
+
+    if (!x->c_running) {
+        return;
+    }
+
+    horizon = now + time_getticks(x->c_lookahead);
+    if (x->c_seq != NULL && (x->c_count == 0 || x->c_seq_last < horizon)) {
+        krait_seq_fetch(x, horizon);
+    }
+
+    if (x->c_count > 0) {
+        krait_seq_schedule(x, now);
+    } else if (x->c_seq == NULL) {
+        x->c_running = 0;
+        outlet_bang(x->c_outlet2);
+    }
+}
+
+
+/**
+ * @brief Fetches events from the python iterator
+ *
+ * Fetches until an event lies beyond `horizon`, the ring buffer is full or
+ * the iterator is exhausted (the iterator is then released). Events which
+ * go back in time are clamped to the previous event time.
+ *
+ * @param x pointer to krait object
+ * @param horizon end of the lookahead window (ticks from the sequence start)
+ *
+ * @return number of events fetched
+ */
+long krait_seq_fetch(t_krait* x, double horizon)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_SCHED);
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    metrics_gil(&span);
+    PyObject* item = NULL;
+    PyObject* seq = NULL;
+    t_krait_event* e = NULL;
+    long fetched = 0;
+    double beat;
+
+    while (x->c_count < KRAIT_MAX_EVENTS && x->c_seq_last <= horizon) {
+        metrics_convert(&span);
+        item = PyIter_Next(x->c_seq);
+        metrics_exec(&span);
+        if (item == NULL) {
+            if (PyErr_Occurred()) {
+                py_handle_error(x->py, "sequence");
+            }
+            Py_CLEAR(x->c_seq);
+            break;
+        }
+
+        e = &x->c_events[(x->c_head + x->c_count) % KRAIT_MAX_EVENTS];
+        e->argc = 0;
+
+        if (PyNumber_Check(item)) {
+            beat = PyFloat_AsDouble(item);
+        } else {
+            seq = PySequence_Fast(item, "sequence event must be a number or a sequence");
+            if (seq == NULL || PySequence_Fast_GET_SIZE(seq) == 0) {
+                goto skip;
+            }
+            beat = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, 0));
+
+            for (Py_ssize_t i = 1; i < PySequence_Fast_GET_SIZE(seq)
+                                   && e->argc < KRAIT_MAX_ATOMS; i++) {
+                PyObject* v = PySequence_Fast_GET_ITEM(seq, i);
+                if (PyLong_Check(v)) {
+                    atom_setlong(e->argv + e->argc++, PyLong_AsLong(v));
+                } else if (PyFloat_Check(v)) {
+                    atom_setfloat(e->argv + e->argc++, PyFloat_AsDouble(v));
+                } else if (PyUnicode_Check(v)) {
+                    const char* str = PyUnicode_AsUTF8(v);
+                    if (str == NULL) {
+                        goto skip;
+                    }
+                    atom_setsym(e->argv + e->argc++, gensym(str));
+                }
+            }
+            Py_CLEAR(seq);
+        }
+        if (PyErr_Occurred()) {
+            goto skip;
+        }
+
+        e->ticks = beat * KRAIT_TICKS_PER_BEAT;
+        if (e->ticks < x->c_seq_last) {
+            e->ticks = x->c_seq_last;
+        }
+        x->c_seq_last = e->ticks;
+        x->c_count++;
+        fetched++;
+        Py_DECREF(item);
+        continue;
+
+    skip:
+        py_handle_error(x->py, "invalid sequence event");
+        PyErr_Clear();
+        Py_XDECREF(seq);
+        seq = NULL;
+        Py_DECREF(item);
+    }
+
+    metrics_convert(&span);
+    PyGILState_Release(gstate);
+    metrics_end(x->py->p_metrics, &span, 1);
+    return fetched;
+}
+
+
+/**
+ * @brief Schedules the `eventtime` time object at the next event
+ *
+ * @param x pointer to krait object
+ * @param now current time (ticks from the sequence start)
+ */
+void krait_seq_schedule(t_krait* x, double now)
+{
+    t_atom a;
+    double delta = x->c_events[x->c_head].ticks - now;
+
+    if (delta < 0.) {
+        delta = 0.;
+    }
+    x->c_seq_now = now + delta;
+
+    atom_setfloat(&a, delta);
+    time_setvalue(x->c_seqtime, NULL, 1, &a);
+    time_schedule(x->c_seqtime, NULL);
+}
+
+
+/**
+ * @brief Outputs a sequencer event from the left outlet
+ *
+ * @param x pointer to krait object
+ * @param e event
+ */
+void krait_seq_output(t_krait* x, t_krait_event* e)
+{
+    if (e->argc == 0) {
+        outlet_bang(x->c_outlet);
+    } else if (atom_gettype(e->argv) == A_SYM) {
+        outlet_anything(x->c_outlet, atom_getsym(e->argv), e->argc - 1, e->argv + 1);
+    } else {
+        outlet_list(x->c_outlet, NULL, e->argc, e->argv);
+    }
+}
+
+
+/**
+ * @brief Stops the sequence
+ *
+ * Takes effect on the next scheduler pass (see krait_seq_post).
+ *
+ * @param x pointer to krait object
+ */
+void krait_seq_stop(t_krait* x)
+{
+    krait_seq_post(x, NULL);
+}
+
+
+/**
+ * @brief Hands an iterator (or a stop) to the scheduler
+ *
+ * The sequencer state is only touched by the scheduler, where the ticks
+ * run: a main thread stop could otherwise release the iterator while a
+ * tick is inside `PyIter_Next`. The last post before the swap wins.
+ *
+ * @param x pointer to krait object
+ * @param iter iterator to start (reference stolen), or NULL to stop
+ */
+void krait_seq_post(t_krait* x, PyObject* iter)
+{
+    PyObject* replaced = NULL;
+
+    critical_enter(x->c_seq_lock);
+    replaced = x->c_seq_pending;
+    x->c_seq_pending = iter;
+    x->c_seq_posted = 1;
+    critical_exit(x->c_seq_lock);
+
+    if (replaced != NULL) {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_DECREF(replaced);
+        PyGILState_Release(gstate);
+    }
+    clock_delay(x->c_seq_clock, 0);
+}
+
+
+/**
+ * @brief Stops the current sequence and starts the posted one
+ *
+ * Called by `c_seq_clock` on the scheduler.
+ *
+ * @param x pointer to krait object
+ */
+void krait_seq_swap(t_krait* x)
+{
+    PyObject* iter = NULL;
+    long posted = 0;
+
+    critical_enter(x->c_seq_lock);
+    posted = x->c_seq_posted;
+    iter = x->c_seq_pending;
+    x->c_seq_pending = NULL;
+    x->c_seq_posted = 0;
+    critical_exit(x->c_seq_lock);
+
+    if (!posted) {
+        return;
+    }
+
+    time_stop(x->c_seqtime);
+    x->c_running = 0;
+    x->c_head = 0;
+    x->c_count = 0;
+    if (x->c_seq != NULL) {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        Py_CLEAR(x->c_seq);
+        PyGILState_Release(gstate);
+    }
+
+    if (iter != NULL) {
+        x->c_seq = iter;
+        x->c_seq_now = 0.;
+        x->c_seq_last = 0.;
+        x->c_running = 1;
+        krait_seq_tick(x);
+    }
+}
@@ -0,0 +1,359 @@
+/** \file codecache.h
+    \brief A single-header bytecode cache for CPython externals.
+
+    Compiles python source files once: code objects are kept in an
+    in-memory dict (shared by the instances of an external) and marshalled
+    to `<max temp folder>/py-js-cache/<basename>.<hash of path>.pyc`.
+
+    Both caches are validated by a 64-bit FNV-1a hash and the size of the
+    source text, not by its modification time, so an edit which keeps the
+    size within the resolution of the file system clock is still seen.
+    Reading and hashing the source costs a fraction of compiling it.
+
+    Usage example:
+
+        static PyObject* code_cache = NULL; // path -> (hash, size, code)
+
+        t_codecache_hit hit;
+        PyObject* co = codecache_compile(&code_cache, path, 1, &hit);
+        ...
+        Py_CLEAR(code_cache);               // before finalizing python
+
+    All functions are `static inline`, need the GIL, and `Python.h` must
+    be included first.
+*/
+
+#ifndef CODECACHE_H
+#define CODECACHE_H
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "ext_path.h"
+
+#include "fnv1a.h"
+
+#include <Python.h>
+#include <marshal.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Constants */
+
+#define CODECACHE_DIR "py-js-cache"
+
+/** where a code object came from (see codecache_compile) */
+typedef enum t_codecache_hit {
+    CODECACHE_COMPILED,
+    CODECACHE_MEMORY,
+    CODECACHE_DISK,
+} t_codecache_hit;
+
+/*--------------------------------------------------------------------------*/
+/* Datastructures */
+
+/**
+ * @brief Header of a cached code object file (followed by marshal data)
+ *
+ * Similar to a `.pyc` header: the magic number ties the cache to the
+ * running python version and the hash and size of the source validate it.
+ */
+typedef struct t_codecache_header {
+    uint32_t magic;             /*!< PyImport_GetMagicNumber() */
+    uint32_t reserved;
+    uint64_t hash;              /*!< FNV-1a hash of the source */
+    int64_t size;               /*!< source size in bytes */
+} t_codecache_header;
+
+/*--------------------------------------------------------------------------*/
+/* Helpers */
+
+/**
+ * @brief Read a source file
+ *
+ * @param path path of file
+ * @param[out] size size of file
+ * @return char* nul-terminated text (free with sysmem_freeptr), or NULL
+ *         with a python exception set
+ */
+static inline char* codecache_read_source(const char* path, long long* size)
+{
+    struct stat st;
+    FILE* fhandle = NULL;
+    char* source = NULL;
+    size_t nread;
+
+    if (stat(path, &st) != 0) {
+        PyErr_Format(PyExc_FileNotFoundError, "could not stat file: %s", path);
+        return NULL;
+    }
+    fhandle = fopen(path, "rb");
+    if (fhandle == NULL) {
+        PyErr_Format(PyExc_OSError, "could not open file: %s", path);
+        return NULL;
+    }
+    source = (char*)sysmem_newptr((long)st.st_size + 1);
+    if (source == NULL) {
+        fclose(fhandle);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    nread = fread(source, 1, (size_t)st.st_size, fhandle);
+    source[nread] = '\0';
+    fclose(fhandle);
+    *size = (long long)nread;
+    return source;
+}
+
+/**
+ * @brief Get path of the on-disk cache file of a python source file
+ *
+ * @param path absolute path of python source file
+ * @param[out] cache_path buffer of MAX_PATH_CHARS for result
+ * @return t_max_err error code
+ *
+ * The cache folder is created if required.
+ */
+static inline t_max_err codecache_path(const char* path, char* cache_path)
+{
+    char tempfolder[MAX_PATH_CHARS];
+    char folder[MAX_PATH_CHARS];
+    char basename[MAX_PATH_CHARS];
+    short tempfolder_id = path_tempfolder();
+    short cache_id = 0;
+    struct stat st;
+
+    if (path_toabsolutesystempath(tempfolder_id, "", tempfolder) != MAX_ERR_NONE) {
+        return MAX_ERR_GENERIC;
+    }
+    snprintf(cache_path, MAX_PATH_CHARS, "%s/%s", tempfolder, CODECACHE_DIR);
+    if (stat(cache_path, &st) != 0
+        && path_createfolder(tempfolder_id, CODECACHE_DIR, &cache_id)) {
+        return MAX_ERR_GENERIC;
+    }
+
+    path_splitnames(path, folder, basename);
+    snprintf(cache_path, MAX_PATH_CHARS, "%s/%s/%s.%016llx.pyc", tempfolder,
+             CODECACHE_DIR, basename,
+             (unsigned long long)codecache_fnv1a(path, strlen(path),
+                                                 CODECACHE_FNV_OFFSET));
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* On-disk cache */
+
+/**
+ * @brief Read a cached code object if it is valid for the given source
+ *
+ * @param cache_path path of cache file
+ * @param hash hash of source
+ * @param size size of source
+ * @return PyObject* code object (new reference) or NULL if missing / stale
+ *
+ * Never leaves a python exception set.
+ */
+static inline PyObject* codecache_read(const char* cache_path, uint64_t hash,
+                                       long long size)
+{
+    t_codecache_header header;
+    PyObject* co = NULL;
+    char* data = NULL;
+    long len = 0;
+
+    FILE* fhandle = fopen(cache_path, "rb");
+    if (fhandle == NULL) {
+        return NULL;
+    }
+
+    if (fread(&header, sizeof(header), 1, fhandle) != 1
+        || header.magic != (uint32_t)PyImport_GetMagicNumber()
+        || header.hash != hash || header.size != size) {
+        goto finally;
+    }
+
+    fseek(fhandle, 0, SEEK_END);
+    len = ftell(fhandle) - (long)sizeof(header);
+    fseek(fhandle, sizeof(header), SEEK_SET);
+    if (len <= 0) {
+        goto finally;
+    }
+
+    data = (char*)sysmem_newptr(len);
+    if (data == NULL || fread(data, 1, len, fhandle) != (size_t)len) {
+        goto finally;
+    }
+
+    co = PyMarshal_ReadObjectFromString(data, len);
+    if (co == NULL || !PyCode_Check(co)) {
+        PyErr_Clear();
+        Py_CLEAR(co);
+    }
+
+finally:
+    if (data) {
+        sysmem_freeptr(data);
+    }
+    fclose(fhandle);
+    return co;
+}
+
+/**
+ * @brief Write a code object to the on-disk cache
+ *
+ * @param cache_path path of cache file
+ * @param hash hash of source
+ * @param size size of source
+ * @param co code object
+ * @return t_max_err error code
+ *
+ * Writes to a temporary file which is then renamed so that concurrent
+ * readers never see a partial file. Failure is not fatal.
+ */
+static inline t_max_err codecache_write(const char* cache_path, uint64_t hash,
+                                        long long size, PyObject* co)
+{
+    char tmp_path[MAX_PATH_CHARS];
+    t_codecache_header header;
+    PyObject* pbytes = NULL;
+    FILE* fhandle = NULL;
+    t_max_err ret = MAX_ERR_GENERIC;
+
+    header.magic = (uint32_t)PyImport_GetMagicNumber();
+    header.reserved = 0;
+    header.hash = hash;
+    header.size = size;
+
+    pbytes = PyMarshal_WriteObjectToString(co, Py_MARSHAL_VERSION);
+    if (pbytes == NULL) {
+        PyErr_Clear();
+        goto finally;
+    }
+
+    snprintf(tmp_path, MAX_PATH_CHARS, "%s.tmp", cache_path);
+    fhandle = fopen(tmp_path, "wb");
+    if (fhandle == NULL) {
+        goto finally;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, fhandle) == 1
+        && fwrite(PyBytes_AS_STRING(pbytes), 1, PyBytes_GET_SIZE(pbytes), fhandle)
+               == (size_t)PyBytes_GET_SIZE(pbytes)) {
+        ret = MAX_ERR_NONE;
+    }
+    fclose(fhandle);
+
+    if (ret == MAX_ERR_NONE) {
+        remove(cache_path); // rename does not overwrite on windows
+        if (rename(tmp_path, cache_path) != 0) {
+            ret = MAX_ERR_GENERIC;
+        }
+    }
+    if (ret != MAX_ERR_NONE) {
+        remove(tmp_path);
+    }
+
+finally:
+    Py_XDECREF(pbytes);
+    return ret;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Compilation */
+
+/**
+ * @brief Compile a python source file to a code object, using the caches
+ *
+ * @param memcache in-memory cache, a dict created on first use
+ * @param path absolute path of python source file
+ * @param use_cache 0 to always compile and not store the result
+ * @param[out] hit where the code object came from (or NULL)
+ * @return PyObject* code object (new reference) or NULL with exception set
+ *
+ * Looks up the in-memory cache, then the on-disk cache, before compiling
+ * the source and storing the result in both.
+ */
+static inline PyObject* codecache_compile(PyObject** memcache, const char* path,
+                                          int use_cache, t_codecache_hit* hit)
+{
+    char cache_path[MAX_PATH_CHARS];
+    char* source = NULL;
+    PyObject* co = NULL;
+    PyObject* entry = NULL;
+    long long size = 0;
+    uint64_t hash;
+    int has_cache_path = 0;
+
+    if (hit) {
+        *hit = CODECACHE_COMPILED;
+    }
+    source = codecache_read_source(path, &size);
+    if (source == NULL) {
+        return NULL;
+    }
+    hash = codecache_fnv1a(source, (size_t)size, CODECACHE_FNV_OFFSET);
+
+    if (use_cache) {
+        if (*memcache == NULL) {
+            *memcache = PyDict_New();
+            if (*memcache == NULL) {
+                goto finally;
+            }
+        }
+
+        // 1. in-memory cache: (hash, size, code)
+        entry = PyDict_GetItemString(*memcache, path); // borrowed
+        if (entry != NULL
+            && PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(entry, 0)) == hash
+            && PyLong_AsLongLong(PyTuple_GET_ITEM(entry, 1)) == size) {
+            co = PyTuple_GET_ITEM(entry, 2);
+            Py_INCREF(co);
+            if (hit) {
+                *hit = CODECACHE_MEMORY;
+            }
+            goto finally;
+        }
+
+        // 2. on-disk cache
+        has_cache_path = (codecache_path(path, cache_path) == MAX_ERR_NONE);
+        if (has_cache_path) {
+            co = codecache_read(cache_path, hash, size);
+            if (co != NULL && hit) {
+                *hit = CODECACHE_DISK;
+            }
+        }
+    }
+
+    // 3. compile from source
+    if (co == NULL) {
+        co = Py_CompileStringExFlags(source, path, Py_file_input, NULL, -1);
+        if (co == NULL || !use_cache) {
+            goto finally;
+        }
+        if (has_cache_path) {
+            codecache_write(cache_path, hash, size, co);
+        }
+    }
+
+    entry = Py_BuildValue("(KLO)", (unsigned long long)hash, size, co);
+    if (entry == NULL || PyDict_SetItemString(*memcache, path, entry) != 0) {
+        PyErr_Clear(); // caching is best-effort
+    }
+    Py_XDECREF(entry);
+
+finally:
+    sysmem_freeptr(source);
+    return co;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CODECACHE_H */
@@ -0,0 +1,48 @@
+/** \file fnv1a.h
+    \brief The 64-bit FNV-1a hash which validates cached code objects.
+
+    Used by codecache.h for the CPython externals and by the pocketpy
+    externals, which cannot include codecache.h. It has no dependencies.
+
+    Usage example:
+
+        uint64_t hash = codecache_fnv1a(source, size, CODECACHE_FNV_OFFSET);
+*/
+
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CODECACHE_FNV_OFFSET 1469598103934665603ULL
+#define CODECACHE_FNV_PRIME 1099511628211ULL
+
+/**
+ * @brief 64-bit FNV-1a hash of a buffer
+ *
+ * @param data buffer
+ * @param n size of buffer
+ * @param h CODECACHE_FNV_OFFSET, or a previous result to continue it
+ * @return uint64_t hash
+ */
+static inline uint64_t codecache_fnv1a(const void* data, size_t n, uint64_t h)
+{
+    const unsigned char* p = (const unsigned char*)data;
+
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= CODECACHE_FNV_PRIME;
+    }
+    return h;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FNV1A_H */
@@ -39,6 +39,11 @@ t_max_err mamba_code(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err mamba_anything(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err mamba_pipe(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
 
+// instrumentation
+t_max_err mamba_metrics(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err mamba_trace(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err mamba_profile(t_mamba* x, t_symbol* s, long argc, t_atom* argv);
+
 
 static t_class* mamba_class = NULL;
 
@@ -59,6 +64,9 @@ void ext_main(void* r)
     class_addmethod(c, (method)mamba_code,      "code",     A_GIMME, 0);
     class_addmethod(c, (method)mamba_pipe,      "pipe",     A_GIMME, 0);
     class_addmethod(c, (method)mamba_anything,  "anything", A_GIMME, 0);
+    class_addmethod(c, (method)mamba_metrics,   "metrics",  A_GIMME, 0);
+    class_addmethod(c, (method)mamba_trace,     "trace",    A_GIMME, 0);
+    class_addmethod(c, (method)mamba_profile,   "profile",  A_GIMME, 0);
 
     class_register(CLASS_BOX, c);
 
@@ -234,3 +242,49 @@ t_max_err mamba_pipe(t_mamba* x, t_symbol* s, long argc, t_atom* argv)
 }
 
 
+/**
+ * @brief Mambo metrics method
+ *
+ * @param x pointer to mamba object
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (`reset` to clear the metrics)
+ *
+ * @return t_max_err
+ */
+t_max_err mamba_metrics(t_mamba* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_metrics(x->py, s, argc, argv, x->c_outlet);
+}
+
+
+/**
+ * @brief Mambo trace method
+ *
+ * @param x pointer to mamba object
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (`start [python]`, `stop`, `write [path]`)
+ *
+ * @return t_max_err
+ */
+t_max_err mamba_trace(t_mamba* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_trace(x->py, (t_object*)x, argc, argv, x->c_outlet);
+}
+
+
+/**
+ * @brief Mambo profile method
+ *
+ * @param x pointer to mamba object
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (`start [interval_ms]`, `stop`, `dump [path]`)
+ *
+ * @return t_max_err
+ */
+t_max_err mamba_profile(t_mamba* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_profile(x->py, (t_object*)x, argc, argv, x->c_outlet);
+}
@@ -0,0 +1,757 @@
+/** \file memstats.h
+    \brief A single-header memory accounting library for CPython externals.
+
+    Wraps the `PYMEM_DOMAIN_MEM` and `PYMEM_DOMAIN_OBJ` allocators of the
+    interpreter (PyMem_Malloc and PyObject_Malloc, i.e. all python objects)
+    with a 16 byte header recording the owner and size of each block. The
+    owner is the instance running python on the calling thread, set with
+    memstats_enter() after taking the GIL and restored by memstats_leave();
+    allocations outside of an instance are counted as `interpreter`.
+
+    A block is counted against its owner until it is freed, by whatever
+    thread or instance: the live bytes of an instance are the memory its
+    scripts created and which is still alive. Records are never freed, so
+    what an instance leaves behind after it is deleted is still reported.
+
+    Accounting costs the header of each block (a 32 byte object takes 48)
+    and a few adds per allocation, about 25% of an allocation-bound loop,
+    so it is off unless the external is built with
+    `PY_MEMSTATS=1` or Max is started with the `PY_MEMSTATS` environment
+    variable set (to anything but 0). The allocator must be installed
+    before the interpreter is initialized: call memstats_preinit() before
+    Py_InitializeFromConfig(). It stays installed until the process exits.
+
+    Allocation sites are not recorded by the header: the report adds the
+    top sites of tracemalloc while it is tracing (`memory trace`), which
+    also sees raw allocations reported to it, like numpy buffers.
+
+    The accounting wraps whichever allocator python was configured with,
+    so with python 3.13+ started with `PYTHONMALLOC=mimalloc` the objects
+    live in mimalloc heaps and are accounted the same way.
+
+    Externals sharing one interpreter (e.g. `py` and `cobra`) share one
+    hook: its ctx starts with MEMSTATS_MAGIC and leads to the process-wide
+    state, which an external adopts instead of wrapping the hook again. A
+    block allocated through two hooks and freed through one would corrupt
+    the heap. The owner of the calling thread lives in the thread-locals of
+    the external which installed the hook, reached through the state.
+
+    Usage example (the `memory` message of an external):
+
+        memory [n]              // dictionary with the top n sites (10)
+        memory reset            // peak = live, also for tracemalloc
+        memory trace [nframes]  // start tracemalloc
+        memory trace stop       // stop tracemalloc
+
+    `Python.h` must be included first.
+*/
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "ext_dictobj.h"
+
+#include <Python.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Constants */
+
+#ifndef PY_MEMSTATS
+#define PY_MEMSTATS 0           /*!< accounting without the env variable */
+#endif
+
+#define MEMSTATS_SITES 10       /*!< default number of tracemalloc sites */
+#define MEMSTATS_DEPTH 16       /*!< nesting of memstats_enter per thread */
+#define MEMSTATS_MAGIC 0x6d656d7374617473ULL /*!< "memstats": ctx of a hook */
+
+/*--------------------------------------------------------------------------*/
+/* Datastructures */
+
+/** allocations of one instance (or of the interpreter) */
+typedef struct t_memstats {
+    uint64_t live;              /*!< bytes in live blocks (wraps below 0) */
+    uint64_t peak;              /*!< highest live since creation or reset */
+    uint64_t allocs;            /*!< blocks allocated */
+    uint64_t frees;             /*!< blocks freed */
+    t_symbol* name;             /*!< name of the instance */
+    int freed;                  /*!< the instance was freed */
+    t_dictionary* dict;         /*!< registered dictionary of `memory` */
+    t_symbol* dict_name;        /*!< name of dict */
+    struct t_memstats* next;
+} t_memstats;
+
+/** prefix of each accounted block, keeps the 16 byte alignment */
+typedef union t_memstats_header {
+    struct {
+        t_memstats* owner;
+        size_t size;
+    } block;
+    char pad[16];
+} t_memstats_header;
+
+struct t_memstats_state;
+
+/** ctx of the hook of one domain */
+typedef struct t_memstats_hook {
+    uint64_t magic;             /*!< MEMSTATS_MAGIC */
+    PyMemAllocatorEx wrapped;   /*!< allocator of the domain below the hook */
+    struct t_memstats_state* state;
+} t_memstats_hook;
+
+/** process-wide state, created with the hook and never freed */
+typedef struct t_memstats_state {
+    t_memstats_hook mem;        /*!< PYMEM_DOMAIN_MEM hook */
+    t_memstats_hook obj;        /*!< PYMEM_DOMAIN_OBJ hook */
+    t_memstats interp;          /*!< blocks allocated outside instances */
+    t_memstats* records;        /*!< all instances, newest first */
+    void (*enter)(t_memstats* m); /*!< owners of the installing external */
+    void (*leave)(void);
+} t_memstats_state;
+
+// shared state, NULL while allocations are not accounted
+static t_memstats_state* memstats_state;
+
+// records created by this external before it found the state
+static t_memstats* memstats_pending;
+
+// owner of the allocations of the calling thread, and the owners it hides
+static TRACE_TLS t_memstats* memstats_tls_owner;
+static TRACE_TLS t_memstats* memstats_tls_stack[MEMSTATS_DEPTH];
+static TRACE_TLS int memstats_tls_depth;
+
+/*--------------------------------------------------------------------------*/
+/* Owners */
+
+static void memstats_tls_enter(t_memstats* m)
+{
+    if (memstats_tls_depth < MEMSTATS_DEPTH) {
+        memstats_tls_stack[memstats_tls_depth] = memstats_tls_owner;
+    }
+    memstats_tls_depth++;
+    if (m) {
+        memstats_tls_owner = m;
+    }
+}
+
+static void memstats_tls_leave(void)
+{
+    if (memstats_tls_depth == 0) {
+        return;
+    }
+    memstats_tls_depth--;
+    if (memstats_tls_depth < MEMSTATS_DEPTH) {
+        memstats_tls_owner = memstats_tls_stack[memstats_tls_depth];
+    }
+}
+
+/**
+ * @brief Attribute the allocations of the calling thread to an instance
+ *
+ * @param m accounting of the instance (NULL: keep the current owner)
+ *
+ * Must be matched by memstats_leave(), usually around a GIL acquisition.
+ * Does nothing while allocations are not accounted.
+ */
+static inline void memstats_enter(t_memstats* m)
+{
+    if (memstats_state) {
+        memstats_state->enter(m);
+    }
+}
+
+/** restore the owner of the matching memstats_enter() */
+static inline void memstats_leave(void)
+{
+    if (memstats_state) {
+        memstats_state->leave();
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Allocator */
+
+/*
+ * The MEM and OBJ domains are only used with the GIL held, which
+ * serializes the counters: plain adds are enough, except in free-threaded
+ * builds. MEMSTATS_ADD evaluates to the new value.
+ */
+#ifdef Py_GIL_DISABLED
+#define MEMSTATS_ADD(p, v) (METRICS_ADD(p, v) + (v))
+#define MEMSTATS_MAX(p, v) metrics_atomic_max(p, v)
+#else
+#define MEMSTATS_ADD(p, v) (*(p) += (v))
+#define MEMSTATS_MAX(p, v) \
+    do {                   \
+        if (*(p) < (v)) {  \
+            *(p) = (v);    \
+        }                  \
+    } while (0)
+#endif
+
+/** count a new block, returns the pointer after its header */
+static inline void* memstats_account(t_memstats_hook* hook,
+                                     t_memstats_header* h, size_t size)
+{
+    t_memstats* m = memstats_tls_owner ? memstats_tls_owner
+                                       : &hook->state->interp;
+    uint64_t live;
+
+    h->block.owner = m;
+    h->block.size = size;
+    live = MEMSTATS_ADD(&m->live, (uint64_t)size);
+    (void)MEMSTATS_ADD(&m->allocs, 1);
+    if ((int64_t)live > 0) {
+        MEMSTATS_MAX(&m->peak, live);
+    }
+    return h + 1;
+}
+
+static void* memstats_malloc(void* ctx, size_t size)
+{
+    t_memstats_hook* hook = (t_memstats_hook*)ctx;
+    PyMemAllocatorEx* a = &hook->wrapped;
+    t_memstats_header* h;
+
+    if (size > (size_t)PY_SSIZE_T_MAX - sizeof(t_memstats_header)) {
+        return NULL;
+    }
+    h = (t_memstats_header*)a->malloc(a->ctx,
+                                      size + sizeof(t_memstats_header));
+    return h ? memstats_account(hook, h, size) : NULL;
+}
+
+static void* memstats_calloc(void* ctx, size_t nelem, size_t elsize)
+{
+    t_memstats_hook* hook = (t_memstats_hook*)ctx;
+    PyMemAllocatorEx* a = &hook->wrapped;
+    t_memstats_header* h;
+    size_t size;
+
+    if (elsize && nelem > ((size_t)PY_SSIZE_T_MAX
+                           - sizeof(t_memstats_header)) / elsize) {
+        return NULL;
+    }
+    size = nelem * elsize;
+    h = (t_memstats_header*)a->calloc(a->ctx, 1,
+                                      size + sizeof(t_memstats_header));
+    return h ? memstats_account(hook, h, size) : NULL;
+}
+
+static void* memstats_realloc(void* ctx, void* ptr, size_t size)
+{
+    PyMemAllocatorEx* a = &((t_memstats_hook*)ctx)->wrapped;
+    t_memstats_header* h;
+    t_memstats* m;
+    size_t old;
+    uint64_t live;
+
+    if (ptr == NULL) {
+        return memstats_malloc(ctx, size);
+    }
+    if (size > (size_t)PY_SSIZE_T_MAX - sizeof(t_memstats_header)) {
+        return NULL;
+    }
+    h = (t_memstats_header*)ptr - 1;
+    m = h->block.owner;
+    old = h->block.size;
+    h = (t_memstats_header*)a->realloc(a->ctx, h,
+                                       size + sizeof(t_memstats_header));
+    if (h == NULL) {
+        return NULL;
+    }
+    // a resized block stays with the instance which allocated it
+    h->block.size = size;
+    live = MEMSTATS_ADD(&m->live, (uint64_t)size - (uint64_t)old);
+    if (size > old && (int64_t)live > 0) {
+        MEMSTATS_MAX(&m->peak, live);
+    }
+    return h + 1;
+}
+
+static void memstats_free(void* ctx, void* ptr)
+{
+    PyMemAllocatorEx* a = &((t_memstats_hook*)ctx)->wrapped;
+    t_memstats_header* h;
+
+    if (ptr == NULL) {
+        return;
+    }
+    h = (t_memstats_header*)ptr - 1;
+    (void)MEMSTATS_ADD(&h->block.owner->live, (uint64_t)0 - h->block.size);
+    (void)MEMSTATS_ADD(&h->block.owner->frees, 1);
+    a->free(a->ctx, h);
+}
+
+/** add a record to the instances of the report (or keep it pending) */
+static inline void memstats_list(t_memstats* m)
+{
+    if (memstats_state) {
+        m->next = memstats_state->records;
+        memstats_state->records = m;
+    } else {
+        m->next = memstats_pending;
+        memstats_pending = m;
+    }
+}
+
+/** the state was found or created: list the pending records */
+static inline void memstats_attach(t_memstats_state* state)
+{
+    t_memstats* m;
+
+    memstats_state = state;
+    while ((m = memstats_pending) != NULL) {
+        memstats_pending = m->next;
+        memstats_list(m);
+    }
+}
+
+/** the allocator is a memstats hook, of this external or another one */
+static inline t_memstats_hook* memstats_hook_of(const PyMemAllocatorEx* a)
+{
+    t_memstats_hook* hook = (t_memstats_hook*)a->ctx;
+
+    if (a->malloc == memstats_malloc
+        || (hook && ((uintptr_t)hook % sizeof(uint64_t)) == 0
+            && hook->magic == MEMSTATS_MAGIC)) {
+        return hook;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Share the hook of the interpreter if there is one
+ *
+ * @return int 1 if the allocators are hooked
+ */
+static inline int memstats_adopt(void)
+{
+    PyMemAllocatorEx mem;
+    t_memstats_hook* hook;
+
+    PyMem_GetAllocator(PYMEM_DOMAIN_MEM, &mem);
+    if ((hook = memstats_hook_of(&mem)) == NULL) {
+        return 0;
+    }
+    if (memstats_state == NULL) {
+        memstats_attach(hook->state);
+    }
+    return 1;
+}
+
+/**
+ * @brief Hook the MEM and OBJ domains, never on top of an existing hook
+ *
+ * A hook replaced by a pre-initialization (after a finalize) is installed
+ * again with the same state, on top of the new allocator.
+ */
+static inline int memstats_install(void)
+{
+    t_memstats_state* state = NULL;
+    PyMemAllocatorEx mem;
+    PyMemAllocatorEx obj;
+    PyMemAllocatorEx hook;
+
+    PyMem_GetAllocator(PYMEM_DOMAIN_MEM, &mem);
+    PyMem_GetAllocator(PYMEM_DOMAIN_OBJ, &obj);
+    if (memstats_hook_of(&mem) || memstats_hook_of(&obj)) {
+        memstats_adopt();
+        return memstats_state != NULL;
+    }
+
+    if ((state = memstats_state) == NULL) {
+        state = (t_memstats_state*)sysmem_newptrclear(sizeof(t_memstats_state));
+        if (state == NULL) {
+            return 0;
+        }
+        state->mem.magic = MEMSTATS_MAGIC;
+        state->mem.state = state;
+        state->obj.magic = MEMSTATS_MAGIC;
+        state->obj.state = state;
+    }
+    state->mem.wrapped = mem;
+    state->obj.wrapped = obj;
+    state->enter = memstats_tls_enter;
+    state->leave = memstats_tls_leave;
+
+    hook.malloc = memstats_malloc;
+    hook.calloc = memstats_calloc;
+    hook.realloc = memstats_realloc;
+    hook.free = memstats_free;
+    hook.ctx = &state->mem;
+    PyMem_SetAllocator(PYMEM_DOMAIN_MEM, &hook);
+    hook.ctx = &state->obj;
+    PyMem_SetAllocator(PYMEM_DOMAIN_OBJ, &hook);
+    if (memstats_state == NULL) {
+        memstats_attach(state);
+    }
+    return 1;
+}
+
+/** accounting was requested at build time or with PY_MEMSTATS */
+static inline int memstats_requested(void)
+{
+    const char* env = getenv("PY_MEMSTATS");
+
+    if (env && *env) {
+        return strcmp(env, "0") != 0;
+    }
+    return PY_MEMSTATS;
+}
+
+/**
+ * @brief Pre-initialize python and install the accounting allocator
+ *
+ * @param isolated pre-initialize with the isolated configuration
+ * @return int 1 if the allocations are accounted
+ *
+ * Call before each Py_InitializeFromConfig(). An external finds the hook
+ * installed by another one (even while python runs) and shares it. It
+ * installs one only if accounting was requested and python is not
+ * initialized. Python selects its allocator (`PYTHONMALLOC`) when
+ * pre-initialized, which is done here first so that the hook wraps the
+ * selected allocator.
+ */
+static inline int memstats_preinit(int isolated)
+{
+#if PY_VERSION_HEX >= 0x03080000
+    PyPreConfig preconfig;
+    PyStatus status;
+
+    if (Py_IsInitialized() || !memstats_requested()) {
+        memstats_adopt();
+        return memstats_state != NULL;
+    }
+    if (isolated) {
+        PyPreConfig_InitIsolatedConfig(&preconfig);
+    } else {
+        PyPreConfig_InitPythonConfig(&preconfig);
+    }
+    preconfig.parse_argv = 0;
+    status = Py_PreInitialize(&preconfig);
+    if (PyStatus_Exception(status)) {
+        post("[memstats] could not pre-initialize python: "
+             "allocations are not accounted");
+        return 0;
+    }
+    memstats_install();
+#endif
+    return memstats_state != NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Lifecycle */
+
+/**
+ * @brief Create the accounting of an instance
+ *
+ * @param name name of the instance
+ * @return t_memstats* record, never freed (see memstats_release)
+ *
+ * Call from the main thread.
+ */
+static inline t_memstats* memstats_new(t_symbol* name)
+{
+    t_memstats* m = (t_memstats*)sysmem_newptrclear(sizeof(t_memstats));
+
+    if (m) {
+        m->name = name;
+        memstats_list(m);
+    }
+    return m;
+}
+
+/**
+ * @brief The instance was freed
+ *
+ * The record keeps counting the blocks it still owns, which are reported
+ * as `<name> (freed)` until they are all freed.
+ */
+static inline void memstats_release(t_memstats* m)
+{
+    if (m == NULL) {
+        return;
+    }
+    if (m->dict) {
+        object_free(m->dict);
+        m->dict = NULL;
+    }
+    m->freed = 1;
+}
+
+/** the peak restarts from the current live bytes */
+static inline void memstats_reset(t_memstats* m)
+{
+    METRICS_STORE(&m->peak, METRICS_LOAD(&m->live));
+}
+
+/*--------------------------------------------------------------------------*/
+/* Queries */
+
+static inline void memstats_fill_record(t_memstats* m, t_dictionary* d)
+{
+    int64_t live = (int64_t)METRICS_LOAD(&m->live);
+
+    dictionary_appendlong(d, gensym("live_bytes"), (t_atom_long)live);
+    dictionary_appendlong(d, gensym("peak_bytes"),
+                          (t_atom_long)METRICS_LOAD(&m->peak));
+    dictionary_appendlong(d, gensym("allocs"),
+                          (t_atom_long)METRICS_LOAD(&m->allocs));
+    dictionary_appendlong(d, gensym("frees"),
+                          (t_atom_long)METRICS_LOAD(&m->frees));
+}
+
+/** one sub-dictionary per instance, freed ones while they own blocks */
+static inline void memstats_fill_instances(t_dictionary* d)
+{
+    char key[256];
+    t_dictionary* sub;
+
+    for (t_memstats* m = memstats_state->records; m; m = m->next) {
+        if (m->freed && METRICS_LOAD(&m->live) == 0) {
+            continue;
+        }
+        snprintf(key, sizeof(key), "%s%s", m->name ? m->name->s_name : "?",
+                 m->freed ? " (freed)" : "");
+        sub = dictionary_new();
+        memstats_fill_record(m, sub);
+        dictionary_appenddictionary(d, gensym(key), (t_object*)sub);
+    }
+    sub = dictionary_new();
+    memstats_fill_record(&memstats_state->interp, sub);
+    dictionary_appenddictionary(d, gensym("interpreter"), (t_object*)sub);
+}
+
+/**
+ * @brief Append the top allocation sites of tracemalloc
+ *
+ * @param d dictionary
+ * @param limit number of sites
+ *
+ * Adds `traced_bytes`, `traced_peak_bytes` and `sites`, a sub-dictionary
+ * of `file:line` -> `bytes count`, while tracemalloc is tracing. The GIL
+ * must be held.
+ */
+static inline void memstats_fill_sites(t_dictionary* d, long limit)
+{
+    PyObject* mod = NULL;
+    PyObject* tracing = NULL;
+    PyObject* traced = NULL;
+    PyObject* snapshot = NULL;
+    PyObject* stats = NULL;
+    t_dictionary* sub = NULL;
+    Py_ssize_t n;
+
+    mod = PyImport_ImportModule("tracemalloc");
+    if (mod == NULL) {
+        goto error;
+    }
+    tracing = PyObject_CallMethod(mod, "is_tracing", NULL);
+    if (tracing == NULL) {
+        goto error;
+    }
+    if (!PyObject_IsTrue(tracing)) {
+        goto finally;
+    }
+    traced = PyObject_CallMethod(mod, "get_traced_memory", NULL);
+    if (traced == NULL || !PyTuple_Check(traced) || PyTuple_Size(traced) < 2) {
+        goto error;
+    }
+    dictionary_appendlong(d, gensym("traced_bytes"),
+        (t_atom_long)PyLong_AsLongLong(PyTuple_GET_ITEM(traced, 0)));
+    dictionary_appendlong(d, gensym("traced_peak_bytes"),
+        (t_atom_long)PyLong_AsLongLong(PyTuple_GET_ITEM(traced, 1)));
+
+    snapshot = PyObject_CallMethod(mod, "take_snapshot", NULL);
+    if (snapshot == NULL) {
+        goto error;
+    }
+    // sorted by size, then count
+    stats = PyObject_CallMethod(snapshot, "statistics", "s", "lineno");
+    if (stats == NULL || !PyList_Check(stats)) {
+        goto error;
+    }
+    sub = dictionary_new();
+    n = PyList_GET_SIZE(stats);
+    for (Py_ssize_t i = 0; i < n && i < limit; i++) {
+        PyObject* stat = PyList_GET_ITEM(stats, i); // borrowed
+        PyObject* size = PyObject_GetAttrString(stat, "size");
+        PyObject* count = PyObject_GetAttrString(stat, "count");
+        PyObject* tb = PyObject_GetAttrString(stat, "traceback");
+        PyObject* frame = tb ? PySequence_GetItem(tb, 0) : NULL;
+        PyObject* filename = frame ? PyObject_GetAttrString(frame, "filename")
+                                   : NULL;
+        PyObject* lineno = frame ? PyObject_GetAttrString(frame, "lineno")
+                                 : NULL;
+        const char* file = filename ? PyUnicode_AsUTF8(filename) : NULL;
+        char key[1024];
+        t_atom atoms[2];
+
+        if (size && count && file && lineno) {
+            snprintf(key, sizeof(key), "%s:%ld", file, PyLong_AsLong(lineno));
+            atom_setlong(atoms, (t_atom_long)PyLong_AsLongLong(size));
+            atom_setlong(atoms + 1, (t_atom_long)PyLong_AsLongLong(count));
+            dictionary_appendatoms(sub, gensym(key), 2, atoms);
+        }
+        Py_XDECREF(size);
+        Py_XDECREF(count);
+        Py_XDECREF(tb);
+        Py_XDECREF(frame);
+        Py_XDECREF(filename);
+        Py_XDECREF(lineno);
+        if (PyErr_Occurred()) {
+            object_free(sub);
+            goto error;
+        }
+    }
+    dictionary_appenddictionary(d, gensym("sites"), (t_object*)sub);
+    goto finally;
+
+error:
+    PyErr_Clear();
+    post("[memstats] could not read the tracemalloc statistics");
+
+finally:
+    Py_XDECREF(stats);
+    Py_XDECREF(snapshot);
+    Py_XDECREF(traced);
+    Py_XDECREF(tracing);
+    Py_XDECREF(mod);
+}
+
+/**
+ * @brief Append the memory report of an instance to a dictionary
+ *
+ * `accounting` (0 or 1), `allocator` (the `PYTHONMALLOC` variable, or
+ * `default`), the counters of the instance, `instances` with the counters
+ * of every instance of the external, and the tracemalloc sites.
+ */
+static inline void memstats_fill(t_memstats* m, t_dictionary* d, long limit)
+{
+    const char* allocator = getenv("PYTHONMALLOC");
+    t_dictionary* sub;
+
+    dictionary_appendlong(d, gensym("accounting"), memstats_state != NULL);
+    dictionary_appendsym(d, gensym("allocator"),
+                         gensym(allocator && *allocator ? allocator
+                                                        : "default"));
+    if (memstats_state) {
+        memstats_fill_record(m, d);
+        sub = dictionary_new();
+        memstats_fill_instances(sub);
+        dictionary_appenddictionary(d, gensym("instances"), (t_object*)sub);
+    }
+    memstats_fill_sites(d, limit);
+}
+
+/** call a tracemalloc function with an optional int argument */
+static inline t_max_err memstats_tracemalloc(const char* func, long arg)
+{
+    PyObject* mod = PyImport_ImportModule("tracemalloc");
+    PyObject* res = NULL;
+
+    if (mod) {
+        res = arg > 0 ? PyObject_CallMethod(mod, func, "l", arg)
+                      : PyObject_CallMethod(mod, func, NULL);
+    }
+    Py_XDECREF(mod);
+    if (res == NULL) {
+        PyErr_Clear();
+        post("[memstats] tracemalloc.%s failed", func);
+        return MAX_ERR_GENERIC;
+    }
+    Py_DECREF(res);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Handle a `memory [n] | reset | trace [nframes | stop]` message
+ *
+ * @param m accounting of the instance
+ * @param name object name (or NULL)
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet outlet for `dictionary <name>` (or NULL)
+ * @return t_symbol* dictionary name, NULL for the other subcommands
+ *
+ * Takes the GIL, call from the main thread.
+ */
+static inline t_symbol* memstats_message(t_memstats* m, t_symbol* name,
+                                         long argc, t_atom* argv,
+                                         void* outlet)
+{
+    PyGILState_STATE gstate;
+    t_symbol* cmd = argc ? atom_getsym(argv) : gensym("");
+    long limit = MEMSTATS_SITES;
+    t_atom atom;
+
+    if (m == NULL) {
+        return NULL;
+    }
+    if (name) {
+        m->name = name;
+    }
+
+    gstate = PyGILState_Ensure();
+    if (cmd == gensym("reset")) {
+        memstats_reset(m);
+#if PY_VERSION_HEX >= 0x03090000
+        memstats_tracemalloc("reset_peak", 0);
+#endif
+        PyGILState_Release(gstate);
+        return NULL;
+    }
+    if (cmd == gensym("trace")) {
+        if (argc > 1 && atom_getsym(argv + 1) == gensym("stop")) {
+            memstats_tracemalloc("stop", 0);
+        } else {
+            memstats_tracemalloc("start",
+                                 argc > 1 ? (long)atom_getlong(argv + 1) : 0);
+        }
+        PyGILState_Release(gstate);
+        return NULL;
+    }
+    if (argc && atom_gettype(argv) == A_LONG && atom_getlong(argv) > 0) {
+        limit = (long)atom_getlong(argv);
+    }
+
+    if (m->dict == NULL) {
+        m->dict = dictionary_new();
+        m->dict_name = NULL;
+        m->dict = dictobj_register(m->dict, &m->dict_name);
+    } else {
+        dictionary_clear(m->dict);
+    }
+    if (m->dict) {
+        if (name) {
+            dictionary_appendsym(m->dict, gensym("name"), name);
+        }
+        memstats_fill(m, m->dict, limit);
+    }
+    PyGILState_Release(gstate);
+
+    if (m->dict && outlet) {
+        atom_setsym(&atom, m->dict_name);
+        outlet_anything(outlet, gensym("dictionary"), 1, &atom);
+    }
+    return m->dict ? m->dict_name : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMSTATS_H */
@@ -0,0 +1,518 @@
+/** \file metrics.h
+    \brief A single-header latency metrics library for python externals.
+
+    Keeps per-message counters and log-linear (HDR-style) latency
+    histograms, plus the time spent waiting for the GIL and the split
+    between atom conversion and python execution. Recording is lock-free
+    (relaxed atomic adds), so spans may end on any thread; queries and
+    resets are done from the main thread.
+
+    All functions are `static inline`: include the header wherever it is
+    needed, no implementation define is required. It only depends on the
+    Max SDK, so it is usable by CPython and pocketpy externals alike.
+
+    Usage example:
+
+        #include "metrics.h"
+
+        t_metrics_span span;
+        metrics_begin(&span, METRICS_EVAL);
+        gstate = PyGILState_Ensure();
+        metrics_gil(&span);                 // time since begin: GIL wait
+        pval = PyRun_String(...);
+        metrics_exec(&span);                // time since last mark: python
+        py_handle_output(x, pval);
+        metrics_convert(&span);             // time since last mark: atoms
+        metrics_end(x->metrics, &span, pval != NULL);
+
+    A `metrics` message then outputs `dictionary <name>` with, for each
+    message type seen: count, errors, mean/p50/p90/p99/p999/max latency (us)
+    and total/gil/convert/exec time (ms). `metrics reset` clears it.
+
+    While tracing (see trace.h), spans and their phases are also recorded
+    as trace events.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "ext_dictobj.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Constants */
+
+/** message types with their own counters and histogram */
+typedef enum t_metrics_kind {
+    METRICS_IMPORT,
+    METRICS_EVAL,
+    METRICS_EXEC,
+    METRICS_EXECFILE,
+    METRICS_CALL,
+    METRICS_PIPE,
+    METRICS_FOLD,
+    METRICS_SCHED,
+    METRICS_CODE,
+    METRICS_ASSIGN,
+    METRICS_ANYTHING,
+    METRICS_OTHER,
+    METRICS_KINDS
+} t_metrics_kind;
+
+static const char* const metrics_kind_names[METRICS_KINDS] = {
+    "import", "eval", "exec", "execfile", "call", "pipe",
+    "fold", "sched", "code", "assign", "anything", "other",
+};
+
+// 8 buckets per power of two (12.5% resolution), exact below 8ns,
+// values above ~4.5 hours all land in the last bucket
+#define METRICS_SUB_BITS 3
+#define METRICS_SUB (1 << METRICS_SUB_BITS)
+#define METRICS_BUCKETS (42 * METRICS_SUB)
+
+/*--------------------------------------------------------------------------*/
+/* Datastructures */
+
+/** latency histogram in nanoseconds */
+typedef struct t_metrics_hist {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[METRICS_BUCKETS];
+} t_metrics_hist;
+
+/** counters of one message type */
+typedef struct t_metrics_entry {
+    t_metrics_hist latency;     /*!< begin to end of each message */
+    uint64_t errors;            /*!< messages that failed */
+    uint64_t gil_ns;            /*!< time waiting for the GIL */
+    uint64_t convert_ns;        /*!< time converting atoms <-> python */
+    uint64_t exec_ns;           /*!< time running python code */
+} t_metrics_entry;
+
+typedef struct t_metrics {
+    t_metrics_entry entries[METRICS_KINDS];
+    t_metrics_hist gil;         /*!< GIL waits of all message types */
+    uint64_t reset_ns;          /*!< time of creation or last reset */
+    t_dictionary* dict;         /*!< registered dictionary of `metrics` */
+    t_symbol* dict_name;        /*!< name of dict */
+} t_metrics;
+
+/** one message in flight, lives on the stack of the method */
+typedef struct t_metrics_span {
+    t_metrics_kind kind;
+    uint64_t start;             /*!< begin time */
+    uint64_t mark;              /*!< time of the last phase mark */
+    uint64_t gil_ns;
+    uint64_t convert_ns;
+    uint64_t exec_ns;
+    int gil_marked;             /*!< metrics_gil was called */
+    int failed;                 /*!< metrics_fail was called */
+} t_metrics_span;
+
+/*--------------------------------------------------------------------------*/
+/* Atomics and clock */
+
+#if defined(_MSC_VER)
+#define METRICS_ADD(p, v) \
+    _InterlockedExchangeAdd64((volatile __int64*)(p), (__int64)(v))
+#define METRICS_LOAD(p) (*(volatile uint64_t*)(p))
+#define METRICS_STORE(p, v) \
+    _InterlockedExchange64((volatile __int64*)(p), (__int64)(v))
+#else
+#define METRICS_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define METRICS_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define METRICS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+static inline void metrics_atomic_max(uint64_t* p, uint64_t v)
+{
+#if defined(_MSC_VER)
+    __int64 cur = (__int64)METRICS_LOAD(p);
+    while ((uint64_t)cur < v) {
+        __int64 prev = _InterlockedCompareExchange64((volatile __int64*)p,
+                                                     (__int64)v, cur);
+        if (prev == cur) {
+            break;
+        }
+        cur = prev;
+    }
+#else
+    uint64_t cur = METRICS_LOAD(p);
+    while (cur < v
+           && !__atomic_compare_exchange_n(p, &cur, v, 1, __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED)) {
+    }
+#endif
+}
+
+/** monotonic time in nanoseconds, the same clock as trace events */
+static inline uint64_t metrics_now(void)
+{
+    return trace_now();
+}
+
+/*--------------------------------------------------------------------------*/
+/* Histograms */
+
+static inline int metrics_bucket(uint64_t v)
+{
+    int msb;
+    int b;
+
+    if (v < METRICS_SUB) {
+        return (int)v;
+    }
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    msb = (int)index;
+#else
+    msb = 63 - __builtin_clzll(v);
+#endif
+    b = (msb - METRICS_SUB_BITS + 1) * METRICS_SUB
+        + (int)((v >> (msb - METRICS_SUB_BITS)) & (METRICS_SUB - 1));
+    return b < METRICS_BUCKETS ? b : METRICS_BUCKETS - 1;
+}
+
+/** midpoint of a bucket in nanoseconds */
+static inline double metrics_bucket_value(int b)
+{
+    int group = b / METRICS_SUB;
+    int sub = b % METRICS_SUB;
+    double lo;
+
+    if (group == 0) {
+        return (double)b;
+    }
+    lo = (double)((uint64_t)(METRICS_SUB + sub) << (group - 1));
+    return lo + (double)((uint64_t)1 << (group - 1)) / 2.0;
+}
+
+static inline void metrics_hist_record(t_metrics_hist* h, uint64_t ns)
+{
+    METRICS_ADD(&h->buckets[metrics_bucket(ns)], 1);
+    METRICS_ADD(&h->total_ns, ns);
+    METRICS_ADD(&h->count, 1);
+    metrics_atomic_max(&h->max_ns, ns);
+}
+
+/**
+ * @brief Percentiles of a histogram in microseconds
+ *
+ * @param h histogram
+ * @param qs quantiles in [0, 1]
+ * @param out results, one per quantile
+ * @param n number of quantiles
+ */
+static inline void metrics_hist_quantiles(t_metrics_hist* h, const double* qs,
+                                          double* out, int n)
+{
+    uint64_t counts[METRICS_BUCKETS];
+    uint64_t total = 0;
+    uint64_t seen = 0;
+    int b = 0;
+
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        counts[i] = METRICS_LOAD(&h->buckets[i]);
+        total += counts[i];
+    }
+    for (int q = 0; q < n; q++) {
+        uint64_t rank = (uint64_t)(qs[q] * (double)total + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        while (b < METRICS_BUCKETS && seen + counts[b] < rank) {
+            seen += counts[b++];
+        }
+        out[q] = total && b < METRICS_BUCKETS
+                     ? metrics_bucket_value(b) / 1e3
+                     : 0.0;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Lifecycle */
+
+static inline t_metrics* metrics_new(void)
+{
+    t_metrics* m = (t_metrics*)sysmem_newptrclear(sizeof(t_metrics));
+    if (m) {
+        m->reset_ns = metrics_now();
+    }
+    return m;
+}
+
+static inline void metrics_free(t_metrics* m)
+{
+    if (m == NULL) {
+        return;
+    }
+    if (m->dict) {
+        object_free(m->dict);
+    }
+    sysmem_freeptr(m);
+}
+
+/**
+ * @brief Zero all counters
+ *
+ * Spans ending concurrently may be partly counted: counters are cleared
+ * one by one, not as a snapshot.
+ */
+static inline void metrics_zero(void* p, size_t size)
+{
+    uint64_t* words = (uint64_t*)p;
+
+    for (size_t i = 0; i < size / sizeof(uint64_t); i++) {
+        METRICS_STORE(words + i, 0);
+    }
+}
+
+static inline void metrics_reset(t_metrics* m)
+{
+    for (int k = 0; k < METRICS_KINDS; k++) {
+        metrics_zero(m->entries + k, sizeof(t_metrics_entry));
+    }
+    metrics_zero(&m->gil, sizeof(t_metrics_hist));
+    m->reset_ns = metrics_now();
+}
+
+/*--------------------------------------------------------------------------*/
+/* Spans */
+
+static inline void metrics_begin(t_metrics_span* sp, t_metrics_kind kind)
+{
+    sp->kind = kind;
+    sp->start = sp->mark = metrics_now();
+    sp->gil_ns = sp->convert_ns = sp->exec_ns = 0;
+    sp->gil_marked = 0;
+    sp->failed = 0;
+}
+
+/** time since the last mark, recorded as a trace event of a phase */
+static inline uint64_t metrics_lap(t_metrics_span* sp, t_trace_cat cat)
+{
+    uint64_t now = metrics_now();
+    uint64_t ns = now - sp->mark;
+    if (trace_enabled()) {
+        trace_record('X', cat, trace_cat_names[cat], sp->mark, ns);
+    }
+    sp->mark = now;
+    return ns;
+}
+
+/*
+ * Phase marks attribute the time since the previous mark (or begin) to a
+ * phase. They accept a NULL span, so helpers shared by several messages can
+ * take an optional span from their caller.
+ */
+
+/**
+ * the GIL was just acquired: time since the last mark was a GIL wait.
+ * Also attaches the trace profile function to this thread (trace.h).
+ */
+static inline void metrics_gil(t_metrics_span* sp)
+{
+    if (sp == NULL) {
+        return;
+    }
+    sp->gil_ns += metrics_lap(sp, TRACE_GIL);
+    sp->gil_marked = 1;
+    trace_python_attach();
+}
+
+/** time since the last mark was spent converting atoms or results */
+static inline void metrics_convert(t_metrics_span* sp)
+{
+    if (sp == NULL) {
+        return;
+    }
+    sp->convert_ns += metrics_lap(sp, TRACE_CONVERT);
+}
+
+/** time since the last mark was spent running python code */
+static inline void metrics_exec(t_metrics_span* sp)
+{
+    if (sp == NULL) {
+        return;
+    }
+    sp->exec_ns += metrics_lap(sp, TRACE_EXEC);
+}
+
+/** count the message as failed even if it reports success */
+static inline void metrics_fail(t_metrics_span* sp)
+{
+    if (sp == NULL) {
+        return;
+    }
+    sp->failed = 1;
+}
+
+/**
+ * @brief Record a finished message
+ *
+ * @param m metrics (may be NULL)
+ * @param sp span started with metrics_begin
+ * @param ok 0 if the message failed
+ */
+static inline void metrics_end(t_metrics* m, t_metrics_span* sp, int ok)
+{
+    t_metrics_entry* e;
+    uint64_t ns = metrics_now() - sp->start;
+
+    if (trace_enabled()) {
+        trace_record('X', TRACE_MESSAGE, metrics_kind_names[sp->kind],
+                     sp->start, ns);
+    }
+    if (m == NULL) {
+        return;
+    }
+    e = m->entries + sp->kind;
+    metrics_hist_record(&e->latency, ns);
+    if (!ok || sp->failed) {
+        METRICS_ADD(&e->errors, 1);
+    }
+    if (sp->gil_marked) {
+        METRICS_ADD(&e->gil_ns, sp->gil_ns);
+        metrics_hist_record(&m->gil, sp->gil_ns);
+    }
+    METRICS_ADD(&e->convert_ns, sp->convert_ns);
+    METRICS_ADD(&e->exec_ns, sp->exec_ns);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Queries */
+
+static inline void metrics_hist_fill(t_metrics_hist* h, t_dictionary* d)
+{
+    static const double qs[] = {0.5, 0.9, 0.99, 0.999};
+    static const char* const qnames[] = {"p50_us", "p90_us", "p99_us",
+                                         "p999_us"};
+    double out[4];
+    uint64_t count = METRICS_LOAD(&h->count);
+    uint64_t total = METRICS_LOAD(&h->total_ns);
+
+    metrics_hist_quantiles(h, qs, out, 4);
+    dictionary_appendlong(d, gensym("count"), (t_atom_long)count);
+    dictionary_appendfloat(d, gensym("mean_us"),
+                           count ? (double)total / count / 1e3 : 0.0);
+    for (int i = 0; i < 4; i++) {
+        dictionary_appendfloat(d, gensym(qnames[i]), out[i]);
+    }
+    dictionary_appendfloat(d, gensym("max_us"),
+                           (double)METRICS_LOAD(&h->max_ns) / 1e3);
+    dictionary_appendfloat(d, gensym("total_ms"), (double)total / 1e6);
+}
+
+/**
+ * @brief Append the metrics to a dictionary
+ *
+ * One sub-dictionary per message type seen since the last reset, plus
+ * `gil` (histogram of GIL waits) and `elapsed_s` (time since the reset).
+ */
+static inline void metrics_fill(t_metrics* m, t_dictionary* d)
+{
+    for (int k = 0; k < METRICS_KINDS; k++) {
+        t_metrics_entry* e = m->entries + k;
+        t_dictionary* sub = NULL;
+
+        if (METRICS_LOAD(&e->latency.count) == 0) {
+            continue;
+        }
+        sub = dictionary_new();
+        metrics_hist_fill(&e->latency, sub);
+        dictionary_appendlong(sub, gensym("errors"),
+                              (t_atom_long)METRICS_LOAD(&e->errors));
+        dictionary_appendfloat(sub, gensym("gil_ms"),
+                               (double)METRICS_LOAD(&e->gil_ns) / 1e6);
+        dictionary_appendfloat(sub, gensym("convert_ms"),
+                               (double)METRICS_LOAD(&e->convert_ns) / 1e6);
+        dictionary_appendfloat(sub, gensym("exec_ms"),
+                               (double)METRICS_LOAD(&e->exec_ns) / 1e6);
+        dictionary_appenddictionary(d, gensym(metrics_kind_names[k]),
+                                    (t_object*)sub);
+    }
+    if (METRICS_LOAD(&m->gil.count)) {
+        t_dictionary* sub = dictionary_new();
+        metrics_hist_fill(&m->gil, sub);
+        dictionary_appenddictionary(d, gensym("gil"), (t_object*)sub);
+    }
+    dictionary_appendfloat(d, gensym("elapsed_s"),
+                           (double)(metrics_now() - m->reset_ns) / 1e9);
+}
+
+/**
+ * @brief Refresh and return the registered dictionary of the metrics
+ *
+ * @param m metrics
+ * @param name object name, stored as `name` in the dictionary (or NULL)
+ * @return t_symbol* name of the dictionary, or NULL
+ *
+ * The dictionary is owned by `m` and reused by each call.
+ */
+static inline t_symbol* metrics_dictionary(t_metrics* m, t_symbol* name)
+{
+    if (m->dict == NULL) {
+        m->dict = dictionary_new();
+        m->dict_name = NULL;
+        m->dict = dictobj_register(m->dict, &m->dict_name);
+        if (m->dict == NULL) {
+            return NULL;
+        }
+    } else {
+        dictionary_clear(m->dict);
+    }
+    if (name) {
+        dictionary_appendsym(m->dict, gensym("name"), name);
+    }
+    metrics_fill(m, m->dict);
+    return m->dict_name;
+}
+
+/**
+ * @brief Handle a `metrics [reset]` message
+ *
+ * @param m metrics
+ * @param name object name (or NULL)
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param outlet outlet for `dictionary <name>` (or NULL)
+ * @return t_symbol* dictionary name, NULL after a reset
+ */
+static inline t_symbol* metrics_message(t_metrics* m, t_symbol* name,
+                                        long argc, t_atom* argv, void* outlet)
+{
+    t_atom atom;
+    t_symbol* dict_name = NULL;
+
+    if (m == NULL) {
+        return NULL;
+    }
+    if (argc && atom_getsym(argv) == gensym("reset")) {
+        metrics_reset(m);
+        return NULL;
+    }
+    dict_name = metrics_dictionary(m, name);
+    if (dict_name && outlet) {
+        atom_setsym(&atom, dict_name);
+        outlet_anything(outlet, gensym("dictionary"), 1, &atom);
+    }
+    return dict_name;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
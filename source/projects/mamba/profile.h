@@ -0,0 +1,411 @@
+/** \file profile.h
+    \brief A single-header sampling profiler for CPython externals.
+
+    A sampler thread wakes up every `interval` ms, takes the GIL and walks
+    the python stacks of all other threads of the interpreter, counting
+    each distinct stack. Nothing is added to the profiled code: threads
+    running python only hand over the GIL at their next eval breaker
+    check, as they do for any other thread, so the overhead is a GIL
+    switch and a stack walk per sample, which is lost in the noise of a
+    busy loop at the default interval of 10 ms. Waiting for the GIL (up to
+    the 5 ms switch interval) lowers the effective rate to 60-100 Hz.
+
+    Since samples are taken when a thread gives up the GIL, the profile is
+    of python execution: a thread idling in Max, or holding the GIL without
+    running python, is not sampled.
+
+    The counts are written in the folded stack format of Brendan Gregg's
+    flamegraph.pl (also read by speedscope and inferno), one line per
+    stack, rooted at the thread:
+
+        main;<module> (patch.py:1);process (patch.py:12);mean (util.py:3) 42
+
+    Usage example (the `profile` message of an external):
+
+        profile start [interval_ms]   // clear and start sampling
+        profile stop                  // stop sampling, keep the counts
+        profile dump [path]           // write <max temp folder>/<name>.folded
+
+    The state is per external and `Python.h` must be included first.
+    profile_free() must be called before the interpreter is finalized.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "ext.h"
+#include "ext_obex.h"
+
+#include <Python.h>
+#if PY_VERSION_HEX < 0x03090000
+#include <frameobject.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Constants */
+
+#define PROFILE_INTERVAL_MS 10
+#define PROFILE_MAX_DEPTH 128
+
+/*--------------------------------------------------------------------------*/
+/* Datastructures */
+
+typedef struct t_profile_state {
+    t_systhread thread;         /*!< sampler thread */
+    int running;                /*!< the sampler runs while set */
+    long interval;              /*!< ms between samples */
+    unsigned long main_ident;   /*!< thread id of the max main thread */
+    long samples;               /*!< samples taken since start */
+    uint64_t start_ns;          /*!< time of start */
+    uint64_t stop_ns;           /*!< time of stop, 0 while running */
+    PyObject* stacks;           /*!< {(thread id, code, ...): count} */
+} t_profile_state;
+
+static t_profile_state profile_state;
+
+/*--------------------------------------------------------------------------*/
+/* Frames */
+
+// the frame accessors return new references (borrowed before 3.9)
+
+static inline PyFrameObject* profile_thread_frame(PyThreadState* ts)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    return PyThreadState_GetFrame(ts);
+#else
+    Py_XINCREF(ts->frame);
+    return ts->frame;
+#endif
+}
+
+static inline PyFrameObject* profile_frame_back(PyFrameObject* frame)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    return PyFrame_GetBack(frame);
+#else
+    Py_XINCREF(frame->f_back);
+    return frame->f_back;
+#endif
+}
+
+static inline PyCodeObject* profile_frame_code(PyFrameObject* frame)
+{
+#if PY_VERSION_HEX >= 0x03090000
+    return PyFrame_GetCode(frame);
+#else
+    Py_INCREF(frame->f_code);
+    return frame->f_code;
+#endif
+}
+
+/*--------------------------------------------------------------------------*/
+/* Sampling */
+
+/**
+ * @brief Count the current stack of every other thread
+ *
+ * Called by the sampler with the GIL held. Stacks deeper than
+ * PROFILE_MAX_DEPTH keep their innermost frames.
+ */
+static inline void profile_sample(void)
+{
+    PyThreadState* self = PyThreadState_Get();
+    PyThreadState* ts = PyInterpreterState_ThreadHead(self->interp);
+    PyObject* codes[PROFILE_MAX_DEPTH];
+
+    for (; ts; ts = PyThreadState_Next(ts)) {
+        PyFrameObject* frame = NULL;
+        PyObject* key = NULL;
+        PyObject* count = NULL;
+        long n = 0;
+        int depth = 0;
+
+        if (ts == self) {
+            continue;
+        }
+        frame = profile_thread_frame(ts);
+        while (frame && depth < PROFILE_MAX_DEPTH) {
+            PyFrameObject* back = profile_frame_back(frame);
+            codes[depth++] = (PyObject*)profile_frame_code(frame);
+            Py_DECREF(frame);
+            frame = back;
+        }
+        Py_XDECREF(frame);
+        if (depth == 0) {
+            continue;
+        }
+
+        // (thread id, outermost code, ..., innermost code)
+        key = PyTuple_New(depth + 1);
+        if (key == NULL) {
+            while (depth) {
+                Py_DECREF(codes[--depth]);
+            }
+            PyErr_Clear();
+            return;
+        }
+        PyTuple_SET_ITEM(key, 0, PyLong_FromUnsignedLong(ts->thread_id));
+        for (int i = 0; i < depth; i++) {
+            PyTuple_SET_ITEM(key, depth - i, codes[i]);
+        }
+        count = PyDict_GetItemWithError(profile_state.stacks, key);
+        n = count ? PyLong_AsLong(count) + 1 : 1;
+        count = PyLong_FromLong(n);
+        if (count == NULL || PyDict_SetItem(profile_state.stacks, key, count)) {
+            PyErr_Clear();
+        }
+        Py_XDECREF(count);
+        Py_DECREF(key);
+    }
+}
+
+static void* profile_run(void* arg)
+{
+    PyGILState_STATE gstate;
+
+    while (TRACE_LOAD(&profile_state.running)) {
+        systhread_sleep(profile_state.interval);
+        gstate = PyGILState_Ensure();
+        if (TRACE_LOAD(&profile_state.running)) {
+            profile_sample();
+            profile_state.samples++;
+        }
+        PyGILState_Release(gstate);
+    }
+    systhread_exit(0);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Control */
+
+/** the sampler thread is running */
+static inline int profile_running(void)
+{
+    return TRACE_LOAD(&profile_state.running) != 0;
+}
+
+/**
+ * @brief Stop the sampler and wait for it to exit, keeping the counts
+ *
+ * Releases the GIL while waiting if the calling thread holds it, since
+ * the sampler may be waiting for it.
+ */
+static inline void profile_stop(void)
+{
+    PyThreadState* save = NULL;
+    unsigned int ret = 0;
+
+    if (!profile_running()) {
+        return;
+    }
+    TRACE_STORE(&profile_state.running, 0);
+    if (PyGILState_Check()) {
+        save = PyEval_SaveThread();
+    }
+    systhread_join(profile_state.thread, &ret);
+    if (save) {
+        PyEval_RestoreThread(save);
+    }
+    profile_state.thread = NULL;
+    profile_state.stop_ns = trace_now();
+}
+
+/**
+ * @brief Stop the sampler and drop the counts
+ *
+ * Call with the GIL held, before Py_FinalizeEx.
+ */
+static inline void profile_free(void)
+{
+    profile_stop();
+    Py_CLEAR(profile_state.stacks);
+}
+
+/**
+ * @brief Clear the counts and start sampling
+ *
+ * @param interval ms between samples (PROFILE_INTERVAL_MS if < 1)
+ * @return t_max_err error code
+ */
+static inline t_max_err profile_start(long interval)
+{
+    PyGILState_STATE gstate;
+
+    profile_stop();
+
+    gstate = PyGILState_Ensure();
+    Py_XDECREF(profile_state.stacks);
+    profile_state.stacks = PyDict_New();
+    if (systhread_ismainthread()) {
+        profile_state.main_ident = PyThread_get_thread_ident();
+    }
+    PyGILState_Release(gstate);
+    if (profile_state.stacks == NULL) {
+        return MAX_ERR_OUT_OF_MEM;
+    }
+
+    profile_state.interval = interval > 0 ? interval : PROFILE_INTERVAL_MS;
+    profile_state.samples = 0;
+    profile_state.start_ns = trace_now();
+    profile_state.stop_ns = 0;
+    TRACE_STORE(&profile_state.running, 1);
+    if (systhread_create((method)profile_run, NULL, 0, 0, 0,
+                         &profile_state.thread)) {
+        TRACE_STORE(&profile_state.running, 0);
+        return MAX_ERR_GENERIC;
+    }
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Output */
+
+/** write a frame name, without the separators of the folded format */
+static inline void profile_write_name(FILE* f, const char* s)
+{
+    for (; *s; s++) {
+        fputc(*s == ';' || *s == '\n' ? '_' : *s, f);
+    }
+}
+
+/** write `qualname (file:line)` of a code object */
+static inline void profile_write_code(FILE* f, PyCodeObject* code)
+{
+#if PY_VERSION_HEX >= 0x030B0000
+    const char* name = PyUnicode_AsUTF8(code->co_qualname);
+#else
+    const char* name = PyUnicode_AsUTF8(code->co_name);
+#endif
+    const char* file = PyUnicode_AsUTF8(code->co_filename);
+    const char* base = NULL;
+
+    if (name == NULL || file == NULL) {
+        PyErr_Clear();
+        fputs("?", f);
+        return;
+    }
+    base = strrchr(file, '/');
+#if defined(_WIN32)
+    if (strrchr(file, '\\') > base) {
+        base = strrchr(file, '\\');
+    }
+#endif
+    profile_write_name(f, name);
+    fputs(" (", f);
+    profile_write_name(f, base ? base + 1 : file);
+    fprintf(f, ":%d)", code->co_firstlineno);
+}
+
+/**
+ * @brief Write the counts in folded stack format
+ *
+ * @param path file to write
+ * @return long number of distinct stacks written, or -1 on error
+ */
+static inline long profile_write(const char* path)
+{
+    PyGILState_STATE gstate;
+    PyObject* key = NULL;
+    PyObject* value = NULL;
+    Py_ssize_t pos = 0;
+    long lines = 0;
+    FILE* f = NULL;
+
+    gstate = PyGILState_Ensure();
+    if (profile_state.stacks == NULL || (f = fopen(path, "w")) == NULL) {
+        PyGILState_Release(gstate);
+        return -1;
+    }
+    while (PyDict_Next(profile_state.stacks, &pos, &key, &value)) {
+        unsigned long ident = PyLong_AsUnsignedLong(PyTuple_GET_ITEM(key, 0));
+
+        if (ident == profile_state.main_ident) {
+            fputs("main", f);
+        } else {
+            fprintf(f, "thread %lu", ident);
+        }
+        for (Py_ssize_t i = 1; i < PyTuple_GET_SIZE(key); i++) {
+            fputc(';', f);
+            profile_write_code(f, (PyCodeObject*)PyTuple_GET_ITEM(key, i));
+        }
+        fprintf(f, " %ld\n", PyLong_AsLong(value));
+        lines++;
+    }
+    PyGILState_Release(gstate);
+    if (fclose(f) != 0) {
+        return -1;
+    }
+    return lines;
+}
+
+/**
+ * @brief Handle a `profile start [interval_ms] | stop | dump [path]` message
+ *
+ * @param x object, for console messages
+ * @param label default file name
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_symbol* path of the written file, NULL otherwise
+ *
+ * `dump` without a path writes `<max temp folder>/<label>.folded`.
+ */
+static inline t_symbol* profile_message(t_object* x, const char* label,
+                                        long argc, t_atom* argv)
+{
+    t_symbol* cmd = argc ? atom_getsym(argv) : gensym("");
+    char folder[MAX_PATH_CHARS];
+    char path[MAX_PATH_CHARS];
+    uint64_t elapsed = 0;
+    long lines = 0;
+
+    if (cmd == gensym("start")) {
+        if (profile_start(argc > 1 ? (long)atom_getlong(argv + 1) : 0)) {
+            object_error(x, "profile: could not start the sampler");
+        }
+        return NULL;
+    }
+    if (cmd == gensym("stop")) {
+        profile_stop();
+        return NULL;
+    }
+    if (cmd != gensym("dump")) {
+        object_error(x, "profile start [interval_ms] | stop | dump [path]");
+        return NULL;
+    }
+    if (argc > 1 && atom_getsym(argv + 1) != gensym("")) {
+        snprintf(path, MAX_PATH_CHARS, "%s", atom_getsym(argv + 1)->s_name);
+    } else {
+        if (path_toabsolutesystempath(path_tempfolder(), "", folder)
+            != MAX_ERR_NONE) {
+            object_error(x, "profile: no temp folder");
+            return NULL;
+        }
+        snprintf(path, MAX_PATH_CHARS, "%s/%s.folded", folder, label);
+    }
+    lines = profile_write(path);
+    if (lines < 0) {
+        object_error(x, "profile: could not write %s", path);
+        return NULL;
+    }
+    elapsed = (profile_state.stop_ns ? profile_state.stop_ns : trace_now())
+              - profile_state.start_ns;
+    object_post(x, "profile: %ld samples in %.1f s, %ld stacks written to %s",
+                profile_state.samples, (double)elapsed / 1e9, lines, path);
+    return gensym(path);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILE_H */
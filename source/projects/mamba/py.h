@@ -38,6 +38,10 @@ extern "C" {
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
+// per-message latency metrics
+#include "metrics.h"
+#include "profile.h"
+
 
 // data structure declaration
 typedef struct t_py t_py;
@@ -59,6 +63,11 @@ t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
 t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv,void* outlet);
 t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
 
+// instrumentation
+t_max_err py_metrics(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
+t_max_err py_trace(t_py* x, t_object* owner, long argc, t_atom* argv, void* outlet);
+t_max_err py_profile(t_py* x, t_object* owner, long argc, t_atom* argv, void* outlet);
+
 // code execution methods
 t_max_err py_exec_file_input(t_py* x, const char* code);
 t_max_err py_exec_single_input(t_py* x, const char* code);
@@ -106,6 +115,7 @@ struct t_py
     short p_code_path;                      /*!< short code for max file system */
     t_symbol* p_code_filepath;              /*!< filepath to python file to execfile */
     PyObject* p_globals;                    /*!< per object 'globals' python namespace */
+    t_metrics* p_metrics;                   /*!< per-message latency metrics */
 };
 
 // clang-format on
@@ -126,7 +136,8 @@ t_max_err py_handle_string_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_list_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_dict_output(t_py* x, void* outlet, PyObject* pval);
 t_max_err py_handle_output(t_py* x, void* outlet, PyObject* pval);
-t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset, void* outlet);
+t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset, void* outlet,
+                       t_metrics_span* span);
 
 PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from);
 
@@ -220,6 +231,7 @@ t_py* py_init(t_class* c)
     x->p_code_pathname[0] = 0;
     x->p_code_path = 0;
     x->p_code_filepath = gensym("");
+    x->p_metrics = metrics_new();
 
 #if PY_VERSION_HEX < 0x0308000
     if (python_home != NULL) {
@@ -267,7 +279,9 @@ void py_free(t_py* x)
 {
     py_log(x, (char*)"deleting object %s", x->p_name->s_name);
     Py_XDECREF(x->p_globals);
+    profile_free();
     Py_FinalizeEx();
+    metrics_free(x->p_metrics);
     free(x);
 }
 
@@ -745,13 +759,18 @@ t_max_err py_handle_output(t_py* x, void* outlet, PyObject* pval)
  */
 t_max_err py_import(t_py* x, t_symbol* s)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_IMPORT);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     PyObject* x_module = NULL;
 
     if (s != gensym("")) {
         x_module = PyImport_ImportModule(s->s_name);
+        metrics_exec(&span);
         // x_module borrrowed ref
         if (x_module == NULL) {
             goto error;
@@ -759,12 +778,16 @@ t_max_err py_import(t_py* x, t_symbol* s)
         PyDict_SetItemString(x->p_globals, s->s_name, x_module);
         PyGILState_Release(gstate);
         py_log(x, (char*)"imported: %s", s->s_name);
+    } else {
+        PyGILState_Release(gstate);
     }
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, (char*)"import %s", s->s_name);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -779,21 +802,29 @@ error:
  */
 t_max_err py_eval(t_py* x, t_symbol* s, void* outlet)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EVAL);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     py_log(x, (char*)"eval %s", s->s_name);
 
     PyObject* pval = PyRun_String(s->s_name, Py_eval_input, x->p_globals,
                                   x->p_globals);
+    metrics_exec(&span);
 
     if (pval != NULL) {
         py_handle_output(x, outlet, pval);
+        metrics_convert(&span);
         PyGILState_Release(gstate);
+        metrics_end(x->p_metrics, &span, 1);
         return MAX_ERR_NONE;
     } else {
         py_handle_error(x, (char*)"eval %s", s->s_name);
         PyGILState_Release(gstate);
+        metrics_end(x->p_metrics, &span, 0);
         return MAX_ERR_GENERIC;
     }
 }
@@ -808,17 +839,23 @@ t_max_err py_eval(t_py* x, t_symbol* s, void* outlet)
  */
 t_max_err py_exec_file_input(t_py* x, const char* code)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXEC);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     PyObject* pval = NULL;
 
     pval = PyRun_String(code, Py_file_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
     Py_DECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
 
     py_log(x, (char*)"py_exec_file_input");
     return MAX_ERR_NONE;
@@ -827,6 +864,7 @@ error:
     py_handle_error(x, (char*)"py_exec_file_input");
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -840,17 +878,23 @@ error:
  */
 t_max_err py_exec_single_input(t_py* x, const char* code)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXEC);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     PyObject* pval = NULL;
 
     pval = PyRun_String(code, Py_single_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
     Py_DECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
 
     py_log(x, (char*)"py_exec_single_input");
     return MAX_ERR_NONE;
@@ -859,6 +903,7 @@ error:
     py_handle_error(x, (char*)"py_exec_single_input");
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -872,17 +917,23 @@ error:
  */
 t_max_err py_exec(t_py* x, t_symbol* s)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXEC);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     PyObject* pval = NULL;
 
     pval = PyRun_String(s->s_name, Py_single_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
     Py_DECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
 
     py_log(x, (char*)"exec %s", s->s_name);
     return MAX_ERR_NONE;
@@ -891,6 +942,7 @@ error:
     py_handle_error(x, (char*)"exec %s", s->s_name);
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -903,8 +955,12 @@ error:
  */
 t_max_err py_execfile(t_py* x, t_symbol* s)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXECFILE);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     PyObject* pval = NULL;
     FILE* fhandle = NULL;
@@ -935,6 +991,7 @@ t_max_err py_execfile(t_py* x, t_symbol* s)
 
     pval = PyRun_File(fhandle, x->p_code_filepath->s_name, Py_file_input,
                       x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         fclose(fhandle);
         goto error;
@@ -944,12 +1001,14 @@ t_max_err py_execfile(t_py* x, t_symbol* s)
     fclose(fhandle);
     Py_DECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, (char*)"execfile");
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1027,13 +1086,15 @@ error:
  * @param argv atom argument vector
  * @param offset offset of atom vector from which to evaluate
  * @param outlet object outlet
+ * @param span metrics of the calling message (or NULL)
  *
  * @return t_max_err error code
  */
 t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset,
-                       void* outlet)
+                       void* outlet, t_metrics_span* span)
 {
     PyGILState_STATE gstate = PyGILState_Ensure();
+    metrics_gil(span);
 
     long textsize = 0;
     char* text = NULL;
@@ -1063,19 +1124,20 @@ t_max_err py_eval_text(t_py* x, long argc, t_atom* argv, int offset,
         goto error;
     }
     sysmem_freeptr(text);
+    metrics_convert(span);
 
     pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+    metrics_exec(span);
     if (pval == NULL) {
         goto error;
     }
     Py_DECREF(co);
 
-    if (!is_eval) {
-        // bang for exec-type op
-        PyGILState_Release(gstate);
-    } else {
+    if (is_eval) {
         py_handle_output(x, outlet, pval);
+        metrics_convert(span);
     }
+    PyGILState_Release(gstate);
     return MAX_ERR_NONE;
 
 error:
@@ -1101,8 +1163,12 @@ error:
  */
 t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_CALL);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     char* callable_name = NULL;
     PyObject* py_argslist = NULL;
@@ -1123,6 +1189,7 @@ t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
 
     py_callable = PyRun_String(callable_name, Py_eval_input, x->p_globals,
                                x->p_globals);
+    metrics_exec(&span);
     if (py_callable == NULL) {
         py_error(x, (char*)"could not evaluate %s", callable_name);
         goto error;
@@ -1143,6 +1210,7 @@ t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
         py_error(x, (char*)"unable to convert args list to tuple");
         goto error;
     }
+    metrics_convert(&span);
 
     pval = PyObject_CallObject(py_callable, py_args);
     if (!PyErr_ExceptionMatches(PyExc_TypeError)) {
@@ -1162,11 +1230,14 @@ t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
     goto handle_output; // this is redundant but safer in case code is added
 
 handle_output:
+    metrics_exec(&span);
     py_handle_output(x, outlet, pval);
+    metrics_convert(&span);
     // success cleanup
     Py_XDECREF(py_callable);
     Py_XDECREF(py_argslist);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
@@ -1176,6 +1247,7 @@ error:
     Py_XDECREF(py_argslist);
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1194,8 +1266,12 @@ error:
  */
 t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_ASSIGN);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     char* varname = NULL;
     PyObject* list = NULL;
@@ -1235,13 +1311,16 @@ t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
         py_error(x, (char*)"assign varname to list failed");
         goto error;
     }
+    metrics_convert(&span);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, (char*)"assign %s", s->s_name);
     Py_XDECREF(list);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1259,7 +1338,13 @@ error:
  */
 t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
 {
-    return py_eval_text(x, argc, argv, 0, outlet);
+    t_metrics_span span;
+    t_max_err err;
+
+    metrics_begin(&span, METRICS_CODE);
+    err = py_eval_text(x, argc, argv, 0, outlet, &span);
+    metrics_end(x->p_metrics, &span, err == MAX_ERR_NONE);
+    return err;
 }
 
 
@@ -1279,6 +1364,8 @@ t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv,
                       void* outlet)
 {
     t_atom atoms[PY_MAX_ELEMS];
+    t_metrics_span span;
+    t_max_err err;
 
     if (s == gensym("")) {
         return MAX_ERR_GENERIC;
@@ -1313,7 +1400,10 @@ t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv,
         }
     }
 
-    return py_eval_text(x, argc, atoms, 1, outlet);
+    metrics_begin(&span, METRICS_ANYTHING);
+    err = py_eval_text(x, argc, atoms, 1, outlet, &span);
+    metrics_end(x->p_metrics, &span, err == MAX_ERR_NONE);
+    return err;
 }
 
 /**
@@ -1329,8 +1419,12 @@ t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv,
  */
 t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_PIPE);
+
     PyGILState_STATE gstate;
     gstate = PyGILState_Ensure();
+    metrics_gil(&span);
 
     long textsize = 0;
     char* text = NULL;
@@ -1376,7 +1470,9 @@ t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
         goto error;
     }
 
+    metrics_convert(&span);
     pval = PyObject_CallFunctionObjArgs(pipe_fun, pstr, NULL);
+    metrics_exec(&span);
 
     if (pval != NULL) {
 
@@ -1393,9 +1489,11 @@ t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
             Py_XDECREF(pval);
         }
 
+        metrics_convert(&span);
         Py_XDECREF(pipe_pre);
         Py_XDECREF(pstr);
         PyGILState_Release(gstate);
+        metrics_end(x->p_metrics, &span, 1);
         return MAX_ERR_NONE;
     } else {
         goto error;
@@ -1407,9 +1505,78 @@ error:
     Py_XDECREF(pstr);
     Py_XDECREF(pval);
     PyGILState_Release(gstate);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
+// ---------------------------------------------------------------------------------------
+// INSTRUMENTATION
+
+/**
+ * @brief Output the latency metrics as a dictionary, or reset them
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (`reset` to clear the metrics)
+ * @param outlet object outlet for `dictionary <name>`
+ *
+ * @return t_max_err error code
+ */
+t_max_err py_metrics(t_py* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
+{
+    metrics_message(x->p_metrics, x->p_name, argc, argv, outlet);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Record a Chrome trace of the python messages (see trace.h)
+ *
+ * @param x pointer to object structure
+ * @param owner external object, its class name labels the trace
+ * @param argc atom argument count
+ * @param argv `start [python]`, `stop` or `write [path]`
+ * @param outlet object outlet for `trace <path>` after `write`
+ *
+ * @return t_max_err error code
+ */
+t_max_err py_trace(t_py* x, t_object* owner, long argc, t_atom* argv, void* outlet)
+{
+    t_atom atom;
+    t_symbol* path = trace_message(owner, object_classname(owner)->s_name,
+                                   argc, argv);
+
+    if (path && outlet) {
+        atom_setsym(&atom, path);
+        outlet_anything(outlet, gensym("trace"), 1, &atom);
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Sample the python stacks for a flamegraph (see profile.h)
+ *
+ * @param x pointer to object structure
+ * @param owner external object, its class name is the default file name
+ * @param argc atom argument count
+ * @param argv `start [interval_ms]`, `stop` or `dump [path]`
+ * @param outlet object outlet for `profile <path>` after `dump`
+ *
+ * @return t_max_err error code
+ */
+t_max_err py_profile(t_py* x, t_object* owner, long argc, t_atom* argv, void* outlet)
+{
+    t_atom atom;
+    t_symbol* path = profile_message(owner, object_classname(owner)->s_name,
+                                     argc, argv);
+
+    if (path && outlet) {
+        atom_setsym(&atom, path);
+        outlet_anything(outlet, gensym("profile"), 1, &atom);
+    }
+    return MAX_ERR_NONE;
+}
+
 #endif
 
 // ---------------------------------------------------------------------------------------
@@ -0,0 +1,1310 @@
+/**
+ * @file fakemax.c
+ * @brief minimal fake Max runtime to run the python externals outside Max
+ *
+ * Defines the Max API functions used by `py.h`, the externals built on it
+ * (zedit, jmx), `py` and `pyjs`, so that an external can be linked into a
+ * test program with an embedded interpreter:
+ *
+ * - one class: `class_new` records the size and free method used by
+ *   `object_alloc` and `object_free`.
+ * - outlets print what they output to stdout, `[outlet N] ...`.
+ * - `post`, `error`, `object_post` and `object_error` print to stdout.
+ * - threads, mutexes and conditions are pthreads; qelems and clocks are never
+ *   fired (call the qelem function from the test instead), `defer` calls
+ *   its function at once.
+ * - paths: every path id is the current directory, the temp folder is
+ *   `P_tmpdir`.
+ * - dictionaries are not stored: `dictionary_append*` only succeed,
+ *   `dictionary_get*` fail.
+ * - hashtabs are unsorted lists, which is enough for the few keys of a test.
+ * - there is no patcher: the `#P` and `#B` obex lookups fail, `jbox_*`
+ *   getters return nothing, filewatchers never report changes.
+ * - `object_new` makes atomarrays; `buffer~` objects are created by the test
+ *   with fakemax_buffer_new() (see fakemax.h).
+ *
+ * Compile it with the external under test against the max-sdk-base headers:
+ *
+ *     gcc -I<max-includes> $(python3-config --includes) test_x.c fakemax.c \
+ *         $(python3-config --ldflags --embed) -lpthread
+ */
+
+#include "fakemax.h"
+
+#include "ext_path.h"
+#include "ext_strings.h"
+#include "ext_critical.h"
+#include "ext_sysfile.h"
+#include "ext_systhread.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FAKEMAX_MAX_SYMBOLS 4096
+
+/*--------------------------------------------------------------------------*/
+/* classes and objects */
+
+static t_class fakemax_class;
+static method fakemax_free = NULL;
+static long fakemax_size = 0;
+static pthread_t fakemax_main_thread;
+
+t_class* class_new(const char* name, const method mnew, const method mfree,
+                   long size, const method mmenu, short type, ...)
+{
+    fakemax_free = mfree;
+    fakemax_size = size;
+    fakemax_main_thread = pthread_self();
+    fakemax_class.c_sym = gensym(name);
+    return &fakemax_class;
+}
+
+t_max_err class_addmethod(t_class* c, const method m, const char* name, ...)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err class_register(t_symbol* name_space, t_class* c)
+{
+    return MAX_ERR_NONE;
+}
+
+short class_getpath(t_class* c)
+{
+    return 0;
+}
+
+void* object_alloc(t_class* c)
+{
+    return calloc(1, fakemax_size);
+}
+
+/*--------------------------------------------------------------------------*/
+/* objects of the fake runtime: marked by their o_messlist */
+
+enum {
+    FAKEMAX_ATOMARRAY,
+    FAKEMAX_DICTIONARY,
+    FAKEMAX_BUFFER,
+    FAKEMAX_BUFFER_REF,
+    FAKEMAX_HASHTAB,
+    FAKEMAX_CLOCK,
+    FAKEMAX_FILEWATCHER,
+};
+
+static char fakemax_tag;
+
+typedef struct fakemax_object {
+    t_object ob;
+    int kind;
+} t_fakemax_object;
+
+typedef struct fakemax_atomarray {
+    t_fakemax_object hdr;
+    long ac;
+    t_atom* av;
+} t_fakemax_atomarray;
+
+typedef struct fakemax_buffer {
+    t_fakemax_object hdr;
+    struct fakemax_buffer* next;
+    t_symbol* name;
+    long frames;
+    long chans;
+    float* samples;
+} t_fakemax_buffer;
+
+typedef struct fakemax_buffer_ref {
+    t_fakemax_object hdr;
+    t_symbol* name;
+} t_fakemax_buffer_ref;
+
+typedef struct fakemax_entry {
+    struct fakemax_entry* next;
+    t_symbol* key;
+    t_object* value;
+} t_fakemax_entry;
+
+typedef struct fakemax_hashtab {
+    t_fakemax_object hdr;
+    t_fakemax_entry* entries;
+    long size;
+    long flags;
+} t_fakemax_hashtab;
+
+static t_fakemax_buffer* fakemax_buffers = NULL;
+
+static void fakemax_hashtab_clear(t_fakemax_hashtab* x, int free_values);
+
+static void* fakemax_object_new(size_t size, int kind)
+{
+    t_fakemax_object* x = (t_fakemax_object*)calloc(1, size);
+    x->ob.o_messlist = (void*)&fakemax_tag;
+    x->kind = kind;
+    return x;
+}
+
+t_max_err object_free(void* x)
+{
+    t_fakemax_object* obj = (t_fakemax_object*)x;
+
+    if (x == NULL) {
+        return MAX_ERR_NONE;
+    }
+    if ((void*)obj->ob.o_messlist != (void*)&fakemax_tag) {
+        // an instance of the external
+        if (fakemax_free) {
+            fakemax_free(x);
+        }
+    } else if (obj->kind == FAKEMAX_ATOMARRAY) {
+        free(((t_fakemax_atomarray*)x)->av);
+    } else if (obj->kind == FAKEMAX_BUFFER) {
+        return MAX_ERR_NONE; // owned by the test (fakemax_buffer_free)
+    } else if (obj->kind == FAKEMAX_HASHTAB) {
+        fakemax_hashtab_clear((t_fakemax_hashtab*)x, 1);
+    }
+    free(x);
+    return MAX_ERR_NONE;
+}
+
+void* object_new(t_symbol* name_space, t_symbol* classname, ...)
+{
+    t_fakemax_atomarray* x = NULL;
+    va_list va;
+    long ac;
+    t_atom* av;
+
+    if (strcmp(classname->s_name, "atomarray") != 0) {
+        return NULL;
+    }
+    va_start(va, classname);
+    ac = va_arg(va, long);
+    av = va_arg(va, t_atom*);
+    va_end(va);
+
+    x = (t_fakemax_atomarray*)fakemax_object_new(sizeof(t_fakemax_atomarray),
+                                                 FAKEMAX_ATOMARRAY);
+    x->ac = ac;
+    x->av = (t_atom*)calloc(ac ? ac : 1, sizeof(t_atom));
+    memcpy(x->av, av, ac * sizeof(t_atom));
+    return x;
+}
+
+t_max_err atomarray_getatoms(t_atomarray* x, long* ac, t_atom** av)
+{
+    *ac = ((t_fakemax_atomarray*)x)->ac;
+    *av = ((t_fakemax_atomarray*)x)->av;
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_method_typed(void* x, t_symbol* method, long ac, t_atom* av,
+                              t_atom* rv)
+{
+    t_fakemax_buffer* b = (t_fakemax_buffer*)x;
+
+    // `sizeinsamps` of a buffer~
+    if (((t_fakemax_object*)x)->kind != FAKEMAX_BUFFER
+        || strcmp(method->s_name, "sizeinsamps") != 0 || ac < 1) {
+        return MAX_ERR_GENERIC;
+    }
+    b->frames = (long)atom_getlong(av);
+    b->samples = (float*)realloc(b->samples,
+                                 (b->frames ? b->frames : 1) * b->chans * sizeof(float));
+    memset(b->samples, 0, b->frames * b->chans * sizeof(float));
+    return MAX_ERR_NONE;
+}
+
+t_symbol* object_classname(void* x)
+{
+    return fakemax_class.c_sym;
+}
+
+void* object_method(void* x, t_symbol* s, ...)
+{
+    return NULL;
+}
+
+t_messlist* object_mess(t_object* x, t_symbol* methodname)
+{
+    return NULL;
+}
+
+void* object_register(t_symbol* name_space, t_symbol* s, void* x)
+{
+    return x;
+}
+
+t_max_err object_obex_lookup(void* x, t_symbol* key, t_object** val)
+{
+    *val = NULL;
+    return MAX_ERR_GENERIC;
+}
+
+void attr_args_process(void* x, short ac, t_atom* av)
+{
+}
+
+t_symbol* object_attr_getsym(void* x, t_symbol* s)
+{
+    return gensym("");
+}
+
+t_max_err object_attr_setchar(void* x, t_symbol* s, char c)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err object_attr_setsym(void* x, t_symbol* s, t_symbol* c)
+{
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* boxes and patchers: there are none */
+
+t_object* jbox_get_object(t_object* box)
+{
+    return NULL;
+}
+
+t_object* jbox_get_patcher(t_object* box)
+{
+    return NULL;
+}
+
+t_symbol* jbox_get_varname(t_object* box)
+{
+    return NULL;
+}
+
+t_max_err jbox_set_varname(t_object* box, t_symbol* ps)
+{
+    return MAX_ERR_NONE;
+}
+
+t_symbol* jbox_get_id(t_object* box)
+{
+    return NULL;
+}
+
+t_max_err jbox_get_patching_rect(t_object* box, t_rect* pr)
+{
+    memset(pr, 0, sizeof(t_rect));
+    return MAX_ERR_NONE;
+}
+
+t_symbol* jpatcher_get_name(t_object* p)
+{
+    return gensym("");
+}
+
+/*--------------------------------------------------------------------------*/
+/* console */
+
+void post(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    printf("post: ");
+    vprintf(fmt, va);
+    printf("\n");
+    va_end(va);
+}
+
+void error(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    printf("error: ");
+    vprintf(fmt, va);
+    printf("\n");
+    va_end(va);
+}
+
+void object_post(t_object* x, const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    printf("post: ");
+    vprintf(fmt, va);
+    printf("\n");
+    va_end(va);
+}
+
+void object_error(t_object* x, const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    printf("error: ");
+    vprintf(fmt, va);
+    printf("\n");
+    va_end(va);
+}
+
+/*--------------------------------------------------------------------------*/
+/* symbols and atoms */
+
+static t_symbol fakemax_symbols[FAKEMAX_MAX_SYMBOLS];
+static int fakemax_nsymbols = 0;
+static pthread_mutex_t fakemax_symbols_lock = PTHREAD_MUTEX_INITIALIZER;
+
+t_symbol* gensym(const char* s)
+{
+    t_symbol* sym = NULL;
+
+    pthread_mutex_lock(&fakemax_symbols_lock);
+    for (int i = 0; i < fakemax_nsymbols; i++) {
+        if (strcmp(fakemax_symbols[i].s_name, s) == 0) {
+            sym = &fakemax_symbols[i];
+            break;
+        }
+    }
+    if (sym == NULL && fakemax_nsymbols < FAKEMAX_MAX_SYMBOLS) {
+        sym = &fakemax_symbols[fakemax_nsymbols++];
+        sym->s_name = strdup(s);
+    }
+    pthread_mutex_unlock(&fakemax_symbols_lock);
+    return sym;
+}
+
+t_symbol* symbol_unique(void)
+{
+    static int n = 0;
+    char name[32];
+
+    snprintf(name, sizeof(name), "u%03d", n++);
+    return gensym(name);
+}
+
+t_max_err atom_setlong(t_atom* a, t_atom_long b)
+{
+    a->a_type = A_LONG;
+    a->a_w.w_long = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setfloat(t_atom* a, double b)
+{
+    a->a_type = A_FLOAT;
+    a->a_w.w_float = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setsym(t_atom* a, t_symbol* b)
+{
+    a->a_type = A_SYM;
+    a->a_w.w_sym = b;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_setobj(t_atom* a, void* b)
+{
+    a->a_type = A_OBJ;
+    a->a_w.w_obj = (t_object*)b;
+    return MAX_ERR_NONE;
+}
+
+t_atom_long atom_getlong(const t_atom* a)
+{
+    return a->a_type == A_FLOAT ? (t_atom_long)a->a_w.w_float : a->a_w.w_long;
+}
+
+t_atom_float atom_getfloat(const t_atom* a)
+{
+    return a->a_type == A_LONG ? (t_atom_float)a->a_w.w_long : a->a_w.w_float;
+}
+
+t_symbol* atom_getsym(const t_atom* a)
+{
+    return a->a_type == A_SYM ? a->a_w.w_sym : gensym("");
+}
+
+void* atom_getobj(const t_atom* a)
+{
+    return a->a_type == A_OBJ ? a->a_w.w_obj : NULL;
+}
+
+long atom_gettype(const t_atom* a)
+{
+    return a->a_type;
+}
+
+static int fakemax_atom_text(const t_atom* a, char* buf, size_t n)
+{
+    switch (a->a_type) {
+    case A_LONG:
+        return snprintf(buf, n, "%lld", (long long)a->a_w.w_long);
+    case A_FLOAT:
+        return snprintf(buf, n, "%g", a->a_w.w_float);
+    case A_SYM:
+        return snprintf(buf, n, "%s", a->a_w.w_sym->s_name);
+    default:
+        return snprintf(buf, n, "?");
+    }
+}
+
+t_max_err atom_gettext(long ac, t_atom* av, long* textsize, char** text,
+                       long flags)
+{
+    size_t size = 1;
+    char item[256];
+
+    for (long i = 0; i < ac; i++) {
+        size += fakemax_atom_text(&av[i], item, sizeof(item)) + 1;
+    }
+    *text = (char*)calloc(1, size);
+    if (*text == NULL) {
+        return MAX_ERR_OUT_OF_MEM;
+    }
+    for (long i = 0; i < ac; i++) {
+        fakemax_atom_text(&av[i], item, sizeof(item));
+        if (i) {
+            strcat(*text, " ");
+        }
+        strcat(*text, item);
+    }
+    *textsize = (long)strlen(*text) + 1;
+    return MAX_ERR_NONE;
+}
+
+t_max_err atom_alloc(long* ac, t_atom** av, char* alloc)
+{
+    if (*ac && *av) {
+        *alloc = 0;
+        return MAX_ERR_NONE;
+    }
+    *av = (t_atom*)calloc(1, sizeof(t_atom));
+    if (*av == NULL) {
+        return MAX_ERR_OUT_OF_MEM;
+    }
+    *ac = 1;
+    *alloc = 1;
+    return MAX_ERR_NONE;
+}
+
+t_atom* atom_dynamic_start(const t_atom* static_array, long static_count,
+                           long request_count)
+{
+    if (request_count <= static_count) {
+        return (t_atom*)static_array;
+    }
+    return (t_atom*)calloc(request_count, sizeof(t_atom));
+}
+
+void atom_dynamic_end(const t_atom* static_array, t_atom* request_array)
+{
+    if (request_array != static_array) {
+        free(request_array);
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* outlets */
+
+typedef struct fakemax_outlet {
+    int index;
+} t_fakemax_outlet;
+
+static int fakemax_noutlets = 0;
+
+static void fakemax_print_atoms(short ac, t_atom* av)
+{
+    char item[256];
+
+    for (short i = 0; i < ac; i++) {
+        fakemax_atom_text(&av[i], item, sizeof(item));
+        printf(" %s", item);
+    }
+    printf("\n");
+}
+
+void* outlet_new(void* x, const char* s)
+{
+    t_fakemax_outlet* o = (t_fakemax_outlet*)calloc(1, sizeof(t_fakemax_outlet));
+    o->index = fakemax_noutlets++;
+    return o;
+}
+
+void* bangout(void* x)
+{
+    return outlet_new(x, "bang");
+}
+
+void* outlet_bang(void* o)
+{
+    printf("[outlet %d] bang\n", ((t_fakemax_outlet*)o)->index);
+    return NULL;
+}
+
+void* outlet_int(void* o, t_atom_long n)
+{
+    printf("[outlet %d] int %lld\n", ((t_fakemax_outlet*)o)->index, (long long)n);
+    return NULL;
+}
+
+void* outlet_float(void* o, double f)
+{
+    printf("[outlet %d] float %g\n", ((t_fakemax_outlet*)o)->index, f);
+    return NULL;
+}
+
+void* outlet_list(void* o, t_symbol* s, short ac, t_atom* av)
+{
+    printf("[outlet %d] list", ((t_fakemax_outlet*)o)->index);
+    fakemax_print_atoms(ac, av);
+    return NULL;
+}
+
+void* outlet_anything(void* o, t_symbol* s, short ac, t_atom* av)
+{
+    printf("[outlet %d] %s", ((t_fakemax_outlet*)o)->index, s->s_name);
+    fakemax_print_atoms(ac, av);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------*/
+/* memory and strings */
+
+char* sysmem_newptr(long size)
+{
+    return (char*)malloc(size);
+}
+
+char* sysmem_newptrclear(long size)
+{
+    return (char*)calloc(1, size);
+}
+
+char* sysmem_resizeptr(void* ptr, long newsize)
+{
+    return (char*)realloc(ptr, newsize);
+}
+
+void sysmem_freeptr(void* ptr)
+{
+    free(ptr);
+}
+
+void sysmem_copyptr(const void* src, void* dst, long bytes)
+{
+    memmove(dst, src, bytes);
+}
+
+// a handle points to its block, followed by the size of the block
+typedef struct fakemax_handle {
+    char* ptr;
+    long size;
+} t_fakemax_handle;
+
+char** sysmem_newhandle(long size)
+{
+    t_fakemax_handle* h = (t_fakemax_handle*)malloc(sizeof(t_fakemax_handle));
+    h->ptr = (char*)malloc(size ? size : 1);
+    h->size = size;
+    return (char**)h;
+}
+
+char** sysmem_newhandleclear(long size)
+{
+    char** h = sysmem_newhandle(size);
+    memset(*h, 0, size);
+    return h;
+}
+
+long sysmem_handlesize(char** handle)
+{
+    return ((t_fakemax_handle*)handle)->size;
+}
+
+void sysmem_freehandle(char** handle)
+{
+    if (handle) {
+        free(*handle);
+        free(handle);
+    }
+}
+
+char* strncpy_zero(char* dst, const char* src, long size)
+{
+    strncpy(dst, src, size);
+    dst[size - 1] = '\0';
+    return dst;
+}
+
+char* strncat_zero(char* dst, const char* src, long size)
+{
+    long n = (long)strlen(dst);
+
+    if (n < size - 1) {
+        strncat(dst, src, size - 1 - n);
+    }
+    return dst;
+}
+
+int snprintf_zero(char* buffer, size_t count, const char* format, ...)
+{
+    va_list va;
+    int n;
+
+    va_start(va, format);
+    n = vsnprintf(buffer, count, format, va);
+    va_end(va);
+    return n;
+}
+
+typedef struct fakemax_string {
+    char* s;
+} t_fakemax_string;
+
+t_string* string_new(const char* psz)
+{
+    t_fakemax_string* x = (t_fakemax_string*)malloc(sizeof(t_fakemax_string));
+    x->s = strdup(psz ? psz : "");
+    return (t_string*)x;
+}
+
+const char* string_getptr(t_string* x)
+{
+    return ((t_fakemax_string*)x)->s;
+}
+
+void string_append(t_string* x, const char* s)
+{
+    t_fakemax_string* str = (t_fakemax_string*)x;
+    str->s = (char*)realloc(str->s, strlen(str->s) + strlen(s) + 1);
+    strcat(str->s, s);
+}
+
+/*--------------------------------------------------------------------------*/
+/* dictionaries */
+
+t_dictionary* dictionary_new(void)
+{
+    return (t_dictionary*)fakemax_object_new(sizeof(t_fakemax_object),
+                                             FAKEMAX_DICTIONARY);
+}
+
+t_dictionary* dictobj_register(t_dictionary* d, t_symbol** name)
+{
+    *name = symbol_unique();
+    return d;
+}
+
+t_max_err dictionary_clear(t_dictionary* d)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendlong(t_dictionary* d, t_symbol* key, t_atom_long value)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendfloat(t_dictionary* d, t_symbol* key, double value)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendsym(t_dictionary* d, t_symbol* key, t_symbol* value)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appenddictionary(t_dictionary* d, t_symbol* key, t_object* value)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendstring(t_dictionary* d, t_symbol* key, const char* value)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_appendatoms(t_dictionary* d, t_symbol* key, long argc,
+                                 t_atom* argv)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err dictionary_getlong(const t_dictionary* d, t_symbol* key,
+                             t_atom_long* value)
+{
+    return MAX_ERR_GENERIC;
+}
+
+t_max_err dictionary_getsym(const t_dictionary* d, t_symbol* key,
+                            t_symbol** value)
+{
+    return MAX_ERR_GENERIC;
+}
+
+/*--------------------------------------------------------------------------*/
+/* hashtabs */
+
+t_hashtab* hashtab_new(long slotcount)
+{
+    return (t_hashtab*)fakemax_object_new(sizeof(t_fakemax_hashtab), FAKEMAX_HASHTAB);
+}
+
+t_max_err hashtab_flags(t_hashtab* x, long flags)
+{
+    ((t_fakemax_hashtab*)x)->flags = flags;
+    return MAX_ERR_NONE;
+}
+
+// frees a value as the OBJ_FLAG_* flags of the hashtab say
+static void fakemax_hashtab_release(t_fakemax_hashtab* x, t_object* value)
+{
+    if (x->flags & OBJ_FLAG_DATA || x->flags & OBJ_FLAG_REF) {
+        return;
+    }
+    if (x->flags & OBJ_FLAG_MEMORY) {
+        sysmem_freeptr(value);
+    } else {
+        object_free(value);
+    }
+}
+
+static t_fakemax_entry** fakemax_hashtab_find(t_fakemax_hashtab* x, t_symbol* key)
+{
+    t_fakemax_entry** p = &x->entries;
+
+    while (*p && (*p)->key != key) {
+        p = &(*p)->next;
+    }
+    return p;
+}
+
+static void fakemax_hashtab_clear(t_fakemax_hashtab* x, int free_values)
+{
+    t_fakemax_entry* e = x->entries;
+
+    while (e) {
+        t_fakemax_entry* next = e->next;
+        if (free_values) {
+            fakemax_hashtab_release(x, e->value);
+        }
+        free(e);
+        e = next;
+    }
+    x->entries = NULL;
+    x->size = 0;
+}
+
+t_max_err hashtab_store(t_hashtab* x, t_symbol* key, t_object* val)
+{
+    t_fakemax_hashtab* ht = (t_fakemax_hashtab*)x;
+    t_fakemax_entry** p = fakemax_hashtab_find(ht, key);
+
+    if (*p) {
+        if ((*p)->value != val) {
+            fakemax_hashtab_release(ht, (*p)->value);
+        }
+    } else {
+        *p = (t_fakemax_entry*)calloc(1, sizeof(t_fakemax_entry));
+        (*p)->key = key;
+        ht->size++;
+    }
+    (*p)->value = val;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_lookup(t_hashtab* x, t_symbol* key, t_object** val)
+{
+    t_fakemax_entry* e = *fakemax_hashtab_find((t_fakemax_hashtab*)x, key);
+
+    if (e == NULL) {
+        *val = NULL;
+        return MAX_ERR_GENERIC;
+    }
+    *val = e->value;
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_chuckkey(t_hashtab* x, t_symbol* key)
+{
+    t_fakemax_hashtab* ht = (t_fakemax_hashtab*)x;
+    t_fakemax_entry** p = fakemax_hashtab_find(ht, key);
+    t_fakemax_entry* e = *p;
+
+    if (e == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+    *p = e->next;
+    free(e);
+    ht->size--;
+    return MAX_ERR_NONE;
+}
+
+t_atom_long hashtab_getsize(t_hashtab* x)
+{
+    return ((t_fakemax_hashtab*)x)->size;
+}
+
+t_max_err hashtab_getkeys(t_hashtab* x, long* kc, t_symbol*** kv)
+{
+    t_fakemax_hashtab* ht = (t_fakemax_hashtab*)x;
+    long i = 0;
+
+    *kc = ht->size;
+    *kv = NULL;
+    if (ht->size == 0) {
+        return MAX_ERR_NONE;
+    }
+    *kv = (t_symbol**)sysmem_newptr(ht->size * sizeof(t_symbol*));
+    for (t_fakemax_entry* e = ht->entries; e; e = e->next) {
+        (*kv)[i++] = e->key;
+    }
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_clear(t_hashtab* x)
+{
+    fakemax_hashtab_clear((t_fakemax_hashtab*)x, 1);
+    return MAX_ERR_NONE;
+}
+
+t_max_err hashtab_chuck(t_hashtab* x)
+{
+    fakemax_hashtab_clear((t_fakemax_hashtab*)x, 0);
+    free(x);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* buffer~ */
+
+t_buffer_obj* fakemax_buffer_new(t_symbol* name, long frames, long chans)
+{
+    t_fakemax_buffer* b = (t_fakemax_buffer*)fakemax_object_new(
+        sizeof(t_fakemax_buffer), FAKEMAX_BUFFER);
+    t_atom size;
+
+    b->name = name;
+    b->chans = chans;
+    atom_setlong(&size, frames);
+    object_method_typed(b, gensym("sizeinsamps"), 1, &size, NULL);
+    b->next = fakemax_buffers;
+    fakemax_buffers = b;
+    return (t_buffer_obj*)b;
+}
+
+void fakemax_buffer_free(t_buffer_obj* buffer)
+{
+    t_fakemax_buffer** p = &fakemax_buffers;
+
+    while (*p && *p != (t_fakemax_buffer*)buffer) {
+        p = &(*p)->next;
+    }
+    if (*p) {
+        *p = (*p)->next;
+    }
+    free(((t_fakemax_buffer*)buffer)->samples);
+    free(buffer);
+}
+
+t_buffer_ref* buffer_ref_new(t_object* self, t_symbol* name)
+{
+    t_fakemax_buffer_ref* x = (t_fakemax_buffer_ref*)fakemax_object_new(
+        sizeof(t_fakemax_buffer_ref), FAKEMAX_BUFFER_REF);
+    x->name = name;
+    return (t_buffer_ref*)x;
+}
+
+void buffer_ref_set(t_buffer_ref* x, t_symbol* name)
+{
+    ((t_fakemax_buffer_ref*)x)->name = name;
+}
+
+t_buffer_obj* buffer_ref_getobject(t_buffer_ref* x)
+{
+    for (t_fakemax_buffer* b = fakemax_buffers; b; b = b->next) {
+        if (b->name == ((t_fakemax_buffer_ref*)x)->name) {
+            return (t_buffer_obj*)b;
+        }
+    }
+    return NULL;
+}
+
+float* buffer_locksamples(t_buffer_obj* buffer_object)
+{
+    return ((t_fakemax_buffer*)buffer_object)->samples;
+}
+
+void buffer_unlocksamples(t_buffer_obj* buffer_object)
+{
+}
+
+t_atom_long buffer_getchannelcount(t_buffer_obj* buffer_object)
+{
+    return ((t_fakemax_buffer*)buffer_object)->chans;
+}
+
+t_atom_long buffer_getframecount(t_buffer_obj* buffer_object)
+{
+    return ((t_fakemax_buffer*)buffer_object)->frames;
+}
+
+t_max_err buffer_setdirty(t_buffer_obj* buffer_object)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err buffer_edit_begin(t_buffer_obj* buffer_object)
+{
+    return MAX_ERR_NONE;
+}
+
+t_max_err buffer_edit_end(t_buffer_obj* buffer_object, long valid)
+{
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* paths and files */
+
+short path_tempfolder(void)
+{
+    return 1;
+}
+
+short path_toabsolutesystempath(const short in_path, const char* in_filename,
+                                 char* out_filename)
+{
+    char folder[MAX_PATH_CHARS];
+
+    if (in_path == 1) {
+        snprintf(folder, MAX_PATH_CHARS, "%s", P_tmpdir);
+    } else if (getcwd(folder, MAX_PATH_CHARS) == NULL) {
+        return 1;
+    }
+    if (in_filename && *in_filename) {
+        snprintf(out_filename, MAX_PATH_CHARS, "%s/%s", folder, in_filename);
+    } else {
+        snprintf(out_filename, MAX_PATH_CHARS, "%s", folder);
+    }
+    return 0;
+}
+
+short path_nameconform(const char* src, char* dst, long style, long type)
+{
+    strncpy_zero(dst, src, MAX_PATH_CHARS);
+    return 0;
+}
+
+t_max_err path_splitnames(const char* pathname, char* foldername, char* filename)
+{
+    const char* sep = strrchr(pathname, '/');
+
+    if (sep == NULL) {
+        foldername[0] = '\0';
+        strncpy_zero(filename, pathname, MAX_FILENAME_CHARS);
+    } else {
+        snprintf(foldername, MAX_PATH_CHARS, "%.*s", (int)(sep - pathname), pathname);
+        strncpy_zero(filename, sep + 1, MAX_FILENAME_CHARS);
+    }
+    return MAX_ERR_NONE;
+}
+
+short path_createfolder(const short path, const char* name, short* newpath)
+{
+    char folder[MAX_PATH_CHARS];
+
+    path_toabsolutesystempath(path, name, folder);
+    *newpath = path;
+    return mkdir(folder, 0755) != 0;
+}
+
+short path_getdefault(void)
+{
+    return 0;
+}
+
+short path_getsupportpath(void)
+{
+    return 0;
+}
+
+short path_desktopfolder(void)
+{
+    return 0;
+}
+
+short path_userdocfolder(void)
+{
+    return 0;
+}
+
+short path_usermaxfolder(void)
+{
+    return 0;
+}
+
+short path_frompathname(const char* name, short* path, char* filename)
+{
+    char folder[MAX_PATH_CHARS];
+
+    path_splitnames(name, folder, filename);
+    *path = 0;
+    return access(name, R_OK) != 0;
+}
+
+short locatefile_extended(char* name, short* outvol, t_fourcc* outtype,
+                          const t_fourcc* filetypelist, short numtypes)
+{
+    if (access(name, R_OK) != 0) {
+        return 1;
+    }
+    *outvol = 0;
+    return 0;
+}
+
+short open_dialog(char* name, short* volptr, t_fourcc* typeptr,
+                  t_fourcc* types, short ntypes)
+{
+    return 1; // cancelled
+}
+
+short path_opensysfile(const char* name, const short path, t_filehandle* ref,
+                       short perm)
+{
+    *ref = (t_filehandle)fopen(name, "rb");
+    return *ref == NULL;
+}
+
+t_max_err sysfile_geteof(t_filehandle f, t_ptr_size* logeof)
+{
+    FILE* fp = (FILE*)f;
+
+    fseek(fp, 0, SEEK_END);
+    *logeof = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    return MAX_ERR_NONE;
+}
+
+t_max_err sysfile_read(t_filehandle f, t_ptr_size* count, void* bufptr)
+{
+    *count = fread(bufptr, 1, *count, (FILE*)f);
+    return MAX_ERR_NONE;
+}
+
+t_max_err sysfile_readtextfile(t_filehandle f, char** htext, t_ptr_size maxlen,
+                               long flags)
+{
+    t_fakemax_handle* h = (t_fakemax_handle*)htext;
+    t_ptr_size size = 0;
+
+    sysfile_geteof(f, &size);
+    if (maxlen && size > maxlen) {
+        size = maxlen;
+    }
+    h->ptr = (char*)realloc(h->ptr, size + 1);
+    h->size = (long)fread(h->ptr, 1, size, (FILE*)f);
+    h->ptr[h->size] = '\0';
+    return MAX_ERR_NONE;
+}
+
+void* filewatcher_new(t_object* owner, short path, const char* filename)
+{
+    return fakemax_object_new(sizeof(t_fakemax_object), FAKEMAX_FILEWATCHER);
+}
+
+void filewatcher_start(void* x)
+{
+}
+
+t_max_err sysfile_close(t_filehandle f)
+{
+    fclose((FILE*)f);
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* threads */
+
+short isr(void)
+{
+    return 0;
+}
+
+short systhread_ismainthread(void)
+{
+    return pthread_equal(pthread_self(), fakemax_main_thread);
+}
+
+void systhread_sleep(int milliseconds)
+{
+    usleep(milliseconds * 1000);
+}
+
+long systhread_create(method entryproc, void* arg, long stacksize,
+                      long priority, long flags, t_systhread* thread)
+{
+    pthread_t* t = (pthread_t*)malloc(sizeof(pthread_t));
+
+    if (pthread_create(t, NULL, (void* (*)(void*))entryproc, arg) != 0) {
+        free(t);
+        return 1;
+    }
+    *thread = (t_systhread)t;
+    return 0;
+}
+
+long systhread_join(t_systhread thread, unsigned int* retval)
+{
+    pthread_join(*(pthread_t*)thread, NULL);
+    free(thread);
+    if (retval) {
+        *retval = 0;
+    }
+    return 0;
+}
+
+void systhread_exit(long status)
+{
+    // returning from the thread function is enough for pthreads
+}
+
+long systhread_mutex_new(t_systhread_mutex* pmutex, long flags)
+{
+    pthread_mutex_t* m = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(m, NULL);
+    *pmutex = (t_systhread_mutex)m;
+    return 0;
+}
+
+long systhread_mutex_free(t_systhread_mutex pmutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t*)pmutex);
+    free(pmutex);
+    return 0;
+}
+
+long systhread_mutex_lock(t_systhread_mutex pmutex)
+{
+    return pthread_mutex_lock((pthread_mutex_t*)pmutex);
+}
+
+long systhread_mutex_unlock(t_systhread_mutex pmutex)
+{
+    return pthread_mutex_unlock((pthread_mutex_t*)pmutex);
+}
+
+long systhread_cond_new(t_systhread_cond* pcond, long flags)
+{
+    pthread_cond_t* c = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
+    pthread_cond_init(c, NULL);
+    *pcond = (t_systhread_cond)c;
+    return 0;
+}
+
+long systhread_cond_free(t_systhread_cond pcond)
+{
+    pthread_cond_destroy((pthread_cond_t*)pcond);
+    free(pcond);
+    return 0;
+}
+
+long systhread_cond_wait(t_systhread_cond pcond, t_systhread_mutex pmutex)
+{
+    return pthread_cond_wait((pthread_cond_t*)pcond, (pthread_mutex_t*)pmutex);
+}
+
+long systhread_cond_signal(t_systhread_cond pcond)
+{
+    return pthread_cond_signal((pthread_cond_t*)pcond);
+}
+
+void critical_new(t_critical* x)
+{
+    pthread_mutex_t* m = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+    *x = (t_critical)m;
+}
+
+void critical_enter(t_critical x)
+{
+    pthread_mutex_lock((pthread_mutex_t*)x);
+}
+
+void critical_exit(t_critical x)
+{
+    pthread_mutex_unlock((pthread_mutex_t*)x);
+}
+
+void critical_free(t_critical x)
+{
+    pthread_mutex_destroy((pthread_mutex_t*)x);
+    free(x);
+}
+
+/*--------------------------------------------------------------------------*/
+/* qelems: never fired, the test calls the qelem function */
+
+t_qelem* qelem_new(void* obj, method fn)
+{
+    return (t_qelem*)calloc(1, sizeof(void*));
+}
+
+void qelem_set(t_qelem* q)
+{
+}
+
+void qelem_unset(t_qelem* q)
+{
+}
+
+void qelem_free(t_qelem* q)
+{
+    free(q);
+}
+
+/*--------------------------------------------------------------------------*/
+/* clocks: never fired, `defer` runs at once */
+
+void* clock_new(void* obj, method fn)
+{
+    return fakemax_object_new(sizeof(t_fakemax_object), FAKEMAX_CLOCK);
+}
+
+void clock_delay(void* x, long n)
+{
+}
+
+void clock_fdelay(void* x, double n)
+{
+}
+
+void clock_unset(void* x)
+{
+}
+
+void clock_getftime(double* time)
+{
+    *time = systimer_gettime_ms();
+}
+
+double systimer_gettime_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void defer(void* ob, method fn, t_symbol* sym, short argc, t_atom* argv)
+{
+    ((void (*)(void*, t_symbol*, short, t_atom*))fn)(ob, sym, argc, argv);
+}
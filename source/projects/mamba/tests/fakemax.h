@@ -0,0 +1,40 @@
+/**
+ * @file fakemax.h
+ * @brief test helpers of the fake Max runtime (fakemax.c)
+ *
+ * Includes the max-sdk-base headers used by the fake runtime and declares
+ * the functions a test calls to set up what Max would provide.
+ */
+
+#ifndef FAKEMAX_H
+#define FAKEMAX_H
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "ext_buffer.h"
+#include "ext_dictobj.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a named buffer~ of zeroed samples
+ *
+ * @param name name looked up by buffer_ref_getobject()
+ * @param frames frame count
+ * @param chans channel count
+ * @return t_buffer_obj* buffer (free with fakemax_buffer_free)
+ */
+t_buffer_obj* fakemax_buffer_new(t_symbol* name, long frames, long chans);
+
+/**
+ * @brief Free a buffer~ created by fakemax_buffer_new()
+ */
+void fakemax_buffer_free(t_buffer_obj* buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAKEMAX_H */
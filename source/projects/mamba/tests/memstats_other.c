@@ -0,0 +1,36 @@
+/* memstats_other.c -- a second external using memstats.h
+ *
+ * Compiled as its own translation unit, with its own copy of the static
+ * state and thread-locals of memstats.h, as another external sharing the
+ * interpreter (e.g. cobra next to py). Used by test_memstats.c.
+ */
+
+#include <Python.h>
+
+#include "memstats.h"
+
+
+int other_preinit(void)
+{
+    return memstats_preinit(0);
+}
+
+t_memstats* other_new(const char* name)
+{
+    return memstats_new(gensym(name));
+}
+
+void other_enter(t_memstats* m)
+{
+    memstats_enter(m);
+}
+
+void other_leave(void)
+{
+    memstats_leave();
+}
+
+void* other_state(void)
+{
+    return memstats_state;
+}
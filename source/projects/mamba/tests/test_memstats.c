@@ -0,0 +1,255 @@
+/* test_memstats.c -- accounting allocator of memstats.h
+ *
+ * Installs the hook in an embedded interpreter (linked with the fake Max
+ * runtime of fakemax.c) and checks:
+ *
+ *  - malloc, calloc, realloc and free of the MEM and OBJ domains are
+ *    counted against the owner of the allocating thread, a block staying
+ *    with its owner when another one resizes or frees it
+ *  - memstats_enter nesting, and the `interpreter` record outside of it
+ *  - peaks and memstats_reset
+ *  - python code run under an owner
+ *  - a second external (memstats_other.c) shares the hook and state
+ *    instead of wrapping the hook again, also when it initializes python
+ *    again after a finalize
+ *
+ * make test_memstats && ./test_memstats
+ */
+
+#include <Python.h>
+
+#include "memstats.h"
+
+#include <assert.h>
+
+// memstats_other.c
+int other_preinit(void);
+t_memstats* other_new(const char* name);
+void other_enter(t_memstats* m);
+void other_leave(void);
+void* other_state(void);
+
+
+#define LIVE(m) ((int64_t)(m)->live)
+
+/**
+ * the allocators of both domains are hooked once, with the shared state
+ * (by either external: a pre-initialization after a finalize can reset the
+ * allocators, the external which installs the hook again is the first one
+ * to initialize python)
+ */
+static void test_hooked_once(void)
+{
+    PyMemAllocatorEx mem;
+    PyMemAllocatorEx obj;
+
+    PyMem_GetAllocator(PYMEM_DOMAIN_MEM, &mem);
+    PyMem_GetAllocator(PYMEM_DOMAIN_OBJ, &obj);
+    assert(memstats_hook_of(&mem) == &memstats_state->mem);
+    assert(memstats_hook_of(&obj) == &memstats_state->obj);
+    assert(memstats_hook_of(&memstats_state->mem.wrapped) == NULL);
+    assert(memstats_hook_of(&memstats_state->obj.wrapped) == NULL);
+}
+
+static int listed(t_memstats* m)
+{
+    for (t_memstats* r = memstats_state->records; r; r = r->next) {
+        if (r == m) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void test_domains(t_memstats* a, t_memstats* b)
+{
+    int64_t live = LIVE(a);
+    uint64_t allocs = a->allocs;
+    uint64_t frees = a->frees;
+    int64_t blive = LIVE(b);
+    uint64_t ballocs = b->allocs;
+    uint64_t bfrees = b->frees;
+    char* p;
+    char* q;
+    char* o;
+
+    memstats_enter(a);
+    p = (char*)PyMem_Malloc(100);
+    q = (char*)PyMem_Calloc(10, 8);
+    o = (char*)PyObject_Malloc(24);
+    memstats_leave();
+    assert(p && q && o);
+    assert(((uintptr_t)p % 16) == 0 && ((uintptr_t)o % 16) == 0);
+    assert(LIVE(a) == live + 100 + 80 + 24);
+    assert(a->allocs == allocs + 3);
+    for (int i = 0; i < 80; i++) {
+        assert(q[i] == 0);
+    }
+
+    // resized and freed by b: the blocks stay with a
+    memstats_enter(b);
+    memset(p, 'x', 100);
+    p = (char*)PyMem_Realloc(p, 300);
+    assert(p && p[99] == 'x');
+    assert(LIVE(a) == live + 300 + 80 + 24);
+    o = (char*)PyObject_Realloc(o, 8);
+    assert(LIVE(a) == live + 300 + 80 + 8);
+    PyMem_Free(q);
+    PyObject_Free(o);
+    assert(LIVE(a) == live + 300);
+    assert(a->frees == frees + 2);
+    PyMem_Free(p);
+    memstats_leave();
+
+    assert(LIVE(a) == live && a->allocs == allocs + 3 && a->frees == frees + 3);
+    assert(LIVE(b) == blive && b->allocs == ballocs && b->frees == bfrees);
+
+    // realloc(NULL) allocates for the caller, free(NULL) does nothing
+    memstats_enter(b);
+    p = (char*)PyMem_Realloc(NULL, 40);
+    assert(LIVE(b) == blive + 40 && b->allocs == ballocs + 1);
+    PyMem_Free(p);
+    PyMem_Free(NULL);
+    memstats_leave();
+    assert(LIVE(b) == blive && b->frees == bfrees + 1);
+}
+
+static void test_nesting(t_memstats* a, t_memstats* b)
+{
+    t_memstats* interp = &memstats_state->interp;
+    int64_t alive = LIVE(a);
+    int64_t blive = LIVE(b);
+    int64_t ilive;
+    void* pa;
+    void* pb;
+    void* pn;
+    void* pi;
+
+    memstats_enter(a);
+    memstats_enter(b);
+    pb = PyMem_Malloc(10);
+    memstats_enter(NULL);           // keeps b
+    pn = PyMem_Malloc(20);
+    memstats_leave();
+    memstats_leave();
+    pa = PyMem_Malloc(40);
+    memstats_leave();
+    assert(LIVE(b) == blive + 30);
+    assert(LIVE(a) == alive + 40);
+
+    // an unmatched leave is ignored
+    memstats_leave();
+    ilive = LIVE(interp);
+    pi = PyMem_Malloc(80);
+    assert(LIVE(interp) == ilive + 80);
+
+    PyMem_Free(pa);
+    PyMem_Free(pb);
+    PyMem_Free(pn);
+    PyMem_Free(pi);
+    assert(LIVE(a) == alive && LIVE(b) == blive && LIVE(interp) == ilive);
+}
+
+static void test_peak(t_memstats* a)
+{
+    void* p;
+
+    memstats_reset(a);
+    assert(a->peak == a->live);
+
+    memstats_enter(a);
+    p = PyMem_Malloc(100000);
+    PyMem_Free(p);
+    memstats_leave();
+    assert((int64_t)a->peak >= LIVE(a) + 100000);
+
+    memstats_reset(a);
+    assert(a->peak == a->live);
+}
+
+static void test_python(t_memstats* a, t_memstats* b)
+{
+    PyObject* globals = PyModule_GetDict(PyImport_AddModule("__main__"));
+    PyObject* r;
+    int64_t alive = LIVE(a);
+    int64_t blive = LIVE(b);
+
+    memstats_enter(a);
+    r = PyRun_String("xa = [str(i) * 10 for i in range(10000)]",
+                     Py_file_input, globals, NULL);
+    memstats_leave();
+    assert(r != NULL);
+    Py_DECREF(r);
+    assert(LIVE(a) > alive + 10000 * 50);
+
+    memstats_enter(b);
+    r = PyRun_String("del xa", Py_file_input, globals, NULL);
+    memstats_leave();
+    assert(r != NULL);
+    Py_DECREF(r);
+    assert(LIVE(a) < alive + 10000);
+    assert(LIVE(b) < blive + 10000);
+}
+
+/** another external adopts the hook: its owners reach the same counters */
+static void test_other_external(void)
+{
+    t_memstats* c = other_new("other");
+    int64_t live = LIVE(c);
+    void* p;
+
+    assert(other_preinit() == 1);
+    assert(other_state() == memstats_state);
+    assert(listed(c));
+    test_hooked_once();
+
+    other_enter(c);
+    p = PyMem_Malloc(64);
+    other_leave();
+    assert(LIVE(c) == live + 64);
+    PyMem_Free(p);
+    assert(LIVE(c) == live);
+}
+
+
+int main(void)
+{
+    PyGILState_STATE gstate;
+    t_memstats* a;
+    t_memstats* b;
+
+    setenv("PY_MEMSTATS", "1", 1);
+
+    // created before the hook: listed once it is installed
+    a = memstats_new(gensym("a"));
+    assert(memstats_state == NULL);
+    memstats_enter(a);              // no-op until accounting starts
+    memstats_leave();
+
+    assert(memstats_preinit(0) == 1);
+    b = memstats_new(gensym("b"));
+    assert(listed(a) && listed(b));
+    test_hooked_once();
+
+    Py_Initialize();
+    test_domains(a, b);
+    test_nesting(a, b);
+    test_peak(a);
+    test_python(a, b);
+    test_other_external();
+
+    // python again, initialized by the other external this time
+    assert(Py_FinalizeEx() == 0);
+    assert(other_preinit() == 1);
+    assert(memstats_preinit(0) == 1);
+    test_hooked_once();
+    Py_Initialize();
+    gstate = PyGILState_Ensure();
+    test_domains(a, b);
+    test_python(a, b);
+    PyGILState_Release(gstate);
+    assert(Py_FinalizeEx() == 0);
+
+    printf("test_memstats: all tests passed\n");
+    return 0;
+}
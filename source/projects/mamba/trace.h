@@ -0,0 +1,498 @@
+/** \file trace.h
+    \brief A single-header Chrome trace recorder for python externals.
+
+    Records timed events into per-thread ring buffers and writes them out
+    as a Chrome trace event (JSON) file, which can be opened in
+    https://ui.perfetto.dev or chrome://tracing to see where the time of a
+    message goes across the main, scheduler and worker threads.
+
+    Recording is lock-free: each thread only writes to its own buffer
+    (allocated the first time it records while tracing is on) and
+    publishes events with a release store of its head counter. Buffers are
+    kept for the lifetime of the external, since threads are reused by Max.
+    When a buffer is full, the oldest events are overwritten.
+
+    The state is per external (one trace for all instances of a class),
+    since a trace follows threads rather than objects.
+
+    `metrics.h` includes this header and records its spans: each message
+    as a `message` event, with its `gil`, `convert` and `exec` phases
+    nested inside. If `Python.h` is included first, `trace start python`
+    also records python function calls (via `PyEval_SetProfile`, which is
+    backed by `sys.monitoring` on 3.12+) on every thread that marks a GIL
+    acquisition with `metrics_gil` or calls `trace_python_attach`.
+
+    Usage example (the `trace` message of an external):
+
+        trace start [python]    // clear and start recording
+        trace stop              // stop recording, keep events
+        trace write [path]      // write <max temp folder>/<name>.trace.json
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "ext.h"
+#include "ext_obex.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <intrin.h>
+#endif
+
+#if defined(Py_PYTHON_H) && PY_VERSION_HEX < 0x03090000
+#include <frameobject.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*--------------------------------------------------------------------------*/
+/* Constants */
+
+/** event categories, shown as `cat` in the trace */
+typedef enum t_trace_cat {
+    TRACE_MESSAGE,  /*!< a max message from begin to end */
+    TRACE_GIL,      /*!< waiting for the GIL */
+    TRACE_CONVERT,  /*!< converting atoms <-> python */
+    TRACE_EXEC,     /*!< running python code */
+    TRACE_PYTHON,   /*!< a python or builtin function call */
+    TRACE_CATS
+} t_trace_cat;
+
+static const char* const trace_cat_names[TRACE_CATS] = {
+    "message", "gil", "convert", "exec", "python",
+};
+
+// 2 MB per thread
+#define TRACE_CAPACITY (1 << 15)
+#define TRACE_NAME_CHARS 46
+
+/*--------------------------------------------------------------------------*/
+/* Datastructures */
+
+/** one event, 64 bytes */
+typedef struct t_trace_event {
+    uint64_t ts;                    /*!< begin time in ns */
+    uint64_t dur;                   /*!< duration in ns ('X' only) */
+    char ph;                        /*!< 'X' complete, 'B' begin, 'E' end */
+    char cat;                       /*!< t_trace_cat */
+    char name[TRACE_NAME_CHARS];    /*!< truncated event name */
+} t_trace_event;
+
+/** ring buffer of one thread */
+typedef struct t_trace_buffer {
+    struct t_trace_buffer* next;    /*!< next buffer of the list */
+    uint64_t head;                  /*!< events written so far */
+    long tid;                       /*!< sequential thread id */
+    char thread_name[32];
+    t_trace_event events[TRACE_CAPACITY];
+} t_trace_buffer;
+
+typedef struct t_trace_state {
+    int active;                     /*!< events are recorded */
+    int python;                     /*!< python calls are recorded */
+    long threads;                   /*!< buffers allocated so far */
+    uint64_t start_ns;              /*!< events before are dropped */
+    uint64_t stop_ns;               /*!< events after are dropped */
+    t_trace_buffer* buffers;        /*!< push-only list of buffers */
+} t_trace_state;
+
+static t_trace_state trace_state;
+
+#if defined(_MSC_VER)
+#define TRACE_TLS __declspec(thread)
+#else
+#define TRACE_TLS __thread
+#endif
+
+static TRACE_TLS t_trace_buffer* trace_tls_buffer;
+
+/*--------------------------------------------------------------------------*/
+/* Atomics and clock */
+
+#if defined(_MSC_VER)
+#define TRACE_LOAD(p) (*(volatile long*)(p))
+#define TRACE_STORE(p, v) _InterlockedExchange((volatile long*)(p), (long)(v))
+#define TRACE_LOAD64(p) (*(volatile uint64_t*)(p))
+#define TRACE_STORE64(p, v) \
+    _InterlockedExchange64((volatile __int64*)(p), (__int64)(v))
+#define TRACE_INCREMENT(p) _InterlockedIncrement((volatile long*)(p))
+#define TRACE_LOAD_PTR(p) (*(void* volatile*)(p))
+#define TRACE_CAS_PTR(p, expected, desired)                                   \
+    (_InterlockedCompareExchangePointer((void* volatile*)(p), (desired),      \
+                                        (expected))                           \
+     == (expected))
+#else
+#define TRACE_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TRACE_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define TRACE_LOAD64(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TRACE_STORE64(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define TRACE_INCREMENT(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#define TRACE_LOAD_PTR(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TRACE_CAS_PTR(p, expected, desired)                                   \
+    __atomic_compare_exchange_n((p), &(expected), (desired), 0,               \
+                                __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#endif
+
+/** monotonic time in nanoseconds */
+static inline uint64_t trace_now(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&t);
+    return (uint64_t)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+#elif defined(__APPLE__)
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*--------------------------------------------------------------------------*/
+/* Recording */
+
+/** events are being recorded */
+static inline int trace_enabled(void)
+{
+    return TRACE_LOAD(&trace_state.active) != 0;
+}
+
+/** buffer of the calling thread, allocated and named on first use */
+static inline t_trace_buffer* trace_buffer(void)
+{
+    t_trace_buffer* b = trace_tls_buffer;
+    t_trace_buffer* head = NULL;
+
+    if (b) {
+        return b;
+    }
+    b = (t_trace_buffer*)sysmem_newptrclear(sizeof(t_trace_buffer));
+    if (b == NULL) {
+        return NULL;
+    }
+    b->tid = TRACE_INCREMENT(&trace_state.threads);
+    if (systhread_ismainthread()) {
+        snprintf(b->thread_name, sizeof(b->thread_name), "main");
+    } else if (isr()) {
+        snprintf(b->thread_name, sizeof(b->thread_name), "scheduler");
+    } else {
+        snprintf(b->thread_name, sizeof(b->thread_name), "thread %ld",
+                 b->tid);
+    }
+    do {
+        head = (t_trace_buffer*)TRACE_LOAD_PTR(&trace_state.buffers);
+        b->next = head;
+    } while (!TRACE_CAS_PTR(&trace_state.buffers, head, b));
+    trace_tls_buffer = b;
+    return b;
+}
+
+/**
+ * @brief Record an event on the calling thread
+ *
+ * @param ph 'X' (complete), 'B' (begin) or 'E' (end)
+ * @param cat category
+ * @param name event name, truncated to TRACE_NAME_CHARS - 1
+ * @param ts begin time in ns (trace_now)
+ * @param dur duration in ns for 'X' events
+ */
+static inline void trace_record(char ph, t_trace_cat cat, const char* name,
+                                uint64_t ts, uint64_t dur)
+{
+    t_trace_buffer* b = trace_buffer();
+    t_trace_event* e = NULL;
+    size_t len = 0;
+
+    if (b == NULL) {
+        return;
+    }
+    // only this thread writes head: a plain read is enough
+    e = b->events + (b->head & (TRACE_CAPACITY - 1));
+    e->ts = ts;
+    e->dur = dur;
+    e->ph = ph;
+    e->cat = (char)cat;
+    if (name) {
+        len = strlen(name);
+        if (len > TRACE_NAME_CHARS - 1) {
+            len = TRACE_NAME_CHARS - 1;
+        }
+        memcpy(e->name, name, len);
+    }
+    e->name[len] = '\0';
+    TRACE_STORE64(&b->head, b->head + 1);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Python calls */
+
+#ifdef Py_PYTHON_H
+
+static int trace_profile(PyObject* obj, PyFrameObject* frame, int what,
+                         PyObject* arg)
+{
+    PyCodeObject* code = NULL;
+    PyObject* name = NULL;
+    const char* cname = NULL;
+
+    if (!trace_enabled()) {
+        return 0;
+    }
+    switch (what) {
+    case PyTrace_CALL:
+#if PY_VERSION_HEX >= 0x03090000
+        code = PyFrame_GetCode(frame);
+#else
+        code = frame->f_code;
+        Py_INCREF(code);
+#endif
+#if PY_VERSION_HEX >= 0x030B0000
+        name = code->co_qualname;
+#else
+        name = code->co_name;
+#endif
+        cname = name ? PyUnicode_AsUTF8(name) : NULL;
+        if (cname == NULL) {
+            PyErr_Clear();
+        }
+        trace_record('B', TRACE_PYTHON, cname ? cname : "<code>",
+                     trace_now(), 0);
+        Py_DECREF(code);
+        break;
+    case PyTrace_C_CALL:
+        cname = PyCFunction_Check(arg)
+                    ? ((PyCFunctionObject*)arg)->m_ml->ml_name
+                    : "<builtin>";
+        trace_record('B', TRACE_PYTHON, cname, trace_now(), 0);
+        break;
+    case PyTrace_RETURN:
+    case PyTrace_C_RETURN:
+    case PyTrace_C_EXCEPTION:
+        trace_record('E', TRACE_PYTHON, NULL, trace_now(), 0);
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief Install or remove the profile function on the calling thread
+ *
+ * Must be called with the GIL held. Installs `trace_profile` if python
+ * calls are being traced, and removes it (only if it is ours) once tracing
+ * stops. The thread state is checked rather than remembered, since
+ * PyGILState_Ensure creates a new one on threads without a python thread
+ * state. Note that it replaces a profiler set by python code (e.g.
+ * cProfile) on that thread while tracing.
+ */
+static inline void trace_python_attach(void)
+{
+    int want = trace_enabled() && trace_state.python;
+    int installed = PyThreadState_Get()->c_profilefunc == trace_profile;
+
+    if (want && !installed) {
+        PyEval_SetProfile(trace_profile, NULL);
+    } else if (!want && installed) {
+        PyEval_SetProfile(NULL, NULL);
+    }
+}
+
+#else
+
+static inline void trace_python_attach(void) {}
+
+#endif /* Py_PYTHON_H */
+
+/*--------------------------------------------------------------------------*/
+/* Control */
+
+/**
+ * @brief Start recording, dropping previously recorded events
+ *
+ * @param python also record python function calls
+ */
+static inline void trace_start(int python)
+{
+    trace_state.python = python;
+    TRACE_STORE64(&trace_state.start_ns, trace_now());
+    TRACE_STORE64(&trace_state.stop_ns, UINT64_MAX);
+    TRACE_STORE(&trace_state.active, 1);
+}
+
+static inline void trace_stop(void)
+{
+    if (trace_enabled()) {
+        TRACE_STORE(&trace_state.active, 0);
+        TRACE_STORE64(&trace_state.stop_ns, trace_now());
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+/* Output */
+
+static inline void trace_write_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/**
+ * @brief Write the recorded events as a Chrome trace JSON file
+ *
+ * @param path file to write
+ * @param process process name shown in the trace
+ * @return long number of events written, or -1 on error
+ *
+ * Events may still be recorded while writing: each buffer is copied
+ * first, and events overwritten during the copy are dropped.
+ */
+static inline long trace_write(const char* path, const char* process)
+{
+    t_trace_event* copy = NULL;
+    t_trace_buffer* b = NULL;
+    uint64_t start = TRACE_LOAD64(&trace_state.start_ns);
+    uint64_t stop = TRACE_LOAD64(&trace_state.stop_ns);
+    long count = 0;
+    FILE* f = NULL;
+
+    copy = (t_trace_event*)sysmem_newptr(sizeof(t_trace_event)
+                                         * TRACE_CAPACITY);
+    if (copy == NULL) {
+        return -1;
+    }
+    f = fopen(path, "w");
+    if (f == NULL) {
+        sysmem_freeptr(copy);
+        return -1;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+               "\"args\":{\"name\":");
+    trace_write_string(f, process);
+    fprintf(f, "}}");
+
+    b = (t_trace_buffer*)TRACE_LOAD_PTR(&trace_state.buffers);
+    for (; b; b = b->next) {
+        uint64_t head = TRACE_LOAD64(&b->head);
+        uint64_t first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+        uint64_t valid = 0;
+
+        for (uint64_t i = first; i < head; i++) {
+            copy[i - first] = b->events[i & (TRACE_CAPACITY - 1)];
+        }
+        // slots reused by the writer since head was read may be torn
+        valid = TRACE_LOAD64(&b->head);
+        valid = valid > TRACE_CAPACITY ? valid - TRACE_CAPACITY : 0;
+        if (valid < first) {
+            valid = first;
+        }
+
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":%ld,\"args\":{\"name\":",
+                b->tid);
+        trace_write_string(f, b->thread_name);
+        fprintf(f, "}}");
+
+        for (uint64_t i = valid; i < head; i++) {
+            t_trace_event* e = copy + (i - first);
+            if (e->ts < start || e->ts > stop) {
+                continue;
+            }
+            fprintf(f, ",\n{\"ph\":\"%c\",\"cat\":\"%s\",\"name\":", e->ph,
+                    trace_cat_names[(int)e->cat]);
+            trace_write_string(f, e->name);
+            fprintf(f, ",\"pid\":1,\"tid\":%ld,\"ts\":%.3f", b->tid,
+                    (double)(e->ts - start) / 1e3);
+            if (e->ph == 'X') {
+                fprintf(f, ",\"dur\":%.3f", (double)e->dur / 1e3);
+            }
+            fprintf(f, "}");
+            count++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    if (fclose(f) != 0) {
+        count = -1;
+    }
+    sysmem_freeptr(copy);
+    return count;
+}
+
+/**
+ * @brief Handle a `trace start [python] | stop | write [path]` message
+ *
+ * @param x object, for console messages
+ * @param label process name in the trace and default file name
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_symbol* path of the written file, NULL otherwise
+ *
+ * `write` without a path writes `<max temp folder>/<label>.trace.json`.
+ */
+static inline t_symbol* trace_message(t_object* x, const char* label,
+                                      long argc, t_atom* argv)
+{
+    t_symbol* cmd = argc ? atom_getsym(argv) : gensym("");
+    char folder[MAX_PATH_CHARS];
+    char path[MAX_PATH_CHARS];
+    long count = 0;
+
+    if (cmd == gensym("start")) {
+        trace_start(argc > 1 && atom_getsym(argv + 1) == gensym("python"));
+        return NULL;
+    }
+    if (cmd == gensym("stop")) {
+        trace_stop();
+        return NULL;
+    }
+    if (cmd != gensym("write")) {
+        object_error(x, "trace start [python] | stop | write [path]");
+        return NULL;
+    }
+    if (argc > 1 && atom_getsym(argv + 1) != gensym("")) {
+        snprintf(path, MAX_PATH_CHARS, "%s", atom_getsym(argv + 1)->s_name);
+    } else {
+        if (path_toabsolutesystempath(path_tempfolder(), "", folder)
+            != MAX_ERR_NONE) {
+            object_error(x, "trace: no temp folder");
+            return NULL;
+        }
+        snprintf(path, MAX_PATH_CHARS, "%s/%s.trace.json", folder, label);
+    }
+    count = trace_write(path, label);
+    if (count < 0) {
+        object_error(x, "trace: could not write %s", path);
+        return NULL;
+    }
+    object_post(x, "trace: %ld events written to %s", count, path);
+    return gensym(path);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
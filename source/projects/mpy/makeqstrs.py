@@ -0,0 +1,216 @@
+"""makeqstrs: regenerate micropython_embed/genhdr/qstrdefs.generated.h
+
+The vendored `micropython_embed` tree was generated by micropython's
+`micropython_embed.mk` for its default embed configuration. When
+`mpconfigport.h` enables features which use qstrs missing from that table
+(e.g. floats or the native emitter), the build fails with undeclared
+`MP_QSTR_xxx` identifiers. Rerun this script after changing the config:
+
+    % python3 makeqstrs.py [--cc cc]
+
+It preprocesses the embed sources (as listed in `micropython.cmake`) with
+this project's `mpconfigport.h`, collects every `MP_QSTR_xxx` and the active
+`Q(...)` entries of `py/qstrdefs.h`, and merges the missing ones into the
+sorted tail of the existing header. Existing entries are never dropped or
+reordered, so qstrs used by the external itself survive.
+
+`moduledefs.h` and `root_pointers.h` are not regenerated: enabling features
+which register new modules or root pointers still needs the upstream tools.
+
+Like the rest of the project tooling, this only uses the standard library.
+"""
+
+import argparse
+import html.entities
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+HERE = Path(__file__).parent
+EMBED = HERE / "micropython_embed"
+HEADER = EMBED / "genhdr" / "qstrdefs.generated.h"
+
+# same escaping as micropython's makeqstrdata.py
+CODEPOINT2NAME = dict(html.entities.codepoint2name)
+CODEPOINT2NAME.update(
+    {
+        ord("-"): "hyphen",
+        ord(" "): "space",
+        ord("'"): "squot",
+        ord(","): "comma",
+        ord("."): "dot",
+        ord(":"): "colon",
+        ord(";"): "semicolon",
+        ord("/"): "slash",
+        ord("%"): "percent",
+        ord("#"): "hash",
+        ord("("): "paren_open",
+        ord(")"): "paren_close",
+        ord("["): "bracket_open",
+        ord("]"): "bracket_close",
+        ord("{"): "brace_open",
+        ord("}"): "brace_close",
+        ord("*"): "star",
+        ord("!"): "bang",
+        ord("\\"): "backslash",
+        ord("+"): "plus",
+        ord("$"): "dollar",
+        ord("="): "equals",
+        ord("?"): "question",
+        ord("@"): "at_sign",
+        ord("^"): "caret",
+        ord("|"): "pipe",
+        ord("~"): "tilde",
+    }
+)
+
+RE_QSTR = re.compile(r"\bMP_QSTR_([_a-zA-Z0-9]+)")
+RE_QDEF = re.compile(r"^QDEF([01])\(MP_QSTR_?(\w*), \d+, \d+, \"(.*)\"\)$")
+RE_QCFG = re.compile(r"^QCFG\((\w+), \(?(\d+)\)?\)")
+
+
+def qstr_ident(qstr: str) -> str:
+    """identifier suffix of a qstr (MP_QSTR_<ident>)"""
+    return "".join(
+        c if c.isalnum() or c == "_" else "_%s_" % CODEPOINT2NAME.get(ord(c), "0x%02x" % ord(c))
+        for c in qstr
+    )
+
+
+def qstr_hash(qstr: bytes, bytes_hash: int) -> int:
+    """djb2 variant used by qstr.c"""
+    h = 5381
+    for b in qstr:
+        h = (h * 33) ^ b
+    h &= (1 << (8 * bytes_hash)) - 1
+    return h or 1
+
+
+def qstr_cstring(qstr: bytes) -> str:
+    """escape a qstr for a C string literal"""
+    return "".join(
+        chr(b) if 32 <= b < 127 and b not in (ord('"'), ord("\\")) else "\\x%02x" % b
+        for b in qstr
+    )
+
+
+def unescape_cstring(s: str) -> str:
+    return re.sub(r"\\x([0-9a-fA-F]{2})", lambda m: chr(int(m.group(1), 16)), s)
+
+
+class QstrGenerator:
+    """Collects the qstrs of a micropython_embed tree for a given config."""
+
+    def __init__(self, cc: str = "cc"):
+        self.cc = cc
+        self.includes = [
+            HERE,
+            EMBED,
+            EMBED / "genhdr",
+            EMBED / "port",
+            EMBED / "py",
+            EMBED / "shared",
+        ]
+
+    def preprocess(self, path: Path, source: str = None) -> str:
+        cmd = [self.cc, "-E", "-DNO_QSTR"] + [f"-I{i}" for i in self.includes]
+        if source is None:
+            cmd.append(str(path))
+            return subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+        cmd += ["-x", "c", "-"]
+        return subprocess.run(
+            cmd, input=source, check=True, capture_output=True, text=True, cwd=path.parent
+        ).stdout
+
+    def sources(self):
+        cmake = (HERE / "micropython.cmake").read_text()
+        names = sorted(set(re.findall(r"^\s*\$\{EMBED_DIR\}/(\S+\.c)", cmake, re.M)))
+        return [EMBED / name for name in names]
+
+    def source_qstrs(self):
+        """identifiers of all MP_QSTR_xxx used by the preprocessed sources"""
+        idents = set()
+        for src in self.sources():
+            idents.update(RE_QSTR.findall(self.preprocess(src)))
+        return idents
+
+    def qstrdefs(self):
+        """active Q(...) entries and QCFG values of py/qstrdefs.h"""
+        lines = (EMBED / "py" / "qstrdefs.h").read_text().splitlines()
+        qstrs = {}
+        # protect Q(...) bodies from the preprocessor, keep the conditionals
+        guarded = []
+        for i, line in enumerate(lines):
+            if line.startswith("Q(") and line.endswith(")"):
+                qstrs[i] = line[2:-1].replace("\\n", "\n").replace("\\r", "\r")
+                guarded.append(f"MPY_Q_ENTRY_{i}")
+            else:
+                guarded.append(line)
+        out = self.preprocess(EMBED / "py" / "qstrdefs.h", "\n".join(guarded) + "\n")
+        active = [qstrs[int(i)] for i in re.findall(r"MPY_Q_ENTRY_(\d+)", out)]
+        cfg = {k: int(v) for k, v in RE_QCFG.findall(out)}
+        return active, cfg
+
+    def read_header(self):
+        """(kind, ident, qstr, line) entries of the existing header"""
+        entries = []
+        for line in HEADER.read_text().splitlines():
+            match = RE_QDEF.match(line)
+            if match:
+                kind, ident, qstr = match.groups()
+                entries.append((kind, ident, unescape_cstring(qstr), line))
+        return entries
+
+    def generate(self):
+        entries = self.read_header()
+        known = set(ident for _, ident, _, _ in entries)
+        qdefs, cfg = self.qstrdefs()
+        bytes_hash = cfg.get("BYTES_IN_HASH", 2)
+
+        new = {}
+        for qstr in qdefs:
+            new.setdefault(qstr_ident(qstr), qstr)
+        for ident in self.source_qstrs():
+            new.setdefault(ident, ident)
+        for ident in known:
+            new.pop(ident, None)
+
+        # the header is a fixed static prefix followed by a tail sorted by
+        # string value: merge the new qstrs into that tail.
+        key = lambda qstr: qstr.encode("utf8")
+        start = len(entries) - 1
+        while start > 0 and key(entries[start - 1][2]) <= key(entries[start][2]):
+            start -= 1
+        lines = [line for _, _, _, line in entries[:start]]
+        tail = [(key(qstr), line) for _, _, qstr, line in entries[start:]]
+        for ident, qstr in new.items():
+            data = key(qstr)
+            tail.append(
+                (
+                    data,
+                    'QDEF1(MP_QSTR_%s, %d, %d, "%s")'
+                    % (ident, qstr_hash(data, bytes_hash), len(data), qstr_cstring(data)),
+                )
+            )
+        tail.sort(key=lambda item: item[0])
+        lines += [line for _, line in tail]
+
+        out = ["// This file was automatically generated by makeqstrdata.py", ""]
+        HEADER.write_text("\n".join(out + lines) + "\n")
+        return sorted(new)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cc", default="cc", help="c compiler used to preprocess")
+    args = parser.parse_args()
+    added = QstrGenerator(args.cc).generate()
+    print(f"{HEADER.relative_to(HERE)}: {len(added)} qstrs added")
+    for ident in added:
+        print(f"  MP_QSTR_{ident}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
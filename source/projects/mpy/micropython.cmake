@@ -50,8 +50,6 @@ set(MPY_INCLUDE_DIRECTORIES
 
 
 set(MPY_SOURCE_FILES
-	${EMBED_DIR}/port/embed_util.c
-	${EMBED_DIR}/port/mphalport.c
 	${EMBED_DIR}/py/argcheck.c
 	${EMBED_DIR}/py/asmarm.c
 	${EMBED_DIR}/py/asmbase.c
@@ -172,8 +170,6 @@ set(MPY_SOURCE_FILES
 	${EMBED_DIR}/py/vm.c
 	${EMBED_DIR}/py/vstr.c
 	${EMBED_DIR}/py/warning.c
-	${EMBED_DIR}/port/embed_util.c
-	${EMBED_DIR}/port/mphalport.c
 	${EMBED_DIR}/py/argcheck.c
 	${EMBED_DIR}/py/asmarm.c
 	${EMBED_DIR}/py/asmbase.c
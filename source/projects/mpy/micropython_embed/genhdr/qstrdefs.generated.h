@@ -173,11 +173,15 @@ QDEF0(MP_QSTR__lt_listcomp_gt_, 5588, 10, "<listcomp>")
 QDEF0(MP_QSTR__lt_setcomp_gt_, 20820, 9, "<setcomp>")
 QDEF1(MP_QSTR__lt_stdin_gt_, 25571, 7, "<stdin>")
 QDEF1(MP_QSTR__lt_string_gt_, 21330, 8, "<string>")
+QDEF1(MP_QSTR_None, 53615, 4, "None")
+QDEF1(MP_QSTR_ViperTypeError, 1501, 14, "ViperTypeError")
 QDEF0(MP_QSTR___add__, 33476, 7, "__add__")
 QDEF0(MP_QSTR___bool__, 25899, 8, "__bool__")
 QDEF1(MP_QSTR___build_class__, 34882, 15, "__build_class__")
+QDEF1(MP_QSTR___complex__, 58053, 11, "__complex__")
 QDEF0(MP_QSTR___contains__, 24518, 12, "__contains__")
 QDEF0(MP_QSTR___eq__, 15985, 6, "__eq__")
+QDEF1(MP_QSTR___float__, 28725, 9, "__float__")
 QDEF0(MP_QSTR___ge__, 18087, 6, "__ge__")
 QDEF0(MP_QSTR___gt__, 33462, 6, "__gt__")
 QDEF0(MP_QSTR___iadd__, 19053, 8, "__iadd__")
@@ -193,21 +197,32 @@ QDEF1(MP_QSTR_bin, 18656, 3, "bin")
 QDEF1(MP_QSTR_bound_method, 41623, 12, "bound_method")
 QDEF1(MP_QSTR_closure, 51828, 7, "closure")
 QDEF1(MP_QSTR_collect, 26011, 7, "collect")
+QDEF1(MP_QSTR_complex, 40389, 7, "complex")
 QDEF1(MP_QSTR_dict_view, 43309, 9, "dict_view")
 QDEF1(MP_QSTR_disable, 30353, 7, "disable")
 QDEF1(MP_QSTR_enable, 56836, 6, "enable")
 QDEF1(MP_QSTR_errno, 4545, 5, "errno")
+QDEF1(MP_QSTR_float, 17461, 5, "float")
 QDEF1(MP_QSTR_function, 551, 8, "function")
 QDEF1(MP_QSTR_gc, 28257, 2, "gc")
 QDEF1(MP_QSTR_generator, 50070, 9, "generator")
 QDEF1(MP_QSTR_hex, 20592, 3, "hex")
+QDEF1(MP_QSTR_imag, 46919, 4, "imag")
 QDEF1(MP_QSTR_isenabled, 58778, 9, "isenabled")
 QDEF1(MP_QSTR_iterator, 48711, 8, "iterator")
 QDEF1(MP_QSTR_maximum_space_recursion_space_depth_space_exceeded, 7795, 32, "maximum recursion depth exceeded")
 QDEF1(MP_QSTR_mem_alloc, 11090, 9, "mem_alloc")
 QDEF1(MP_QSTR_mem_free, 25291, 8, "mem_free")
 QDEF1(MP_QSTR_module, 39359, 6, "module")
+QDEF1(MP_QSTR_native, 2948, 6, "native")
 QDEF1(MP_QSTR_oct, 23805, 3, "oct")
+QDEF1(MP_QSTR_ptr, 28755, 3, "ptr")
+QDEF1(MP_QSTR_ptr16, 51956, 5, "ptr16")
+QDEF1(MP_QSTR_ptr32, 51890, 5, "ptr32")
+QDEF1(MP_QSTR_ptr8, 31371, 4, "ptr8")
+QDEF1(MP_QSTR_real, 63935, 4, "real")
+QDEF1(MP_QSTR_uint, 15843, 4, "uint")
+QDEF1(MP_QSTR_viper, 9053, 5, "viper")
 QDEF1(MP_QSTR__brace_open__colon__hash_b_brace_close_, 14168, 5, "{:#b}")
 QDEF1(MP_QSTR__brace_open__colon__hash_o_brace_close_, 14325, 5, "{:#o}")
 QDEF1(MP_QSTR__brace_open__colon__hash_x_brace_close_, 14850, 5, "{:#x}")
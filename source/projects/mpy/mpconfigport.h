@@ -13,3 +13,33 @@
 #define MICROPY_ENABLE_COMPILER                 (1)
 #define MICROPY_ENABLE_GC                       (1)
 #define MICROPY_PY_GC                           (1)
+
+// Grow the gc heap in arena chunks owned by the external (see mpy_vm.c).
+#define MICROPY_GC_SPLIT_HEAP                   (1)
+#define MICROPY_GC_SPLIT_HEAP_AUTO              (1)
+#define MP_PLAT_ALLOC_HEAP(size)                mpy_vm_arena_alloc(size)
+#define MP_PLAT_FREE_HEAP(ptr)                  mpy_vm_arena_free(ptr)
+
+// Double precision floats (Max floats are doubles).
+#define MICROPY_FLOAT_IMPL                      (MICROPY_FLOAT_IMPL_DOUBLE)
+
+// Native code emitter for @micropython.native and @micropython.viper.
+// Micropython has no arm64 emitter, so this is x86-64 only.
+#if defined(__x86_64__) || defined(_M_X64)
+#define MICROPY_EMIT_X64                        (1)
+// the native glue table references bytearray (viper buffer access)
+#define MICROPY_PY_BUILTINS_BYTEARRAY           (1)
+#endif
+
+// Executable memory for native code is mapped outside the gc heap,
+// writable while emitting and read/execute once committed (see mpy_vm.c).
+#define MP_PLAT_ALLOC_EXEC(min_size, ptr, size) mpy_vm_alloc_exec(min_size, ptr, size)
+#define MP_PLAT_FREE_EXEC(ptr, size)            mpy_vm_free_exec(ptr, size)
+#define MP_PLAT_COMMIT_EXEC(buf, len, reloc)    mpy_vm_commit_exec(buf, len, reloc)
+
+#include <stddef.h>
+void *mpy_vm_arena_alloc(size_t size);
+void mpy_vm_arena_free(void *ptr);
+void mpy_vm_alloc_exec(size_t min_size, void **ptr, size_t *size);
+void mpy_vm_free_exec(void *ptr, size_t size);
+void *mpy_vm_commit_exec(void *buf, size_t len, void *reloc);
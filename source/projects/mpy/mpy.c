@@ -1,170 +1,764 @@
 /**
     @file mpy - a micropython external
 
+    All instances share one micropython vm (see mpy_vm.h). Each instance
+    has a persistent namespace in which `eval`, `exec`, `execfile`, `call`,
+    `assign` and `import` operate. The gc heap is a growable arena whose
+    initial size, growth limit and collection policy are attributes.
+
 */
 
 #include "ext.h"
 #include "ext_obex.h"
 
-#include "port/micropython_embed.h"
-
-// This is example 1 script, which will be compiled and executed.
-static const char *example_1 =
-    "print('hello world!', list(x + 1 for x in range(10)), end='eol\\n')";
-
-// This is example 2 script, which will be compiled and executed.
-static const char *example_2 =
-    "for i in range(10):\n"
-    "    print('iter {:08}'.format(i))\n"
-    "\n"
-    "try:\n"
-    "    1//0\n"
-    "except Exception as er:\n"
-    "    print('caught exception', repr(er))\n"
-    "\n"
-    "import gc\n"
-    "print('run GC collect')\n"
-    "gc.collect()\n"
-    "\n"
-    "print('finish')\n"
-    ;
-
-// This array is the MicroPython GC heap.
-static char HEAP[8 * 1024];
+#include "py/runtime.h"
+
+#include "mpy_vm.h"
+
+#define MPY_MAX_ATOMS 128
+#define MPY_MAX_LINE 1024
+
+#define MPY_DEFAULT_HEAPSIZE 64   // KB
+#define MPY_DEFAULT_HEAPMAX 4096  // KB
 
 
 typedef struct mpy {
     t_object c_obj;
-    void* c_outlet;
 
+    t_atom_long c_heapsize;    // initial / minimum arena size in KB
+    t_atom_long c_heapmax;     // arena growth limit in KB
+    char c_autocollect;        // collect when the heap is full
+    t_symbol* c_emit;          // bytecode, native or viper
+    int c_emit_id;             // MPY_EMIT_xxx of c_emit
+
+    char c_vm;                 // holds a reference to the shared vm
+    mp_int_t c_id;             // key of the namespace in the vm registry
+    mp_obj_dict_t* c_ns;       // namespace (kept alive by the registry)
+
+    char c_line[MPY_MAX_LINE]; // partial line of print output
+    size_t c_line_len;
+
+    void* c_outlet_right;      // gc statistics
+    void* c_outlet;
 } t_mpy;
 
+/* state of a single call into the vm (see mpy_vm_run) */
+typedef struct mpy_call {
+    t_mpy* x;
+    const char* text;
+    size_t text_len;
+    mp_parse_input_kind_t kind;
+    t_symbol* name;
+    long argc;
+    t_atom* argv;
+    long n_out;
+    t_atom out[MPY_MAX_ATOMS];
+} t_mpy_call;
+
 
 // prototypes
 void* mpy_new(t_symbol* s, long argc, t_atom* argv);
 void mpy_free(t_mpy* x);
 
-// generic methods
-void mpy_bang(t_mpy* x);
+// attributes
+t_max_err mpy_heapsize_set(t_mpy* x, void* attr, long argc, t_atom* argv);
+t_max_err mpy_heapmax_set(t_mpy* x, void* attr, long argc, t_atom* argv);
+t_max_err mpy_autocollect_set(t_mpy* x, void* attr, long argc, t_atom* argv);
+t_max_err mpy_emit_set(t_mpy* x, void* attr, long argc, t_atom* argv);
 
 // core py methods
-// t_max_err mpy_import(t_mpy* x, t_symbol* s);
-// t_max_err mpy_eval(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
-// t_max_err mpy_exec(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
-// t_max_err mpy_execfile(t_mpy* x, t_symbol* s);
+t_max_err mpy_import(t_mpy* x, t_symbol* s);
+t_max_err mpy_eval(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err mpy_exec(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err mpy_execfile(t_mpy* x, t_symbol* s);
 
 // extra py methods
-// t_max_err mpy_call(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
-// t_max_err mpy_assign(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
-// t_max_err mpy_code(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
-// t_max_err mpy_anything(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
-// t_max_err mpy_pipe(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet);
+t_max_err mpy_call(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err mpy_assign(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
+
+// memory
+t_max_err mpy_gc(t_mpy* x, t_symbol* s, long argc, t_atom* argv);
 
 
 static t_class* s_mpy_class = NULL;
+static t_systhread_mutex s_mpy_mutex = NULL;
+static mp_int_t s_mpy_next_id = 0;
 
 void ext_main(void* r)
 {
     t_class* c = class_new("mpy", (method)mpy_new, (method)mpy_free,
                            sizeof(t_mpy), (method)0L, A_GIMME, 0);
 
-    class_addmethod(c, (method)mpy_bang,      "bang", 0);
-
-    // class_addmethod(c, (method)mpy_import,    "import",   A_SYM, 0);
-    // class_addmethod(c, (method)mpy_eval,      "eval",     A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_exec,      "exec",     A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_execfile,  "execfile", A_DEFSYM, 0);
-
-    // class_addmethod(c, (method)mpy_assign,    "assign",   A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_call,      "call",     A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_code,      "code",     A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_pipe,      "pipe",     A_GIMME, 0);
-    // class_addmethod(c, (method)mpy_anything,  "anything", A_GIMME, 0);
+    class_addmethod(c, (method)mpy_import,    "import",   A_SYM, 0);
+    class_addmethod(c, (method)mpy_eval,      "eval",     A_GIMME, 0);
+    class_addmethod(c, (method)mpy_exec,      "exec",     A_GIMME, 0);
+    class_addmethod(c, (method)mpy_execfile,  "execfile", A_DEFSYM, 0);
+
+    class_addmethod(c, (method)mpy_assign,    "assign",   A_GIMME, 0);
+    class_addmethod(c, (method)mpy_call,      "call",     A_GIMME, 0);
+
+    class_addmethod(c, (method)mpy_gc,        "gc",       A_GIMME, 0);
+
+    CLASS_ATTR_LABEL(c,     "heapsize", 0,  "initial heap size (KB)");
+    CLASS_ATTR_LONG(c,      "heapsize", 0,  t_mpy, c_heapsize);
+    CLASS_ATTR_FILTER_MIN(c, "heapsize", 4);
+    CLASS_ATTR_BASIC(c,     "heapsize", 0);
+    CLASS_ATTR_SAVE(c,      "heapsize", 0);
+    CLASS_ATTR_ACCESSORS(c, "heapsize", NULL, mpy_heapsize_set);
+
+    CLASS_ATTR_LABEL(c,     "heapmax", 0,  "maximum heap size (KB)");
+    CLASS_ATTR_LONG(c,      "heapmax", 0,  t_mpy, c_heapmax);
+    CLASS_ATTR_FILTER_MIN(c, "heapmax", 4);
+    CLASS_ATTR_BASIC(c,     "heapmax", 0);
+    CLASS_ATTR_SAVE(c,      "heapmax", 0);
+    CLASS_ATTR_ACCESSORS(c, "heapmax", NULL, mpy_heapmax_set);
+
+    CLASS_ATTR_LABEL(c,     "autocollect", 0,  "collect when the heap is full");
+    CLASS_ATTR_CHAR(c,      "autocollect", 0,  t_mpy, c_autocollect);
+    CLASS_ATTR_STYLE(c,     "autocollect", 0,  "onoff");
+    CLASS_ATTR_BASIC(c,     "autocollect", 0);
+    CLASS_ATTR_SAVE(c,      "autocollect", 0);
+    CLASS_ATTR_ACCESSORS(c, "autocollect", NULL, mpy_autocollect_set);
+
+    CLASS_ATTR_LABEL(c,     "emit", 0,  "code emitter");
+    CLASS_ATTR_SYM(c,       "emit", 0,  t_mpy, c_emit);
+    CLASS_ATTR_ENUM(c,      "emit", 0,  "bytecode native viper");
+    CLASS_ATTR_BASIC(c,     "emit", 0);
+    CLASS_ATTR_SAVE(c,      "emit", 0);
+    CLASS_ATTR_ACCESSORS(c, "emit", NULL, mpy_emit_set);
 
     class_register(CLASS_BOX, c);
 
     s_mpy_class = c;
 
+    systhread_mutex_new(&s_mpy_mutex, 0);
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Output */
+
+/**
+ * @brief Post the buffered print line to the Max console.
+ */
+static void mpy_flush(t_mpy* x, int is_error)
+{
+    if (x->c_line_len == 0) {
+        return;
+    }
+    x->c_line[x->c_line_len] = 0;
+    if (is_error) {
+        object_error((t_object*)x, "%s", x->c_line);
+    } else {
+        object_post((t_object*)x, "%s", x->c_line);
+    }
+    x->c_line_len = 0;
+}
+
+/**
+ * @brief Line-buffer micropython output into console posts.
+ */
+static void mpy_write(t_mpy* x, const char* str, size_t len, int is_error)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '\n') {
+            mpy_flush(x, is_error);
+        } else {
+            if (x->c_line_len == MPY_MAX_LINE - 1) {
+                mpy_flush(x, is_error);
+            }
+            x->c_line[x->c_line_len++] = str[i];
+        }
+    }
+}
+
+static void mpy_print_strn(void* data, const char* str, size_t len)
+{
+    mpy_write((t_mpy*)data, str, len, 0);
+}
+
+static void mpy_error_strn(void* data, const char* str, size_t len)
+{
+    mpy_write((t_mpy*)data, str, len, 1);
 }
 
+/**
+ * @brief Send the atoms collected by a call out of the left outlet.
+ */
+static void mpy_output(t_mpy* x, t_mpy_call* call)
+{
+    if (call->n_out == 0) {
+        return;
+    }
+
+    if (call->n_out == 1) {
+        switch (call->out[0].a_type) {
+        case A_LONG:
+            outlet_int(x->c_outlet, atom_getlong(call->out));
+            return;
+        case A_FLOAT:
+            outlet_float(x->c_outlet, atom_getfloat(call->out));
+            return;
+        default:
+            outlet_anything(x->c_outlet, atom_getsym(call->out), 0, NULL);
+            return;
+        }
+    }
+
+    if (call->out[0].a_type == A_SYM) {
+        outlet_anything(x->c_outlet, atom_getsym(call->out), call->n_out - 1,
+                        call->out + 1);
+    } else {
+        outlet_list(x->c_outlet, NULL, call->n_out, call->out);
+    }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Conversion (inside the vm) */
+
+/**
+ * @brief Convert a micropython scalar to an atom (repr for other types).
+ */
+static void mpy_obj_to_atom(mp_obj_t obj, t_atom* atom)
+{
+    if (mp_obj_is_bool(obj)) {
+        atom_setlong(atom, obj == mp_const_true);
+    } else if (mp_obj_is_int(obj)) {
+        atom_setlong(atom, mp_obj_get_int(obj));
+#if MICROPY_PY_BUILTINS_FLOAT
+    } else if (mp_obj_is_float(obj)) {
+        atom_setfloat(atom, mp_obj_get_float(obj));
+#endif
+    } else if (mp_obj_is_str(obj)) {
+        atom_setsym(atom, gensym(mp_obj_str_get_str(obj)));
+    } else {
+        vstr_t vstr;
+        mp_print_t print;
+        vstr_init_print(&vstr, 16, &print);
+        mp_obj_print_helper(&print, obj, PRINT_REPR);
+        atom_setsym(atom, gensym(vstr_null_terminated_str(&vstr)));
+        vstr_clear(&vstr);
+    }
+}
+
+/**
+ * @brief Convert a result into the output atoms of a call.
+ *
+ * None produces no output, lists and tuples are flattened one level.
+ */
+static void mpy_result_to_atoms(mp_obj_t obj, t_mpy_call* call)
+{
+    call->n_out = 0;
+
+    if (obj == mp_const_none) {
+        return;
+    }
+
+    if (mp_obj_is_type(obj, &mp_type_list) || mp_obj_is_type(obj, &mp_type_tuple)) {
+        size_t len = 0;
+        mp_obj_t* items = NULL;
+        mp_obj_get_array(obj, &len, &items);
+        if (len > MPY_MAX_ATOMS) {
+            len = MPY_MAX_ATOMS;
+        }
+        for (size_t i = 0; i < len; i++) {
+            mpy_obj_to_atom(items[i], call->out + i);
+        }
+        call->n_out = (long)len;
+        return;
+    }
+
+    mpy_obj_to_atom(obj, call->out);
+    call->n_out = 1;
+}
+
+/**
+ * @brief Convert an atom to a micropython object.
+ */
+static mp_obj_t mpy_atom_to_obj(t_atom* atom)
+{
+    switch (atom->a_type) {
+    case A_LONG:
+        return mp_obj_new_int((mp_int_t)atom_getlong(atom));
+    case A_FLOAT:
+#if MICROPY_PY_BUILTINS_FLOAT
+        return mp_obj_new_float(atom_getfloat(atom));
+#else
+        mp_raise_TypeError(MP_ERROR_TEXT("float atoms need a float-enabled micropython build"));
+#endif
+    case A_SYM: {
+        const char* s = atom_getsym(atom)->s_name;
+        return mp_obj_new_str(s, strlen(s));
+    }
+    default:
+        return mp_const_none;
+    }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* VM entry */
+
+/**
+ * @brief Run `fn` in the shared vm with print output posted for `x`.
+ *
+ * The vm lock is released before returning, so results must be sent out
+ * by the caller afterwards (downstream objects may call back into mpy).
+ */
+static t_max_err mpy_run(t_mpy* x, mpy_vm_fn fn, void* ctx)
+{
+    mp_print_t err_print = {x, mpy_error_strn};
+    int ret = 0;
+
+    systhread_mutex_lock(s_mpy_mutex);
+    mpy_vm_set_stdout(mpy_print_strn, x);
+    ret = mpy_vm_run(fn, ctx, &err_print);
+    mpy_flush(x, ret != 0);
+    mpy_vm_set_stdout(NULL, NULL);
+    systhread_mutex_unlock(s_mpy_mutex);
+
+    return ret == 0 ? MAX_ERR_NONE : MAX_ERR_GENERIC;
+}
+
+static void mpy_namespace_new_cb(void* ctx)
+{
+    t_mpy* x = (t_mpy*)ctx;
+    x->c_ns = mpy_vm_namespace_new(x->c_id, "__main__");
+}
+
+static void mpy_namespace_free_cb(void* ctx)
+{
+    t_mpy* x = (t_mpy*)ctx;
+    mpy_vm_namespace_free(x->c_id);
+    x->c_ns = NULL;
+}
+
+static void mpy_exec_cb(void* ctx)
+{
+    t_mpy_call* call = (t_mpy_call*)ctx;
+    mpy_vm_set_emit(call->x->c_emit_id);
+    mp_obj_t result = mpy_vm_exec(call->x->c_ns, call->text, call->text_len,
+                                  call->kind);
+    mpy_result_to_atoms(result, call);
+}
+
+static void mpy_call_cb(void* ctx)
+{
+    t_mpy_call* call = (t_mpy_call*)ctx;
+    mp_obj_t args[MPY_MAX_ATOMS];
+    size_t n_args = call->argc > MPY_MAX_ATOMS ? MPY_MAX_ATOMS : call->argc;
+
+    mp_obj_t func = mpy_vm_lookup(call->x->c_ns, call->name->s_name);
+    for (size_t i = 0; i < n_args; i++) {
+        args[i] = mpy_atom_to_obj(call->argv + i);
+    }
+    mpy_result_to_atoms(mp_call_function_n_kw(func, n_args, 0, args), call);
+}
+
+static void mpy_assign_cb(void* ctx)
+{
+    t_mpy_call* call = (t_mpy_call*)ctx;
+    mp_obj_t value = mp_const_none;
+    qstr name = qstr_from_str(call->name->s_name);
+
+    if (call->argc == 1) {
+        value = mpy_atom_to_obj(call->argv);
+    } else {
+        value = mp_obj_new_list(0, NULL);
+        for (long i = 0; i < call->argc; i++) {
+            mp_obj_list_append(value, mpy_atom_to_obj(call->argv + i));
+        }
+    }
+    mp_obj_dict_store(MP_OBJ_FROM_PTR(call->x->c_ns), MP_OBJ_NEW_QSTR(name), value);
+}
+
+static void mpy_import_cb(void* ctx)
+{
+    t_mpy_call* call = (t_mpy_call*)ctx;
+    qstr name = qstr_from_str(call->name->s_name);
+    mp_obj_t module = mp_import_name(name, mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+    mp_obj_dict_store(MP_OBJ_FROM_PTR(call->x->c_ns), MP_OBJ_NEW_QSTR(name), module);
+}
+
+static void mpy_collect_cb(void* ctx) { mpy_vm_collect(); }
+
+
+/*--------------------------------------------------------------------------*/
+/* Lifecycle */
 
 void* mpy_new(t_symbol* s, long argc, t_atom* argv)
 {
     t_mpy* x = (t_mpy*)object_alloc(s_mpy_class);
-    x->c_outlet = bangout(x);
+
+    if (x) {
+        x->c_heapsize = MPY_DEFAULT_HEAPSIZE;
+        x->c_heapmax = MPY_DEFAULT_HEAPMAX;
+        x->c_autocollect = 1;
+        x->c_emit = gensym("bytecode");
+        x->c_emit_id = MPY_EMIT_BYTECODE;
+        x->c_vm = 0;
+        x->c_ns = NULL;
+        x->c_line_len = 0;
+
+        x->c_outlet_right = outlet_new(x, NULL);
+        x->c_outlet = outlet_new(x, NULL);
+
+        attr_args_process(x, argc, argv);
+
+        systhread_mutex_lock(s_mpy_mutex);
+        int starting = !mpy_vm_is_running();
+        int err = mpy_vm_acquire((size_t)x->c_heapsize * 1024,
+                                 (size_t)x->c_heapmax * 1024);
+        if (err == 0) {
+            x->c_vm = 1;
+            if (starting) {
+                mpy_vm_set_autocollect(x->c_autocollect);
+            } else {
+                mpy_vm_grow((size_t)x->c_heapsize * 1024);
+            }
+        }
+        x->c_id = s_mpy_next_id++;
+        systhread_mutex_unlock(s_mpy_mutex);
+
+        if (err != 0) {
+            object_error((t_object*)x, "could not allocate %ld KB heap",
+                         (long)x->c_heapsize);
+            object_free(x);
+            return NULL;
+        }
+
+        if (mpy_run(x, mpy_namespace_new_cb, x) != MAX_ERR_NONE) {
+            object_free(x);
+            return NULL;
+        }
+    }
+
     return x;
 }
 
 
 void mpy_free(t_mpy* x)
 {
-    // Deinitialise MicroPython.
+    if (!x->c_vm) {
+        return;
+    }
+
+    if (x->c_ns) {
+        mpy_run(x, mpy_namespace_free_cb, x);
+    }
+
+    systhread_mutex_lock(s_mpy_mutex);
+    mpy_vm_release();
+    systhread_mutex_unlock(s_mpy_mutex);
 }
 
 
-void mpy_bang(t_mpy* x) {
-    // test embedded MicroPython
-    int stack_top;
-    mp_embed_init(&HEAP[0], sizeof(HEAP), &stack_top);
-    
-    // mp_embed_init(&HEAP[0], sizeof(HEAP));
-    mp_embed_exec_str(example_1);
-    mp_embed_exec_str(example_2);
-    mp_embed_deinit();
-    
-    outlet_bang(x->c_outlet); 
+/*--------------------------------------------------------------------------*/
+/* Attributes */
+
+/**
+ * @brief Select the emitter for code sent to this instance.
+ *
+ * `native` and `viper` compile every function to machine code; they are
+ * only available where micropython has an emitter (x86-64). Individual
+ * functions can also use the `@micropython.native` and `@micropython.viper`
+ * decorators with the default `bytecode` emitter.
+ */
+t_max_err mpy_emit_set(t_mpy* x, void* attr, long argc, t_atom* argv)
+{
+    static const char* names[] = { "bytecode", "native", "viper" };
+
+    if (argc && argv) {
+        t_symbol* emit = atom_getsym(argv);
+        for (int i = 0; i < 3; i++) {
+            if (emit == gensym(names[i])) {
+                if (i != MPY_EMIT_BYTECODE && !mpy_vm_has_native()) {
+                    object_error((t_object*)x,
+                                 "%s emitter not available on this platform",
+                                 emit->s_name);
+                    return MAX_ERR_GENERIC;
+                }
+                x->c_emit = emit;
+                x->c_emit_id = i;
+                return MAX_ERR_NONE;
+            }
+        }
+        object_error((t_object*)x, "emit expects bytecode, native or viper");
+        return MAX_ERR_GENERIC;
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Set the heap size, growing the running vm's arena if needed.
+ *
+ * The vm is shared: its arena is at least as large as the largest
+ * `heapsize` of any instance.
+ */
+t_max_err mpy_heapsize_set(t_mpy* x, void* attr, long argc, t_atom* argv)
+{
+    if (argc && argv) {
+        x->c_heapsize = atom_getlong(argv);
+        systhread_mutex_lock(s_mpy_mutex);
+        if (mpy_vm_grow((size_t)x->c_heapsize * 1024) != 0) {
+            object_error((t_object*)x, "could not grow heap to %ld KB",
+                         (long)x->c_heapsize);
+        }
+        systhread_mutex_unlock(s_mpy_mutex);
+    }
+    return MAX_ERR_NONE;
 }
 
+/**
+ * @brief Set the arena growth limit of the shared vm.
+ */
+t_max_err mpy_heapmax_set(t_mpy* x, void* attr, long argc, t_atom* argv)
+{
+    if (argc && argv) {
+        x->c_heapmax = atom_getlong(argv);
+        systhread_mutex_lock(s_mpy_mutex);
+        if (mpy_vm_is_running()) {
+            mpy_vm_set_limit((size_t)x->c_heapmax * 1024);
+        }
+        systhread_mutex_unlock(s_mpy_mutex);
+    }
+    return MAX_ERR_NONE;
+}
 
-// t_max_err mpy_import(t_mpy* x, t_symbol* s)
-// {
-//     return py_import(x->py, s); // returns t_max_err
-// }
+/**
+ * @brief Enable or disable collection on a full heap.
+ *
+ * With `autocollect 0` the arena grows instead (up to `heapmax`) so that
+ * no message pays for a collection; use the `gc` message at safe points.
+ */
+t_max_err mpy_autocollect_set(t_mpy* x, void* attr, long argc, t_atom* argv)
+{
+    if (argc && argv) {
+        x->c_autocollect = atom_getlong(argv) != 0;
+        systhread_mutex_lock(s_mpy_mutex);
+        mpy_vm_set_autocollect(x->c_autocollect);
+        systhread_mutex_unlock(s_mpy_mutex);
+    }
+    return MAX_ERR_NONE;
+}
 
 
-// t_max_err mpy_eval(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
-// {
-//     return py_eval(x->py, s, argc, argv, x->c_outlet);
-// }
+/*--------------------------------------------------------------------------*/
+/* Core Methods */
 
+/**
+ * @brief Evaluate or execute the code in the atoms of a message.
+ */
+static t_max_err mpy_run_text(t_mpy* x, long argc, t_atom* argv,
+                              mp_parse_input_kind_t kind)
+{
+    t_mpy_call call = {x};
+    long textsize = 0;
+    char* text = NULL;
+    t_max_err err = MAX_ERR_GENERIC;
+
+    if (argc == 1 && atom_gettype(argv) == A_SYM) {
+        call.text = atom_getsym(argv)->s_name;
+    } else {
+        err = atom_gettext(argc, argv, &textsize, &text,
+                           OBEX_UTIL_ATOM_GETTEXT_SYM_NO_QUOTE);
+        if (err != MAX_ERR_NONE || text == NULL) {
+            object_error((t_object*)x, "could not convert message to text");
+            return MAX_ERR_GENERIC;
+        }
+        call.text = text;
+    }
+
+    call.text_len = strlen(call.text);
+    call.kind = kind;
+    err = mpy_run(x, mpy_exec_cb, &call);
+
+    if (text) {
+        sysmem_freeptr(text);
+    }
+
+    if (err == MAX_ERR_NONE) {
+        mpy_output(x, &call);
+    }
+    return err;
+}
 
-// t_max_err mpy_exec(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
-// {
-//     return py_exec(x->py, s, argc, argv);
-// }
+t_max_err mpy_eval(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return mpy_run_text(x, argc, argv, MP_PARSE_EVAL_INPUT);
+}
 
+t_max_err mpy_exec(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return mpy_run_text(x, argc, argv, MP_PARSE_FILE_INPUT);
+}
 
-// t_max_err mpy_execfile(t_mpy* x, t_symbol* s)
-// {
-//     return py_execfile(x->py, s);
-// }
+t_max_err mpy_import(t_mpy* x, t_symbol* s)
+{
+    t_mpy_call call = {x};
+    call.name = s;
+    return mpy_run(x, mpy_import_cb, &call);
+}
 
+/**
+ * @brief Execute a python file in the instance namespace.
+ */
+t_max_err mpy_execfile(t_mpy* x, t_symbol* s)
+{
+    t_mpy_call call = {x};
+    char filename[MAX_PATH_CHARS];
+    short path = 0;
+    t_fourcc outtype = 0;
+    t_filehandle fh = NULL;
+    t_ptr_size size = 0;
+    char* text = NULL;
+    t_max_err err = MAX_ERR_GENERIC;
+
+    if (s == gensym("")) {
+        object_error((t_object*)x, "execfile needs a file name");
+        goto error;
+    }
+
+    strncpy_zero(filename, s->s_name, MAX_PATH_CHARS);
+    if (locatefile_extended(filename, &path, &outtype, NULL, 0)) {
+        object_error((t_object*)x, "can't find file %s", s->s_name);
+        goto error;
+    }
+
+    if (path_opensysfile(filename, path, &fh, READ_PERM)) {
+        object_error((t_object*)x, "can't open file %s", s->s_name);
+        goto error;
+    }
+
+    sysfile_geteof(fh, &size);
+    text = sysmem_newptr((long)size + 1);
+    if (text == NULL || sysfile_read(fh, &size, text) != MAX_ERR_NONE) {
+        object_error((t_object*)x, "can't read file %s", s->s_name);
+        goto error;
+    }
+    text[size] = 0;
+
+    call.text = text;
+    call.text_len = size;
+    call.kind = MP_PARSE_FILE_INPUT;
+    err = mpy_run(x, mpy_exec_cb, &call);
+
+error:
+    if (fh) {
+        sysfile_close(fh);
+    }
+    if (text) {
+        sysmem_freeptr(text);
+    }
+    return err;
+}
 
-// t_max_err mpy_call(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
-// {
-//     return py_call(x->py, s, argc, argv, x->c_outlet);
-// }
 
+/*--------------------------------------------------------------------------*/
+/* Extra Methods */
 
-// t_max_err mpy_assign(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
-// {
-//     return py_assign(x->py, s, argc, argv);
-// }
+/**
+ * @brief Call a function in the namespace: `call <func> [args...]`
+ */
+t_max_err mpy_call(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_mpy_call call = {x};
+    t_max_err err = MAX_ERR_GENERIC;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        object_error((t_object*)x, "call needs a function name");
+        return MAX_ERR_GENERIC;
+    }
+
+    call.name = atom_getsym(argv);
+    call.argc = argc - 1;
+    call.argv = argv + 1;
+
+    err = mpy_run(x, mpy_call_cb, &call);
+    if (err == MAX_ERR_NONE) {
+        mpy_output(x, &call);
+    }
+    return err;
+}
 
+/**
+ * @brief Assign atoms to a name: `assign <name> <value|values...>`
+ *
+ * A single atom is assigned as a scalar, several as a list.
+ */
+t_max_err mpy_assign(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_mpy_call call = {x};
 
-// t_max_err mpy_code(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
-// {
-//     return py_code(x->py, s, argc, argv, x->c_outlet);
-// }
+    if (argc < 2 || atom_gettype(argv) != A_SYM) {
+        object_error((t_object*)x, "assign needs a name and a value");
+        return MAX_ERR_GENERIC;
+    }
 
+    call.name = atom_getsym(argv);
+    call.argc = argc - 1;
+    call.argv = argv + 1;
+    return mpy_run(x, mpy_assign_cb, &call);
+}
 
-// t_max_err mpy_anything(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
-// {
-//     return py_anything(x->py, s, argc, argv, x->c_outlet);
-// }
 
+/*--------------------------------------------------------------------------*/
+/* Memory */
 
-// t_max_err mpy_pipe(t_mpy* x, t_symbol* s, long argc, t_atom* argv, void* outlet)
-// {
-//     return py_pipe(x->py, s, argc, argv, x->c_outlet);
-// }
+/**
+ * @brief Collect garbage and/or report gc statistics: `gc [collect|info]`
+ *
+ * Statistics go out of the right outlet:
+ *
+ *  collections <n>
+ *  pause <last ms> <max ms> <total ms>
+ *  heap <total> <used> <free> <largest free block>   (bytes)
+ *  fragmentation <0..1>
+ *  arena <chunks> <bytes> <limit>
+ *  native <bytes>                                     (mapped for native code)
+ */
+t_max_err mpy_gc(t_mpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    mpy_gc_stats_t stats;
+    t_atom atoms[4];
+    t_max_err err = MAX_ERR_NONE;
+
+    if (argc == 0 || atom_getsym(argv) == gensym("collect")) {
+        err = mpy_run(x, mpy_collect_cb, NULL);
+    } else if (atom_getsym(argv) != gensym("info")) {
+        object_error((t_object*)x, "gc expects 'collect' or 'info'");
+        return MAX_ERR_GENERIC;
+    }
+
+    systhread_mutex_lock(s_mpy_mutex);
+    mpy_vm_gc_stats(&stats);
+    systhread_mutex_unlock(s_mpy_mutex);
+
+    atom_setlong(atoms, stats.collections);
+    outlet_anything(x->c_outlet_right, gensym("collections"), 1, atoms);
+
+    atom_setfloat(atoms + 0, stats.pause_last_us / 1000.0);
+    atom_setfloat(atoms + 1, stats.pause_max_us / 1000.0);
+    atom_setfloat(atoms + 2, stats.pause_total_us / 1000.0);
+    outlet_anything(x->c_outlet_right, gensym("pause"), 3, atoms);
+
+    atom_setlong(atoms + 0, stats.heap_total);
+    atom_setlong(atoms + 1, stats.heap_used);
+    atom_setlong(atoms + 2, stats.heap_free);
+    atom_setlong(atoms + 3, stats.heap_max_free);
+    outlet_anything(x->c_outlet_right, gensym("heap"), 4, atoms);
+
+    atom_setfloat(atoms, stats.fragmentation);
+    outlet_anything(x->c_outlet_right, gensym("fragmentation"), 1, atoms);
+
+    atom_setlong(atoms + 0, stats.arena_chunks);
+    atom_setlong(atoms + 1, stats.arena_bytes);
+    atom_setlong(atoms + 2, stats.arena_limit);
+    outlet_anything(x->c_outlet_right, gensym("arena"), 3, atoms);
+
+    atom_setlong(atoms, stats.native_bytes);
+    outlet_anything(x->c_outlet_right, gensym("native"), 1, atoms);
+
+    return err;
+}
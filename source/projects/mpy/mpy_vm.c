@@ -0,0 +1,770 @@
+/**
+    @file mpy_vm.c - shared micropython vm, gc arena and statistics
+
+    Replaces the `embed_util.c` and `mphalport.c` of the generated
+    `micropython_embed` port: the vm is initialised once and kept alive,
+    the gc heap lives in a growable arena, collections are timed and stdout
+    is routed to a callback instead of `printf`.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "py/compile.h"
+#include "py/emitglue.h"
+#include "py/gc.h"
+#include "py/lexer.h"
+#include "py/mphal.h"
+#include "py/nlr.h"
+#include "py/runtime.h"
+#include "py/stackctrl.h"
+#include "shared/runtime/gchelper.h"
+
+#include "mpy_vm.h"
+
+
+/* a mapping from which native code regions are carved */
+typedef struct mpy_exec_pool {
+    char* base;
+    size_t size;
+    size_t used;
+    struct mpy_exec_pool* next;
+} t_mpy_exec_pool;
+
+/* whole pages of a pool holding the code of one native function */
+typedef struct mpy_exec_region {
+    void* ptr;
+    size_t size;
+    int in_use;
+    struct mpy_exec_region* next;
+} t_mpy_exec_region;
+
+typedef struct mpy_vm {
+    long refcount;
+    int running;
+
+    // arena: chunks[0] is the initial heap passed to gc_init
+    void* chunks[MPY_VM_MAX_CHUNKS];
+    size_t sizes[MPY_VM_MAX_CHUNKS];
+    size_t n_chunks;
+    size_t arena_bytes;
+    size_t arena_limit;
+
+    // gc statistics
+    size_t collections;
+    double pause_last_us;
+    double pause_max_us;
+    double pause_total_us;
+
+    // native code
+    t_mpy_exec_pool* exec_pools;
+    t_mpy_exec_region* exec_regions;
+    size_t exec_bytes;
+
+    // stdout
+    mpy_vm_print_fn print_fn;
+    void* print_data;
+} t_mpy_vm;
+
+static t_mpy_vm mpy_vm = {0};
+
+
+/*--------------------------------------------------------------------------*/
+/* Helpers */
+
+/**
+ * @brief Monotonic clock in microseconds.
+ */
+static double mpy_vm_now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+/**
+ * @brief Allocate and record an arena chunk.
+ *
+ * @param size chunk size in bytes
+ * @return void* chunk or NULL if the chunk table is full or malloc failed
+ */
+static void* mpy_vm_chunk_new(size_t size)
+{
+    void* chunk = NULL;
+
+    if (mpy_vm.n_chunks == MPY_VM_MAX_CHUNKS) {
+        return NULL;
+    }
+
+    chunk = malloc(size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    mpy_vm.chunks[mpy_vm.n_chunks] = chunk;
+    mpy_vm.sizes[mpy_vm.n_chunks] = size;
+    mpy_vm.n_chunks++;
+    mpy_vm.arena_bytes += size;
+    return chunk;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Port hooks (see mpconfigport.h) */
+
+/**
+ * @brief Bytes available to a new heap chunk (MICROPY_GC_SPLIT_HEAP_AUTO).
+ */
+size_t gc_get_max_new_split(void)
+{
+    if (mpy_vm.n_chunks == MPY_VM_MAX_CHUNKS
+        || mpy_vm.arena_bytes >= mpy_vm.arena_limit) {
+        return 0;
+    }
+    return mpy_vm.arena_limit - mpy_vm.arena_bytes;
+}
+
+/**
+ * @brief Allocate a heap chunk for the gc (MP_PLAT_ALLOC_HEAP).
+ */
+void* mpy_vm_arena_alloc(size_t size)
+{
+    if (size > gc_get_max_new_split()) {
+        return NULL;
+    }
+    return mpy_vm_chunk_new(size);
+}
+
+/**
+ * @brief Release a heap chunk the gc found empty (MP_PLAT_FREE_HEAP).
+ */
+void mpy_vm_arena_free(void* ptr)
+{
+    for (size_t i = 1; i < mpy_vm.n_chunks; i++) {
+        if (mpy_vm.chunks[i] == ptr) {
+            mpy_vm.arena_bytes -= mpy_vm.sizes[i];
+            free(ptr);
+            memmove(&mpy_vm.chunks[i], &mpy_vm.chunks[i + 1],
+                    (mpy_vm.n_chunks - i - 1) * sizeof(void*));
+            memmove(&mpy_vm.sizes[i], &mpy_vm.sizes[i + 1],
+                    (mpy_vm.n_chunks - i - 1) * sizeof(size_t));
+            mpy_vm.n_chunks--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Size of a memory page (the unit of code protection).
+ */
+static size_t mpy_vm_page_size(void)
+{
+    static size_t page = 0;
+
+    if (page == 0) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page = info.dwPageSize;
+#else
+        page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+    return page;
+}
+
+/**
+ * @brief Map a new pool of writable memory for native code.
+ *
+ * @param min_size bytes the pool must hold at least
+ * @return t_mpy_exec_pool* pool or NULL if the mapping failed
+ */
+static t_mpy_exec_pool* mpy_vm_exec_pool_new(size_t min_size)
+{
+    t_mpy_exec_pool* pool = NULL;
+    size_t size = min_size > MPY_VM_EXEC_POOL ? min_size : MPY_VM_EXEC_POOL;
+    void* mem = NULL;
+
+#ifdef _WIN32
+    mem = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    int flags = MAP_PRIVATE | MAP_ANON;
+#if defined(__APPLE__) && defined(MAP_JIT)
+    flags |= MAP_JIT;
+#endif
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mem == MAP_FAILED) {
+        mem = NULL;
+    }
+#endif
+
+    pool = mem ? malloc(sizeof(t_mpy_exec_pool)) : NULL;
+    if (pool == NULL) {
+        if (mem) {
+#ifdef _WIN32
+            VirtualFree(mem, 0, MEM_RELEASE);
+#else
+            munmap(mem, size);
+#endif
+        }
+        return NULL;
+    }
+
+    pool->base = mem;
+    pool->size = size;
+    pool->used = 0;
+    pool->next = mpy_vm.exec_pools;
+    mpy_vm.exec_pools = pool;
+    return pool;
+}
+
+/**
+ * @brief Allocate writable memory for native code (MP_PLAT_ALLOC_EXEC).
+ *
+ * Regions are whole pages, so each can be switched to read/execute on its
+ * own, carved from pools of MPY_VM_EXEC_POOL bytes instead of one mapping
+ * per function. Regions released by the emitter are reused. Code is kept
+ * until the vm is released, since native functions hold raw pointers into
+ * it and the gc does not trace them. Raises MemoryError on failure.
+ */
+void mpy_vm_alloc_exec(size_t min_size, void** ptr, size_t* size)
+{
+    size_t page = mpy_vm_page_size();
+    size_t need = (min_size + page - 1) / page * page;
+    t_mpy_exec_region* region = NULL;
+    t_mpy_exec_pool* pool = NULL;
+
+    if (need == 0) {
+        need = page;
+    }
+
+    // 1. reuse the smallest released region which fits
+    for (t_mpy_exec_region* r = mpy_vm.exec_regions; r; r = r->next) {
+        if (!r->in_use && r->size >= need && (region == NULL || r->size < region->size)) {
+            region = r;
+        }
+    }
+
+    // 2. carve a new region from a pool with room left
+    if (region == NULL) {
+        for (pool = mpy_vm.exec_pools; pool; pool = pool->next) {
+            if (pool->size - pool->used >= need) {
+                break;
+            }
+        }
+        if (pool == NULL) {
+            pool = mpy_vm_exec_pool_new(need);
+        }
+        region = pool ? malloc(sizeof(t_mpy_exec_region)) : NULL;
+        if (region == NULL) {
+            m_malloc_fail(min_size);
+        }
+        region->ptr = pool->base + pool->used;
+        region->size = need;
+        region->next = mpy_vm.exec_regions;
+        mpy_vm.exec_regions = region;
+        pool->used += need;
+    }
+
+    region->in_use = 1;
+    mpy_vm.exec_bytes += region->size;
+
+    *ptr = region->ptr;
+    *size = region->size;
+}
+
+/**
+ * @brief Release native code memory for reuse (MP_PLAT_FREE_EXEC).
+ *
+ * Called by the emitter when a function fails to compile. The pages are
+ * made writable again and kept in their pool.
+ */
+void mpy_vm_free_exec(void* ptr, size_t size)
+{
+    for (t_mpy_exec_region* r = mpy_vm.exec_regions; r; r = r->next) {
+        if (r->ptr == ptr && r->in_use) {
+#ifdef _WIN32
+            DWORD old = 0;
+            VirtualProtect(r->ptr, r->size, PAGE_READWRITE, &old);
+#else
+            mprotect(r->ptr, r->size, PROT_READ | PROT_WRITE);
+#endif
+            r->in_use = 0;
+            mpy_vm.exec_bytes -= r->size;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Unmap all native code memory (when the vm is released).
+ */
+static void mpy_vm_exec_clear(void)
+{
+    while (mpy_vm.exec_regions) {
+        t_mpy_exec_region* region = mpy_vm.exec_regions;
+        mpy_vm.exec_regions = region->next;
+        free(region);
+    }
+
+    while (mpy_vm.exec_pools) {
+        t_mpy_exec_pool* pool = mpy_vm.exec_pools;
+        mpy_vm.exec_pools = pool->next;
+#ifdef _WIN32
+        VirtualFree(pool->base, 0, MEM_RELEASE);
+#else
+        munmap(pool->base, pool->size);
+#endif
+        free(pool);
+    }
+    mpy_vm.exec_bytes = 0;
+}
+
+/**
+ * @brief Make emitted native code executable (MP_PLAT_COMMIT_EXEC).
+ *
+ * Switches the mapping from read/write to read/execute, so code is never
+ * writable and executable at the same time.
+ */
+void* mpy_vm_commit_exec(void* buf, size_t len, void* reloc)
+{
+#ifdef _WIN32
+    DWORD old = 0;
+    VirtualProtect(buf, len, PAGE_EXECUTE_READ, &old);
+    FlushInstructionCache(GetCurrentProcess(), buf, len);
+#else
+    if (mprotect(buf, len, PROT_READ | PROT_EXEC) != 0) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("can't make native code executable"));
+    }
+    __builtin___clear_cache((char*)buf, (char*)buf + len);
+#endif
+    return buf;
+}
+
+/**
+ * @brief Run a timed garbage collection cycle.
+ *
+ * Called for explicit collections and by `gc_alloc` when the heap is full.
+ */
+void gc_collect(void)
+{
+    double start = mpy_vm_now_us();
+
+    gc_collect_start();
+    gc_helper_collect_regs_and_stack();
+    gc_collect_end();
+
+    double pause = mpy_vm_now_us() - start;
+    mpy_vm.collections++;
+    mpy_vm.pause_last_us = pause;
+    mpy_vm.pause_total_us += pause;
+    if (pause > mpy_vm.pause_max_us) {
+        mpy_vm.pause_max_us = pause;
+    }
+}
+
+/**
+ * @brief Send stdout to the registered print callback.
+ */
+void mp_hal_stdout_tx_strn_cooked(const char* str, size_t len)
+{
+    if (mpy_vm.print_fn) {
+        mpy_vm.print_fn(mpy_vm.print_data, str, len);
+    } else {
+        fwrite(str, 1, len, stdout);
+    }
+}
+
+/**
+ * @brief Called if an exception escapes all nlr handlers.
+ *
+ * All vm entry goes through `mpy_vm_run`, so this is a bug.
+ */
+void nlr_jump_fail(void* val)
+{
+    fprintf(stderr, "mpy: uncaught micropython exception %p\n", val);
+    abort();
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Lifecycle */
+
+/**
+ * @brief Start the shared vm or add a reference to it.
+ *
+ * @param heap_size initial heap chunk in bytes (ignored if already running)
+ * @param heap_limit maximum arena size in bytes
+ * @return int 0 on success
+ */
+int mpy_vm_acquire(size_t heap_size, size_t heap_limit)
+{
+    volatile int stack_top = 0;
+    void* heap = NULL;
+
+    if (mpy_vm.running) {
+        mpy_vm.refcount++;
+        return 0;
+    }
+
+    if (heap_size < MPY_VM_MIN_CHUNK) {
+        heap_size = MPY_VM_MIN_CHUNK;
+    }
+
+    mpy_vm.arena_limit = heap_limit > heap_size ? heap_limit : heap_size;
+
+    heap = mpy_vm_chunk_new(heap_size);
+    if (heap == NULL) {
+        return -1;
+    }
+
+    mp_stack_set_top((void*)&stack_top);
+    gc_init(heap, (char*)heap + heap_size);
+    mp_init();
+
+    mpy_vm.running = 1;
+    mpy_vm.refcount = 1;
+    return 0;
+}
+
+/**
+ * @brief Drop a reference to the shared vm, deinitializing it with the last.
+ */
+void mpy_vm_release(void)
+{
+    if (!mpy_vm.running || --mpy_vm.refcount > 0) {
+        return;
+    }
+
+    mp_deinit();
+
+    for (size_t i = 0; i < mpy_vm.n_chunks; i++) {
+        free(mpy_vm.chunks[i]);
+    }
+
+    mpy_vm_exec_clear();
+
+    mpy_vm_print_fn print_fn = mpy_vm.print_fn;
+    void* print_data = mpy_vm.print_data;
+    memset(&mpy_vm, 0, sizeof(mpy_vm));
+    mpy_vm.print_fn = print_fn;
+    mpy_vm.print_data = print_data;
+}
+
+/**
+ * @brief Check if the shared vm is initialized.
+ */
+int mpy_vm_is_running(void) { return mpy_vm.running; }
+
+
+/*--------------------------------------------------------------------------*/
+/* Arena and GC */
+
+/**
+ * @brief Grow the arena so that it holds at least `heap_size` bytes.
+ *
+ * Adds a single chunk for the difference. The arena never shrinks
+ * explicitly: the gc returns grown chunks once they are empty.
+ *
+ * @param heap_size requested arena size in bytes
+ * @return int 0 on success (or nothing to do)
+ */
+int mpy_vm_grow(size_t heap_size)
+{
+    void* chunk = NULL;
+    size_t size = 0;
+
+    if (!mpy_vm.running || heap_size <= mpy_vm.arena_bytes) {
+        return 0;
+    }
+
+    size = heap_size - mpy_vm.arena_bytes;
+    if (size < MPY_VM_MIN_CHUNK) {
+        size = MPY_VM_MIN_CHUNK;
+    }
+
+    if (mpy_vm.arena_limit < mpy_vm.arena_bytes + size) {
+        mpy_vm.arena_limit = mpy_vm.arena_bytes + size;
+    }
+
+    chunk = mpy_vm_chunk_new(size);
+    if (chunk == NULL) {
+        return -1;
+    }
+
+    gc_add(chunk, (char*)chunk + size);
+    return 0;
+}
+
+/**
+ * @brief Set the maximum arena size used by automatic growth.
+ */
+void mpy_vm_set_limit(size_t heap_limit) { mpy_vm.arena_limit = heap_limit; }
+
+/**
+ * @brief Enable or disable collection on allocation failure.
+ *
+ * When disabled, a full heap grows the arena instead of collecting, so
+ * collections only happen on an explicit `mpy_vm_collect`.
+ */
+void mpy_vm_set_autocollect(int enabled)
+{
+    if (mpy_vm.running) {
+        MP_STATE_MEM(gc_auto_collect_enabled) = enabled ? 1 : 0;
+    }
+}
+
+/**
+ * @brief Run an explicit garbage collection.
+ *
+ * Must be called from inside `mpy_vm_run` so that the stack scan is bounded.
+ */
+void mpy_vm_collect(void) { gc_collect(); }
+
+/**
+ * @brief Fill `stats` with the gc counters and the current heap layout.
+ */
+void mpy_vm_gc_stats(mpy_gc_stats_t* stats)
+{
+    gc_info_t info;
+
+    memset(stats, 0, sizeof(mpy_gc_stats_t));
+    stats->collections = mpy_vm.collections;
+    stats->pause_last_us = mpy_vm.pause_last_us;
+    stats->pause_max_us = mpy_vm.pause_max_us;
+    stats->pause_total_us = mpy_vm.pause_total_us;
+    stats->arena_chunks = mpy_vm.n_chunks;
+    stats->arena_bytes = mpy_vm.arena_bytes;
+    stats->arena_limit = mpy_vm.arena_limit;
+    stats->native_bytes = mpy_vm.exec_bytes;
+
+    if (!mpy_vm.running) {
+        return;
+    }
+
+    gc_info(&info);
+    stats->heap_total = info.total;
+    stats->heap_used = info.used;
+    stats->heap_free = info.free;
+    stats->heap_max_free = info.max_free * MICROPY_BYTES_PER_GC_BLOCK;
+    if (info.free > 0) {
+        stats->fragmentation = 1.0 - (double)stats->heap_max_free / (double)info.free;
+    }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Native code */
+
+/**
+ * @brief Check if the native and viper emitters are compiled in.
+ */
+int mpy_vm_has_native(void) { return MICROPY_EMIT_NATIVE; }
+
+/**
+ * @brief Select the emitter for code compiled by `mpy_vm_exec`.
+ *
+ * Applies until the current `mpy_vm_run` returns, which restores the
+ * previous emitter, so the choice of one instance never leaks into code
+ * compiled for another. Functions can still override it with
+ * `@micropython.bytecode`, `@micropython.native` or `@micropython.viper`.
+ *
+ * @param emit MPY_EMIT_BYTECODE, MPY_EMIT_NATIVE or MPY_EMIT_VIPER
+ * @return int 0 on success, -1 if native code is not available
+ */
+int mpy_vm_set_emit(int emit)
+{
+#if MICROPY_EMIT_NATIVE
+    static const uint8_t opts[] = {
+        MP_EMIT_OPT_BYTECODE, MP_EMIT_OPT_NATIVE_PYTHON, MP_EMIT_OPT_VIPER
+    };
+    if (!mpy_vm.running || emit < 0 || emit > MPY_EMIT_VIPER) {
+        return -1;
+    }
+    MP_STATE_VM(default_emit_opt) = opts[emit];
+    return 0;
+#else
+    return emit == MPY_EMIT_BYTECODE ? 0 : -1;
+#endif
+}
+
+/*--------------------------------------------------------------------------*/
+/* Output */
+
+/**
+ * @brief Route `print` output to `fn(data, str, len)` (NULL: stdout).
+ */
+void mpy_vm_set_stdout(mpy_vm_print_fn fn, void* data)
+{
+    mpy_vm.print_fn = fn;
+    mpy_vm.print_data = data;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Execution */
+
+/**
+ * @brief Call `fn` under an nlr handler, restoring the vm on exceptions.
+ *
+ * Kept out of line so its frame (and the frames of `fn`) lie below the
+ * stack top set by `mpy_vm_run`, which bounds the conservative stack scan.
+ */
+static MP_NOINLINE int mpy_vm_run_protected(mpy_vm_fn fn, void* ctx,
+                                            const mp_print_t* err_print)
+{
+    nlr_buf_t nlr;
+    mp_obj_dict_t* globals = mp_globals_get();
+    mp_obj_dict_t* locals = mp_locals_get();
+#if MICROPY_EMIT_NATIVE
+    uint8_t emit_opt = MP_STATE_VM(default_emit_opt);
+#endif
+
+    if (nlr_push(&nlr) == 0) {
+        fn(ctx);
+        nlr_pop();
+#if MICROPY_EMIT_NATIVE
+        MP_STATE_VM(default_emit_opt) = emit_opt;
+#endif
+        return 0;
+    }
+
+    mp_globals_set(globals);
+    mp_locals_set(locals);
+#if MICROPY_EMIT_NATIVE
+    MP_STATE_VM(default_emit_opt) = emit_opt;
+#endif
+    mp_obj_print_exception(err_print, MP_OBJ_FROM_PTR(nlr.ret_val));
+    return -1;
+}
+
+/**
+ * @brief Enter the vm and call `fn(ctx)`.
+ *
+ * Every call into micropython goes through here. Max may call from
+ * different threads and stacks, so the gc stack top is reset on each entry.
+ * Micropython objects must not outlive `fn` in `ctx`: only the stack below
+ * this frame is scanned by the gc.
+ *
+ * @param fn callback doing the micropython work
+ * @param ctx callback argument
+ * @param err_print printer for uncaught exceptions
+ * @return int 0 on success, -1 if an exception was raised
+ */
+int mpy_vm_run(mpy_vm_fn fn, void* ctx, const mp_print_t* err_print)
+{
+    volatile int stack_top = 0;
+
+    if (!mpy_vm.running) {
+        return -1;
+    }
+
+    mp_stack_set_top((void*)&stack_top);
+    return mpy_vm_run_protected(fn, ctx, err_print);
+}
+
+/**
+ * @brief Get the registry dict of instance namespaces.
+ *
+ * Stored in `__main__` so that the namespaces are gc roots.
+ */
+static mp_obj_t mpy_vm_registry(void)
+{
+    mp_obj_t key = MP_OBJ_NEW_QSTR(qstr_from_str("__mpy_namespaces__"));
+    mp_map_t* main = &MP_STATE_VM(dict_main).map;
+    mp_map_elem_t* elem = mp_map_lookup(main, key, MP_MAP_LOOKUP);
+
+    if (elem != NULL) {
+        return elem->value;
+    }
+
+    mp_obj_t registry = mp_obj_new_dict(0);
+    mp_map_lookup(main, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = registry;
+    return registry;
+}
+
+/**
+ * @brief Create the namespace of an instance (call inside `mpy_vm_run`).
+ *
+ * @param id unique instance id
+ * @param name value of `__name__` in the namespace
+ * @return mp_obj_dict_t* new namespace
+ */
+mp_obj_dict_t* mpy_vm_namespace_new(mp_int_t id, const char* name)
+{
+    mp_obj_t ns = mp_obj_new_dict(0);
+    mp_obj_dict_store(ns, MP_OBJ_NEW_QSTR(MP_QSTR___name__),
+                      MP_OBJ_NEW_QSTR(qstr_from_str(name)));
+    mp_obj_dict_store(mpy_vm_registry(), mp_obj_new_int(id), ns);
+    return MP_OBJ_TO_PTR(ns);
+}
+
+/**
+ * @brief Drop the namespace of an instance (call inside `mpy_vm_run`).
+ */
+void mpy_vm_namespace_free(mp_int_t id)
+{
+    mp_obj_t registry = mpy_vm_registry();
+    mp_map_lookup(mp_obj_dict_get_map(registry), mp_obj_new_int(id),
+                  MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+}
+
+/**
+ * @brief Compile and run source text in a namespace.
+ *
+ * @param ns globals and locals of the code
+ * @param src source text
+ * @param len length of `src`
+ * @param kind MP_PARSE_EVAL_INPUT (returns the value) or MP_PARSE_FILE_INPUT
+ * @return mp_obj_t result of the evaluation (None for file input)
+ */
+mp_obj_t mpy_vm_exec(mp_obj_dict_t* ns, const char* src, size_t len,
+                     mp_parse_input_kind_t kind)
+{
+    mp_obj_dict_t* globals = mp_globals_get();
+    mp_obj_dict_t* locals = mp_locals_get();
+
+    mp_globals_set(ns);
+    mp_locals_set(ns);
+
+    mp_lexer_t* lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, src, len, 0);
+    qstr source_name = lex->source_name;
+    mp_parse_tree_t parse_tree = mp_parse(lex, kind);
+    mp_obj_t module_fun = mp_compile(&parse_tree, source_name, false);
+    mp_obj_t result = mp_call_function_0(module_fun);
+
+    mp_globals_set(globals);
+    mp_locals_set(locals);
+    return result;
+}
+
+/**
+ * @brief Resolve a name in a namespace, falling back to builtins.
+ *
+ * Raises NameError if not found.
+ */
+mp_obj_t mpy_vm_lookup(mp_obj_dict_t* ns, const char* name)
+{
+    mp_obj_dict_t* globals = mp_globals_get();
+
+    mp_globals_set(ns);
+    mp_obj_t obj = mp_load_global(qstr_from_str(name));
+    mp_globals_set(globals);
+    return obj;
+}
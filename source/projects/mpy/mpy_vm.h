@@ -0,0 +1,83 @@
+/**
+    @file mpy_vm.h - shared micropython vm, gc arena and statistics
+
+    MicroPython keeps its interpreter state in a single process-wide
+    `mp_state_ctx`, so every `mpy` instance shares one vm. The vm is
+    reference counted: it is created by the first instance and torn down
+    with the last. Each instance runs its code in its own namespace dict.
+
+    The gc heap is an arena of chunks: the first chunk is sized by the
+    `heapsize` of the instance which starts the vm, further chunks are added
+    on demand (up to `heapmax`) when an allocation fails after a collection.
+
+    On x86-64 the native and viper emitters are available; their code is
+    mapped outside the gc heap and released with the vm.
+
+    This file has no Max dependencies.
+*/
+
+#ifndef MPY_VM_H
+#define MPY_VM_H
+
+#include <stddef.h>
+
+#include "py/obj.h"
+#include "py/parse.h"
+
+#define MPY_VM_MAX_CHUNKS 64
+#define MPY_VM_MIN_CHUNK (4 * 1024)
+#define MPY_VM_EXEC_POOL (256 * 1024) // mapping size for native code regions
+
+typedef struct mpy_gc_stats {
+    size_t collections;    // explicit and automatic collections
+    double pause_last_us;  // duration of the last collection
+    double pause_max_us;   // longest collection
+    double pause_total_us; // sum of all collections
+    size_t heap_total;     // gc pool bytes (all chunks)
+    size_t heap_used;      // bytes in live blocks
+    size_t heap_free;      // bytes in free blocks
+    size_t heap_max_free;  // largest contiguous free run in bytes
+    double fragmentation;  // 1 - max_free / free (0: free space contiguous)
+    size_t arena_chunks;   // number of heap chunks
+    size_t arena_bytes;    // bytes allocated for all chunks
+    size_t arena_limit;    // growth limit in bytes
+    size_t native_bytes;   // executable memory mapped for native code
+} mpy_gc_stats_t;
+
+enum {
+    MPY_EMIT_BYTECODE,
+    MPY_EMIT_NATIVE,
+    MPY_EMIT_VIPER,
+};
+
+typedef void (*mpy_vm_print_fn)(void* data, const char* str, size_t len);
+typedef void (*mpy_vm_fn)(void* ctx);
+
+// lifecycle
+int mpy_vm_acquire(size_t heap_size, size_t heap_limit);
+void mpy_vm_release(void);
+int mpy_vm_is_running(void);
+
+// arena and gc
+int mpy_vm_grow(size_t heap_size);
+void mpy_vm_set_limit(size_t heap_limit);
+void mpy_vm_set_autocollect(int enabled);
+void mpy_vm_collect(void);
+void mpy_vm_gc_stats(mpy_gc_stats_t* stats);
+
+// native code
+int mpy_vm_has_native(void);
+int mpy_vm_set_emit(int emit);
+
+// output
+void mpy_vm_set_stdout(mpy_vm_print_fn fn, void* data);
+
+// execution
+int mpy_vm_run(mpy_vm_fn fn, void* ctx, const mp_print_t* err_print);
+mp_obj_dict_t* mpy_vm_namespace_new(mp_int_t id, const char* name);
+void mpy_vm_namespace_free(mp_int_t id);
+mp_obj_t mpy_vm_exec(mp_obj_dict_t* ns, const char* src, size_t len,
+                     mp_parse_input_kind_t kind);
+mp_obj_t mpy_vm_lookup(mp_obj_dict_t* ns, const char* name);
+
+#endif // MPY_VM_H
@@ -0,0 +1,149 @@
+/* bench_emit.c -- control-rate math under the micropython emitters of `mpy`
+ *
+ * Compares, for the same one-pole smoothing kernel run over a 64 step
+ * block (a typical control-rate update):
+ *
+ *  1. bytecode (default emitter)
+ *  2. @micropython.native
+ *  3. @micropython.viper (typed locals, ints are machine words)
+ *
+ * in Q16 fixed point (`_i`) and in floats (`_f`). Viper has no native float
+ * type, so its float kernel mostly measures the boxed float path.
+ *
+ * Build from source/projects/mpy against a libmpy.a of the embed sources
+ * (see micropython.cmake), x86-64 only:
+ *
+ * E=micropython_embed
+ * gcc -O2 -I. -I$E -I$E/genhdr -I$E/port -I$E/py -I$E/shared \
+ *     -o bench_emit tests/bench_emit.c mpy_vm.c libmpy.a -lm
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "py/runtime.h"
+
+#include "mpy_vm.h"
+
+#define N_CALLS 20000
+#define N_STEPS 64
+
+static const char* kernels =
+    "def smooth_i(n):\n"
+    "    y = 0\n"
+    "    x = 100 << 16\n"
+    "    for i in range(n):\n"
+    "        y += ((x - y) * 3277) >> 16\n"
+    "    return y\n"
+    "\n"
+    "@micropython.native\n"
+    "def smooth_native_i(n):\n"
+    "    y = 0\n"
+    "    x = 100 << 16\n"
+    "    for i in range(n):\n"
+    "        y += ((x - y) * 3277) >> 16\n"
+    "    return y\n"
+    "\n"
+    "@micropython.viper\n"
+    "def smooth_viper_i(n: int) -> int:\n"
+    "    y = 0\n"
+    "    x = 100 << 16\n"
+    "    for i in range(n):\n"
+    "        y += ((x - y) * 3277) >> 16\n"
+    "    return y\n"
+    "\n"
+    "def smooth_f(n):\n"
+    "    y = 0.0\n"
+    "    x = 100.0\n"
+    "    for i in range(n):\n"
+    "        y += (x - y) * 0.05\n"
+    "    return y\n"
+    "\n"
+    "@micropython.native\n"
+    "def smooth_native_f(n):\n"
+    "    y = 0.0\n"
+    "    x = 100.0\n"
+    "    for i in range(n):\n"
+    "        y += (x - y) * 0.05\n"
+    "    return y\n"
+    "\n"
+    "@micropython.viper\n"
+    "def smooth_viper_f(n: int):\n"
+    "    y = 0.0\n"
+    "    x = 100.0\n"
+    "    for i in range(n):\n"
+    "        y += (x - y) * 0.05\n"
+    "    return y\n";
+
+static const char* names[] = {
+    "smooth_i", "smooth_native_i", "smooth_viper_i",
+    "smooth_f", "smooth_native_f", "smooth_viper_f",
+};
+
+typedef struct bench {
+    const char* name;
+    double elapsed;
+} t_bench;
+
+static mp_obj_dict_t* ns = NULL;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double elapsed, double base)
+{
+    printf("%-18s %10.0f calls/sec  (%.3f us/call, x%.2f)\n", name,
+           N_CALLS / elapsed, elapsed * 1e6 / N_CALLS, base / elapsed);
+}
+
+static void setup_cb(void* ctx)
+{
+    ns = mpy_vm_namespace_new(0, "bench");
+    mpy_vm_exec(ns, kernels, strlen(kernels), MP_PARSE_FILE_INPUT);
+}
+
+static void bench_cb(void* ctx)
+{
+    t_bench* b = (t_bench*)ctx;
+    mp_obj_t func = mpy_vm_lookup(ns, b->name);
+    mp_obj_t n = MP_OBJ_NEW_SMALL_INT(N_STEPS);
+
+    double start = now();
+    for (int i = 0; i < N_CALLS; i++) {
+        mp_call_function_1(func, n);
+    }
+    b->elapsed = now() - start;
+}
+
+int main(void)
+{
+    t_bench b;
+    double base = 0.0;
+
+    if (mpy_vm_acquire(256 * 1024, 4096 * 1024) != 0) {
+        return 1;
+    }
+    if (mpy_vm_run(setup_cb, NULL, &mp_plat_print) != 0) {
+        return 1;
+    }
+
+    printf("%d calls of a %d step block\n", N_CALLS, N_STEPS);
+    for (int i = 0; i < 6; i++) {
+        b.name = names[i];
+        if (mpy_vm_run(bench_cb, &b, &mp_plat_print) != 0) {
+            return 1;
+        }
+        if (i % 3 == 0) {
+            base = b.elapsed;
+        }
+        report(b.name, b.elapsed, base);
+    }
+
+    mpy_vm_release();
+    return 0;
+}
@@ -26,6 +26,23 @@ namespace pyjs {
 
 constexpr int PY_MAX_ELEMS = 1024;
 
+// ---------------------------------------------------------------------------
+// globals
+
+/**
+ * @brief      Process-wide count of the interpreters sharing the runtime.
+ *
+ * Kept in a capsule on `sys` rather than in a static, which would be per
+ * binary: mpyx and mpyx~ would each count their own instances and both
+ * finalize python.
+ */
+struct py_runtime_refs {
+    long count; //!< live PythonInterpreter instances, of all binaries
+    bool owned; //!< python was initialized by one of them
+};
+
+constexpr const char* PY_RUNTIME_REFS = "_pyjs_runtime_refs"; //!< sys attribute and capsule name
+
 // ---------------------------------------------------------------------------
 // enums
 
@@ -109,6 +126,7 @@ public:
     symbol get_pythonpath();
     void set_loglevel(log_level value);
     log_level get_loglevel();
+    PyObject* globals();
 
     // python <-> atom translation
     PyObject* atoms_to_plist_with_offset(const atoms& args, int start_from);
@@ -202,6 +220,56 @@ public:
 */
 
 
+// ---------------------------------------------------------------------------
+// runtime reference count
+
+/**
+ * @brief      Frees the reference count when `sys` is torn down.
+ */
+static void py_runtime_refs_free(PyObject* capsule)
+{
+    PyMem_RawFree(PyCapsule_GetPointer(capsule, PY_RUNTIME_REFS));
+}
+
+/**
+ * @brief      Gets the process-wide reference count, creating it if missing.
+ *
+ * @param[in]  owned  Whether the caller initialized python (only used when
+ *                    the count is created).
+ *
+ * @return     The reference count, or nullptr on error.
+ *
+ * Needs the GIL.
+ */
+static py_runtime_refs* py_runtime_refs_get(bool owned)
+{
+    PyObject* capsule = PySys_GetObject(PY_RUNTIME_REFS); // borrowed
+    if (capsule != NULL) {
+        return (py_runtime_refs*)PyCapsule_GetPointer(capsule, PY_RUNTIME_REFS);
+    }
+
+    py_runtime_refs* refs = (py_runtime_refs*)PyMem_RawCalloc(1, sizeof(py_runtime_refs));
+    if (refs == NULL) {
+        return nullptr;
+    }
+    refs->owned = owned;
+
+    capsule = PyCapsule_New(refs, PY_RUNTIME_REFS, py_runtime_refs_free);
+    if (capsule == NULL) {
+        PyErr_Clear();
+        PyMem_RawFree(refs);
+        return nullptr;
+    }
+    if (PySys_SetObject(PY_RUNTIME_REFS, capsule) != 0) {
+        PyErr_Clear();
+        Py_DECREF(capsule); // frees refs
+        return nullptr;
+    }
+    Py_DECREF(capsule); // sys holds it
+    return refs;
+}
+
+
 // ---------------------------------------------------------------------------
 // constructor / destructor methods
 
@@ -215,6 +283,11 @@ public:
  * will be initialized with the default PYTHONHOME. If the class parameter is
  * provided, the python interpreter will be initialized with either the path to
  * the python interpreter in the package or in the bundle itself.
+ *
+ * All instances share one python runtime: it is initialized by the first
+ * and finalized by the last, the others only add their own namespace. The
+ * count is process-wide (see py_runtime_refs), and python is not finalized
+ * if another external initialized it.
  */
 PythonInterpreter::PythonInterpreter(c74::max::t_class* c)
 {
@@ -224,47 +297,59 @@ PythonInterpreter::PythonInterpreter(c74::max::t_class* c)
     this->m_source_path = symbol();
     this->m_log_level = log_level::PY_DEBUG;
 
-    // python init
-    wchar_t* python_home = NULL;
+    PyGILState_STATE gstate = PyGILState_UNLOCKED;
+    bool initialized = Py_IsInitialized();
 
-    if (c) { // special-case pythonhome config, only makes sense if c not NULL
+    if (initialized) {
+        gstate = PyGILState_Ensure();
+    } else {
+        // python init
+        wchar_t* python_home = NULL;
+
+        if (c) { // special-case pythonhome config, only makes sense if c not NULL
 
 #if defined(__APPLE__) && defined(BUILD_STATIC)
-        const char* resources_path = this->get_path_to_external(
-                                             c, "/Contents/Resources")
-                                         .c_str();
-        python_home = Py_DecodeLocale(resources_path, NULL);
+            const char* resources_path = this->get_path_to_external(
+                                                 c, "/Contents/Resources")
+                                             .c_str();
+            python_home = Py_DecodeLocale(resources_path, NULL);
 #endif
 
 #if defined(__APPLE__) && defined(BUILD_SHARED_PKG)
-        const char* package_path = this->get_path_to_package(
-                                           c, "/support/python" PY_VER)
-                                       .c_str();
-        python_home = Py_DecodeLocale(package_path, NULL);
+            const char* package_path = this->get_path_to_package(
+                                               c, "/support/python" PY_VER)
+                                           .c_str();
+            python_home = Py_DecodeLocale(package_path, NULL);
 #endif
 
-    } // end special-case python-home config
+        } // end special-case python-home config
 
 #if PY_VERSION_HEX < 0x0308000
-    if (python_home != NULL) {
-        Py_SetPythonHome(python_home);
-        PyMem_RawFree(python_home);
-    }
-    Py_Initialize();
+        if (python_home != NULL) {
+            Py_SetPythonHome(python_home);
+            PyMem_RawFree(python_home);
+        }
+        Py_Initialize();
 #else
-    PyConfig config;
-    PyConfig_InitPythonConfig(&config);
-    config.parse_argv = 0; // Disable parsing command line arguments
-    config.isolated = 0;   // default is disabled
-    config.home = python_home;
-
-    PyStatus status = Py_InitializeFromConfig(&config);
-    if (PyStatus_Exception(status)) {
+        PyConfig config;
+        PyConfig_InitPythonConfig(&config);
+        config.parse_argv = 0; // Disable parsing command line arguments
+        config.isolated = 0;   // default is disabled
+        config.home = python_home;
+
+        PyStatus status = Py_InitializeFromConfig(&config);
+        if (PyStatus_Exception(status)) {
+            PyConfig_Clear(&config);
+            this->log_error("could not initialize python");
+        }
         PyConfig_Clear(&config);
-        this->log_error("could not initialize python");
-    }
-    PyConfig_Clear(&config);
 #endif
+    }
+
+    py_runtime_refs* refs = py_runtime_refs_get(!initialized);
+    if (refs) {
+        refs->count++;
+    }
 
     const char* main_mod_name = this->name();
     PyObject* main_mod = PyImport_AddModule(main_mod_name); // borrowed
@@ -278,6 +363,10 @@ PythonInterpreter::PythonInterpreter(c74::max::t_class* c)
     PyDict_SetItemString(builtins, "PY_OBJ_NAME", py_name);
     PyDict_SetItemString(this->m_globals, "__builtins__", builtins);
     Py_XDECREF(py_name);
+
+    if (initialized) {
+        PyGILState_Release(gstate);
+    }
 }
 
 
@@ -286,7 +375,19 @@ PythonInterpreter::PythonInterpreter(c74::max::t_class* c)
  */
 PythonInterpreter::~PythonInterpreter()
 {
-    Py_XDECREF(this->m_globals);
+    PyGILState_STATE gstate = PyGILState_Ensure();
+
+    py_runtime_refs* refs = py_runtime_refs_get(false);
+    if (refs == nullptr || --refs->count > 0 || !refs->owned) {
+        // m_globals is borrowed from the module: drop the module instead
+        PyObject* modules = PyImport_GetModuleDict(); // borrowed
+        if (PyDict_DelItemString(modules, this->name()) != 0) {
+            PyErr_Clear();
+        }
+        PyGILState_Release(gstate);
+        return;
+    }
+
     Py_FinalizeEx();
 }
 
@@ -588,6 +689,14 @@ void PythonInterpreter::set_loglevel(log_level value)
 log_level PythonInterpreter::get_loglevel() { return this->m_log_level; }
 
 
+/**
+ * @brief      Gets the per object python namespace.
+ *
+ * @return     The globals dict (borrowed reference).
+ */
+PyObject* PythonInterpreter::globals() { return this->m_globals; }
+
+
 // ---------------------------------------------------------------------------
 // translation methods
 
@@ -0,0 +1,506 @@
+#include "c74_min.h"
+
+#define MPY_INTERPRETER_IMPLEMENTATION
+#include "mpy_interpreter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace c74::min;
+
+
+// ---------------------------------------------------------------------------
+// constants
+
+constexpr long MPYX_MAX_CHANNELS = 64;
+constexpr long MPYX_MAX_DECIMATION = 64;
+constexpr size_t MPYX_N_BLOCKS = 8; // blocks in flight between audio and python
+
+
+// ---------------------------------------------------------------------------
+// classes
+
+/**
+ * @brief      A block of audio handed from the audio thread to the python
+ * worker.
+ *
+ * Channels are planar: channel `c` is the contiguous run of `frame_count`
+ * samples at `samples.data() + c * frame_count`, which python sees as a
+ * float64 memoryview.
+ */
+struct audio_block {
+    std::vector<double> samples;
+    long channel_count = 0;
+    long frame_count = 0;
+    long filled = 0;          // frames written by the audio thread
+    Py_ssize_t shape = 0;     // memoryview shape (frame_count)
+    Py_ssize_t stride = sizeof(double);
+};
+
+
+/**
+ * @brief      The blocks, queues and worker thread of one dsp configuration.
+ *
+ * `free_blocks` is filled by the worker and drained by the audio thread,
+ * `full_blocks` the other way around. Once published, no other thread
+ * touches the queues: a pipeline is only freed after the audio thread has
+ * moved on to a newer one (see PythonAudioExternal::publish).
+ */
+struct audio_pipeline {
+    std::vector<std::unique_ptr<audio_block>> blocks;
+    fifo<audio_block*> free_blocks { MPYX_N_BLOCKS };
+    moodycamel::BlockingReaderWriterQueue<audio_block*> full_blocks { MPYX_N_BLOCKS };
+    audio_block* current = nullptr; // block being filled (audio thread only)
+    std::thread worker;
+    std::atomic<bool> running { false };
+};
+
+
+/**
+ * @brief      Storage of an audio block which python still has views of.
+ */
+struct retired_block {
+    std::vector<double> samples;
+    std::vector<_PyManagedBufferObject*> buffers; // of the exported views (owned)
+};
+
+
+class PythonAudioExternal : public object<PythonAudioExternal>, public vector_operator<> {
+private:
+    // shared with the audio and worker threads (declared before the attributes using them)
+    std::atomic<bool> m_enabled { false };
+    std::atomic<bool> m_reported { false }; // callback error already posted
+    std::atomic<c74::max::t_symbol*> m_callback_name { nullptr };
+    std::atomic<long> m_processed { 0 };
+    std::atomic<long> m_dropped { 0 };
+    std::atomic<long> m_errors { 0 };
+
+public:
+    MIN_DESCRIPTION {"Run Python code on blocks of audio in Max/MSP."};
+    MIN_TAGS        {"python, audio"};
+    MIN_AUTHOR      {"S. Alireza"};
+    MIN_RELATED     {"mpyx"};
+
+    outlet<> output { this, "(anything) output results of processing python code" };
+    outlet<thread_check::any, thread_action::fifo> results { this,
+        "(anything) output results of the audio callback and stats" };
+
+    PythonAudioExternal(const atoms& args = {})
+    {
+        long channels = args.empty() ? 1 : long(args[0]);
+        channels = std::max(1L, std::min(channels, MPYX_MAX_CHANNELS));
+
+        for (long i = 0; i < channels; i++) {
+            std::string desc = i == 0
+                ? "(signal) channel 1, (anything) messages and python code"
+                : "(signal) channel " + std::to_string(i + 1);
+            m_inlets.push_back(std::make_unique<inlet<>>(this, desc, "signal"));
+        }
+
+        if (dummy()) {
+            return;
+        }
+
+        this->py = std::make_unique<pyjs::PythonInterpreter>(this_class);
+
+        // hand the GIL over so the worker thread can take it; main thread
+        // methods re-acquire it with PyGILState_Ensure.
+        if (PyGILState_Check()) {
+            s_main_tstate = PyEval_SaveThread();
+        }
+    }
+
+    ~PythonAudioExternal()
+    {
+        // dsp_free() has run: the audio thread no longer calls operator()
+        m_pending.store(nullptr);
+        this->retire(m_published);
+        this->retire(m_taken);
+
+        if (!this->py) {
+            return;
+        }
+
+        if (s_main_tstate) {
+            PyEval_RestoreThread(s_main_tstate);
+            s_main_tstate = nullptr;
+        }
+        this->py.reset();
+
+        // other instances still run python: release the GIL again
+        if (Py_IsInitialized()) {
+            s_main_tstate = PyEval_SaveThread();
+        } else {
+            // python is finalized: nothing views the retired storage
+            guard lock(s_retired_mutex);
+            s_retired.clear();
+        }
+    }
+
+    attribute<symbol> callback { this, "callback", "",
+        description {
+            "Name of the python function called with each block of audio. "
+            "It receives a tuple of float64 memoryviews, one per channel, "
+            "which are only valid during the call."
+        },
+        c74::min::setter { MIN_FUNCTION {
+            symbol name = args[0];
+            m_callback_name.store(name);
+            m_reported.store(false);
+            m_enabled.store(name != symbol(""));
+            return args;
+        }}
+    };
+
+    attribute<int, threadsafe::no, limit::clamp> decimation { this, "decimation", 1,
+        range { 1, MPYX_MAX_DECIMATION },
+        description {
+            "Number of signal vectors per python call. "
+            "Takes effect when the dsp chain is compiled."
+        }
+    };
+
+    message<> dspsetup { this, "dspsetup",
+        MIN_FUNCTION {
+            int vector_size = args[1];
+            if (this->py) {
+                this->publish(this->new_pipeline(long(m_inlets.size()), vector_size * decimation));
+            }
+            return {};
+        }
+    };
+
+    /**
+     * @brief      Copies the input into the current block (audio thread).
+     *
+     * Never blocks or allocates: when python falls behind and no free block
+     * is available the vector is dropped and counted. Taking a newly
+     * published pipeline tells the main thread the previous one is unused.
+     */
+    void operator()(audio_bundle input, audio_bundle output)
+    {
+        if (m_pending.load(std::memory_order_relaxed) != nullptr) {
+            audio_pipeline* next = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+            if (next != nullptr) {
+                m_active = next;
+            }
+        }
+
+        audio_pipeline* p = m_active;
+        if (p == nullptr || !m_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        audio_block* block = p->current;
+        if (block == nullptr) {
+            if (!p->free_blocks.try_dequeue(block)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            block->filled = 0;
+            p->current = block;
+        }
+
+        long frames = std::min(input.frame_count(), block->frame_count - block->filled);
+        long channels = std::min(input.channel_count(), block->channel_count);
+        for (long c = 0; c < channels; c++) {
+            std::copy(input.samples(c), input.samples(c) + frames,
+                      block->samples.data() + c * block->frame_count + block->filled);
+        }
+        block->filled += frames;
+
+        if (block->filled == block->frame_count) {
+            p->full_blocks.try_enqueue(block);
+            p->current = nullptr;
+        }
+    }
+
+    message<> stats { this, "stats", "Output processed, dropped and failed block counts.",
+        MIN_FUNCTION {
+            results.send("processed", long(m_processed.load()));
+            results.send("dropped", long(m_dropped.load()));
+            results.send("errors", long(m_errors.load()));
+            return {};
+        }
+    };
+
+    message<> import { this, "import", "Import Python module.",
+        MIN_FUNCTION {
+            this->py->import(args);
+            return {};
+        }
+    };
+
+    message<> eval { this, "eval", "Evaluate python expression.",
+        MIN_FUNCTION {
+            this->py->eval(args, &output);
+            return {};
+        }
+    };
+
+    message<> exec { this, "exec", "Execute python code.",
+        MIN_FUNCTION {
+            this->py->exec(args);
+            return {};
+        }
+    };
+
+    message<> execfile { this, "execfile", "Execute python code from file.",
+        MIN_FUNCTION {
+            this->py->execfile(args);
+            return {};
+        }
+    };
+
+    message<> call { this, "call", "Call python function with atom arguments.",
+        MIN_FUNCTION {
+            this->py->call(args, &output);
+            return {};
+        }
+    };
+
+    message<> assign { this, "assign", "Assign python variable to atom expression.",
+        MIN_FUNCTION {
+            this->py->assign(args);
+            return {};
+        }
+    };
+
+private:
+    static PyThreadState* s_main_tstate; // main thread state while the GIL is released
+    static std::mutex s_retired_mutex;
+    static std::vector<retired_block> s_retired; // storage still viewed by python
+
+    std::vector<std::unique_ptr<inlet<>>> m_inlets;
+    std::unique_ptr<pyjs::PythonInterpreter> py;
+
+    // audio -> python block pipelines, swapped on dspsetup
+    std::atomic<audio_pipeline*> m_pending { nullptr }; // published, not yet taken by the audio thread
+    audio_pipeline* m_active = nullptr;                 // audio thread only
+    std::unique_ptr<audio_pipeline> m_taken;            // main thread: may be in use by the audio thread
+    std::unique_ptr<audio_pipeline> m_published;        // main thread: last published
+
+    /**
+     * @brief      Creates a pipeline and starts its worker (main thread).
+     *
+     * The blocks are queued before the worker starts and before the audio
+     * thread can see the pipeline, so each queue still has one producer and
+     * one consumer at a time.
+     */
+    std::unique_ptr<audio_pipeline> new_pipeline(long channels, long frames)
+    {
+        auto p = std::make_unique<audio_pipeline>();
+
+        for (size_t i = 0; i < MPYX_N_BLOCKS; i++) {
+            auto block = std::make_unique<audio_block>();
+            block->samples.resize(channels * frames);
+            block->channel_count = channels;
+            block->frame_count = frames;
+            block->shape = frames;
+            p->free_blocks.enqueue(block.get());
+            p->blocks.push_back(std::move(block));
+        }
+
+        p->running.store(true);
+        p->worker = std::thread([this, pp = p.get()] { this->worker(pp); });
+        return p;
+    }
+
+    /**
+     * @brief      Hands a pipeline to the audio thread (main thread).
+     *
+     * Never waits for the audio thread, which may not be running. If the
+     * previously published pipeline was not taken it can no longer be, so
+     * it is freed. If it was taken, the audio thread has let go of the one
+     * before it, which is freed instead.
+     */
+    void publish(std::unique_ptr<audio_pipeline> p)
+    {
+        audio_pipeline* untaken = m_pending.exchange(p.get(), std::memory_order_acq_rel);
+
+        if (untaken != nullptr) {
+            this->retire(m_published);
+        } else if (m_published) {
+            this->retire(m_taken);
+            m_taken = std::move(m_published);
+        }
+        m_published = std::move(p);
+    }
+
+    /**
+     * @brief      Stops the worker of a pipeline and frees it (main thread).
+     */
+    void retire(std::unique_ptr<audio_pipeline>& p)
+    {
+        if (!p) {
+            return;
+        }
+        p->running.store(false);
+        if (p->worker.joinable()) {
+            p->worker.join();
+        }
+        p.reset();
+    }
+
+    void worker(audio_pipeline* p)
+    {
+        audio_block* block;
+        while (p->running.load()) {
+            if (p->full_blocks.wait_dequeue_timed(block, std::chrono::milliseconds(100))) {
+                this->process(block);
+                p->free_blocks.enqueue(block);
+            }
+        }
+    }
+
+    /**
+     * @brief      Frees retired storage which python no longer views.
+     *
+     * Needs the GIL: the exports of a managed buffer change under it.
+     */
+    static void sweep_retired()
+    {
+        guard lock(s_retired_mutex);
+
+        for (auto it = s_retired.begin(); it != s_retired.end();) {
+            bool viewed = std::any_of(it->buffers.begin(), it->buffers.end(),
+                [](_PyManagedBufferObject* mbuf) { return mbuf->exports > 0; });
+            if (viewed) {
+                ++it;
+                continue;
+            }
+            for (_PyManagedBufferObject* mbuf : it->buffers) {
+                Py_DECREF(mbuf);
+            }
+            it = s_retired.erase(it);
+        }
+    }
+
+    /**
+     * @brief      Calls the python callback with a block (worker thread).
+     *
+     * The memoryviews are released after the call. If python kept a view or
+     * buffer export (e.g. a slice, or a numpy array made with frombuffer) the
+     * block gets fresh storage and the exported one is retired until the
+     * last view of it is gone, so python never sees recycled or freed audio.
+     */
+    void process(audio_block* block)
+    {
+        c74::max::t_symbol* name = m_callback_name.load();
+        if (name == nullptr || name == c74::max::gensym("")) {
+            return;
+        }
+
+        atoms result;
+        retired_block retired;
+
+        PyGILState_STATE gstate = PyGILState_Ensure();
+
+        PyObject* pfunc = PyDict_GetItemString(this->py->globals(), name->s_name); // borrowed
+        PyObject* pviews = PyTuple_New(block->channel_count);
+        PyObject* pval = NULL;
+
+        if (pfunc == NULL || !PyCallable_Check(pfunc)) {
+            m_errors++;
+            if (!m_reported.exchange(true)) {
+                c74::max::error("[py %s] callback '%s' is not a function",
+                                this->py->name(), name->s_name);
+            }
+            goto done;
+        }
+
+        for (long c = 0; c < block->channel_count; c++) {
+            Py_buffer view = {};
+            view.buf = block->samples.data() + c * block->frame_count;
+            view.len = block->frame_count * sizeof(double);
+            view.itemsize = sizeof(double);
+            view.readonly = 1;
+            view.ndim = 1;
+            view.format = (char*)"d";
+            view.shape = &block->shape;
+            view.strides = &block->stride;
+            PyTuple_SET_ITEM(pviews, c, PyMemoryView_FromBuffer(&view));
+        }
+
+        pval = PyObject_CallFunctionObjArgs(pfunc, pviews, NULL);
+        if (pval == NULL) {
+            m_errors++;
+            // post the first failure only: the callback runs at audio rate
+            if (!m_reported.exchange(true)) {
+                this->py->handle_error("audio callback %s failed", name->s_name);
+            }
+            PyErr_Clear();
+        } else {
+            m_processed++;
+            result = this->pobject_to_atoms(pval);
+            Py_DECREF(pval);
+        }
+
+        for (long c = 0; c < block->channel_count; c++) {
+            // views derived from ours (slices, memoryview(v)) share its
+            // managed buffer and survive release(): check for them first
+            PyMemoryViewObject* pview = (PyMemoryViewObject*)PyTuple_GET_ITEM(pviews, c);
+            bool exported = pview->mbuf->exports > 1;
+            PyObject* ok = PyObject_CallMethod((PyObject*)pview, "release", NULL);
+            if (ok == NULL) {
+                PyErr_Clear();
+                exported = true;
+            }
+            Py_XDECREF(ok);
+            if (exported) {
+                Py_INCREF(pview->mbuf);
+                retired.buffers.push_back(pview->mbuf);
+            }
+        }
+
+        sweep_retired();
+
+        if (!retired.buffers.empty()) {
+            c74::max::error("[py %s] '%s' kept a reference to an audio block: copy it instead",
+                            this->py->name(), name->s_name);
+            retired.samples = std::move(block->samples);
+            block->samples = std::vector<double>(block->channel_count * block->frame_count);
+            guard lock(s_retired_mutex);
+            s_retired.push_back(std::move(retired));
+        }
+
+    done:
+        Py_XDECREF(pviews);
+        PyGILState_Release(gstate);
+
+        if (!result.empty()) {
+            results.send(result);
+        }
+    }
+
+    /**
+     * @brief      Converts a callback result: scalars and flat sequences.
+     */
+    atoms pobject_to_atoms(PyObject* pval)
+    {
+        atoms result;
+
+        if (pval == Py_None) {
+            return result;
+        }
+
+        if (PyList_Check(pval) || PyTuple_Check(pval)) {
+            Py_ssize_t len = std::min(PySequence_Fast_GET_SIZE(pval), (Py_ssize_t)pyjs::PY_MAX_ELEMS);
+            for (Py_ssize_t i = 0; i < len; i++) {
+                result.push_back(this->py->pobject_to_atom(PySequence_Fast_GET_ITEM(pval, i)));
+            }
+        } else {
+            result.push_back(this->py->pobject_to_atom(pval));
+        }
+        return result;
+    }
+};
+
+PyThreadState* PythonAudioExternal::s_main_tstate = nullptr;
+std::mutex PythonAudioExternal::s_retired_mutex;
+std::vector<retired_block> PythonAudioExternal::s_retired;
+
+
+MIN_EXTERNAL(PythonAudioExternal);
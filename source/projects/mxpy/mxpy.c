@@ -5,11 +5,28 @@
 #include <Python.h>
 
 enum { PY_MAX_ELEMS = 1024 };
+enum { PY_STACK_ARGS = 16 }; ///< max method args converted on the stack
+
+#if PY_VERSION_HEX < 0x03090000
+static inline PyObject* PyObject_VectorcallMethod(PyObject* name, PyObject* const* args,
+                                                  size_t nargsf, PyObject* kwnames)
+{
+    PyObject* func = PyObject_GetAttr(args[0], name);
+    if (func == NULL) {
+        return NULL;
+    }
+    PyObject* result = _PyObject_Vectorcall(func, args + 1,
+                                            PyVectorcall_NARGS(nargsf) - 1, kwnames);
+    Py_DECREF(func);
+    return result;
+}
+#endif
 
 typedef struct _mxpy {
     t_object x_ob;       ///< standard object header
     void* x_outlet;      ///< left outlet for msg output
     PyObject* py_object; ///< Python class object represented by this object
+    t_hashtab* x_names;  ///< selector -> interned python method name
     int x_debug;         ///< Switch on and off debug logging.
 } t_mxpy;
 
@@ -32,6 +49,7 @@ static void mxpy_sym(t_mxpy* x, t_symbol* s);
 static void mxpy_int(t_mxpy* x, long n);
 static void mxpy_float(t_mxpy* x, double n);
 
+static PyObject* mxpy_method_name(t_mxpy* x, t_symbol* s);
 static void mxpy_eval(t_mxpy* x, t_symbol* s, int argc, t_atom* argv);
 static void* mxpy_init(t_mxpy* x, int argc, t_atom* argv);
 
@@ -241,41 +259,69 @@ static void mxpy_float(t_mxpy* x, double n)
     mxpy_eval(x, gensym("mx_float"), 1, atoms);
 }
 
+/**
+ * @brief Returns the interned python method name for a selector
+ *
+ * Names are interned once per selector so that dispatch only needs the
+ * type's attribute cache instead of building a new string per message.
+ *
+ * @return borrowed reference or NULL with error set
+ */
+static PyObject* mxpy_method_name(t_mxpy* x, t_symbol* s)
+{
+    PyObject* name = NULL;
+
+    if (hashtab_lookup(x->x_names, s, (t_object**)&name) == MAX_ERR_NONE) {
+        return name;
+    }
+    name = PyUnicode_InternFromString(s->s_name);
+    if (name != NULL) {
+        hashtab_store(x->x_names, s, (t_object*)name); // owns the reference
+    }
+    return name;
+}
+
 static void mxpy_eval(t_mxpy* x, t_symbol* s, int argc, t_atom* argv)
 {
     mxpy_debug(x, "mxpy_eval start");
     mxpy_debug(x, "s: %s argc: %i", s->s_name, argc);
 
-    PyObject* func = NULL;
-    PyObject* args = NULL;
+    PyObject* stack[PY_STACK_ARGS + 1];
+    PyObject** args = stack;
+    PyObject* name = NULL;
     PyObject* value = NULL;
+    int nargs = 0;
 
     if (x->py_object == NULL) {
         mxpy_warn(x, "Warning: message sent to uninitialized python object.");
         return;
     }
 
-    func = PyObject_GetAttrString(x->py_object, s->s_name);
-    args = mxpy_atoms_to_pylist(x, argc, argv);
-
-    if (!func) {
-        mxpy_warn(x, "Warning: no Python function found for s %s.", s->s_name);
-    } else {
-        if (!PyCallable_Check(func)) {
-            mxpy_warn(x, "Warning: Python attribute for s %s is not callable.",
-                 s->s_name);
-        } else {
-            value = PyObject_CallObject(func, args);
+    if (argc > PY_STACK_ARGS) {
+        args = (PyObject**)sysmem_newptr((argc + 1) * sizeof(PyObject*));
+        if (args == NULL) {
+            mxpy_error(x, "out of memory for %d arguments", argc);
+            return;
         }
-        Py_DECREF(func);
     }
 
-    if (args) {
-        Py_DECREF(args);
+    name = mxpy_method_name(x, s);
+    if (name != NULL) {
+        // slot 0 is self, args are converted in place, no tuple is built
+        args[0] = x->py_object;
+        for (nargs = 0; nargs < argc; nargs++) {
+            args[nargs + 1] = mxpy_atom_to_pyobject(x, &argv[nargs]);
+        }
+        value = PyObject_VectorcallMethod(name, args, (size_t)(argc + 1), NULL);
     }
 
     if (value == NULL) {
-        mxpy_warn(x, "Warning: Python call for '%s' failed.", s->s_name);
+        if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            mxpy_warn(x, "Warning: no Python function found for s %s.", s->s_name);
+        } else {
+            mxpy_warn(x, "Warning: Python call for '%s' failed.", s->s_name);
+        }
+        PyErr_Clear();
 
     } else {
         if (PyTuple_Check(value)) {
@@ -291,6 +337,13 @@ static void mxpy_eval(t_mxpy* x, t_symbol* s, int argc, t_atom* argv)
 
         Py_DECREF(value);
     }
+
+    for (int i = 1; i <= nargs; i++) {
+        Py_DECREF(args[i]);
+    }
+    if (args != stack) {
+        sysmem_freeptr(args);
+    }
 }
 
 static void* mxpy_init(t_mxpy* x, int argc, t_atom* argv)
@@ -408,6 +461,8 @@ static void* mxpy_new(t_symbol* s, int argc, t_atom* argv)
 
     if (x) {
         x->py_object = NULL;
+        x->x_names = hashtab_new(0);
+        hashtab_flags(x->x_names, OBJ_FLAG_DATA);
         x->x_debug = 1;
 
         // create an outlet on which to return values
@@ -430,6 +485,22 @@ static void mxpy_free(t_mxpy* x)
         if (x->py_object) {
             Py_DECREF(x->py_object);
         }
+        if (x->x_names) {
+            long nkeys = 0;
+            t_symbol** keys = NULL;
+            PyObject* name = NULL;
+            hashtab_getkeys(x->x_names, &nkeys, &keys);
+            for (long i = 0; i < nkeys; i++) {
+                if (hashtab_lookup(x->x_names, keys[i], (t_object**)&name) == MAX_ERR_NONE) {
+                    Py_XDECREF(name);
+                }
+            }
+            if (keys) {
+                sysmem_freeptr(keys);
+            }
+            object_free(x->x_names);
+            x->x_names = NULL;
+        }
         Py_Finalize();
         x->x_outlet = NULL;
         x->py_object = NULL;
@@ -26,6 +26,9 @@ t_max_err pktpy_eval(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err pktpy_exec(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err pktpy_anything(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err pktpy_execfile(t_pktpy* x, t_symbol* s);
+t_max_err pktpy_vec(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
+void pktpy_metrics(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
+void pktpy_trace(t_pktpy* x, t_symbol* s, long argc, t_atom* argv);
 
 // code-editor methods
 void pktpy_dblclick(t_pktpy* x);
@@ -71,6 +74,9 @@ void ext_main(void* r)
     class_addmethod(c, (method)pktpy_exec,       "exec",       A_GIMME,    0);
     class_addmethod(c, (method)pktpy_anything,   "anything",   A_GIMME,    0);
     class_addmethod(c, (method)pktpy_execfile,   "execfile",   A_DEFSYM,   0);
+    class_addmethod(c, (method)pktpy_vec,        "vec",        A_GIMME,    0);
+    class_addmethod(c, (method)pktpy_metrics,    "metrics",    A_GIMME,    0);
+    class_addmethod(c, (method)pktpy_trace,      "trace",      A_GIMME,    0);
 
     // code editor
     class_addmethod(c, (method)pktpy_read,       "read",       A_DEFSYM,  0);
@@ -167,6 +173,7 @@ void* pktpy_new(t_symbol* s, long argc, t_atom* argv)
         x->name = gensym("");
         x->outlet = bangout((t_object*)x);
         x->py = new PktpyInterpreter(); // <-- can also be a struct
+        x->py->owner = (t_object*)x;
 
         // text editor
         x->code_buffer = sysmem_newhandle(0);
@@ -250,6 +257,21 @@ t_max_err pktpy_anything(t_pktpy* x, t_symbol* s, long argc, t_atom* argv)
     return x->py->anything(s, argc, argv, x->outlet);
 }
 
+/**
+ * @brief      bind a list of numbers to a global `dsp.vec` variable
+ *
+ * @param      x     object instance
+ * @param      s     symbol
+ * @param[in]  argc  no of atoms
+ * @param      argv  atom array (name: sym, values: float/int ...)
+ *
+ * @return     The t maximum error.
+ */
+t_max_err pktpy_vec(t_pktpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return x->py->setvec(s, argc, argv);
+}
+
 /**
  * @brief      { function_description }
  *
@@ -263,6 +285,38 @@ t_max_err pktpy_execfile(t_pktpy* x, t_symbol* s)
     return x->py->execfile(s);
 }
 
+/**
+ * @brief      output the latency metrics as `dictionary <name>`
+ *
+ * @param      x     object instance
+ * @param      s     symbol
+ * @param[in]  argc  no of atoms
+ * @param      argv  atom array (`reset` to clear the metrics)
+ */
+void pktpy_metrics(t_pktpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    metrics_message(x->py->metrics, x->name, argc, argv, x->outlet);
+}
+
+/**
+ * @brief      record a Chrome trace of the messages (see mamba/trace.h)
+ *
+ * @param      x     object instance
+ * @param      s     symbol
+ * @param[in]  argc  no of atoms
+ * @param      argv  atom array (`start`, `stop` or `write [path]`)
+ */
+void pktpy_trace(t_pktpy* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atom;
+    t_symbol* path = trace_message((t_object*)x, "pktpy", argc, argv);
+
+    if (path) {
+        atom_setsym(&atom, path);
+        outlet_anything(x->outlet, gensym("trace"), 1, &atom);
+    }
+}
+
 
 /* -------------------------------------------------------------------------
  * code-editor methods
@@ -460,6 +514,85 @@ void add_custom_builtins(t_pktpy* x)
         return py_var(vm, x + y);
     });
 
+    // contiguous double vector type: dsp.vec
+    x->py->register_user_class<PyVec>(mod_dsp, "vec");
+
+    // in-place views on buffer~ and jit.matrix memory: dsp.buffer, dsp.matrix
+    x->py->register_user_class<PyBuffer>(mod_dsp, "buffer");
+    x->py->register_user_class<PyMatrix>(mod_dsp, "matrix");
+
+    // copy a channel of a named buffer~ into a new vec
+    x->py->bind(mod_dsp, "from_buffer(name: str, channel: int = 0) -> vec", [](VM* vm, ArgsView args) {
+        t_pktpy *x = lambda_get_userdata<t_pktpy *>(args.begin());
+        Str name = py_cast<Str>(vm, args[0]);
+        i64 channel = py_cast<i64>(vm, args[1]);
+
+        t_buffer_ref* ref = buffer_ref_new((t_object*)x, gensym(name.c_str()));
+        t_buffer_obj* buf = buffer_ref_getobject(ref);
+        if (buf == NULL) {
+            object_free(ref);
+            vm->ValueError("buffer~ not found: " + name);
+        }
+
+        t_atom_long frames = buffer_getframecount(buf);
+        t_atom_long nchans = buffer_getchannelcount(buf);
+        if (channel < 0 || channel >= nchans) {
+            object_free(ref);
+            vm->IndexError("buffer~ channel out of range");
+        }
+
+        PyVar pvec = vm->new_user_object<PyVec>((size_t)frames);
+        f64* out = _py_cast<PyVec&>(vm, pvec).data.data();
+
+        float* samples = buffer_locksamples(buf);
+        if (samples) {
+            for (t_atom_long i = 0; i < frames; i++) {
+                out[i] = samples[i * nchans + channel];
+            }
+            buffer_unlocksamples(buf);
+        }
+        object_free(ref);
+        return pvec;
+    }, x);
+
+    // write a vec into a channel of a named buffer~ (truncated to its size)
+    x->py->bind(mod_dsp, "to_buffer(v: vec, name: str, channel: int = 0) -> int", [](VM* vm, ArgsView args) {
+        t_pktpy *x = lambda_get_userdata<t_pktpy *>(args.begin());
+        const PyVec& vec = py_cast<PyVec&>(vm, args[0]);
+        Str name = py_cast<Str>(vm, args[1]);
+        i64 channel = py_cast<i64>(vm, args[2]);
+
+        t_buffer_ref* ref = buffer_ref_new((t_object*)x, gensym(name.c_str()));
+        t_buffer_obj* buf = buffer_ref_getobject(ref);
+        if (buf == NULL) {
+            object_free(ref);
+            vm->ValueError("buffer~ not found: " + name);
+        }
+
+        t_atom_long frames = buffer_getframecount(buf);
+        t_atom_long nchans = buffer_getchannelcount(buf);
+        if (channel < 0 || channel >= nchans) {
+            object_free(ref);
+            vm->IndexError("buffer~ channel out of range");
+        }
+
+        t_atom_long n = (t_atom_long)vec.size() < frames ? (t_atom_long)vec.size() : frames;
+        const f64* in = vec.data.data();
+
+        float* samples = buffer_locksamples(buf);
+        if (samples) {
+            for (t_atom_long i = 0; i < n; i++) {
+                samples[i * nchans + channel] = (float)in[i];
+            }
+            buffer_unlocksamples(buf);
+            buffer_setdirty(buf);
+        } else {
+            n = 0;
+        }
+        object_free(ref);
+        return py_var(vm, n);
+    }, x);
+
 
     // --------------------------------------------------------------
     // builtin module
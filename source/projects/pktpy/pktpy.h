@@ -3,15 +3,21 @@
 
 #include "ext.h"
 #include "ext_obex.h"
+#include "ext_buffer.h"
+#include "jit.common.h"
 
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 #define PK_ENABLE_OS     1
 #define PK_ENABLE_THREAD 1
 
 #include "pocketpy.h"
 
+// per-message latency metrics (shared with other python externals)
+#include "../mamba/metrics.h"
+
 using namespace pkpy;
 
 // ---------------------------------------------------------------------------
@@ -50,6 +56,379 @@ void stderr_nowrite(const char * txt, int size) {
 };
 
 
+// ---------------------------------------------------------------------------
+// bulk numeric type
+
+/**
+ * @brief      contiguous double-precision vector, exposed to python
+ *             as `dsp.vec`
+ *
+ *             Elementwise operations and reductions run as plain loops over
+ *             the underlying array (which the compiler can auto-vectorize)
+ *             instead of boxing every element as a python float.
+ */
+struct PyVec {
+    std::vector<f64> data;
+
+    PyVec() {}
+    PyVec(size_t n) : data(n, 0.0) {}
+    PyVec(const f64* src, size_t n) : data(src, src + n) {}
+
+    size_t size() const { return data.size(); }
+
+    static void _register(VM* vm, PyVar mod, PyVar type);
+};
+
+
+/**
+ * @brief      Sum of an array, using four partial sums so that the loop
+ *             is not serialized on a single accumulator.
+ */
+static inline f64 pyvec_sum(const f64* a, size_t n)
+{
+    f64 s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i];
+        s1 += a[i + 1];
+        s2 += a[i + 2];
+        s3 += a[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+
+/**
+ * @brief      Dot product of two arrays of equal length (see `pyvec_sum`)
+ */
+static inline f64 pyvec_dot(const f64* a, const f64* b, size_t n)
+{
+    f64 s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+
+/**
+ * @brief      Applies a binary operator elementwise to a vec and either
+ *             another vec of the same size or a scalar.
+ *
+ * @param      lhs        vec operand
+ * @param      rhs        vec or int/float operand
+ * @param      op         binary operator on f64
+ * @param      reflected  scalar is the left operand (`__rsub__` etc.)
+ *
+ * @return     new vec, or NotImplemented for unsupported operand types
+ */
+template <typename Op>
+PyVar pyvec_binary_op(VM* vm, PyVar lhs, PyVar rhs, Op op, bool reflected = false)
+{
+    const PyVec& self = _CAST(PyVec&, lhs);
+    size_t n = self.size();
+
+    if (vm->is_user_type<PyVec>(rhs)) {
+        const PyVec& other = _CAST(PyVec&, rhs);
+        if (other.size() != n) {
+            vm->ValueError("vec sizes do not match");
+        }
+        PyVar ret = vm->new_user_object<PyVec>(n);
+        f64* __restrict out = _CAST(PyVec&, ret).data.data();
+        const f64* a = self.data.data();
+        const f64* b = other.data.data();
+        for (size_t i = 0; i < n; i++) {
+            out[i] = op(a[i], b[i]);
+        }
+        return ret;
+    }
+
+    if (!is_int(rhs) && !is_float(rhs)) {
+        return vm->NotImplemented;
+    }
+
+    f64 scalar = CAST_F(rhs);
+    PyVar ret = vm->new_user_object<PyVec>(n);
+    f64* __restrict out = _CAST(PyVec&, ret).data.data();
+    const f64* a = self.data.data();
+    if (reflected) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = op(scalar, a[i]);
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = op(a[i], scalar);
+        }
+    }
+    return ret;
+}
+
+
+/**
+ * @brief      Fills a vec from an int (size), list, tuple or another vec
+ */
+static void pyvec_assign(VM* vm, PyVec& self, PyVar src)
+{
+    i64 n;
+    if (try_cast_int(src, &n)) {
+        if (n < 0) {
+            vm->ValueError("vec size must be >= 0");
+        }
+        self.data.assign((size_t)n, 0.0);
+    } else if (vm->is_user_type<PyVec>(src)) {
+        self.data = _CAST(PyVec&, src).data;
+    } else if (is_type(src, vm->tp_list) || is_type(src, vm->tp_tuple)) {
+        ArgsView items(nullptr, nullptr);
+        if (is_type(src, vm->tp_list)) {
+            List& list = _CAST(List&, src);
+            items = ArgsView(list.begin(), list.end());
+        } else {
+            items = ArgsView(_CAST(Tuple&, src));
+        }
+        self.data.resize(items.size());
+        f64* out = self.data.data();
+        for (int i = 0; i < items.size(); i++) {
+            out[i] = CAST_F(items[i]);
+        }
+    } else {
+        vm->TypeError("vec() expects an int, list, tuple or vec");
+    }
+}
+
+
+void PyVec::_register(VM* vm, PyVar mod, PyVar type)
+{
+    Type t = PK_OBJ_GET(Type, type);
+
+    // vec(data=0): size, list/tuple of numbers or vec to copy
+    vm->bind(type, "__init__(self, data=0)", [](VM* vm, ArgsView args) {
+        PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        pyvec_assign(vm, self, args[1]);
+        return vm->None;
+    });
+
+    vm->bind__len__(t, [](VM* vm, PyVar obj) {
+        return (i64)_CAST(PyVec&, obj).size();
+    });
+
+    vm->bind__repr__(t, [](VM* vm, PyVar obj) -> Str {
+        const PyVec& self = _CAST(PyVec&, obj);
+        SStream ss;
+        ss << "vec([";
+        for (size_t i = 0; i < self.size(); i++) {
+            if (i > 0) ss << ", ";
+            ss << self.data[i];
+        }
+        ss << "])";
+        return ss.str();
+    });
+
+    vm->bind__getitem__(t, [](VM* vm, PyVar _0, PyVar _1) {
+        const PyVec& self = _CAST(PyVec&, _0);
+        i64 index;
+        if (try_cast_int(_1, &index)) {
+            index = vm->normalized_index(index, self.size());
+            return VAR(self.data[index]);
+        }
+        if (is_type(_1, vm->tp_slice)) {
+            int start, stop, step;
+            vm->parse_int_slice(_CAST(Slice&, _1), self.size(), start, stop, step);
+            if (step == 1) {
+                size_t n = stop > start ? stop - start : 0;
+                return vm->new_user_object<PyVec>(self.data.data() + start, n);
+            }
+            PyVar ret = vm->new_user_object<PyVec>();
+            PyVec& sliced = _CAST(PyVec&, ret);
+            PK_SLICE_LOOP(i, start, stop, step) sliced.data.push_back(self.data[i]);
+            return ret;
+        }
+        vm->TypeError("vec indices must be integers or slices");
+        PK_UNREACHABLE()
+    });
+
+    vm->bind__setitem__(t, [](VM* vm, PyVar _0, PyVar _1, PyVar _2) {
+        PyVec& self = _CAST(PyVec&, _0);
+        i64 index;
+        if (try_cast_int(_1, &index)) {
+            index = vm->normalized_index(index, self.size());
+            self.data[index] = CAST_F(_2);
+            return;
+        }
+        if (is_type(_1, vm->tp_slice)) {
+            int start, stop, step;
+            vm->parse_int_slice(_CAST(Slice&, _1), self.size(), start, stop, step);
+            if (vm->is_user_type<PyVec>(_2)) {
+                const PyVec& other = _CAST(PyVec&, _2);
+                size_t n = 0;
+                PK_SLICE_LOOP(i, start, stop, step) n++;
+                if (n != other.size()) {
+                    vm->ValueError("vec slice assignment size mismatch");
+                }
+                size_t j = 0;
+                PK_SLICE_LOOP(i, start, stop, step) self.data[i] = other.data[j++];
+            } else {
+                f64 value = CAST_F(_2);
+                PK_SLICE_LOOP(i, start, stop, step) self.data[i] = value;
+            }
+            return;
+        }
+        vm->TypeError("vec indices must be integers or slices");
+    });
+
+    vm->bind__iter__(t, [](VM* vm, PyVar obj) {
+        const PyVec& self = _CAST(PyVec&, obj);
+        List items(self.size());
+        for (size_t i = 0; i < self.size(); i++) {
+            items[i] = VAR(self.data[i]);
+        }
+        return vm->py_iter(VAR(std::move(items)));
+    });
+
+    vm->bind__neg__(t, [](VM* vm, PyVar obj) {
+        const PyVec& self = _CAST(PyVec&, obj);
+        size_t n = self.size();
+        PyVar ret = vm->new_user_object<PyVec>(n);
+        f64* __restrict out = _CAST(PyVec&, ret).data.data();
+        const f64* a = self.data.data();
+        for (size_t i = 0; i < n; i++) {
+            out[i] = -a[i];
+        }
+        return ret;
+    });
+
+    // elementwise arithmetic (vec op vec, vec op scalar)
+    vm->bind__add__(t, [](VM* vm, PyVar lhs, PyVar rhs) {
+        return pyvec_binary_op(vm, lhs, rhs, [](f64 a, f64 b) { return a + b; });
+    });
+    vm->bind__sub__(t, [](VM* vm, PyVar lhs, PyVar rhs) {
+        return pyvec_binary_op(vm, lhs, rhs, [](f64 a, f64 b) { return a - b; });
+    });
+    vm->bind__mul__(t, [](VM* vm, PyVar lhs, PyVar rhs) {
+        return pyvec_binary_op(vm, lhs, rhs, [](f64 a, f64 b) { return a * b; });
+    });
+    vm->bind__truediv__(t, [](VM* vm, PyVar lhs, PyVar rhs) {
+        return pyvec_binary_op(vm, lhs, rhs, [](f64 a, f64 b) { return a / b; });
+    });
+
+    // reflected arithmetic (scalar op vec)
+    vm->bind(type, "__radd__(self, other)", [](VM* vm, ArgsView args) {
+        return pyvec_binary_op(vm, args[0], args[1], [](f64 a, f64 b) { return a + b; }, true);
+    });
+    vm->bind(type, "__rsub__(self, other)", [](VM* vm, ArgsView args) {
+        return pyvec_binary_op(vm, args[0], args[1], [](f64 a, f64 b) { return a - b; }, true);
+    });
+    vm->bind(type, "__rmul__(self, other)", [](VM* vm, ArgsView args) {
+        return pyvec_binary_op(vm, args[0], args[1], [](f64 a, f64 b) { return a * b; }, true);
+    });
+    vm->bind(type, "__rtruediv__(self, other)", [](VM* vm, ArgsView args) {
+        return pyvec_binary_op(vm, args[0], args[1], [](f64 a, f64 b) { return a / b; }, true);
+    });
+
+    // pocketpy only falls back to reflected methods for + - *, and the
+    // int and float __truediv__ raise TypeError for a vec divisor, so
+    // `scalar / vec` is dispatched here (same result for numbers)
+    auto scalar_truediv = [](VM* vm, PyVar lhs, PyVar rhs) -> PyVar {
+        if (vm->is_user_type<PyVec>(rhs)) {
+            return pyvec_binary_op(vm, rhs, lhs, [](f64 a, f64 b) { return a / b; }, true);
+        }
+        return VAR(CAST_F(lhs) / CAST_F(rhs));
+    };
+    vm->bind__truediv__(VM::tp_float, scalar_truediv);
+    vm->bind__truediv__(VM::tp_int, scalar_truediv);
+
+    // reductions
+    vm->bind(type, "sum(self) -> float", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        return VAR(pyvec_sum(self.data.data(), self.size()));
+    });
+
+    vm->bind(type, "mean(self) -> float", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        if (self.size() == 0) {
+            vm->ValueError("mean() of empty vec");
+        }
+        return VAR(pyvec_sum(self.data.data(), self.size()) / self.size());
+    });
+
+    vm->bind(type, "min(self) -> float", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        if (self.size() == 0) {
+            vm->ValueError("min() of empty vec");
+        }
+        const f64* a = self.data.data();
+        f64 result = a[0];
+        for (size_t i = 1; i < self.size(); i++) {
+            result = a[i] < result ? a[i] : result;
+        }
+        return VAR(result);
+    });
+
+    vm->bind(type, "max(self) -> float", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        if (self.size() == 0) {
+            vm->ValueError("max() of empty vec");
+        }
+        const f64* a = self.data.data();
+        f64 result = a[0];
+        for (size_t i = 1; i < self.size(); i++) {
+            result = a[i] > result ? a[i] : result;
+        }
+        return VAR(result);
+    });
+
+    vm->bind(type, "dot(self, other: vec) -> float", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        const PyVec& other = py_cast<PyVec&>(vm, args[1]);
+        if (other.size() != self.size()) {
+            vm->ValueError("vec sizes do not match");
+        }
+        return VAR(pyvec_dot(self.data.data(), other.data.data(), self.size()));
+    });
+
+    // in-place helpers
+    vm->bind(type, "fill(self, value: float)", [](VM* vm, ArgsView args) {
+        PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        std::fill(self.data.begin(), self.data.end(), CAST_F(args[1]));
+        return vm->None;
+    });
+
+    vm->bind(type, "resize(self, n: int)", [](VM* vm, ArgsView args) {
+        PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        i64 n = py_cast<i64>(vm, args[1]);
+        if (n < 0) {
+            vm->ValueError("vec size must be >= 0");
+        }
+        self.data.resize((size_t)n, 0.0);
+        return vm->None;
+    });
+
+    // conversions
+    vm->bind(type, "copy(self) -> vec", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        return vm->new_user_object<PyVec>(self.data.data(), self.size());
+    });
+
+    vm->bind(type, "tolist(self) -> list", [](VM* vm, ArgsView args) {
+        const PyVec& self = _py_cast<PyVec&>(vm, args[0]);
+        List items(self.size());
+        for (size_t i = 0; i < self.size(); i++) {
+            items[i] = VAR(self.data[i]);
+        }
+        return VAR(std::move(items));
+    });
+}
+
+
 
 /**
  * @brief      This class describes a pocketpy interpreter,
@@ -66,6 +445,8 @@ public:
     t_symbol* source_name; //!< base name of python file to execfile
     t_symbol* source_path; //!< full path to python file to execfile
     short     path_code;    
+    t_object* owner;       //!< max object owning buffer~ references
+    t_metrics* metrics;    //!< per-message latency metrics (no GIL: gil is unused)
 
     PktpyInterpreter();
     ~PktpyInterpreter();
@@ -100,11 +481,13 @@ public:
     List atoms_to_plist_with_offset(long argc, t_atom* argv, int start_from);
     List atoms_to_plist(long argc, t_atom* argv);
     t_max_err plist_to_atoms(List seq, int* argc, t_atom** argv);
+    PyObject* atoms_to_pvec(long argc, t_atom* argv, int start_from);
     // Tuple atoms_to_ptuple(int argc, t_atom* argv);
 
     // python value -> atom -> outlet
     t_max_err handle_pyvar_output(PyObject* pval, void* outlet);
     t_max_err handle_plist_output(List plist, void* outlet);
+    t_max_err handle_pvec_output(const PyVec& vec, void* outlet);
     // t_max_err handle_dict_output(PyObject* pval, void* outlet);
 
     // core message method helpers
@@ -121,6 +504,7 @@ public:
     t_max_err exec2(t_symbol* s, long argc, t_atom* argv);
     t_max_err anything(t_symbol* s, long argc, t_atom* argv, void* outlet);
     t_max_err execfile(t_symbol* s);
+    t_max_err setvec(t_symbol* s, long argc, t_atom* argv);
 };
 
 // ---------------------------------------------------------------------------
@@ -136,6 +520,8 @@ PktpyInterpreter::PktpyInterpreter()
     this->source_name = gensym("");
     this->source_path = gensym("");
     this->path_code = 0;
+    this->owner = NULL;
+    this->metrics = metrics_new();
     this->loglevel = log_level::PY_LOG_LEVEL;
     this->_stdout = &::stdout_write;
     this->_stderr = &::stderr_write;
@@ -145,7 +531,11 @@ PktpyInterpreter::PktpyInterpreter()
 /**
  * @brief      PktpyInterpreter destructor method.
  */
-PktpyInterpreter::~PktpyInterpreter() { delete this; }
+PktpyInterpreter::~PktpyInterpreter()
+{
+    metrics_free(this->metrics);
+    delete this;
+}
 
 
 // ---------------------------------------------------------------------------
@@ -486,7 +876,7 @@ t_max_err PktpyInterpreter::pobject_to_atom(PyObject* value, t_atom* atom)
     }
 
     else if (is_type(value, this->tp_float)) {
-        double float_value = py_cast<float>(this, value);
+        double float_value = py_cast<f64>(this, value);
         atom_setfloat(atom, float_value);
     }
 
@@ -597,6 +987,31 @@ t_max_err PktpyInterpreter::plist_to_atoms(List plist, int* argc,
 }
 
 
+/**
+ * @brief Translates atom vector to a `dsp.vec` in a single pass, without
+ *        boxing each element as a pocketpy object
+ *
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param start_from index of vector to start from
+ *
+ * @return pocketpy vec object
+ */
+PyObject* PktpyInterpreter::atoms_to_pvec(long argc, t_atom* argv,
+                                          int start_from)
+{
+    long n = argc > start_from ? argc - start_from : 0;
+    PyObject* pvec = this->new_user_object<PyVec>((size_t)n);
+    f64* out = _py_cast<PyVec&>(this, pvec).data.data();
+
+    // atom_getfloat converts longs and returns 0 for symbols
+    for (long i = 0; i < n; i++) {
+        out[i] = atom_getfloat(argv + start_from + i);
+    }
+    return pvec;
+}
+
+
 // ---------------------------------------------------------------------------
 // output methods
 
@@ -635,14 +1050,14 @@ t_max_err PktpyInterpreter:: handle_plist_output(List plist, void* outlet)
 
     for (PyObject* obj : plist) {
         if (is_int(obj)) {
-            int int_obj = py_cast<int>(this, obj);
+            t_atom_long int_obj = py_cast<i64>(this, obj);
             atom_setlong(atoms + i, int_obj);
             this->log_debug((char*)"%d long: %ld\n", i, int_obj);
             i += 1;
         }
 
         if (is_float(obj)) {
-            float float_obj = py_cast<float>(this, obj);
+            double float_obj = py_cast<f64>(this, obj);
             atom_setfloat(atoms + i, float_obj);
             this->log_debug((char*)"%d float: %f\n", i, float_obj);
             i += 1;
@@ -669,6 +1084,37 @@ t_max_err PktpyInterpreter:: handle_plist_output(List plist, void* outlet)
 
 
 
+/**
+ * @brief Handler to output a `dsp.vec` as max list of floats
+ *
+ * @param vec pktpy vec
+ * @return t_max_err error code
+ */
+t_max_err PktpyInterpreter::handle_pvec_output(const PyVec& vec, void* outlet)
+{
+    t_atom atoms_static[PY_MAX_ELEMS];
+    t_atom* atoms = NULL;
+    long n = (long)vec.size();
+
+    if (n == 0) {
+        this->log_error((char*)"cannot convert vec of length 0 to atoms");
+        return MAX_ERR_GENERIC;
+    }
+
+    atoms = atom_dynamic_start(atoms_static, PY_MAX_ELEMS, n);
+
+    const f64* data = vec.data.data();
+    for (long i = 0; i < n; i++) {
+        atom_setfloat(atoms + i, data[i]);
+    }
+
+    outlet_list(outlet, NULL, n, atoms);
+    atom_dynamic_end(atoms_static, atoms);
+    return MAX_ERR_NONE;
+}
+
+
+
 /**
  * @brief Generic handler to output arbitrarily-typed python object as max
  * object
@@ -679,13 +1125,13 @@ t_max_err PktpyInterpreter:: handle_plist_output(List plist, void* outlet)
 t_max_err PktpyInterpreter::handle_pyvar_output(PyObject* pval, void* outlet)
 {
     if (is_float(pval)) {
-        float float_result = py_cast<float>(this, pval);
+        double float_result = py_cast<f64>(this, pval);
         outlet_float(outlet, float_result);
         return MAX_ERR_NONE;
     }
 
     else if (is_int(pval)) {
-        float long_result = py_cast<int>(this, pval);
+        t_atom_long long_result = py_cast<i64>(this, pval);
         outlet_int(outlet, long_result);
         return MAX_ERR_NONE;
     }
@@ -702,6 +1148,10 @@ t_max_err PktpyInterpreter::handle_pyvar_output(PyObject* pval, void* outlet)
         return handle_plist_output(plist, outlet);
     }
 
+    else if (this->is_user_type<PyVec>(pval)) {
+        return handle_pvec_output(_py_cast<PyVec&>(this, pval), outlet);
+    }
+
     // else if (PyDict_Check(pval)) {
     //     return this->handle_dict_output(outlet, pval);
     // }
@@ -731,19 +1181,23 @@ t_max_err PktpyInterpreter::handle_pyvar_output(PyObject* pval, void* outlet)
  */
 t_max_err PktpyInterpreter::eval_pcode(char* pcode, void* outlet)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EVAL);
+
     PyObject* result = this->exec(pcode, "<eval>", EVAL_MODE);
+    metrics_exec(&span);
 
     if (result != NULL) {
 
         this->log_debug((char*)"eval %s", pcode);
 
         if (is_type(result, this->tp_int)) {
-            int int_result = py_cast<int>(this, result);
+            t_atom_long int_result = py_cast<i64>(this, result);
             outlet_int(outlet, int_result);
         }
 
         else if (is_type(result, this->tp_float)) {
-            double float_result = py_cast<float>(this, result);
+            double float_result = py_cast<f64>(this, result);
             outlet_float(outlet, float_result);
         }
 
@@ -764,6 +1218,10 @@ t_max_err PktpyInterpreter::eval_pcode(char* pcode, void* outlet)
             // outlet_anything(outlet, gensym("list"), 0, (t_atom*)NIL);
         }
 
+        else if (this->is_user_type<PyVec>(result)) {
+            this->handle_pvec_output(_py_cast<PyVec&>(this, result), outlet);
+        }
+
         else if (is_type(result, this->tp_tuple)) {
             Tuple tuple_result = py_cast<Tuple>(this, result);
             outlet_anything(outlet, gensym("tuple"), 0, (t_atom*)NIL);
@@ -811,9 +1269,12 @@ t_max_err PktpyInterpreter::eval_pcode(char* pcode, void* outlet)
         else {
             this->log_debug((char*)"Type Check not Implemented");
         }
+        metrics_convert(&span);
+        metrics_end(this->metrics, &span, 1);
         return MAX_ERR_NONE;
     }
     this->log_error((char*)"eval %s", pcode);
+    metrics_end(this->metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -828,7 +1289,14 @@ t_max_err PktpyInterpreter::eval_pcode(char* pcode, void* outlet)
  */ 
 t_max_err PktpyInterpreter::exec_pcode(char* pcode)
 {
-    if (this->exec(pcode, "main.py", EXEC_MODE) == NULL) {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXEC);
+
+    PyObject* result = this->exec(pcode, "main.py", EXEC_MODE);
+    metrics_exec(&span);
+    metrics_end(this->metrics, &span, result != NULL);
+
+    if (result == NULL) {
         this->log_error((char*)"exec %s", pcode);            
         return MAX_ERR_GENERIC;
     }
@@ -850,11 +1318,16 @@ t_max_err PktpyInterpreter::execfile_path(char* path)
         return MAX_ERR_GENERIC;
     }
 
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXECFILE);
+
     std::string str_path(path);
     std::ifstream ifs(str_path);
     std::stringstream buffer;
     buffer << ifs.rdbuf();
-    this->exec(buffer.str(), "main.py", EXEC_MODE);
+    PyObject* result = this->exec(buffer.str(), "main.py", EXEC_MODE);
+    metrics_exec(&span);
+    metrics_end(this->metrics, &span, result != NULL);
 
     return MAX_ERR_NONE;
 }
@@ -899,17 +1372,24 @@ t_max_err PktpyInterpreter::eval_text_to_outlet(long argc, t_atom* argv, void* o
 {
     long textsize = 0;
     char* text = NULL;
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_ANYTHING);
 
     t_max_err err = atom_gettext(argc, argv, &textsize, &text,
                                  OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
     if (err == MAX_ERR_NONE && textsize && text) {
         this->log_debug((char*)">>> %s", text);
+        metrics_convert(&span);
         PyObject* pval = this->eval_text(text);
+        metrics_exec(&span);
         if (pval != NULL) {
             this->handle_pyvar_output(pval, outlet);
+            metrics_convert(&span);
+            metrics_end(this->metrics, &span, 1);
             return MAX_ERR_NONE;
         }
     }
+    metrics_end(this->metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -989,6 +1469,35 @@ t_max_err PktpyInterpreter::execfile(t_symbol* s)
 }
 
 
+/**
+ * @brief Bind a max list of numbers to a global `dsp.vec` variable
+ *
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (name: sym, values: float/int ...)
+ *
+ * @return t_max_err error code
+ */
+t_max_err PktpyInterpreter::setvec(t_symbol* s, long argc, t_atom* argv)
+{
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        this->log_error((char*)"vec: first arg must be a variable name");
+        return MAX_ERR_GENERIC;
+    }
+
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_ASSIGN);
+
+    t_symbol* varname = atom_getsym(argv);
+    PyObject* pvec = this->atoms_to_pvec(argc, argv, 1);
+    this->_main->attr().set(varname->s_name, pvec);
+
+    metrics_convert(&span);
+    metrics_end(this->metrics, &span, 1);
+    return MAX_ERR_NONE;
+}
+
+
 /**
  * @brief      Try to eval a string of python code, if it succeeds convert
  *             it to atoms and send it out the outlet, otherwise, try to exec it
@@ -1037,4 +1546,495 @@ t_max_err PktpyInterpreter::anything(t_symbol* s, long argc, t_atom* argv,
 }
 
 
+// ---------------------------------------------------------------------------
+// buffer~ and jit.matrix views
+//
+// `dsp.buffer(name, channel=0)` and `dsp.matrix(name, plane=0)` are views on
+// the memory of a named buffer~ (one channel) or jit.matrix (one plane).
+// Indexing and slicing read and write samples/cells in place. Each access
+// locks the memory for its duration unless the view is held with
+// `lock()`/`unlock()` or a `with` block.
+
+/**
+ * @brief      locked, flat window on buffer~ or jit.matrix memory, released
+ *             on destruction (also when a python error unwinds the stack)
+ */
+struct MaxSpan {
+    char* data = nullptr;           //!< base pointer
+    int length = 0;                 //!< number of elements in the view
+    long nchans = 1;                //!< buffer: interleaved channel count
+    long channel = 0;               //!< buffer: channel of the view
+    long plane = 0;                 //!< matrix: plane of the view
+    t_jit_matrix_info info;         //!< matrix: type, dims and strides
+    bool is_matrix = false;
+    t_buffer_obj* buffer = nullptr; //!< buffer to unlock on release
+    void* matrix = nullptr;         //!< matrix to unlock on release
+    long savelock = 0;              //!< previous matrix lock state
+    bool dirty = false;             //!< buffer samples were written
+
+    MaxSpan() { memset(&info, 0, sizeof(info)); }
+    MaxSpan(const MaxSpan&) = delete;
+    ~MaxSpan() { this->release(); }
+
+    void release()
+    {
+        if (this->buffer) {
+            buffer_unlocksamples(this->buffer);
+            if (this->dirty) {
+                buffer_setdirty(this->buffer);
+            }
+            this->buffer = nullptr;
+        }
+        if (this->matrix) {
+            jit_object_method(this->matrix, _jit_sym_lock, this->savelock);
+            this->matrix = nullptr;
+        }
+    }
+
+    char* cell(int index) const
+    {
+        char* p = this->data;
+        long rem = index;
+        for (long d = 0; d < this->info.dimcount; d++) {
+            p += (rem % this->info.dim[d]) * this->info.dimstride[d];
+            rem /= this->info.dim[d];
+        }
+        return p;
+    }
+
+    f64 get(int index) const
+    {
+        if (!this->is_matrix) {
+            return ((float*)this->data)[index * this->nchans + this->channel];
+        }
+        char* p = this->cell(index);
+        if (this->info.type == _jit_sym_char)
+            return ((unsigned char*)p)[this->plane];
+        if (this->info.type == _jit_sym_long)
+            return ((t_int32*)p)[this->plane];
+        if (this->info.type == _jit_sym_float32)
+            return ((float*)p)[this->plane];
+        return ((double*)p)[this->plane];
+    }
+
+    void set(int index, f64 value)
+    {
+        if (!this->is_matrix) {
+            ((float*)this->data)[index * this->nchans + this->channel] = (float)value;
+            this->dirty = true;
+            return;
+        }
+        char* p = this->cell(index);
+        if (this->info.type == _jit_sym_char)
+            ((unsigned char*)p)[this->plane] =
+                (unsigned char)(value < 0 ? 0 : value > 255 ? 255 : value);
+        else if (this->info.type == _jit_sym_long)
+            ((t_int32*)p)[this->plane] = (t_int32)value;
+        else if (this->info.type == _jit_sym_float32)
+            ((float*)p)[this->plane] = (float)value;
+        else
+            ((double*)p)[this->plane] = value;
+    }
+};
+
+
+/**
+ * @brief      view on one channel of a named buffer~, exposed as `dsp.buffer`
+ */
+struct PyBuffer {
+    t_buffer_ref* ref = nullptr;
+    t_symbol* name = nullptr;
+    long channel = 0;
+    t_buffer_obj* locked = nullptr; //!< non-null while held by `lock()`
+    float* samples = nullptr;       //!< samples of the held buffer
+
+    PyBuffer() {}
+    PyBuffer(const PyBuffer&) = delete;
+    ~PyBuffer()
+    {
+        this->unlock();
+        if (this->ref) {
+            object_free(this->ref);
+        }
+    }
+
+    void lock(VM* vm)
+    {
+        if (this->locked) return;
+        t_buffer_obj* buf = buffer_ref_getobject(this->ref);
+        if (buf == NULL) {
+            vm->ValueError(_S("buffer~ not found: ", this->name->s_name));
+        }
+        this->samples = buffer_locksamples(buf);
+        if (this->samples == NULL) {
+            vm->ValueError(_S("buffer~ could not be locked: ", this->name->s_name));
+        }
+        this->locked = buf;
+    }
+
+    void unlock()
+    {
+        if (this->locked) {
+            buffer_unlocksamples(this->locked);
+            buffer_setdirty(this->locked);
+            this->locked = nullptr;
+            this->samples = nullptr;
+        }
+    }
+
+    void acquire(VM* vm, MaxSpan& span)
+    {
+        t_buffer_obj* buf = this->locked ? this->locked : buffer_ref_getobject(this->ref);
+        if (buf == NULL) {
+            vm->ValueError(_S("buffer~ not found: ", this->name->s_name));
+        }
+        span.nchans = buffer_getchannelcount(buf);
+        if (this->channel >= span.nchans) {
+            vm->IndexError(_S("buffer~ channel out of range: ", this->name->s_name));
+        }
+        if (this->locked) {
+            span.data = (char*)this->samples; // released by `unlock()`
+        } else {
+            span.data = (char*)buffer_locksamples(buf);
+            if (span.data == NULL) {
+                vm->ValueError(_S("buffer~ could not be locked: ", this->name->s_name));
+            }
+            span.buffer = buf;
+        }
+        span.length = (int)buffer_getframecount(buf);
+        span.channel = this->channel;
+    }
+
+    static void _register(VM* vm, PyVar mod, PyVar type);
+};
+
+
+/**
+ * @brief      view on one plane of a named jit.matrix, exposed as `dsp.matrix`
+ */
+struct PyMatrix {
+    t_symbol* name = nullptr;
+    long plane = 0;
+    void* locked = nullptr;         //!< non-null while held by `lock()`
+    long savelock = 0;
+
+    PyMatrix() {}
+    PyMatrix(const PyMatrix&) = delete;
+    ~PyMatrix() { this->unlock(); }
+
+    void* find(VM* vm)
+    {
+        void* matrix = jit_object_findregistered(this->name);
+        if (matrix == NULL || !jit_object_method(matrix, _jit_sym_class_jit_matrix)) {
+            vm->ValueError(_S("jit.matrix not found: ", this->name->s_name));
+        }
+        return matrix;
+    }
+
+    void lock(VM* vm)
+    {
+        if (this->locked) return;
+        void* matrix = this->find(vm);
+        this->savelock = (long)jit_object_method(matrix, _jit_sym_lock, 1);
+        this->locked = matrix;
+    }
+
+    void unlock()
+    {
+        if (this->locked) {
+            jit_object_method(this->locked, _jit_sym_lock, this->savelock);
+            this->locked = nullptr;
+        }
+    }
+
+    void acquire(VM* vm, MaxSpan& span)
+    {
+        void* matrix = this->locked ? this->locked : this->find(vm);
+        if (!this->locked) {
+            span.savelock = (long)jit_object_method(matrix, _jit_sym_lock, 1);
+            span.matrix = matrix;
+        }
+        jit_object_method(matrix, _jit_sym_getinfo, &span.info);
+        jit_object_method(matrix, _jit_sym_getdata, &span.data);
+        if (span.data == NULL) {
+            vm->ValueError(_S("jit.matrix has no data: ", this->name->s_name));
+        }
+        if (this->plane >= span.info.planecount) {
+            vm->IndexError(_S("jit.matrix plane out of range: ", this->name->s_name));
+        }
+        span.length = 1;
+        for (long d = 0; d < span.info.dimcount; d++) {
+            span.length *= span.info.dim[d];
+        }
+        span.plane = this->plane;
+        span.is_matrix = true;
+    }
+
+    static void _register(VM* vm, PyVar mod, PyVar type);
+};
+
+
+/**
+ * @brief      Locks the memory of a `dsp.buffer` or `dsp.matrix` view
+ */
+static void max_span_acquire(VM* vm, PyVar obj, MaxSpan& span)
+{
+    if (vm->is_user_type<PyBuffer>(obj)) {
+        _CAST(PyBuffer&, obj).acquire(vm, span);
+    } else if (vm->is_user_type<PyMatrix>(obj)) {
+        _CAST(PyMatrix&, obj).acquire(vm, span);
+    } else {
+        vm->TypeError("expected a dsp.buffer or dsp.matrix");
+    }
+}
+
+
+/**
+ * @brief      Binds the indexing and bulk methods shared by `dsp.buffer`
+ *             and `dsp.matrix`
+ */
+template <typename T>
+void bind_max_view(VM* vm, PyVar type)
+{
+    Type t = PK_OBJ_GET(Type, type);
+
+    vm->bind__len__(t, [](VM* vm, PyVar obj) {
+        MaxSpan span;
+        max_span_acquire(vm, obj, span);
+        return (i64)span.length;
+    });
+
+    vm->bind__getitem__(t, [](VM* vm, PyVar _0, PyVar _1) {
+        MaxSpan span;
+        max_span_acquire(vm, _0, span);
+        i64 index;
+        if (try_cast_int(_1, &index)) {
+            index = vm->normalized_index(index, span.length);
+            return VAR(span.get((int)index));
+        }
+        if (is_type(_1, vm->tp_slice)) {
+            int start, stop, step;
+            vm->parse_int_slice(_CAST(Slice&, _1), span.length, start, stop, step);
+            List items;
+            PK_SLICE_LOOP(i, start, stop, step) items.push_back(VAR(span.get(i)));
+            return VAR(std::move(items));
+        }
+        vm->TypeError("indices must be integers or slices");
+        PK_UNREACHABLE()
+    });
+
+    vm->bind__setitem__(t, [](VM* vm, PyVar _0, PyVar _1, PyVar _2) {
+        MaxSpan span;
+        max_span_acquire(vm, _0, span);
+        i64 index;
+        if (try_cast_int(_1, &index)) {
+            index = vm->normalized_index(index, span.length);
+            span.set((int)index, CAST_F(_2));
+            return;
+        }
+        if (is_type(_1, vm->tp_slice)) {
+            int start, stop, step;
+            vm->parse_int_slice(_CAST(Slice&, _1), span.length, start, stop, step);
+            if (vm->is_user_type<PyVec>(_2) || is_type(_2, vm->tp_list)) {
+                PyVec values;
+                pyvec_assign(vm, values, _2);
+                size_t n = 0;
+                PK_SLICE_LOOP(i, start, stop, step) n++;
+                if (n != values.size()) {
+                    vm->ValueError("slice assignment size mismatch");
+                }
+                size_t j = 0;
+                PK_SLICE_LOOP(i, start, stop, step) span.set(i, values.data[j++]);
+            } else {
+                f64 value = CAST_F(_2);
+                PK_SLICE_LOOP(i, start, stop, step) span.set(i, value);
+            }
+            return;
+        }
+        vm->TypeError("indices must be integers or slices");
+    });
+
+    // explicit locking: `with view: ...` or `view.lock()` / `view.unlock()`
+    vm->bind(type, "lock(self)", [](VM* vm, ArgsView args) {
+        _py_cast<T&>(vm, args[0]).lock(vm);
+        return args[0];
+    });
+    vm->bind(type, "unlock(self)", [](VM* vm, ArgsView args) {
+        _py_cast<T&>(vm, args[0]).unlock();
+        return vm->None;
+    });
+    vm->bind(type, "__enter__(self)", [](VM* vm, ArgsView args) {
+        _py_cast<T&>(vm, args[0]).lock(vm);
+        return args[0];
+    });
+    vm->bind(type, "__exit__(self)", [](VM* vm, ArgsView args) {
+        _py_cast<T&>(vm, args[0]).unlock();
+        return vm->None;
+    });
+
+    vm->bind(type, "tolist(self) -> list", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        List items(span.length);
+        for (int i = 0; i < span.length; i++) {
+            items[i] = VAR(span.get(i));
+        }
+        return VAR(std::move(items));
+    });
+
+    vm->bind(type, "tovec(self) -> vec", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        PyVar ret = vm->new_user_object<PyVec>((size_t)span.length);
+        f64* out = _CAST(PyVec&, ret).data.data();
+        for (int i = 0; i < span.length; i++) {
+            out[i] = span.get(i);
+        }
+        return ret;
+    });
+
+    vm->bind(type, "fill(self, value: float)", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        f64 value = CAST_F(args[1]);
+        if (!span.is_matrix && span.nchans == 1) {
+            // contiguous mono buffer: plain loop
+            float* samples = (float*)span.data;
+            for (int i = 0; i < span.length; i++) {
+                samples[i] = (float)value;
+            }
+            span.dirty = true;
+        } else {
+            for (int i = 0; i < span.length; i++) {
+                span.set(i, value);
+            }
+        }
+        return vm->None;
+    });
+
+    // view.map(func): replaces each element x by func(x)
+    vm->bind(type, "map(self, func)", [](VM* vm, ArgsView args) {
+        PyVar func = args[1];
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        for (int i = 0; i < span.length; i++) {
+            PyVar result = vm->call(func, VAR(span.get(i)));
+            span.set(i, CAST_F(result));
+        }
+        return vm->None;
+    });
+
+    // view.copy(src): copies a vec, list, tuple, buffer or matrix (truncated
+    // to the shorter of the two) and returns the number of elements copied
+    vm->bind(type, "copy(self, src) -> int", [](VM* vm, ArgsView args) {
+        PyVar src = args[1];
+        int n = 0;
+        if (vm->is_user_type<PyBuffer>(src) || vm->is_user_type<PyMatrix>(src)) {
+            MaxSpan from;
+            max_span_acquire(vm, src, from);
+            MaxSpan to;
+            max_span_acquire(vm, args[0], to);
+            n = from.length < to.length ? from.length : to.length;
+            for (int i = 0; i < n; i++) {
+                to.set(i, from.get(i));
+            }
+        } else {
+            PyVec values;
+            pyvec_assign(vm, values, src);
+            MaxSpan to;
+            max_span_acquire(vm, args[0], to);
+            n = (int)values.size() < to.length ? (int)values.size() : to.length;
+            for (int i = 0; i < n; i++) {
+                to.set(i, values.data[i]);
+            }
+        }
+        return VAR(n);
+    });
+}
+
+
+void PyBuffer::_register(VM* vm, PyVar mod, PyVar type)
+{
+    // buffer(name, channel=0)
+    vm->bind(type, "__init__(self, name: str, channel: int = 0)", [](VM* vm, ArgsView args) {
+        PyBuffer& self = _py_cast<PyBuffer&>(vm, args[0]);
+        PktpyInterpreter* py = static_cast<PktpyInterpreter*>(vm);
+        if (py->owner == NULL) {
+            vm->ValueError("buffer(): no owner object");
+        }
+        self.name = gensym(py_cast<Str>(vm, args[1]).c_str());
+        self.channel = (long)py_cast<i64>(vm, args[2]);
+        if (self.channel < 0) {
+            vm->ValueError("buffer(): channel must be >= 0");
+        }
+        if (self.ref) {
+            self.unlock();
+            object_free(self.ref);
+        }
+        self.ref = buffer_ref_new(py->owner, self.name);
+        return vm->None;
+    });
+
+    vm->bind_property(type, "frames: int", [](VM* vm, ArgsView args) {
+        PyBuffer& self = _py_cast<PyBuffer&>(vm, args[0]);
+        t_buffer_obj* buf = buffer_ref_getobject(self.ref);
+        return VAR((i64)(buf ? buffer_getframecount(buf) : 0));
+    });
+
+    vm->bind_property(type, "channels: int", [](VM* vm, ArgsView args) {
+        PyBuffer& self = _py_cast<PyBuffer&>(vm, args[0]);
+        t_buffer_obj* buf = buffer_ref_getobject(self.ref);
+        return VAR((i64)(buf ? buffer_getchannelcount(buf) : 0));
+    });
+
+    vm->bind_property(type, "samplerate: float", [](VM* vm, ArgsView args) {
+        PyBuffer& self = _py_cast<PyBuffer&>(vm, args[0]);
+        t_buffer_obj* buf = buffer_ref_getobject(self.ref);
+        return VAR((f64)(buf ? buffer_getsamplerate(buf) : 0.0));
+    });
+
+    bind_max_view<PyBuffer>(vm, type);
+}
+
+
+void PyMatrix::_register(VM* vm, PyVar mod, PyVar type)
+{
+    // matrix(name, plane=0)
+    vm->bind(type, "__init__(self, name: str, plane: int = 0)", [](VM* vm, ArgsView args) {
+        PyMatrix& self = _py_cast<PyMatrix&>(vm, args[0]);
+        self.unlock();
+        self.name = gensym(py_cast<Str>(vm, args[1]).c_str());
+        self.plane = (long)py_cast<i64>(vm, args[2]);
+        if (self.plane < 0) {
+            vm->ValueError("matrix(): plane must be >= 0");
+        }
+        return vm->None;
+    });
+
+    vm->bind_property(type, "planecount: int", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        return VAR((i64)span.info.planecount);
+    });
+
+    vm->bind_property(type, "dim: tuple", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        Tuple dims((int)span.info.dimcount);
+        for (long d = 0; d < span.info.dimcount; d++) {
+            dims[d] = VAR((i64)span.info.dim[d]);
+        }
+        return VAR(std::move(dims));
+    });
+
+    vm->bind_property(type, "type: str", [](VM* vm, ArgsView args) {
+        MaxSpan span;
+        max_span_acquire(vm, args[0], span);
+        return VAR(Str(span.info.type->s_name));
+    });
+
+    bind_max_view<PyMatrix>(vm, type);
+}
+
+
 #endif /* PKTPY_INTERPRETER_H */
@@ -7,11 +7,22 @@
 
 #include "pktpy2_api.h"
 
+#include "../mamba/fnv1a.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
 // ----------------------------------------------------------------------------
 // globals
 
 t_class* pktpy2_class = NULL; // global pointer to object class
 
+// code cache counters (the cache is shared by all objects in the vm)
+static long pktpy2_cache_hits = 0;
+static long pktpy2_cache_misses = 0;
+static long pktpy2_cache_evictions = 0;
+static long pktpy2_cache_precompiled = 0;
+
 // ----------------------------------------------------------------------------
 // datastructure
 
@@ -44,6 +55,10 @@ struct t_pktpy2 {
                                 /// the code editor and 'globals' namespace
     t_bool p_autoload;          /// bool to autoload of p_code_filepath
 
+    // code cache
+    char p_cache;               /// reuse compiled code objects (default: on)
+    long p_stats[PKTPY2_STATS_SIZE]; /// snapshot of cache stats for the attr
+
     // outlet creation
     void* p_outlet_right;       /// right outlet to bang success
     void* p_outlet_middle;      /// middle outleet to bang error
@@ -69,7 +84,10 @@ void pktpy2_init(t_pktpy2* x)
     py_setglobal(py_name("add"), r0);
 
     // bind native module 'api'
-    api_module_initialize();
+    api_module_initialize((t_object*)x);
+
+    // compiled code cache
+    pktpy2_cache_init();
 }
 
 void ext_main(void* r)
@@ -85,6 +103,7 @@ void ext_main(void* r)
     class_addmethod(c, (method)pktpy2_eval,       "eval",       A_GIMME,   0);
     class_addmethod(c, (method)pktpy2_exec,       "exec",       A_GIMME,   0);
     class_addmethod(c, (method)pktpy2_execfile,   "execfile",   A_DEFSYM,  0);
+    class_addmethod(c, (method)pktpy2_precompile, "precompile", A_GIMME,   0);
 
     // code editor
     class_addmethod(c, (method)pktpy2_read,       "read",       A_DEFSYM,  0);
@@ -102,6 +121,16 @@ void ext_main(void* r)
     CLASS_ATTR_SAVE(c,      "name", 0);
     CLASS_ATTR_ACCESSORS(c, "name", pktpy2_name_get, pktpy2_name_set);
 
+    CLASS_ATTR_LABEL(c,     "cache", 0,  "cache compiled code");
+    CLASS_ATTR_CHAR(c,      "cache", 0,  t_pktpy2, p_cache);
+    CLASS_ATTR_STYLE(c,     "cache", 0,  "onoff");
+    CLASS_ATTR_BASIC(c,     "cache", 0);
+    CLASS_ATTR_SAVE(c,      "cache", 0);
+
+    CLASS_ATTR_LABEL(c,      "stats", 0, "code cache hits misses entries evictions precompiled");
+    CLASS_ATTR_LONG_ARRAY(c, "stats", ATTR_SET_OPAQUE_USER, t_pktpy2, p_stats, PKTPY2_STATS_SIZE);
+    CLASS_ATTR_ACCESSORS(c,  "stats", pktpy2_stats_get, NULL);
+
     class_register(CLASS_BOX, c);
     pktpy2_class = c;
 }
@@ -130,6 +159,9 @@ void* pktpy2_new(t_symbol* s, long argc, t_atom* argv)
         x->p_run_on_save = 0;
         x->p_run_on_close = 1;
 
+        // code cache
+        x->p_cache = 1;
+
         // create outlet(s)
         x->p_outlet_right = bangout((t_object*)x);
         x->p_outlet_middle = bangout((t_object*)x);
@@ -586,6 +618,236 @@ error:
 // }
 
 
+/*--------------------------------------------------------------------------*/
+/* Code cache */
+
+
+/**
+ * @brief Creates the module which keeps compiled code objects alive
+ *
+ * Code objects are stored in three dicts of a private module so that the
+ * pocketpy gc owns them: `exec` and `eval` are keyed by source string,
+ * `files` maps an absolute path to a `(code, hash, size)` tuple.
+ */
+void pktpy2_cache_init(void)
+{
+    py_GlobalRef mod = py_getmodule(PKTPY2_CACHE_MODULE);
+    if (mod != NULL) {
+        return;
+    }
+    mod = py_newmodule(PKTPY2_CACHE_MODULE);
+    py_newdict(py_emplacedict(mod, py_name("exec")));
+    py_newdict(py_emplacedict(mod, py_name("eval")));
+    py_newdict(py_emplacedict(mod, py_name("files")));
+
+    pktpy2_cache_hits = 0;
+    pktpy2_cache_misses = 0;
+    pktpy2_cache_evictions = 0;
+    pktpy2_cache_precompiled = 0;
+}
+
+
+/**
+ * @brief Returns one of the code cache dicts
+ *
+ * @param name one of `exec`, `eval` or `files`
+ * @return py_Ref dict or NULL if the cache is not initialized
+ */
+py_Ref pktpy2_cache_dict(const char* name)
+{
+    py_GlobalRef mod = py_getmodule(PKTPY2_CACHE_MODULE);
+    if (mod == NULL) {
+        return NULL;
+    }
+    return py_getdict(mod, py_name(name));
+}
+
+
+/**
+ * @brief Compiles a source string once, reusing the cached code object
+ *
+ * @param x pointer to object struct
+ * @param source python source
+ * @param mode EXEC_MODE or EVAL_MODE
+ * @return true on success with the code object in `py_retval()`
+ *
+ * The cache for a mode is reset when it holds PKTPY2_CACHE_SIZE entries,
+ * which bounds memory for messages with ever-changing source.
+ */
+bool pktpy2_compile(t_pktpy2* x, const char* source, enum py_CompileMode mode)
+{
+    const char* name = (mode == EVAL_MODE) ? "eval" : "exec";
+    py_Ref codes = x->p_cache ? pktpy2_cache_dict(name) : NULL;
+
+    if (codes != NULL) {
+        int found = py_dict_getitem_by_str(codes, source);
+        if (found == -1) {
+            return false;
+        }
+        if (found == 1) {
+            pktpy2_cache_hits++;
+            return true;
+        }
+    }
+
+    pktpy2_cache_misses++;
+    if (!py_compile(source, "<string>", mode, false)) {
+        return false;
+    }
+    if (codes == NULL) {
+        return true;
+    }
+
+    if (py_dict_len(codes) >= PKTPY2_CACHE_SIZE) {
+        pktpy2_cache_evictions += py_dict_len(codes);
+        codes = py_emplacedict(py_getmodule(PKTPY2_CACHE_MODULE), py_name(name));
+        py_newdict(codes);
+    }
+
+    py_StackRef code = py_pushtmp();
+    py_assign(code, py_retval());
+    bool ok = py_dict_setitem_by_str(codes, source, code);
+    py_assign(py_retval(), code);
+    py_pop();
+    return ok;
+}
+
+
+/**
+ * @brief Compiles a python file once, reusing the cached code object
+ *
+ * @param x pointer to object struct
+ * @param path absolute path of python file
+ * @return true on success with the code object in `py_retval()`
+ *
+ * The file is read on every call: a cached entry is reused while the
+ * FNV-1a hash and size of its source are unchanged, which unlike the mtime
+ * (whole seconds) also catches edits within the same second.
+ */
+bool pktpy2_compile_file(t_pktpy2* x, const char* path)
+{
+    struct stat st;
+    py_Ref files = x->p_cache ? pktpy2_cache_dict("files") : NULL;
+    char* source = NULL;
+    FILE* fhandle = NULL;
+    size_t nread = 0;
+    py_i64 hash = 0;
+
+    if (stat(path, &st) != 0) {
+        return py_exception(tp_OSError, "could not stat file: %s", path);
+    }
+
+    fhandle = fopen(path, "rb");
+    if (fhandle == NULL) {
+        return py_exception(tp_OSError, "could not open file: %s", path);
+    }
+    source = (char*)sysmem_newptr((long)st.st_size + 1);
+    if (source == NULL) {
+        fclose(fhandle);
+        return py_exception(tp_OSError, "could not allocate buffer for file: %s", path);
+    }
+    nread = fread(source, 1, (size_t)st.st_size, fhandle);
+    source[nread] = '\0';
+    fclose(fhandle);
+    hash = (py_i64)codecache_fnv1a(source, nread, CODECACHE_FNV_OFFSET);
+
+    if (files != NULL) {
+        int found = py_dict_getitem_by_str(files, path);
+        if (found == -1) {
+            sysmem_freeptr(source);
+            return false;
+        }
+        if (found == 1) {
+            py_Ref entry = py_retval();
+            if (py_toint(py_tuple_getitem(entry, 1)) == hash
+                && py_toint(py_tuple_getitem(entry, 2)) == (py_i64)nread) {
+                pktpy2_cache_hits++;
+                sysmem_freeptr(source);
+                py_assign(py_retval(), py_tuple_getitem(entry, 0));
+                return true;
+            }
+        }
+    }
+
+    pktpy2_cache_misses++;
+    bool ok = py_compile(source, path, EXEC_MODE, false);
+    sysmem_freeptr(source);
+    if (!ok || files == NULL) {
+        return ok;
+    }
+
+    py_StackRef entry = py_pushtmp();
+    py_newtuple(entry, 3);
+    py_assign(py_tuple_getitem(entry, 0), py_retval());
+    py_newint(py_tuple_getitem(entry, 1), hash);
+    py_newint(py_tuple_getitem(entry, 2), (py_i64)nread);
+    ok = py_dict_setitem_by_str(files, path, entry);
+    py_assign(py_retval(), py_tuple_getitem(entry, 0));
+    py_pop();
+    return ok;
+}
+
+
+/**
+ * @brief Runs a compiled code object in the main module
+ *
+ * @param code code object from pktpy2_compile or pktpy2_compile_file
+ * @param mode EXEC_MODE or EVAL_MODE (result in `py_retval()`)
+ * @return true on success
+ */
+bool pktpy2_run_code(py_Ref code, enum py_CompileMode mode)
+{
+    const char* func = (mode == EVAL_MODE) ? "eval" : "exec";
+    py_StackRef arg = py_pushtmp();
+    py_assign(arg, code);
+    bool ok = py_call(py_getbuiltin(py_name(func)), 1, arg);
+    py_pop();
+    return ok;
+}
+
+
+/**
+ * @brief Compiles python files into the code cache without running them
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector (file names)
+ * @return t_max_err error code
+ *
+ * Intended for startup (e.g. `loadbang` -> `precompile a.py b.py`) so that
+ * later `execfile` or `load` messages skip lexing and compiling.
+ */
+t_max_err pktpy2_precompile(t_pktpy2* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_max_err err = MAX_ERR_NONE;
+
+    for (long i = 0; i < argc; i++) {
+        if (atom_gettype(argv + i) != A_SYM) {
+            continue;
+        }
+        if (pktpy2_locate_path_from_symbol(x, atom_getsym(argv + i)) != MAX_ERR_NONE) {
+            err = MAX_ERR_GENERIC;
+            continue;
+        }
+        if (!pktpy2_compile_file(x, x->p_code_pathname)) {
+            py_printexc();
+            err = MAX_ERR_GENERIC;
+            continue;
+        }
+        pktpy2_cache_precompiled++;
+        object_post((t_object*)x, "precompiled: %s", x->p_code_pathname);
+    }
+
+    if (err == MAX_ERR_NONE) {
+        pktpy2_bang_success(x);
+    } else {
+        pktpy2_bang_failure(x);
+    }
+    return err;
+}
+
+
 /**
  * @brief Import a python module
  *
@@ -640,7 +902,8 @@ t_max_err pktpy2_exec(t_pktpy2* x, t_symbol* s, long argc, t_atom* argv)
         goto error;
     }
 
-    bool ok = py_exec(py_argv, "<string>", EXEC_MODE, NULL);
+    bool ok = pktpy2_compile(x, py_argv, EXEC_MODE)
+           && pktpy2_run_code(py_retval(), EXEC_MODE);
     if(!ok) goto error;
 
     pktpy2_bang_success(x);
@@ -668,7 +931,8 @@ t_max_err pktpy2_eval(t_pktpy2* x, t_symbol* s, long argc, t_atom* argv)
     char* py_argv = atom_getsym(argv)->s_name;
     object_post((t_object*)x, "%s %s", s->s_name, py_argv);
 
-    bool ok = py_eval(py_argv, NULL);
+    bool ok = pktpy2_compile(x, py_argv, EVAL_MODE)
+           && pktpy2_run_code(py_retval(), EVAL_MODE);
 
     if (ok) {
         py_GlobalRef retval = py_retval();
@@ -729,7 +993,8 @@ void pktpy2_run(t_pktpy2* x)
         // is empty string
         goto error;
 
-    bool ok = py_exec(*x->p_code, "<string>", EXEC_MODE, NULL);
+    bool ok = pktpy2_compile(x, *x->p_code, EXEC_MODE)
+           && pktpy2_run_code(py_retval(), EXEC_MODE);
     if(!ok) {
         goto error;
     }
@@ -768,9 +1033,6 @@ void pktpy2_load(t_pktpy2* x, t_symbol* s)
 t_max_err pktpy2_execfile(t_pktpy2* x, t_symbol* s)
 {
     t_max_err err;
-    t_filehandle fh = NULL;
-    t_handle p_code = sysmem_newhandle(0);
-    int code_size = 0;
 
     if (s != gensym("")) {
         // set x->p_code_filepath
@@ -788,14 +1050,8 @@ t_max_err pktpy2_execfile(t_pktpy2* x, t_symbol* s)
 
     // assume x->p_code_filepath has be been set without errors
 
-    err = path_opensysfile(x->p_code_filename, x->p_code_path, &fh, READ_PERM);
-    if (err == MAX_ERR_NONE) {
-        sysfile_readtextfile(fh, p_code, 0, TEXT_LB_UNIX | TEXT_NULL_TERMINATE);
-        sysfile_close(fh);
-        code_size = sysmem_handlesize(p_code);
-    }
-
-    bool ok = py_exec(*p_code, "<string>", EXEC_MODE, NULL);
+    bool ok = pktpy2_compile_file(x, x->p_code_pathname)
+           && pktpy2_run_code(py_retval(), EXEC_MODE);
     if(!ok) goto error;
 
     // success cleanup
@@ -883,7 +1139,8 @@ t_max_err pktpy2_edsave(t_pktpy2* x, char** text, long size)
 
         object_post((t_object*)x, "run-on-save activated");
 
-        bool ok = py_exec(*text, "<string>", EXEC_MODE, NULL);
+        bool ok = pktpy2_compile(x, *text, EXEC_MODE)
+               && pktpy2_run_code(py_retval(), EXEC_MODE);
         if(!ok) {
             goto error;
         }
@@ -980,6 +1237,36 @@ t_max_err pktpy2_name_set(t_pktpy2 *x, t_object *attr, long argc, t_atom *argv)
     return MAX_ERR_NONE;
 }
 
+t_max_err pktpy2_stats_get(t_pktpy2 *x, t_object *attr, long *argc, t_atom **argv)
+{
+    char alloc;
+    long entries = 0;
+    const char* names[] = {"exec", "eval", "files"};
+
+    for (int i = 0; i < 3; i++) {
+        py_Ref codes = pktpy2_cache_dict(names[i]);
+        if (codes != NULL) {
+            entries += py_dict_len(codes);
+        }
+    }
+
+    x->p_stats[0] = pktpy2_cache_hits;
+    x->p_stats[1] = pktpy2_cache_misses;
+    x->p_stats[2] = entries;
+    x->p_stats[3] = pktpy2_cache_evictions;
+    x->p_stats[4] = pktpy2_cache_precompiled;
+
+    if (argc && argv) {
+        if (atom_alloc_array(PKTPY2_STATS_SIZE, argc, argv, &alloc)) {
+            return MAX_ERR_OUT_OF_MEM;
+        }
+        for (int i = 0; i < PKTPY2_STATS_SIZE; i++) {
+            atom_setlong(*argv + i, x->p_stats[i]);
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
 
 /**
  * @brief Searches the Max filesystem context for a file given by a symbol
@@ -18,6 +18,9 @@
 // Constants
 
 #define PY_MAX_ELEMS 1024
+#define PKTPY2_CACHE_MODULE "__pktpy2_cache__" // holds compiled code objects
+#define PKTPY2_CACHE_SIZE 256   // max cached source strings per mode before reset
+#define PKTPY2_STATS_SIZE 5     // hits, misses, entries, evictions, precompiled
 #define ITER_SUCCESS 1
 #define ITER_STOP 0
 #define ITER_FAILURE (-1)
@@ -51,6 +54,7 @@ void pktpy2_init(t_pktpy2* x);
 
 t_max_err pktpy2_name_get(t_pktpy2 *x, t_object *attr, long *argc, t_atom **argv);
 t_max_err pktpy2_name_set(t_pktpy2 *x, t_object *attr, long argc, t_atom *argv);
+t_max_err pktpy2_stats_get(t_pktpy2 *x, t_object *attr, long *argc, t_atom **argv);
 
 // ----------------------------------------------------------------------------
 // Helpers
@@ -80,6 +84,16 @@ t_max_err pktpy2_handle_list_output(t_pktpy2* x, py_GlobalRef plist);
 t_max_err pktpy2_handle_tuple_output(t_pktpy2* x, py_GlobalRef ptuple);
 t_max_err pktpy2_handle_output(t_pktpy2* x, py_GlobalRef retval);
 
+// ----------------------------------------------------------------------------
+// Code Cache
+
+void pktpy2_cache_init(void);
+py_Ref pktpy2_cache_dict(const char* name);
+bool pktpy2_compile(t_pktpy2* x, const char* source, enum py_CompileMode mode);
+bool pktpy2_compile_file(t_pktpy2* x, const char* path);
+bool pktpy2_run_code(py_Ref code, enum py_CompileMode mode);
+t_max_err pktpy2_precompile(t_pktpy2* x, t_symbol* s, long argc, t_atom* argv);
+
 // ----------------------------------------------------------------------------
 // Core Python Methods
 
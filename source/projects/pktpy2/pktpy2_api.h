@@ -9,6 +9,10 @@
 // max api
 #include "ext.h"
 #include "ext_obex.h"
+#include "ext_buffer.h"
+
+// jitter api
+#include "jit.common.h"
 
 // pocketpy
 #include "pocketpy.h"
@@ -236,6 +240,663 @@ static bool Person__set_age(int argc, py_Ref argv) {
 // }
 
 
+// ----------------------------------------------------------------------------
+// Buffer and Matrix views
+//
+// `api.Buffer(name, channel=0)` and `api.Matrix(name, plane=0)` are views on
+// the memory of a named buffer~ (one channel) or jit.matrix (one plane).
+// Indexing and slicing read and write the samples/cells in place. Every
+// access locks the memory for its duration, unless the view is held
+// locked with `lock()`/`unlock()` or a `with` block.
+
+static t_object* api_owner = NULL; /// object owning the buffer~ references
+
+typedef struct t_api_span t_api_span;
+
+/// a locked, flat, double-valued window on buffer~ or jit.matrix memory
+struct t_api_span {
+    char* data;                 /// base pointer
+    int length;                 /// number of elements in the view
+    double (*get)(t_api_span* span, int index);
+    void (*set)(t_api_span* span, int index, double value);
+    long nchans;                /// buffer: number of interleaved channels
+    long channel;               /// buffer: channel of the view
+    long plane;                 /// matrix: plane of the view
+    t_jit_matrix_info info;     /// matrix: type, dims and strides
+    t_buffer_obj* buffer;       /// buffer to unlock on release (if any)
+    void* matrix;               /// matrix to unlock on release (if any)
+    long savelock;              /// previous matrix lock state
+    bool dirty;                 /// buffer samples were written
+};
+
+typedef struct t_buffer_view {
+    t_buffer_ref* ref;
+    t_symbol* name;
+    long channel;
+    t_buffer_obj* locked;       /// non-NULL while held by `lock()`
+    float* samples;             /// samples of the held buffer
+} t_buffer_view;
+
+typedef struct t_matrix_view {
+    t_symbol* name;
+    long plane;
+    void* locked;               /// non-NULL while held by `lock()`
+    long savelock;
+} t_matrix_view;
+
+static py_Type tp_api_buffer;
+static py_Type tp_api_matrix;
+
+// element accessors
+
+static double api_buffer_get(t_api_span* span, int index)
+{
+    return ((float*)span->data)[index * span->nchans + span->channel];
+}
+
+static void api_buffer_set(t_api_span* span, int index, double value)
+{
+    ((float*)span->data)[index * span->nchans + span->channel] = (float)value;
+    span->dirty = true;
+}
+
+static char* api_matrix_cell(t_api_span* span, int index)
+{
+    char* p = span->data;
+    long rem = index;
+    for (long d = 0; d < span->info.dimcount; d++) {
+        p += (rem % span->info.dim[d]) * span->info.dimstride[d];
+        rem /= span->info.dim[d];
+    }
+    return p;
+}
+
+static double api_matrix_get(t_api_span* span, int index)
+{
+    char* p = api_matrix_cell(span, index);
+    t_symbol* type = span->info.type;
+
+    if (type == _jit_sym_char)
+        return ((unsigned char*)p)[span->plane];
+    if (type == _jit_sym_long)
+        return ((t_int32*)p)[span->plane];
+    if (type == _jit_sym_float32)
+        return ((float*)p)[span->plane];
+    return ((double*)p)[span->plane];
+}
+
+static void api_matrix_set(t_api_span* span, int index, double value)
+{
+    char* p = api_matrix_cell(span, index);
+    t_symbol* type = span->info.type;
+
+    if (type == _jit_sym_char)
+        ((unsigned char*)p)[span->plane] =
+            (unsigned char)(value < 0 ? 0 : value > 255 ? 255 : value);
+    else if (type == _jit_sym_long)
+        ((t_int32*)p)[span->plane] = (t_int32)value;
+    else if (type == _jit_sym_float32)
+        ((float*)p)[span->plane] = (float)value;
+    else
+        ((double*)p)[span->plane] = value;
+}
+
+// locking
+
+static void api_span_release(t_api_span* span);
+
+static bool api_buffer_acquire(t_buffer_view* self, t_api_span* span)
+{
+    memset(span, 0, sizeof(t_api_span));
+
+    t_buffer_obj* buf = self->locked ? self->locked : buffer_ref_getobject(self->ref);
+    if (buf == NULL) {
+        return ValueError("buffer~ '%s' not found", self->name->s_name);
+    }
+
+    span->nchans = buffer_getchannelcount(buf);
+    if (self->channel >= span->nchans) {
+        return IndexError("buffer~ '%s' has %ld channels", self->name->s_name,
+                          span->nchans);
+    }
+
+    if (self->locked) {
+        span->data = (char*)self->samples; // released by `unlock()`
+    } else {
+        span->data = (char*)buffer_locksamples(buf);
+        if (span->data == NULL) {
+            return ValueError("buffer~ '%s' could not be locked", self->name->s_name);
+        }
+        span->buffer = buf;
+    }
+
+    span->length = (int)buffer_getframecount(buf);
+    span->channel = self->channel;
+    span->get = api_buffer_get;
+    span->set = api_buffer_set;
+    return true;
+}
+
+static bool api_matrix_acquire(t_matrix_view* self, t_api_span* span)
+{
+    memset(span, 0, sizeof(t_api_span));
+
+    void* matrix = self->locked ? self->locked : jit_object_findregistered(self->name);
+    if (matrix == NULL || !jit_object_method(matrix, _jit_sym_class_jit_matrix)) {
+        return ValueError("jit.matrix '%s' not found", self->name->s_name);
+    }
+
+    if (!self->locked) {
+        span->savelock = (long)jit_object_method(matrix, _jit_sym_lock, 1);
+        span->matrix = matrix;
+    }
+    jit_object_method(matrix, _jit_sym_getinfo, &span->info);
+    jit_object_method(matrix, _jit_sym_getdata, &span->data);
+
+    if (span->data == NULL) {
+        api_span_release(span);
+        return ValueError("jit.matrix '%s' has no data", self->name->s_name);
+    }
+
+    if (self->plane >= span->info.planecount) {
+        api_span_release(span);
+        return IndexError("jit.matrix '%s' has %ld planes", self->name->s_name,
+                          span->info.planecount);
+    }
+
+    span->length = 1;
+    for (long d = 0; d < span->info.dimcount; d++) {
+        span->length *= span->info.dim[d];
+    }
+    span->plane = self->plane;
+    span->get = api_matrix_get;
+    span->set = api_matrix_set;
+    return true;
+}
+
+static bool api_span_acquire(py_Ref obj, t_api_span* span)
+{
+    if (py_istype(obj, tp_api_buffer))
+        return api_buffer_acquire(py_touserdata(obj), span);
+    if (py_istype(obj, tp_api_matrix))
+        return api_matrix_acquire(py_touserdata(obj), span);
+    return TypeError("expected a Buffer or Matrix");
+}
+
+static void api_span_release(t_api_span* span)
+{
+    // views held by `lock()` are released by `unlock()`
+    if (span->buffer) {
+        buffer_unlocksamples(span->buffer);
+        if (span->dirty) {
+            buffer_setdirty(span->buffer);
+        }
+    }
+    if (span->matrix) {
+        jit_object_method(span->matrix, _jit_sym_lock, span->savelock);
+    }
+}
+
+// indexing
+
+static bool api_parse_slice(py_Ref slice, int length, int* start, int* stop, int* step)
+{
+    py_Ref s_start = py_getslot(slice, 0);
+    py_Ref s_stop = py_getslot(slice, 1);
+    py_Ref s_step = py_getslot(slice, 2);
+
+    *step = py_isnone(s_step) ? 1 : (int)py_toint(s_step);
+    if (*step == 0) {
+        return ValueError("slice step cannot be zero");
+    }
+
+    int lower = *step < 0 ? -1 : 0;
+    int upper = *step < 0 ? length - 1 : length;
+
+    if (py_isnone(s_start)) {
+        *start = *step < 0 ? upper : lower;
+    } else {
+        *start = (int)py_toint(s_start);
+        if (*start < 0) *start += length;
+        *start = *start < lower ? lower : *start > upper ? upper : *start;
+    }
+
+    if (py_isnone(s_stop)) {
+        *stop = *step < 0 ? lower : upper;
+    } else {
+        *stop = (int)py_toint(s_stop);
+        if (*stop < 0) *stop += length;
+        *stop = *stop < lower ? lower : *stop > upper ? upper : *stop;
+    }
+    return true;
+}
+
+static int api_slice_len(int start, int stop, int step)
+{
+    if (step > 0)
+        return stop > start ? (stop - start + step - 1) / step : 0;
+    return start > stop ? (start - stop - step - 1) / (-step) : 0;
+}
+
+static bool api_span_getitem(t_api_span* span, py_Ref key)
+{
+    if (py_isint(key)) {
+        py_i64 index = py_toint(key);
+        if (index < 0) index += span->length;
+        if (index < 0 || index >= span->length) {
+            return IndexError("index %d out of range", (int)py_toint(key));
+        }
+        py_newfloat(py_retval(), span->get(span, (int)index));
+        return true;
+    }
+
+    if (py_istype(key, tp_slice)) {
+        int start, stop, step;
+        if (!api_parse_slice(key, span->length, &start, &stop, &step)) return false;
+        int n = api_slice_len(start, stop, step);
+        py_newlistn(py_retval(), n);
+        for (int i = 0; i < n; i++) {
+            py_newfloat(py_list_getitem(py_retval(), i),
+                        span->get(span, start + i * step));
+        }
+        return true;
+    }
+    return TypeError("indices must be integers or slices");
+}
+
+static bool api_span_setitem(t_api_span* span, py_Ref key, py_Ref value)
+{
+    py_f64 number;
+
+    if (py_isint(key)) {
+        py_i64 index = py_toint(key);
+        if (index < 0) index += span->length;
+        if (index < 0 || index >= span->length) {
+            return IndexError("index %d out of range", (int)py_toint(key));
+        }
+        if (!py_castfloat(value, &number)) return false;
+        span->set(span, (int)index, number);
+        return true;
+    }
+
+    if (py_istype(key, tp_slice)) {
+        int start, stop, step;
+        if (!api_parse_slice(key, span->length, &start, &stop, &step)) return false;
+        int n = api_slice_len(start, stop, step);
+
+        if (py_islist(value) || py_istuple(value)) {
+            bool is_list = py_islist(value);
+            int len = is_list ? py_list_len(value) : py_tuple_len(value);
+            if (len != n) {
+                return ValueError("slice assignment of %d items to %d", len, n);
+            }
+            for (int i = 0; i < n; i++) {
+                py_Ref item = is_list ? py_list_getitem(value, i)
+                                      : py_tuple_getitem(value, i);
+                if (!py_castfloat(item, &number)) return false;
+                span->set(span, start + i * step, number);
+            }
+            return true;
+        }
+
+        if (!py_castfloat(value, &number)) return false;
+        for (int i = 0; i < n; i++) {
+            span->set(span, start + i * step, number);
+        }
+        return true;
+    }
+    return TypeError("indices must be integers or slices");
+}
+
+// shared methods: argv[0] is a Buffer or Matrix
+
+static bool api_view__len__(int argc, py_Ref argv)
+{
+    t_api_span span;
+    PY_CHECK_ARGC(1);
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    py_newint(py_retval(), span.length);
+    api_span_release(&span);
+    return true;
+}
+
+static bool api_view__getitem__(int argc, py_Ref argv)
+{
+    t_api_span span;
+    PY_CHECK_ARGC(2);
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    bool ok = api_span_getitem(&span, py_arg(1));
+    api_span_release(&span);
+    return ok;
+}
+
+static bool api_view__setitem__(int argc, py_Ref argv)
+{
+    t_api_span span;
+    PY_CHECK_ARGC(3);
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    bool ok = api_span_setitem(&span, py_arg(1), py_arg(2));
+    api_span_release(&span);
+    if (ok) py_newnone(py_retval());
+    return ok;
+}
+
+static bool api_view_tolist(int argc, py_Ref argv)
+{
+    t_api_span span;
+    PY_CHECK_ARGC(1);
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    py_newlistn(py_retval(), span.length);
+    for (int i = 0; i < span.length; i++) {
+        py_newfloat(py_list_getitem(py_retval(), i), span.get(&span, i));
+    }
+    api_span_release(&span);
+    return true;
+}
+
+static bool api_view_fill(int argc, py_Ref argv)
+{
+    t_api_span span;
+    py_f64 value;
+    PY_CHECK_ARGC(2);
+    if (!py_castfloat(py_arg(1), &value)) return false;
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+
+    if (span.buffer && span.nchans == 1) {
+        // contiguous mono buffer: plain loop
+        float* samples = (float*)span.data;
+        for (int i = 0; i < span.length; i++) {
+            samples[i] = (float)value;
+        }
+        span.dirty = true;
+    } else {
+        for (int i = 0; i < span.length; i++) {
+            span.set(&span, i, value);
+        }
+    }
+    api_span_release(&span);
+    py_newnone(py_retval());
+    return true;
+}
+
+/// view.map(func): replaces each element x by func(x)
+static bool api_view_map(int argc, py_Ref argv)
+{
+    t_api_span span;
+    py_f64 number;
+    bool ok = true;
+    PY_CHECK_ARGC(2);
+    if (!py_callable(py_arg(1))) {
+        return TypeError("map() expects a callable");
+    }
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+
+    py_Ref func = py_pushtmp();
+    py_assign(func, py_arg(1));
+    py_Ref item = py_pushtmp();
+
+    for (int i = 0; i < span.length && ok; i++) {
+        py_newfloat(item, span.get(&span, i));
+        ok = py_call(func, 1, item) && py_castfloat(py_retval(), &number);
+        if (ok) span.set(&span, i, number);
+    }
+    py_pop();
+    py_pop();
+    api_span_release(&span);
+    if (ok) py_newnone(py_retval());
+    return ok;
+}
+
+/// view.copy(src): copies a list, tuple, Buffer or Matrix (truncated to the
+/// shorter of the two) and returns the number of elements copied
+static bool api_view_copy(int argc, py_Ref argv)
+{
+    t_api_span dst, src;
+    py_f64 number;
+    bool ok = true;
+    int n;
+    PY_CHECK_ARGC(2);
+    py_Ref source = py_arg(1);
+
+    if (py_islist(source) || py_istuple(source)) {
+        bool is_list = py_islist(source);
+        if (!api_span_acquire(py_arg(0), &dst)) return false;
+        n = is_list ? py_list_len(source) : py_tuple_len(source);
+        n = n < dst.length ? n : dst.length;
+        for (int i = 0; i < n && ok; i++) {
+            py_Ref item = is_list ? py_list_getitem(source, i) : py_tuple_getitem(source, i);
+            ok = py_castfloat(item, &number);
+            if (ok) dst.set(&dst, i, number);
+        }
+        api_span_release(&dst);
+    } else {
+        if (!api_span_acquire(source, &src)) return false;
+        if (!api_span_acquire(py_arg(0), &dst)) {
+            api_span_release(&src);
+            return false;
+        }
+        n = src.length < dst.length ? src.length : dst.length;
+        for (int i = 0; i < n; i++) {
+            dst.set(&dst, i, src.get(&src, i));
+        }
+        api_span_release(&dst);
+        api_span_release(&src);
+    }
+    if (ok) py_newint(py_retval(), n);
+    return ok;
+}
+
+// Buffer
+
+static void Buffer__dtor(void* ud)
+{
+    t_buffer_view* self = (t_buffer_view*)ud;
+    if (self->locked) {
+        buffer_unlocksamples(self->locked);
+        buffer_setdirty(self->locked);
+        self->locked = NULL;
+        self->samples = NULL;
+    }
+    if (self->ref) {
+        object_free(self->ref);
+        self->ref = NULL;
+    }
+}
+
+static bool Buffer__new__(int argc, py_Ref argv)
+{
+    t_buffer_view* self = py_newobject(py_retval(), py_totype(argv), 0,
+                                       sizeof(t_buffer_view));
+    memset(self, 0, sizeof(t_buffer_view));
+    return true;
+}
+
+static bool Buffer__init__(int argc, py_Ref argv)
+{
+    // Buffer(name: str, channel: int = 0)
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    if (api_owner == NULL) {
+        return ValueError("Buffer(): no owner object");
+    }
+    long channel = (long)py_toint(py_arg(2));
+    if (channel < 0) {
+        return ValueError("Buffer(): channel must be >= 0");
+    }
+    // __init__ may be called again on a live object: unlock and release
+    // the previous buffer reference first
+    Buffer__dtor(self);
+    self->name = gensym(py_tostr(py_arg(1)));
+    self->channel = channel;
+    self->ref = buffer_ref_new(api_owner, self->name);
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Buffer_lock(int argc, py_Ref argv)
+{
+    PY_CHECK_ARGC(1);
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    if (self->locked == NULL) {
+        t_buffer_obj* buf = buffer_ref_getobject(self->ref);
+        if (buf == NULL) {
+            return ValueError("buffer~ '%s' not found", self->name->s_name);
+        }
+        self->samples = buffer_locksamples(buf);
+        if (self->samples == NULL) {
+            return ValueError("buffer~ '%s' could not be locked", self->name->s_name);
+        }
+        self->locked = buf;
+    }
+    py_assign(py_retval(), py_arg(0)); // returned for `with`
+    return true;
+}
+
+static bool Buffer_unlock(int argc, py_Ref argv)
+{
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    if (self->locked) {
+        buffer_unlocksamples(self->locked);
+        buffer_setdirty(self->locked);
+        self->locked = NULL;
+        self->samples = NULL;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Buffer__frames(int argc, py_Ref argv)
+{
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    t_buffer_obj* buf = buffer_ref_getobject(self->ref);
+    py_newint(py_retval(), buf ? buffer_getframecount(buf) : 0);
+    return true;
+}
+
+static bool Buffer__channels(int argc, py_Ref argv)
+{
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    t_buffer_obj* buf = buffer_ref_getobject(self->ref);
+    py_newint(py_retval(), buf ? buffer_getchannelcount(buf) : 0);
+    return true;
+}
+
+static bool Buffer__samplerate(int argc, py_Ref argv)
+{
+    t_buffer_view* self = py_touserdata(py_arg(0));
+    t_buffer_obj* buf = buffer_ref_getobject(self->ref);
+    py_newfloat(py_retval(), buf ? buffer_getsamplerate(buf) : 0.0);
+    return true;
+}
+
+// Matrix
+
+static void Matrix__dtor(void* ud)
+{
+    t_matrix_view* self = (t_matrix_view*)ud;
+    if (self->locked) {
+        jit_object_method(self->locked, _jit_sym_lock, self->savelock);
+        self->locked = NULL;
+    }
+}
+
+static bool Matrix__new__(int argc, py_Ref argv)
+{
+    t_matrix_view* self = py_newobject(py_retval(), py_totype(argv), 0,
+                                       sizeof(t_matrix_view));
+    memset(self, 0, sizeof(t_matrix_view));
+    return true;
+}
+
+static bool Matrix__init__(int argc, py_Ref argv)
+{
+    // Matrix(name: str, plane: int = 0)
+    t_matrix_view* self = py_touserdata(py_arg(0));
+    PY_CHECK_ARG_TYPE(1, tp_str);
+    PY_CHECK_ARG_TYPE(2, tp_int);
+    self->name = gensym(py_tostr(py_arg(1)));
+    self->plane = (long)py_toint(py_arg(2));
+    if (self->plane < 0) {
+        return ValueError("Matrix(): plane must be >= 0");
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Matrix_lock(int argc, py_Ref argv)
+{
+    PY_CHECK_ARGC(1);
+    t_matrix_view* self = py_touserdata(py_arg(0));
+    if (self->locked == NULL) {
+        void* matrix = jit_object_findregistered(self->name);
+        if (matrix == NULL || !jit_object_method(matrix, _jit_sym_class_jit_matrix)) {
+            return ValueError("jit.matrix '%s' not found", self->name->s_name);
+        }
+        self->savelock = (long)jit_object_method(matrix, _jit_sym_lock, 1);
+        self->locked = matrix;
+    }
+    py_assign(py_retval(), py_arg(0)); // returned for `with`
+    return true;
+}
+
+static bool Matrix_unlock(int argc, py_Ref argv)
+{
+    t_matrix_view* self = py_touserdata(py_arg(0));
+    if (self->locked) {
+        jit_object_method(self->locked, _jit_sym_lock, self->savelock);
+        self->locked = NULL;
+    }
+    py_newnone(py_retval());
+    return true;
+}
+
+static bool Matrix__planecount(int argc, py_Ref argv)
+{
+    t_api_span span;
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    py_newint(py_retval(), span.info.planecount);
+    api_span_release(&span);
+    return true;
+}
+
+static bool Matrix__dim(int argc, py_Ref argv)
+{
+    t_api_span span;
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    py_newtuple(py_retval(), (int)span.info.dimcount);
+    for (long d = 0; d < span.info.dimcount; d++) {
+        py_newint(py_tuple_getitem(py_retval(), (int)d), span.info.dim[d]);
+    }
+    api_span_release(&span);
+    return true;
+}
+
+static bool Matrix__type(int argc, py_Ref argv)
+{
+    t_api_span span;
+    if (!api_span_acquire(py_arg(0), &span)) return false;
+    py_newstr(py_retval(), span.info.type->s_name);
+    api_span_release(&span);
+    return true;
+}
+
+static void api_bind_view(py_Type type)
+{
+    py_bindmagic(type, __len__, api_view__len__);
+    py_bindmagic(type, __getitem__, api_view__getitem__);
+    py_bindmagic(type, __setitem__, api_view__setitem__);
+    py_bindmagic(type, __exit__, type == tp_api_buffer ? Buffer_unlock : Matrix_unlock);
+    py_bindmagic(type, __enter__, type == tp_api_buffer ? Buffer_lock : Matrix_lock);
+    py_bindmethod(type, "lock", type == tp_api_buffer ? Buffer_lock : Matrix_lock);
+    py_bindmethod(type, "unlock", type == tp_api_buffer ? Buffer_unlock : Matrix_unlock);
+    py_bindmethod(type, "tolist", api_view_tolist);
+    py_bindmethod(type, "fill", api_view_fill);
+    py_bindmethod(type, "map", api_view_map);
+    py_bindmethod(type, "copy", api_view_copy);
+}
+
+
 // ----------------------------------------------------------------------------
 // utils
 
@@ -261,8 +922,9 @@ static bool print_args(int argc, py_Ref argv) {
 // ----------------------------------------------------------------------------
 // initialize
 
-bool api_module_initialize(void) {
+bool api_module_initialize(t_object* owner) {
     py_GlobalRef mod = py_newmodule("api");
+    api_owner = owner;
     py_bindfunc(mod, "post", api_post);
     py_bindfunc(mod, "error", api_error);
 
@@ -274,6 +936,22 @@ bool api_module_initialize(void) {
     py_bindproperty(type, "id", Person__id, Person__set_id);
     py_bindproperty(type, "age", Person__age, Person__set_age);
 
+    tp_api_buffer = py_newtype("Buffer", tp_object, mod, Buffer__dtor);
+    py_bindmagic(tp_api_buffer, __new__, Buffer__new__);
+    py_bind(py_tpobject(tp_api_buffer), "__init__(self, name, channel=0)", Buffer__init__);
+    py_bindproperty(tp_api_buffer, "frames", Buffer__frames, NULL);
+    py_bindproperty(tp_api_buffer, "channels", Buffer__channels, NULL);
+    py_bindproperty(tp_api_buffer, "samplerate", Buffer__samplerate, NULL);
+    api_bind_view(tp_api_buffer);
+
+    tp_api_matrix = py_newtype("Matrix", tp_object, mod, Matrix__dtor);
+    py_bindmagic(tp_api_matrix, __new__, Matrix__new__);
+    py_bind(py_tpobject(tp_api_matrix), "__init__(self, name, plane=0)", Matrix__init__);
+    py_bindproperty(tp_api_matrix, "planecount", Matrix__planecount, NULL);
+    py_bindproperty(tp_api_matrix, "dim", Matrix__dim, NULL);
+    py_bindproperty(tp_api_matrix, "type", Matrix__type, NULL);
+    api_bind_view(tp_api_matrix);
+
     // py_Type type = py_newtype("Atom", tp_object, mod, NULL);
     // py_bindmagic(type, __new__, Atom__new__);
     // py_bind(type, "__new__(cls, *args, **kw)", Atom__new__);
@@ -21,8 +21,11 @@ subcommands:
     pyjs         build pyjs externals
     python       download and build python from src
     test         run all tests
+    trace        trace imports to compute a minimal stdlib
 
 """
+import sys
+
 from . import utils
 from .cli import Commander, option, option_group
 from .ext.relocatable_python import relocatable_options, fix_framework
@@ -32,6 +35,7 @@ from .factory import FactoryManager
 from .package import PackageManager
 from .config import Project
 from .install import Installer
+from .trace import ImportTracer, TraceError
 
 # ----------------------------------------------------------------------------
 # Commandline interface
@@ -53,7 +57,8 @@ common_options = option_group(
     option("-z", "--ziplib", action="store_true", help="zip python library"),
     option("--dump", action="store_true", help="dump project and product vars"),
     option("--release", action="store_true", help="set configuration to release"),
-    option("--precompile", action="store_true", help="use precompiled bytecode in zipped stdlib")
+    option("--precompile", action="store_true", help="use precompiled bytecode in zipped stdlib"),
+    option("--trace-manifest", type=str, help="also strip modules unused in trace manifest")
 )
 
 # combined_options = common_options + relocatable_options
@@ -364,6 +369,23 @@ class Application(Commander):
         installer.install_numpy()
 
 
+    # ----------------------------------------------------------------------------
+    # import tracing methods
+
+    @option("-e", "--executable", required=True, help="python executable to trace with")
+    @option("-l", "--lib", required=True, help="stdlib dir of executable (lib/pythonX.Y)")
+    @option("-k", "--keep", nargs="+", default=[], metavar="NAME", help="never strip these")
+    @option("-o", "--output", default="trace.json", help="manifest output path")
+    @option("scripts", nargs="+", metavar="SCRIPT", help="scripts or patches to trace")
+    def do_trace(self, args):
+        """trace imports to compute a minimal stdlib"""
+        tracer = ImportTracer(args.executable, args.lib, args.scripts, args.keep)
+        try:
+            tracer.write_manifest(args.output)
+        except TraceError as e:
+            tracer.log.error("trace failed, no manifest written: %s", e)
+            sys.exit(1)
+
     # ----------------------------------------------------------------------------
     # utility methods
 
@@ -69,6 +69,7 @@ from .config import (
 from .depend import DependencyManager
 from .ext.relocatable_python import download_relocatable_to
 from .shell import ShellCmd
+from .trace import load_manifest
 
 logging.basicConfig(format=LOG_FORMAT, level=LOG_LEVEL)
 
@@ -846,6 +847,17 @@ class PythonBuilder(Builder):
         """remove list of non-critical executables"""
         self.rm_bins(self.product.DEFAULT_BINS_TO_RM)
 
+    def remove_untraced(self, manifest_path):
+        """remove packages and extensions not found by an import trace
+
+        see `builder.trace.ImportTracer` for how the manifest is produced.
+        """
+        manifest = load_manifest(manifest_path)
+        done_pkgs = self.product.DEFAULT_PKGS_TO_RM
+        done_exts = self.product.DEFAULT_EXTS_TO_RM
+        self.rm_libs(n for n in manifest["pkgs_to_rm"] if n not in done_pkgs)
+        self.rm_exts(n for n in manifest["exts_to_rm"] if n not in done_exts)
+
     def write_python_getpip(self):
         """optionally provide latets pip to binary"""
         with open(f"{self.prefix}/bin/get_pip.sh", encoding="utf8") as txtfile:
@@ -876,6 +888,10 @@ class PythonBuilder(Builder):
         self.remove_extensions()
         self.remove_binaries()
 
+        trace_manifest = getattr(self.settings, "trace_manifest", None)
+        if trace_manifest:
+            self.remove_untraced(trace_manifest)
+
     def ziplib(self):
         """zip python package in site-packages in .zip archive"""
         if self.settings.precompile or getenv("PRECOMPILE"):
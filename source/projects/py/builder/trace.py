@@ -0,0 +1,361 @@
+"""trace: derive minimal stdlib and extension sets by import tracing.
+
+Runs a set of representative python scripts (or the python code referenced
+by max patches) under the target python executable, records every module
+that ends up in `sys.modules`, and computes which top-level stdlib entries
+and `lib-dynload` extensions were never touched. The result is written to a
+json manifest which `PythonBuilder.clean` can consume (`--trace-manifest`)
+in addition to the hand-maintained `Product.DEFAULT_PKGS_TO_RM` and
+`Product.DEFAULT_EXTS_TO_RM` lists.
+
+    % python3 -m builder trace -e <python> -l <python_lib> script.py patch.maxpat
+
+Like the rest of the builder, this only uses the standard library.
+"""
+
+import ast
+import json
+import logging
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+from textwrap import dedent
+from typing import Dict, Iterable, List, Optional, Set, Union
+
+from .config import LOG_FORMAT, LOG_LEVEL
+
+Pathlike = Union[str, Path]
+
+logging.basicConfig(format=LOG_FORMAT, level=LOG_LEVEL)
+
+
+class TraceError(Exception):
+    """a traced script failed: the trace is incomplete and must not be used"""
+
+
+# the prelude loaded into every `py` object (source of `py_prelude.h`): the
+# traced interpreter runs it before the scripts, so that its imports are
+# part of every trace.
+PRELUDE = Path(__file__).resolve().parent.parent / "py_prelude.new.py"
+
+# modules which must survive stripping even if a trace never imports them
+# (interpreter bootstrap and error reporting).
+ESSENTIAL_MODULES = set(
+    [
+        "__future__",
+        "_collections_abc",
+        "_sitebuiltins",
+        "abc",
+        "codecs",
+        "encodings",
+        "genericpath",
+        "io",
+        "linecache",
+        "os",
+        "posixpath",
+        "site",
+        "stat",
+        "traceback",
+        "types",
+        "lib-dynload",
+        "site-packages",
+    ]
+)
+
+# injected into the traced interpreter: runs the prelude (second argument)
+# and each script, then dumps the loaded modules (as a python literal) to
+# the path given as first argument. It only uses builtins, so that its own
+# imports (which would otherwise be json and runpy) do not end up in the
+# trace.
+TRACE_BOOTSTRAP = dedent(
+    """
+    import sys
+    out, prelude, scripts = sys.argv[1], sys.argv[2], sys.argv[3:]
+    errors = {}
+    for script in [prelude] + scripts:
+        name = "__main__" if script != prelude else "py_prelude"
+        try:
+            with open(script, "rb") as f:
+                code = compile(f.read(), script, "exec")
+            sys.argv[:] = [script]
+            exec(code, {"__name__": name, "__file__": script,
+                        "__builtins__": __builtins__})
+        except SystemExit as e:
+            if e.code not in (None, 0):
+                errors[script] = repr(e)
+        except BaseException as e:
+            errors[script] = repr(e)
+    modules = {}
+    for name, mod in list(sys.modules.items()):
+        modules[name] = getattr(mod, "__file__", None)
+    with open(out, "w") as f:
+        f.write(repr(dict(modules=modules, errors=errors,
+                          builtins=list(sys.builtin_module_names))))
+    """
+)
+
+# `import x`, `import x.y`, `from x import y` message or code lines
+RE_IMPORT = re.compile(r"^\s*(?:from\s+([\w\.]+)\s+import|import\s+([\w\., ]+))")
+
+
+class ImportTracer:
+    """Computes the transitive module closure of a set of scripts.
+
+    executable: the python interpreter to trace with (usually the built one)
+    python_lib: stdlib directory of that interpreter (e.g. lib/python3.12)
+    scripts: python scripts or max patches (.maxpat/.maxhelp) to trace
+    keep: extra top-level names which should never be stripped
+    """
+
+    def __init__(
+        self,
+        executable: Pathlike,
+        python_lib: Pathlike,
+        scripts: Iterable[Pathlike],
+        keep: Optional[Iterable[str]] = None,
+    ):
+        self.executable = str(executable)
+        self.python_lib = Path(python_lib)
+        # absolute, since the traced interpreter runs in a temporary folder
+        self.scripts = [Path(os.path.abspath(s)) for s in scripts]
+        self.keep = ESSENTIAL_MODULES | set(keep or [])
+        self.modules: Dict[str, Optional[str]] = {}
+        self.errors: Dict[str, str] = {}
+        self.log = logging.getLogger(self.__class__.__name__)
+
+    def __str__(self):
+        return f"<{self.__class__.__name__}:{len(self.scripts)} scripts>"
+
+    # ------------------------------------------------------------------------
+    # script collection
+
+    def imports_from_code(self, code: str) -> List[str]:
+        """extract imported module names from lines of python code"""
+        names = []
+        for line in code.splitlines():
+            match = RE_IMPORT.match(line)
+            if not match:
+                continue
+            if match.group(1):
+                names.append(match.group(1))
+            else:
+                for name in match.group(2).split(","):
+                    name = name.strip().split(" ")[0]
+                    if name:
+                        names.append(name)
+        return names
+
+    def script_from_patch(self, patch: Path, tmpdir: Path) -> Path:
+        """convert a max patch to a traceable script
+
+        Collects the `import` messages, `@file` attributes and embedded
+        code of all boxes in the patch (recursively into subpatchers).
+        """
+        with open(patch, encoding="utf8") as f:
+            data = json.load(f)
+
+        lines = []
+
+        def visit(patcher):
+            for entry in patcher.get("boxes", []):
+                box = entry.get("box", {})
+                text = box.get("text", "")
+                if text:
+                    lines.extend(
+                        f"import {name}" for name in self.imports_from_code(text)
+                    )
+                    match = re.search(r"@file\s+(\S+)", text)
+                    if match:
+                        pyfile = patch.parent / match.group(1)
+                        if pyfile.exists():
+                            lines.append(f"exec(open({str(pyfile)!r}).read())")
+                if "patcher" in box:
+                    visit(box["patcher"])
+
+        visit(data.get("patcher", {}))
+        script = tmpdir / f"{patch.stem}_trace.py"
+        script.write_text("\n".join(lines) + "\n", encoding="utf8")
+        return script
+
+    def collect_scripts(self, tmpdir: Path) -> List[str]:
+        """normalize scripts and patches into a list of runnable scripts"""
+        result = []
+        for script in self.scripts:
+            if not script.exists():
+                raise TraceError(f"script not found: {script}")
+            if script.suffix in (".maxpat", ".maxhelp"):
+                result.append(str(self.script_from_patch(script, tmpdir)))
+            else:
+                result.append(str(script))
+        return result
+
+    # ------------------------------------------------------------------------
+    # tracing
+
+    def trace(self) -> Dict[str, Optional[str]]:
+        """run all scripts in the traced interpreter and collect modules
+
+        Raises `TraceError` if the interpreter or any script fails, since
+        stripping by an incomplete trace would remove modules in use.
+        """
+        with tempfile.TemporaryDirectory() as tmp:
+            tmpdir = Path(tmp)
+            out = tmpdir / "modules.txt"
+            scripts = self.collect_scripts(tmpdir)
+            self.log.info("tracing %d scripts with %s", len(scripts), self.executable)
+            proc = subprocess.run(
+                [self.executable, "-c", TRACE_BOOTSTRAP, str(out), str(PRELUDE)]
+                + scripts,
+                cwd=str(tmpdir),
+            )
+            if proc.returncode != 0 or not out.exists():
+                raise TraceError(
+                    f"traced interpreter exited with {proc.returncode}"
+                )
+            result = ast.literal_eval(out.read_text(encoding="utf8"))
+        if result["errors"]:
+            for script, err in result["errors"].items():
+                self.log.error("%s raised %s", script, err)
+            raise TraceError(f"{len(result['errors'])} scripts failed")
+        self.modules = result["modules"]
+        self.errors = result["errors"]
+        return self.modules
+
+    @property
+    def toplevel(self) -> Set[str]:
+        """top-level names of all traced modules"""
+        return set(name.split(".")[0] for name in self.modules)
+
+    # ------------------------------------------------------------------------
+    # closure
+
+    def stdlib_entries(self) -> Dict[str, Path]:
+        """map of top-level stdlib names to their files or folders"""
+        entries = {}
+        for entry in self.python_lib.iterdir():
+            if entry.is_dir():
+                entries[entry.name] = entry
+            elif entry.suffix in (".py", ".pyc"):
+                entries[entry.stem] = entry
+        return entries
+
+    def extension_entries(self) -> Dict[str, Path]:
+        """map of extension module names to their lib-dynload files"""
+        dynload = self.python_lib / "lib-dynload"
+        if not dynload.exists():
+            return {}
+        return {entry.name.split(".")[0]: entry for entry in dynload.glob("*.so")}
+
+    def unused_packages(self) -> Set[str]:
+        """stdlib entry names (as `rm_libs` expects them) never imported"""
+        used = self.toplevel | self.keep
+        return set(
+            path.name
+            for name, path in self.stdlib_entries().items()
+            if name not in used and not name.startswith("config-")
+        )
+
+    def unused_extensions(self) -> Set[str]:
+        """extension names (as `rm_exts` expects them) never imported"""
+        used = set(self.modules) | self.keep
+        return set(name for name in self.extension_entries() if name not in used)
+
+    # ------------------------------------------------------------------------
+    # reporting
+
+    @staticmethod
+    def size_of(path: Path) -> int:
+        """size in bytes of a file or folder"""
+        if path.is_file():
+            return path.stat().st_size
+        return sum(f.stat().st_size for f in path.rglob("*") if f.is_file())
+
+    def startup_time(self, repeat: int = 5) -> Dict[str, float]:
+        """median cumulative import time (us) of the traced module set
+
+        Uses `-X importtime`, so it measures imports only, not script
+        execution.
+        """
+        names = sorted(n for n in self.toplevel if n.isidentifier())
+        code = "\n".join(f"try: import {n}\nexcept: pass" for n in names)
+        totals = []
+        for _ in range(repeat):
+            proc = subprocess.run(
+                [self.executable, "-X", "importtime", "-c", code],
+                capture_output=True,
+                text=True,
+                check=False,
+            )
+            total = 0
+            for line in proc.stderr.splitlines():
+                # import time: self [us] | cumulative | imported package
+                fields = line.split("|")
+                if line.startswith("import time:") and len(fields) == 3:
+                    selftime = fields[0].split(":")[1].strip()
+                    if selftime.isdigit():
+                        total += int(selftime)
+            totals.append(total)
+        return {"median_us": statistics.median(totals), "runs": repeat}
+
+    def report(self) -> Dict:
+        """size and startup-time report of the stripped vs full stdlib"""
+        stdlib = self.stdlib_entries()
+        exts = self.extension_entries()
+        pkgs_rm = self.unused_packages()
+        exts_rm = self.unused_extensions()
+        size_full = sum(self.size_of(p) for p in stdlib.values())
+        size_rm = sum(self.size_of(self.python_lib / n) for n in pkgs_rm)
+        size_rm += sum(self.size_of(exts[n]) for n in exts_rm)
+        return {
+            "scripts": [str(s) for s in self.scripts],
+            "modules": len(self.modules),
+            "stdlib_entries": len(stdlib),
+            "extensions": len(exts),
+            "pkgs_to_rm": len(pkgs_rm),
+            "exts_to_rm": len(exts_rm),
+            "size_full": size_full,
+            "size_stripped": size_full - size_rm,
+            "startup": self.startup_time(),
+        }
+
+    def write_manifest(self, path: Pathlike) -> Dict:
+        """trace (if needed) and write a json manifest used by the builder"""
+        if not self.modules:
+            self.trace()
+        manifest = {
+            "modules": sorted(self.modules),
+            "pkgs_to_rm": sorted(self.unused_packages()),
+            "exts_to_rm": sorted(self.unused_extensions()),
+            "report": self.report(),
+        }
+        with open(path, "w", encoding="utf8") as f:
+            json.dump(manifest, f, indent=4)
+        rep = manifest["report"]
+        self.log.info(
+            "stripped: %d pkgs, %d exts, %.1f MB -> %.1f MB, imports %.1f ms",
+            rep["pkgs_to_rm"],
+            rep["exts_to_rm"],
+            rep["size_full"] / 1e6,
+            rep["size_stripped"] / 1e6,
+            rep["startup"]["median_us"] / 1e3,
+        )
+        return manifest
+
+
+def load_manifest(path: Pathlike) -> Dict:
+    """load a trace manifest written by `ImportTracer.write_manifest`"""
+    with open(path, encoding="utf8") as f:
+        return json.load(f)
+
+
+if __name__ == "__main__":
+    tracer = ImportTracer(sys.executable, Path(os.__file__).parent, sys.argv[1:])
+    try:
+        tracer.write_manifest("trace.json")
+    except TraceError as e:
+        tracer.log.error("trace failed, no manifest written: %s", e)
+        sys.exit(1)
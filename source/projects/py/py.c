@@ -20,10 +20,55 @@ static t_hashtab* py_global_registry = NULL; // global object lookups
 
 static uintptr_t py_global_obj_ref = 0;
 
+static PyObject* py_global_code_cache = NULL; // path -> (hash, size, code)
+
+// bumped when bound globals are reassigned or modules are reloaded, which
+// invalidates cached callables of `bind` and dotted names of `call`
+static unsigned long py_global_epoch = 0;
+
+#if PY_HAVE_DICT_WATCHER
+static int py_global_watcher_id = -1;         // watches object globals
+static PyObject* py_global_bound_keys = NULL; // root names of bound callables
+static int py_bind_watcher(PyDict_WatchEvent event, PyObject* dict,
+                           PyObject* key, PyObject* new_value);
+#endif
+
 /*--------------------------------------------------------------------------*/
 /* Datastructures */
 
 
+/**
+ * @brief Cached parse of a (possibly dotted) name of a python callable
+ */
+typedef struct {
+    PyObject* key;           /*!< interned root name, e.g. 'math' of 'math.sqrt' */
+    PyObject* attrs;         /*!< tuple of interned attribute names after the root or NULL */
+} t_py_lookup;
+
+/**
+ * @brief Message name bound to a python callable via `bind`
+ */
+struct t_py_binding {
+    t_symbol* target;        /*!< (dotted) name of the callable */
+    PyObject* func;          /*!< cached callable or NULL */
+    unsigned long epoch;     /*!< py_global_epoch when func was resolved */
+};
+
+
+/**
+ * @brief Python call scheduled by `sched` or `every`
+ */
+typedef struct {
+    long id;                 /*!< handle output on scheduling, used by `cancel` */
+    double due;              /*!< logical scheduler time to fire at (ms) */
+    double due_wall;         /*!< system time expected at firing (ms), for jitter */
+    double period;           /*!< repeat interval (ms), 0 for a one-shot call */
+    t_py_binding binding;    /*!< callable, re-resolved like `bind` */
+    long argc;
+    t_atom* argv;            /*!< call arguments (owned) */
+} t_py_task;
+
+
 struct t_py {
     /* object header */
     t_object p_ob;                /*!< object header */
@@ -39,15 +84,38 @@ struct t_py {
     struct {
         t_symbol* pythonpath;    /*!< path to python directory */
         t_bool debug;            /*!< bool to switch per-object debug state */
+        t_bool cache;            /*!< bool to switch bytecode caching of files */
         PyObject* globals;       /*!< per object 'globals' python namespace */
+        t_hashtab* lookups;      /*!< symbol -> t_py_lookup name resolution cache */
+        t_hashtab* bindings;     /*!< message symbol -> t_py_binding via `bind` */
+        t_bool watched;          /*!< globals watched while there are bindings */
+        t_metrics* metrics;      /*!< per-message latency metrics */
+        t_memstats* memstats;    /*!< memory allocated by this object */
     } python;
 
     /* time-based ops */
     struct {
-        void* clock;              /*!< a clock in case of scheduled ops */
-        t_atomarray* sched_data;  /*!< atomarray for scheduled python function call */
+        void* clock;              /*!< set to the due time of the earliest task */
+        t_py_task* tasks;         /*!< binary min-heap of pending tasks by due time */
+        long count;               /*!< number of pending tasks */
+        long capacity;            /*!< allocated task slots */
+        long next_id;             /*!< handle of the next scheduled task */
+        long fired;               /*!< number of tasks fired */
+        long batches;             /*!< number of clock ticks which fired tasks */
+        long batch_max;           /*!< most tasks fired in one tick */
+        double jitter_last;       /*!< actual - expected fire time of last task (ms) */
+        double jitter_sum;        /*!< sum of jitter, for the mean */
+        double jitter_max;        /*!< largest jitter (ms) */
     } scheduler;
 
+    /* hot-reload */
+    struct {
+        t_bool autoreload;        /*!< reload tracked modules when their files change */
+        PyObject* modules;        /*!< tracked user modules: name -> file mtime (ns) */
+        t_hashtab* watchers;      /*!< module file path -> filewatcher */
+        void* clock;              /*!< debounces file change notifications */
+    } reload;
+
     /* text editor attrs */
     struct {
         t_object* code_editor;   /*!< code editor object */
@@ -66,6 +134,7 @@ struct t_py {
     } editor;
 
     /* outlet creation */
+    void* p_outlet_sched;       /*!< rightmost outlet for scheduled task handles */
     void* p_outlet_right;       /*!< right outlet to bang success */
     void* p_outlet_middle;      /*!< middle outleet to bang error */
     void* p_outlet_left;        /*!< left outleet for msg output  */
@@ -110,10 +179,12 @@ void ext_main(void* module_ref)
     class_addmethod(c, (method)py_eval,       "eval",       A_GIMME,   0);
     class_addmethod(c, (method)py_exec,       "exec",       A_GIMME,   0);
     class_addmethod(c, (method)py_execfile,   "execfile",   A_DEFSYM,  0);
+    class_addmethod(c, (method)py_reload,     "reload",     A_NOTHING, 0);
 
     // core extra
     class_addmethod(c, (method)py_apply,      "apply",      A_GIMME,   0);
     class_addmethod(c, (method)py_assign,     "assign",     A_GIMME,   0);
+    class_addmethod(c, (method)py_bind,       "bind",       A_GIMME,   0);
     class_addmethod(c, (method)py_call,       "call",       A_GIMME,   0);
     class_addmethod(c, (method)py_code,       "code",       A_GIMME,   0);
     class_addmethod(c, (method)py_pipe,       "pipe",       A_GIMME,   0);
@@ -124,11 +195,17 @@ void ext_main(void* module_ref)
 
     // time-based
     class_addmethod(c, (method)py_sched,      "sched",      A_GIMME,   0);
+    class_addmethod(c, (method)py_every,      "every",      A_GIMME,   0);
+    class_addmethod(c, (method)py_cancel,     "cancel",     A_GIMME,   0);
 
     // meta
     class_addmethod(c, (method)py_assist,     "assist",     A_CANT,    0);
     class_addmethod(c, (method)py_metadata,   "info",                  0);
     class_addmethod(c, (method)py_count,      "count",      A_NOTHING, 0);
+    class_addmethod(c, (method)py_metrics,    "metrics",    A_GIMME,   0);
+    class_addmethod(c, (method)py_trace,      "trace",      A_GIMME,   0);
+    class_addmethod(c, (method)py_profile,    "profile",    A_GIMME,   0);
+    class_addmethod(c, (method)py_memory,     "memory",     A_GIMME,   0);
     class_addmethod(c, (method)py_get,        "get",        A_DEFSYM,  0);
 
     // interobject
@@ -144,6 +221,9 @@ void ext_main(void* module_ref)
     class_addmethod(c, (method)py_run,        "run",        A_NOTHING, 0);
     class_addmethod(c, (method)py_okclose,    "okclose",    A_CANT,    0);
 
+    // hot-reload
+    class_addmethod(c, (method)py_filechanged, "filechanged", A_CANT,  0);
+
     // datastructure helpers
     class_addmethod(c, (method)py_appendtodict, "appendtodictionary",  A_CANT, 0);
 
@@ -186,6 +266,18 @@ void ext_main(void* module_ref)
     CLASS_ATTR_BASIC(c,     "debug", 0);
     CLASS_ATTR_SAVE(c,      "debug", 0);
 
+    CLASS_ATTR_LONG(c,      "cache", 0,  t_py, python.cache);
+    CLASS_ATTR_STYLE(c,     "cache", 0, "onoff");
+    CLASS_ATTR_DEFAULT(c,   "cache", 0,     "1");
+    CLASS_ATTR_BASIC(c,     "cache", 0);
+    CLASS_ATTR_SAVE(c,      "cache", 0);
+
+    CLASS_ATTR_LONG(c,      "autoreload", 0,  t_py, reload.autoreload);
+    CLASS_ATTR_STYLE(c,     "autoreload", 0, "onoff");
+    CLASS_ATTR_DEFAULT(c,   "autoreload", 0,     "0");
+    CLASS_ATTR_BASIC(c,     "autoreload", 0);
+    CLASS_ATTR_SAVE(c,      "autoreload", 0);
+
     CLASS_ATTR_ORDER(c,     "name",         0,  "1");
     CLASS_ATTR_ORDER(c,     "file",         0,  "2");
     CLASS_ATTR_ORDER(c,     "autoload",     0,  "3");
@@ -193,6 +285,8 @@ void ext_main(void* module_ref)
     CLASS_ATTR_ORDER(c,     "run_on_close", 0,  "5");
     CLASS_ATTR_ORDER(c,     "pythonpath",   0,  "6");
     CLASS_ATTR_ORDER(c,     "debug",        0,  "7");
+    CLASS_ATTR_ORDER(c,     "cache",        0,  "8");
+    CLASS_ATTR_ORDER(c,     "autoreload",   0,  "9");
 
     // clang-format on
     //------------------------------------------------------------------------
@@ -261,11 +355,45 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
         // set default debug level
         x->python.debug = 0;
 
+        // bytecode caching of execfile / load / autoload
+        x->python.cache = 1;
+
+        // name resolution cache of call / pipe / fold
+        x->python.lookups = hashtab_new(0);
+        hashtab_flags(x->python.lookups, OBJ_FLAG_DATA);
+
+        // message name -> callable bindings
+        x->python.bindings = hashtab_new(0);
+        hashtab_flags(x->python.bindings, OBJ_FLAG_DATA);
+
+        // latency metrics of the python messages
+        x->python.metrics = metrics_new();
+
+        // memory allocated by the python code of this object
+        x->python.memstats = memstats_new(x->obj.name);
+
         // clocked tasks
         x->scheduler.clock = clock_new((t_object*)x, (method)py_task);
-        x->scheduler.sched_data = NULL;
+        x->scheduler.tasks = NULL;
+        x->scheduler.count = 0;
+        x->scheduler.capacity = 0;
+        x->scheduler.next_id = 1;
+        x->scheduler.fired = 0;
+        x->scheduler.batches = 0;
+        x->scheduler.batch_max = 0;
+        x->scheduler.jitter_last = 0.0;
+        x->scheduler.jitter_sum = 0.0;
+        x->scheduler.jitter_max = 0.0;
+
+        // hot-reload of tracked modules
+        x->reload.autoreload = 0;
+        x->reload.modules = NULL;
+        x->reload.watchers = hashtab_new(0);
+        hashtab_flags(x->reload.watchers, OBJ_FLAG_OBJ);
+        x->reload.clock = clock_new((t_object*)x, (method)py_reload_task);
 
         // create outlet(s)
+        x->p_outlet_sched = outlet_new(x, NULL);
         x->p_outlet_right = bangout((t_object*)x);
         x->p_outlet_middle = bangout((t_object*)x);
         x->p_outlet_left = outlet_new(x, NULL);
@@ -288,8 +416,11 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
             error("could not set scripting name to box");
         }
 
-        // initialize python interpreter
+        // initialize python interpreter (which installs the accounting
+        // allocator), allocations from here on (including autoload) are
+        // accounted to this object
         py_init(x);
+        memstats_enter(x->python.memstats);
 
         post("initialized python version: %s", PY_VERSION);
 
@@ -327,6 +458,7 @@ void* py_new(t_symbol* s, long argc, t_atom* argv)
 
         // process @arg attributes
         attr_args_process(x, argc, argv);
+        memstats_leave();
     }
     return (x);
 }
@@ -382,6 +514,9 @@ void py_init(t_py* x)
     config.isolated = PY_CFG_ISOLATED; // default is disabled
     config.home = python_home;
 
+    // accounting allocator (when enabled) must precede initialization
+    memstats_preinit(PY_CFG_ISOLATED);
+
     status = Py_InitializeFromConfig(&config);
     if (PyStatus_Exception(status)) {
         PyConfig_Clear(&config);
@@ -395,6 +530,7 @@ void py_init(t_py* x)
     PyObject* main_mod = PyImport_AddModule(x->obj.name->s_name); // borrowed
     x->python.globals = PyModule_GetDict(main_mod); // borrowed reference
     py_init_builtins(x); // does this have to be a separate function?
+    x->reload.modules = PyDict_New();
 
     // register the object
     object_register(CLASS_BOX, x->obj.name, x);
@@ -422,15 +558,22 @@ void py_free(t_py* x)
 {
     // code editor cleanup
     object_free(x->editor.code_editor);
+    py_sched_clear(x);
     object_free(x->scheduler.clock);
-    if (x->scheduler.sched_data) {
-        object_free(x->scheduler.sched_data);
-    }
+    object_free(x->reload.clock);
+    object_free(x->reload.watchers); // stops and frees the filewatchers
     
     if (x->editor.code) {
         sysmem_freehandle(x->editor.code);
     }
 
+    Py_XDECREF(x->reload.modules);
+    py_lookup_clear(x);
+    object_free(x->python.lookups);
+    py_bind_clear(x);
+    object_free(x->python.bindings);
+    metrics_free(x->python.metrics);
+    memstats_release(x->python.memstats);
     Py_XDECREF(x->python.globals);
     // python objects cleanup
     py_debug(x, "will be deleted");
@@ -438,6 +581,15 @@ void py_free(t_py* x)
     if (py_global_obj_count == 0) {
         /* WARNING: don't call x here or max will crash */
         hashtab_chuck(py_global_registry);
+        Py_CLEAR(py_global_code_cache);
+        profile_free();
+#if PY_HAVE_DICT_WATCHER
+        if (py_global_watcher_id >= 0) {
+            PyDict_ClearWatcher(py_global_watcher_id);
+            py_global_watcher_id = -1;
+        }
+        Py_CLEAR(py_global_bound_keys);
+#endif
         // post("last py obj freed -> finalizing py mem / interpreter.");
         if(Py_FinalizeEx()) { // returns 0 if successful, -1 if there were errors
             error("error finalizing `py`");
@@ -449,6 +601,36 @@ void py_free(t_py* x)
 }
 
 
+/**
+ * @brief Take the GIL for the object
+ *
+ * @param x pointer to object structure
+ * @return PyGILState_STATE state to pass to py_gil_release
+ *
+ * Allocations of the calling thread are accounted to the object until the
+ * matching py_gil_release (see memstats.h).
+ */
+PyGILState_STATE py_gil_ensure(t_py* x)
+{
+    PyGILState_STATE state = PyGILState_Ensure();
+    memstats_enter(x->python.memstats);
+    return state;
+}
+
+
+/**
+ * @brief Release the GIL taken by py_gil_ensure
+ *
+ * @param x pointer to object structure
+ * @param state state returned by py_gil_ensure
+ */
+void py_gil_release(t_py* x, PyGILState_STATE state)
+{
+    memstats_leave();
+    PyGILState_Release(state);
+}
+
+
 /*--------------------------------------------------------------------------*/
 /* Attribute Accessors and Helpers */
 
@@ -960,6 +1142,9 @@ void py_assist(t_py* x, void* b, long io, long idx, char* s)
         case O_SUCCESS:
             snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: (bang) success", idx);
             break;
+        case O_SCHED:
+            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: (sched) handles of scheduled calls", idx);
+            break;
         }
     }
 }
@@ -973,6 +1158,107 @@ void py_assist(t_py* x, void* b, long io, long idx, char* s)
 void py_count(t_py* x) { outlet_int(x->p_outlet_left, py_global_obj_count); }
 
 
+/**
+ * @brief Output or reset the latency metrics of the object
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `metrics` outputs `dictionary <name>` from the left outlet, with the
+ * counts and latency percentiles of each message type, GIL waits and the
+ * split between atom conversion and python execution. `metrics reset`
+ * clears them.
+ */
+t_max_err py_metrics(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    metrics_message(x->python.metrics, x->obj.name, argc, argv,
+                    x->p_outlet_left);
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Record a Chrome trace of the python messages of all py objects
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `trace start [python]` starts recording messages, GIL waits and atom
+ * conversions (and python calls with `python`) on all threads,
+ * `trace stop` stops and `trace write [path]` writes the trace file and
+ * outputs `trace <path>` from the left outlet.
+ */
+t_max_err py_trace(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atom;
+    t_symbol* path = trace_message((t_object*)x, "py", argc, argv);
+
+    if (path == NULL) {
+        return MAX_ERR_NONE;
+    }
+    atom_setsym(&atom, path);
+    outlet_anything(x->p_outlet_left, gensym("trace"), 1, &atom);
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Sample the python stacks of all threads for a flamegraph
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `profile start [interval_ms]` starts a sampler thread (default 10 ms),
+ * `profile stop` stops it and `profile dump [path]` writes the stack
+ * counts in folded format and outputs `profile <path>` from the left
+ * outlet. Unlike cProfile, the profiled code is not instrumented.
+ */
+t_max_err py_profile(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_atom atom;
+    t_symbol* path = profile_message((t_object*)x, "py", argc, argv);
+
+    if (path == NULL) {
+        return MAX_ERR_NONE;
+    }
+    atom_setsym(&atom, path);
+    outlet_anything(x->p_outlet_left, gensym("profile"), 1, &atom);
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Output the memory allocated by the python code of the object
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `memory [n]` outputs `dictionary <name>` from the left outlet, with the
+ * live and peak bytes of this object and of every py object (when the
+ * interpreter was started with `PY_MEMSTATS` set), and the top `n` sites
+ * of tracemalloc while it traces. `memory reset` resets the peaks and
+ * `memory trace [nframes]` / `memory trace stop` start or stop tracemalloc.
+ */
+t_max_err py_memory(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    memstats_message(x->python.memstats, x->obj.name, argc, argv,
+                     x->p_outlet_left);
+    return MAX_ERR_NONE;
+}
+
+
 /**
  * @brief      join parent path to child subpath
  *
@@ -1019,6 +1305,8 @@ void py_metadata(t_py* x)
 {
     char output_path[MAX_PATH_CHARS];
 
+    py_sched_info(x);
+
     short supportpath_id = path_getsupportpath();
     short tempfolder_id = path_tempfolder();
     short desktopfolder_id = path_desktopfolder();
@@ -1124,195 +1412,514 @@ void py_bang_failure(t_py* x) { outlet_bang(x->p_outlet_middle); }
 /* Time-based */
 
 /**
- * @brief Schedule a python function call
- *
- * @param x pointer to object struct
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * @brief Orders scheduled tasks by due time, then by scheduling order
  */
-t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv)
+static int py_sched_before(t_py_task* a, t_py_task* b)
 {
-    t_max_err ret = 0;
-
-    // schedule a python call
-    // [sched <time> func arg1 arg2 ... argN]
-    float time = 0.0;
+    return a->due < b->due || (a->due == b->due && a->id < b->id);
+}
 
-    // first atom in argv must be a float
-    if (argv->a_type != A_FLOAT) {
-        py_error(x, "first atom must be a float!");
-        goto error;
-    }
 
-    if (argc < 2) {
-        py_error(x, "need at least 2 args to schedule function calls");
-        goto error;
-    }
+/**
+ * @brief Restore the heap order from slot i towards the root
+ */
+static void py_sched_sift_up(t_py* x, long i)
+{
+    t_py_task* tasks = x->scheduler.tasks;
+    t_py_task task = tasks[i];
 
-    if ((argv + 0)->a_type != A_FLOAT) {
-        py_error(x, "1st arg of sched needs to be a float time in ms");
-        goto error;
+    while (i > 0) {
+        long parent = (i - 1) / 2;
+        if (!py_sched_before(&task, &tasks[parent])) {
+            break;
+        }
+        tasks[i] = tasks[parent];
+        i = parent;
     }
+    tasks[i] = task;
+}
 
-    // argv+0 is the object name to send to
-    time = atom_getfloat(argv);
-    if (time == 0.0) {
-        goto error;
-    }
 
-    // atom after the name of the time
-    if ((argv + 1)->a_type != A_SYM) {
-        py_error(
-            x, "2nd elem of sched atom needs to be the name of the callable");
-        goto error;
+/**
+ * @brief Restore the heap order from slot i towards the leaves
+ */
+static void py_sched_sift_down(t_py* x, long i)
+{
+    t_py_task* tasks = x->scheduler.tasks;
+    t_py_task task = tasks[i];
+    long n = x->scheduler.count;
+
+    while (2 * i + 1 < n) {
+        long child = 2 * i + 1;
+        if (child + 1 < n && py_sched_before(&tasks[child + 1], &tasks[child])) {
+            child++;
+        }
+        if (!py_sched_before(&tasks[child], &task)) {
+            break;
+        }
+        tasks[i] = tasks[child];
+        i = child;
     }
+    tasks[i] = task;
+}
 
-    // address the minimum case: e.g a bang
-    argc = argc - 1;
-    argv = argv + 1;
 
-    // success
-    // reset it
-    if (x->scheduler.sched_data != NULL) {
-        object_free(x->scheduler.sched_data);
-        x->scheduler.sched_data = NULL;
-    }
+/**
+ * @brief Remove the task in slot i from the heap (without freeing it)
+ */
+static t_py_task py_sched_remove(t_py* x, long i)
+{
+    t_py_task task = x->scheduler.tasks[i];
 
-    x->scheduler.sched_data = atomarray_new(argc, argv);
-    if (x->scheduler.sched_data == NULL) {
-        py_error(x, "sched_data not scheduled");
-        goto error;
+    x->scheduler.count--;
+    if (i < x->scheduler.count) {
+        x->scheduler.tasks[i] = x->scheduler.tasks[x->scheduler.count];
+        py_sched_sift_down(x, i);
+        py_sched_sift_up(x, i);
     }
-    clock_fdelay(x->scheduler.clock, time);
-    ret = MAX_ERR_NONE;
-    goto finally;
+    return task;
+}
 
-error:
-    py_error(x, "send failed");
-    ret = MAX_ERR_GENERIC;
 
-finally:
-    return ret;
+/**
+ * @brief Release the callable and arguments of a task
+ */
+static void py_sched_free_task(t_py_task* task)
+{
+    Py_XDECREF(task->binding.func);
+    task->binding.func = NULL;
+    if (task->argv) {
+        sysmem_freeptr(task->argv);
+        task->argv = NULL;
+    }
 }
 
+
 /**
- * @brief Wraps a scheduled python function call.
- *
- * @param x pointer to object struct
- * @return t_max_err error code
+ * @brief Set the clock to the due time of the earliest task
  */
-t_max_err py_task(t_py* x)
+static void py_sched_arm(t_py* x)
 {
-    double time;
-    long argc = 0;
-    t_atom* argv = NULL;
+    double now, delay;
 
-    clock_getftime(&time);
-    // also scheduler_gettime(&time);
-    t_max_err err = atomarray_getatoms(x->scheduler.sched_data, &argc, &argv);
-    if (err != MAX_ERR_NONE) {
-        py_error(x, "atomarray arg initialization failed");
-        return MAX_ERR_GENERIC;
+    if (x->scheduler.count == 0) {
+        clock_unset(x->scheduler.clock);
+        return;
     }
-    py_debug(x, "%lx instance is executing at time %.2f", x, time);
-    py_call(x, gensym(""), argc, argv);
-    py_bang_success(x);
-    return MAX_ERR_NONE;
+    clock_getftime(&now);
+    delay = x->scheduler.tasks[0].due - now;
+    clock_fdelay(x->scheduler.clock, delay > 0.0 ? delay : 0.0);
 }
 
 
-/*--------------------------------------------------------------------------*/
-/* Handlers */
-
 /**
- * @brief Generic python error handler
+ * @brief Add a python call to the scheduler
  *
  * @param x pointer to object struct
- * @param fmt format string
- * @param ... other args
- *
+ * @param delay time to the first call (ms)
+ * @param period repeat interval (ms), 0 for a one-shot call
+ * @param argc atom argument count (callable name first)
+ * @param argv atom argument vector
+ * @return long handle of the task, 0 on failure
  */
-void py_handle_error(t_py* x, char* fmt, ...)
+long py_sched_add(t_py* x, double delay, double period, long argc, t_atom* argv)
 {
-    if (!PyErr_Occurred()) { // borrowed 
-        return;
-    }
+    t_py_task task = {0};
+    double now;
 
-    char msg[PY_MAX_ELEMS];
+    if (argc > 1) {
+        task.argv = (t_atom*)sysmem_newptr((argc - 1) * sizeof(t_atom));
+        if (task.argv == NULL) {
+            return 0;
+        }
+        sysmem_copyptr(argv + 1, task.argv, (argc - 1) * sizeof(t_atom));
+        task.argc = argc - 1;
+    }
 
-    va_list va;
-    va_start(va, fmt);
-    vsnprintf(msg, PY_MAX_ELEMS, fmt, va);
-    va_end(va);
+    // the heap is only changed under the GIL, like in py_task
+    PyGILState_STATE gstate = py_gil_ensure(x);
+
+    if (x->scheduler.count == x->scheduler.capacity) {
+        long capacity = x->scheduler.capacity ? 2 * x->scheduler.capacity : 16;
+        t_py_task* tasks = x->scheduler.tasks
+            ? (t_py_task*)sysmem_resizeptr(x->scheduler.tasks, capacity * sizeof(t_py_task))
+            : (t_py_task*)sysmem_newptr(capacity * sizeof(t_py_task));
+        if (tasks == NULL) {
+            py_gil_release(x, gstate);
+            if (task.argv) {
+                sysmem_freeptr(task.argv);
+            }
+            return 0;
+        }
+        x->scheduler.tasks = tasks;
+        x->scheduler.capacity = capacity;
+    }
 
-    // get error info
-    PyObject *ptype = NULL;
-    PyObject *pvalue = NULL;
-    PyObject *ptraceback = NULL;
-    PyErr_Fetch(&ptype, &pvalue, &ptraceback);
-    PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
-    Py_XDECREF(ptype);
+    clock_getftime(&now);
+    task.id = x->scheduler.next_id++;
+    task.due = now + delay;
+    task.due_wall = systimer_gettime_ms() + delay;
+    task.period = period;
+    task.binding.target = atom_getsym(argv);
+    py_bind_track(task.binding.target);
 
-    PyObject* pvalue_pstr = PyObject_Repr(pvalue);
-    const char* pvalue_str = PyUnicode_AsUTF8(pvalue_pstr);
-    Py_XDECREF(pvalue);
-    Py_XDECREF(pvalue_pstr);
+    x->scheduler.tasks[x->scheduler.count++] = task;
+    py_sched_sift_up(x, x->scheduler.count - 1);
+    py_sched_arm(x);
 
-    object_error((t_object*)x, "[ERROR] (%s) %s: %s", x->obj.name->s_name, msg,
-                 pvalue_str);
-    Py_XDECREF(ptraceback);
+    py_gil_release(x, gstate);
+    return task.id;
 }
 
 
 /**
- * @brief Handler to output python float as max float
- *
- * @param x pointer to object struct
- * @param pfloat python float
- * @return t_max_err error code
+ * @brief Parse and add a `sched` or `every` message
  *
+ * Outputs `sched <handle>` from the rightmost outlet on success, apart
+ * from the results of python calls.
  */
-t_max_err py_handle_float_output(t_py* x, PyObject* pfloat)
+static t_max_err py_sched_message(t_py* x, t_symbol* s, long argc, t_atom* argv, int periodic)
 {
-    if (pfloat == NULL) {
-        goto error;
+    double time = 0.0;
+    long id = 0;
+    t_atom handle;
+
+    if (argc < 2) {
+        py_error(x, "usage: %s <ms> <callable> [args]", s->s_name);
+        return MAX_ERR_GENERIC;
     }
 
-    if (PyFloat_Check(pfloat)) {
-        float float_result = (float)PyFloat_AsDouble(pfloat);
-        if (PyErr_Occurred()) {
-            goto error;
-        }
+    if (atom_gettype(argv) != A_FLOAT && atom_gettype(argv) != A_LONG) {
+        py_error(x, "1st arg of %s needs to be a time in ms", s->s_name);
+        return MAX_ERR_GENERIC;
+    }
 
-        outlet_float(x->p_outlet_left, float_result);
-        py_bang_success(x);
+    time = atom_getfloat(argv);
+    if (time < 0.0 || (periodic && time == 0.0)) {
+        py_error(x, "%s time must be %s", s->s_name, periodic ? "> 0" : ">= 0");
+        return MAX_ERR_GENERIC;
     }
-    Py_XDECREF(pfloat);
-    return MAX_ERR_NONE;
 
-error:
-    py_handle_error(x, "py_handle_float_output failed");
-    Py_XDECREF(pfloat);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    if (atom_gettype(argv + 1) != A_SYM) {
+        py_error(x, "2nd arg of %s needs to be the name of the callable", s->s_name);
+        return MAX_ERR_GENERIC;
+    }
+
+    id = py_sched_add(x, time, periodic ? time : 0.0, argc - 1, argv + 1);
+    if (id == 0) {
+        py_error(x, "%s failed: out of memory", s->s_name);
+        return MAX_ERR_OUT_OF_MEM;
+    }
+
+    atom_setlong(&handle, id);
+    outlet_anything(x->p_outlet_sched, gensym("sched"), 1, &handle);
+    return MAX_ERR_NONE;
 }
 
+
 /**
- * @brief Handler to output python long as max int
+ * @brief Schedule a python function call
  *
  * @param x pointer to object struct
- * @param plong python long
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * `sched <ms> <callable> [args]` calls `callable` once after `ms`. Any
+ * number of calls can be pending; each outputs a `sched <handle>` message
+ * from the rightmost outlet, which `cancel <handle>` accepts.
  */
-t_max_err py_handle_long_output(t_py* x, PyObject* plong)
+t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    if (plong == NULL) {
-        goto error;
-    }
+    return py_sched_message(x, s, argc, argv, 0);
+}
 
-    if (PyLong_Check(plong)) {
+
+/**
+ * @brief Schedule a periodic python function call
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `every <ms> <callable> [args]` calls `callable` every `ms` until
+ * cancelled. Due times advance by the period, so calls do not drift; a
+ * period missed entirely (e.g. by a long callback) is skipped.
+ */
+t_max_err py_every(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    return py_sched_message(x, s, argc, argv, 1);
+}
+
+
+/**
+ * @brief Cancel scheduled python function calls
+ *
+ * @param x pointer to object struct
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * `cancel <handle> [handle ...]` cancels the given tasks, `cancel` all.
+ */
+t_max_err py_cancel(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_max_err err = MAX_ERR_NONE;
+
+    if (argc == 0) {
+        py_sched_clear(x);
+        return MAX_ERR_NONE;
+    }
+
+    PyGILState_STATE gstate = py_gil_ensure(x);
+    for (long i = 0; i < argc; i++) {
+        long id = atom_getlong(argv + i);
+        long j = 0;
+
+        while (j < x->scheduler.count && x->scheduler.tasks[j].id != id) {
+            j++;
+        }
+        if (j == x->scheduler.count) {
+            py_debug(x, "cancel: no pending task %ld", id);
+            err = MAX_ERR_GENERIC;
+            continue;
+        }
+        t_py_task task = py_sched_remove(x, j);
+        py_sched_free_task(&task);
+    }
+    py_sched_arm(x);
+    py_gil_release(x, gstate);
+
+    return err;
+}
+
+
+/**
+ * @brief Cancel all scheduled calls and release the task heap
+ *
+ * @param x pointer to object struct
+ */
+void py_sched_clear(t_py* x)
+{
+    PyGILState_STATE gstate = py_gil_ensure(x);
+
+    clock_unset(x->scheduler.clock);
+    if (x->scheduler.tasks != NULL) {
+        for (long i = 0; i < x->scheduler.count; i++) {
+            py_sched_free_task(&x->scheduler.tasks[i]);
+        }
+        sysmem_freeptr(x->scheduler.tasks);
+        x->scheduler.tasks = NULL;
+        x->scheduler.count = 0;
+        x->scheduler.capacity = 0;
+    }
+
+    py_gil_release(x, gstate);
+}
+
+
+/**
+ * @brief Post scheduler statistics to the console (part of `info`)
+ *
+ * @param x pointer to object struct
+ *
+ * Jitter is the system time a call actually started minus the time it was
+ * expected at, so it includes the time taken by earlier calls of the same
+ * tick.
+ */
+void py_sched_info(t_py* x)
+{
+    post("sched.pending: %ld", x->scheduler.count);
+    post("sched.fired: %ld in %ld ticks (max %ld per tick)",
+         x->scheduler.fired, x->scheduler.batches, x->scheduler.batch_max);
+    post("sched.jitter: last %.3f ms, mean %.3f ms, max %.3f ms",
+         x->scheduler.jitter_last,
+         x->scheduler.fired ? x->scheduler.jitter_sum / x->scheduler.fired : 0.0,
+         x->scheduler.jitter_max);
+}
+
+
+/**
+ * @brief Fires all scheduled python function calls which are due
+ *
+ * @param x pointer to object struct
+ * @return t_max_err error code
+ *
+ * All calls due in this tick run under one GIL acquisition. Calls scheduled
+ * by the callbacks themselves run on a later tick.
+ */
+t_max_err py_task(t_py* x)
+{
+    double now;
+    long last_id = x->scheduler.next_id;
+    long fired = 0;
+    t_max_err err = MAX_ERR_NONE;
+    t_metrics_span span;
+
+    clock_getftime(&now);
+    // the GIL wait is counted once, in the first call of the tick
+    metrics_begin(&span, METRICS_SCHED);
+    PyGILState_STATE gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    while (x->scheduler.count > 0 && x->scheduler.tasks[0].due <= now
+           && x->scheduler.tasks[0].id < last_id) {
+        if (fired > 0) {
+            metrics_begin(&span, METRICS_SCHED);
+        }
+        t_py_task* next = &x->scheduler.tasks[0];
+        t_py_task task = *next;
+        double jitter = systimer_gettime_ms() - task.due_wall;
+        PyObject* func = py_bound_func(x, &next->binding); // borrowed
+
+        if (task.period > 0.0) {
+            // advance in place, skipping periods which are already over
+            double skip = floor((now - next->due) / task.period) + 1.0;
+            next->due += skip * task.period;
+            next->due_wall += skip * task.period;
+            py_sched_sift_down(x, 0);
+        } else {
+            task = py_sched_remove(x, 0);
+            func = task.binding.func;
+        }
+
+        x->scheduler.jitter_last = jitter;
+        x->scheduler.jitter_sum += jitter;
+        if (jitter > x->scheduler.jitter_max) {
+            x->scheduler.jitter_max = jitter;
+        }
+        fired++;
+
+        // the callback may cancel or add tasks: `task` is not used after it
+        if (func == NULL) {
+            PyErr_Format(PyExc_NameError, "'%s' is not a defined callable",
+                         task.binding.target->s_name);
+            py_handle_error(x, "sched %s", task.binding.target->s_name);
+            py_bang_failure(x);
+            metrics_end(x->python.metrics, &span, 0);
+            err = MAX_ERR_GENERIC;
+        } else if (py_call_func(x, func, task.binding.target->s_name,
+                                task.argc, task.argv, &span) == MAX_ERR_NONE) {
+            py_bang_success(x);
+            metrics_end(x->python.metrics, &span, 1);
+        } else {
+            metrics_end(x->python.metrics, &span, 0);
+            err = MAX_ERR_GENERIC;
+        }
+
+        if (task.period == 0.0) {
+            py_sched_free_task(&task);
+        }
+    }
+
+    if (fired) {
+        x->scheduler.fired += fired;
+        x->scheduler.batches++;
+        if (fired > x->scheduler.batch_max) {
+            x->scheduler.batch_max = fired;
+        }
+        py_debug(x, "%ld scheduled calls at time %.2f", fired, now);
+    }
+
+    py_sched_arm(x);
+    py_gil_release(x, gstate);
+    return err;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Handlers */
+
+/**
+ * @brief Generic python error handler
+ *
+ * @param x pointer to object struct
+ * @param fmt format string
+ * @param ... other args
+ *
+ */
+void py_handle_error(t_py* x, char* fmt, ...)
+{
+    if (!PyErr_Occurred()) { // borrowed 
+        return;
+    }
+
+    char msg[PY_MAX_ELEMS];
+
+    va_list va;
+    va_start(va, fmt);
+    vsnprintf(msg, PY_MAX_ELEMS, fmt, va);
+    va_end(va);
+
+    // get error info
+    PyObject *ptype = NULL;
+    PyObject *pvalue = NULL;
+    PyObject *ptraceback = NULL;
+    PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+    PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
+    Py_XDECREF(ptype);
+
+    PyObject* pvalue_pstr = PyObject_Repr(pvalue);
+    const char* pvalue_str = PyUnicode_AsUTF8(pvalue_pstr);
+    Py_XDECREF(pvalue);
+    Py_XDECREF(pvalue_pstr);
+
+    object_error((t_object*)x, "[ERROR] (%s) %s: %s", x->obj.name->s_name, msg,
+                 pvalue_str);
+    Py_XDECREF(ptraceback);
+}
+
+
+/**
+ * @brief Handler to output python float as max float
+ *
+ * @param x pointer to object struct
+ * @param pfloat python float
+ * @return t_max_err error code
+ *
+ */
+t_max_err py_handle_float_output(t_py* x, PyObject* pfloat)
+{
+    if (pfloat == NULL) {
+        goto error;
+    }
+
+    if (PyFloat_Check(pfloat)) {
+        float float_result = (float)PyFloat_AsDouble(pfloat);
+        if (PyErr_Occurred()) {
+            goto error;
+        }
+
+        outlet_float(x->p_outlet_left, float_result);
+        py_bang_success(x);
+    }
+    Py_XDECREF(pfloat);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "py_handle_float_output failed");
+    Py_XDECREF(pfloat);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Handler to output python long as max int
+ *
+ * @param x pointer to object struct
+ * @param plong python long
+ * @return t_max_err error code
+ */
+t_max_err py_handle_long_output(t_py* x, PyObject* plong)
+{
+    if (plong == NULL) {
+        goto error;
+    }
+
+    if (PyLong_Check(plong)) {
         long long_result = PyLong_AsLong(plong);
         if (PyErr_Occurred()) {
             goto error;
@@ -1639,112 +2246,635 @@ error:
     return NULL;
 }
 
-/*--------------------------------------------------------------------------*/
-/* Core Methods */
-
 /**
- * @brief Import a python module
+ * @brief Parse a (possibly dotted) name into a lookup entry
  *
- * @param x pointer to object structure
- * @param s symbol of module to be imported
- * @return t_max_err error code
+ * @param sym name or dotted name (e.g. `f`, `os.path.join`)
+ * @return t_py_lookup* new entry or NULL (no exception set)
  */
-t_max_err py_import(t_py* x, t_symbol* s)
+static t_py_lookup* py_lookup_new(t_symbol* sym)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    t_py_lookup* entry = NULL;
+    const char* name = sym->s_name;
+    const char* dot = strchr(name, '.');
+    Py_ssize_t nattrs = 0;
+
+    entry = (t_py_lookup*)sysmem_newptrclear(sizeof(t_py_lookup));
+    if (entry == NULL) {
+        return NULL;
+    }
 
-    PyObject* x_module = NULL;
+    entry->key = dot ? PyUnicode_FromStringAndSize(name, dot - name)
+                     : PyUnicode_FromString(name);
+    if (entry->key == NULL) {
+        goto error;
+    }
+    PyUnicode_InternInPlace(&entry->key);
 
-    if (s != gensym("")) {
-        x_module = PyImport_ImportModule(s->s_name);
-        // x_module borrrowed ref
-        if (x_module == NULL) {
+    if (dot == NULL) {
+        return entry;
+    }
+
+    // intern the attribute path, e.g. ('path', 'join') of 'os.path.join'
+    for (const char* p = dot; p != NULL; p = strchr(p + 1, '.')) {
+        nattrs++;
+    }
+    entry->attrs = PyTuple_New(nattrs);
+    if (entry->attrs == NULL) {
+        goto error;
+    }
+    for (Py_ssize_t i = 0; i < nattrs; i++) {
+        const char* part = dot + 1;
+        dot = strchr(part, '.');
+        Py_ssize_t len = dot ? (Py_ssize_t)(dot - part) : (Py_ssize_t)strlen(part);
+        if (len == 0) {
             goto error;
         }
-        PyDict_SetItemString(x->python.globals, s->s_name, x_module);
-        PyGILState_Release(gstate);
-        py_bang_success(x);
-        py_debug(x, "imported: %s", s->s_name);
+        PyObject* attr = PyUnicode_FromStringAndSize(part, len);
+        if (attr == NULL) {
+            goto error;
+        }
+        PyUnicode_InternInPlace(&attr);
+        PyTuple_SET_ITEM(entry->attrs, i, attr); // steals reference
     }
-    return MAX_ERR_NONE;
+    return entry;
 
 error:
-    py_handle_error(x, "import %s", s->s_name);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    PyErr_Clear();
+    Py_XDECREF(entry->key);
+    Py_XDECREF(entry->attrs);
+    sysmem_freeptr(entry);
+    return NULL;
 }
 
 /**
- * @brief Evaluate a max symbol as a python expression
+ * @brief Release a lookup entry
  *
- * @param x pointer to object structure
- * @param s symbol of object to be evaluated
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * @param entry lookup entry
  */
-t_max_err py_eval(t_py* x, t_symbol* s, long argc, t_atom* argv)
+static void py_lookup_free(t_py_lookup* entry)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    Py_XDECREF(entry->key);
+    Py_XDECREF(entry->attrs);
+    sysmem_freeptr(entry);
+}
 
-    char* py_argv = atom_getsym(argv)->s_name;
-    py_debug(x, "%s %s", s->s_name, py_argv);
+/**
+ * @brief Resolve a symbol to a python object via the cached name lookup
+ *
+ * @param x pointer to object struct
+ * @param sym name or dotted name (e.g. `f`, `math.sqrt`) of the object
+ * @return PyObject* new reference, or NULL (no exception set) if undefined
+ *
+ * The name is parsed into interned strings once, so an undotted name costs
+ * one dict lookup in the object's globals (then builtins) and each further
+ * part of a dotted name one getattr. Resolved objects themselves are never
+ * cached, so `mymod.f = g` is seen by the next lookup of `mymod.f`.
+ *
+ * Only names resolving to callables are cached (symbols passed as string
+ * arguments would otherwise grow the cache without bound), and the cache
+ * is emptied when it reaches PY_LOOKUP_MAX entries.
+ */
+PyObject* py_lookup(t_py* x, t_symbol* sym)
+{
+    t_py_lookup* entry = NULL;
+    PyObject* obj = NULL;
+    int cached = 1;
+
+    if (hashtab_lookup(x->python.lookups, sym, (t_object**)&entry) != MAX_ERR_NONE) {
+        entry = py_lookup_new(sym);
+        if (entry == NULL) {
+            return NULL;
+        }
+        cached = 0;
+    }
 
-    PyObject* pval = PyRun_String(py_argv, Py_eval_input, x->python.globals,
-                                  x->python.globals);
+    obj = PyDict_GetItemWithError(x->python.globals, entry->key); // borrowed
+    if (obj == NULL && !PyErr_Occurred()) {
+        obj = PyDict_GetItemWithError(PyEval_GetBuiltins(), entry->key); // borrowed
+    }
+    Py_XINCREF(obj);
+
+    if (obj != NULL && entry->attrs != NULL) {
+        Py_ssize_t nattrs = PyTuple_GET_SIZE(entry->attrs);
+        for (Py_ssize_t i = 0; i < nattrs && obj != NULL; i++) {
+            PyObject* next = PyObject_GetAttr(obj, PyTuple_GET_ITEM(entry->attrs, i));
+            Py_DECREF(obj);
+            obj = next;
+        }
+    }
+    if (obj == NULL) {
+        PyErr_Clear();
+    }
 
-    if (pval != NULL) {
-        py_handle_output(x, pval);
-        PyGILState_Release(gstate);
-        return MAX_ERR_NONE;
+    if (cached) {
+        return obj;
     }
-    py_handle_error(x, "eval %s", py_argv);
-    PyGILState_Release(gstate);
-    py_bang_failure(x);
-    return MAX_ERR_GENERIC;
+    if (obj != NULL && PyCallable_Check(obj)) {
+        if (hashtab_getsize(x->python.lookups) >= PY_LOOKUP_MAX) {
+            py_lookup_clear(x);
+        }
+        hashtab_store(x->python.lookups, sym, (t_object*)entry);
+    } else {
+        py_lookup_free(entry);
+    }
+    return obj;
 }
 
 /**
- * @brief Execute a max symbol as one to many lines of python code
+ * @brief Release all cached name lookups of an object
  *
- * @param x pointer to object structure
- * @param s symbol
- * @param argc atom argument count
- * @param argv atom argument vector
- * @return t_max_err error code
+ * @param x pointer to object struct
+ *
+ * @note requires the GIL
  */
-t_max_err py_exec(t_py* x, t_symbol* s, long argc, t_atom* argv)
+void py_lookup_clear(t_py* x)
 {
-    PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    long kc = 0;
+    t_symbol** kv = NULL;
+    t_py_lookup* entry = NULL;
 
-    const char* py_argv = NULL;
-    PyObject* pval = NULL;
+    if (x->python.lookups == NULL) {
+        return;
+    }
 
-    py_argv = atom_getsym(argv)->s_name;
-    if (py_argv == NULL) {
+    hashtab_getkeys(x->python.lookups, &kc, &kv);
+    for (long i = 0; i < kc; i++) {
+        if (hashtab_lookup(x->python.lookups, kv[i], (t_object**)&entry) == MAX_ERR_NONE) {
+            py_lookup_free(entry);
+        }
+    }
+    if (kv) {
+        sysmem_freeptr(kv);
+    }
+    hashtab_clear(x->python.lookups);
+}
+
+/**
+ * @brief Translates a max symbol to a python str, dropping enclosing quotes
+ *
+ * @param sym symbol
+ * @return PyObject* new reference
+ */
+static PyObject* py_symbol_to_str(t_symbol* sym)
+{
+    const char* s = sym->s_name;
+    size_t len = strlen(s);
+    if (len >= 2 && (s[0] == '\'' || s[0] == '"') && s[len - 1] == s[0]) {
+        return PyUnicode_FromStringAndSize(s + 1, len - 2);
+    }
+    return PyUnicode_FromStringAndSize(s, len);
+}
+
+/**
+ * @brief Translates a typed atom to a python object without eval
+ *
+ * @param x pointer to object struct
+ * @param atom atom
+ * @return PyObject* new reference (NULL on error)
+ *
+ * Numbers pass through as int / float. Symbols naming an object in the
+ * object's globals or builtins (incl. `True`, `False`, `None`) resolve to that
+ * object, other symbols become strings.
+ */
+PyObject* py_atom_to_pyobj(t_py* x, t_atom* atom)
+{
+    PyObject* obj = NULL;
+
+    switch (atom_gettype(atom)) {
+    case A_LONG:
+        return PyLong_FromLongLong((long long)atom_getlong(atom));
+    case A_FLOAT:
+        return PyFloat_FromDouble(atom_getfloat(atom));
+    case A_SYM:
+        obj = py_lookup(x, atom_getsym(atom));
+        if (obj != NULL) {
+            return obj;
+        }
+        return py_symbol_to_str(atom_getsym(atom));
+    default:
+        Py_RETURN_NONE;
+    }
+}
+
+/**
+ * @brief Translates the value of a `key=value` symbol to a python object
+ *
+ * @param x pointer to object struct
+ * @param s value part of symbol
+ * @return PyObject* new reference (NULL on error)
+ */
+static PyObject* py_kwarg_to_pyobj(t_py* x, const char* s)
+{
+    char* end = NULL;
+
+    if (*s) {
+        long long l = strtoll(s, &end, 10);
+        if (*end == '\0') {
+            return PyLong_FromLongLong(l);
+        }
+        double d = strtod(s, &end);
+        if (*end == '\0') {
+            return PyFloat_FromDouble(d);
+        }
+    }
+    t_atom atom;
+    atom_setsym(&atom, gensym(s));
+    return py_atom_to_pyobj(x, &atom);
+}
+
+/*--------------------------------------------------------------------------*/
+/* Bytecode Cache */
+
+/**
+ * @brief Compile a python source file to a code object, using the cache
+ *
+ * @param x pointer to object struct
+ * @param path absolute path of python source file
+ * @return PyObject* code object (new reference) or NULL with exception set
+ *
+ * If the `cache` attribute is on, code objects are looked up first in an
+ * in-memory cache shared by all py objects, then in the on-disk cache, both
+ * validated against a hash of the source (see mamba/codecache.h). Must be
+ * called with the GIL held.
+ */
+PyObject* py_compile_file(t_py* x, const char* path)
+{
+    t_codecache_hit hit;
+    PyObject* co = codecache_compile(&py_global_code_cache, path,
+                                     x->python.cache, &hit);
+    if (co == NULL) {
+        return NULL;
+    }
+
+    switch (hit) {
+    case CODECACHE_MEMORY:
+        py_debug(x, "bytecode cache hit (memory): %s", path);
+        break;
+    case CODECACHE_DISK:
+        py_debug(x, "bytecode cache hit (disk): %s", path);
+        break;
+    default:
+        py_debug(x, "compiled: %s", path);
+    }
+    return co;
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Hot Reload */
+
+/**
+ * @brief Snapshot the names of the currently loaded python modules
+ *
+ * @param x pointer to object struct
+ * @return PyObject* new reference to a set of module names (or NULL)
+ *
+ * @note requires the GIL. Pass the result to `py_reload_track` after
+ *       running code which may import modules.
+ */
+PyObject* py_reload_snapshot(t_py* x)
+{
+    // depends on definition in py_prelude.h
+    PyObject* pfunc = PyDict_GetItemString(x->python.globals, "__reload_snapshot"); // borrowed
+    if (pfunc == NULL) {
+        return NULL;
+    }
+    PyObject* before = PyObject_CallObject(pfunc, NULL);
+    if (before == NULL) {
+        PyErr_Clear(); // tracking is best-effort
+    }
+    return before;
+}
+
+/**
+ * @brief Track user modules imported since a snapshot and watch their files
+ *
+ * @param x pointer to object struct
+ * @param before set of module names from `py_reload_snapshot` (may be NULL)
+ * @param name name of a module to track even if it was already loaded (or NULL)
+ * @return t_max_err error code
+ *
+ * @note requires the GIL. Stdlib and site-packages modules are not tracked.
+ */
+t_max_err py_reload_track(t_py* x, PyObject* before, const char* name)
+{
+    PyObject* pfunc = NULL;
+    PyObject* pname = NULL;
+    PyObject* paths = NULL;
+
+    if (before == NULL || x->reload.modules == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+
+    // depends on definition in py_prelude.h
+    pfunc = PyDict_GetItemString(x->python.globals, "__reload_track"); // borrowed
+    if (pfunc == NULL) {
+        goto error;
+    }
+
+    if (name != NULL) {
+        pname = PyUnicode_FromString(name);
+        if (pname == NULL) {
+            goto error;
+        }
+    } else {
+        Py_INCREF(Py_None);
+        pname = Py_None;
+    }
+
+    paths = PyObject_CallFunctionObjArgs(pfunc, before, x->reload.modules, pname, NULL);
+    if (paths == NULL) {
+        goto error;
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_Size(paths); i++) {
+        const char* path = PyUnicode_AsUTF8(PyList_GET_ITEM(paths, i));
+        if (path != NULL) {
+            py_reload_watch(x, path);
+        }
+    }
+
+    Py_DECREF(paths);
+    Py_DECREF(pname);
+    return MAX_ERR_NONE;
+
+error:
+    PyErr_Clear(); // tracking is best-effort
+    Py_XDECREF(pname);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Start a filewatcher on a tracked module file
+ *
+ * @param x pointer to object struct
+ * @param path absolute path of module file
+ * @return t_max_err error code
+ *
+ * Changes are reported via the `filechanged` method. A file is watched
+ * once: a module untracked when it left `sys.modules` and imported again
+ * keeps its first watcher.
+ */
+t_max_err py_reload_watch(t_py* x, const char* path)
+{
+    char filename[MAX_FILENAME_CHARS];
+    short path_id = 0;
+    void* watcher = NULL;
+    t_symbol* key = gensym(path);
+
+    if (hashtab_lookup(x->reload.watchers, key, (t_object**)&watcher) == MAX_ERR_NONE) {
+        return MAX_ERR_NONE;
+    }
+
+    if (path_frompathname(path, &path_id, filename)) {
+        py_debug(x, "cannot watch: %s", path);
+        return MAX_ERR_GENERIC;
+    }
+
+    watcher = filewatcher_new((t_object*)x, path_id, filename);
+    if (watcher == NULL) {
+        py_debug(x, "cannot watch: %s", path);
+        return MAX_ERR_GENERIC;
+    }
+    filewatcher_start(watcher);
+    hashtab_store(x->reload.watchers, key, watcher);
+    py_debug(x, "watching: %s", path);
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Reload changed tracked modules and their dependents
+ *
+ * @param x pointer to object struct
+ * @return t_max_err error code
+ *
+ * Only modules whose files changed since they were (re)loaded are reloaded,
+ * followed by the tracked modules which depend on them. Names in the
+ * object's globals bound to functions or classes of reloaded modules are
+ * rebound, so scheduled (`sched`) and `call`-ed functions, which are looked
+ * up by name when they fire, use the new definitions. Unlike `execfile`,
+ * the object's own setup code is not re-run.
+ */
+t_max_err py_reload(t_py* x)
+{
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+
+    PyObject* pfunc = NULL;
+    PyObject* before = NULL;
+    PyObject* reloaded = NULL;
+
+    if (x->reload.modules == NULL) {
+        goto error;
+    }
+
+    // depends on definition in py_prelude.h
+    pfunc = PyDict_GetItemString(x->python.globals, "__reload"); // borrowed
+    if (pfunc == NULL) {
+        py_error(x, "no __reload function in globals");
+        goto error;
+    }
+
+    // reloaded code may import new modules
+    before = py_reload_snapshot(x);
+
+    reloaded = PyObject_CallFunctionObjArgs(pfunc, x->reload.modules,
+                                           x->python.globals, NULL);
+    if (reloaded == NULL) {
+        goto error;
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_Size(reloaded); i++) {
+        py_info(x, "reloaded: %s", PyUnicode_AsUTF8(PyList_GET_ITEM(reloaded, i)));
+    }
+    if (PyList_Size(reloaded) > 0) {
+        py_global_epoch++; // module attributes of cached callables changed
+    }
+
+    py_reload_track(x, before, NULL);
+    Py_XDECREF(before);
+    Py_DECREF(reloaded);
+    py_gil_release(x, gstate);
+    py_bang_success(x);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "reload");
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Clock callback which reloads after file changes settled
+ *
+ * @param x pointer to object struct
+ */
+void py_reload_task(t_py* x)
+{
+    py_reload(x);
+}
+
+/**
+ * @brief Filewatcher notification that a tracked module file changed
+ *
+ * @param x pointer to object struct
+ * @param filename name of changed file
+ * @param path max path id of changed file
+ *
+ * Editors often write a file in several steps, so the reload is deferred
+ * by PY_RELOAD_DELAY ms and repeated notifications are coalesced.
+ */
+void py_filechanged(t_py* x, char* filename, short path)
+{
+    py_debug(x, "file changed: %s", filename);
+    if (x->reload.autoreload) {
+        clock_delay(x->reload.clock, PY_RELOAD_DELAY);
+    }
+}
+
+
+/*--------------------------------------------------------------------------*/
+/* Core Methods */
+
+/**
+ * @brief Import a python module
+ *
+ * @param x pointer to object structure
+ * @param s symbol of module to be imported
+ * @return t_max_err error code
+ */
+t_max_err py_import(t_py* x, t_symbol* s)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_IMPORT);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    PyObject* x_module = NULL;
+    PyObject* before = NULL;
+
+    if (s != gensym("")) {
+        before = py_reload_snapshot(x);
+        x_module = PyImport_ImportModule(s->s_name);
+        // x_module borrrowed ref
+        if (x_module == NULL) {
+            goto error;
+        }
+        PyDict_SetItemString(x->python.globals, s->s_name, x_module);
+        py_reload_track(x, before, s->s_name);
+        Py_XDECREF(before);
+        metrics_exec(&span);
+        py_gil_release(x, gstate);
+        py_bang_success(x);
+        py_debug(x, "imported: %s", s->s_name);
+    } else {
+        py_gil_release(x, gstate);
+    }
+    metrics_end(x->python.metrics, &span, 1);
+    return MAX_ERR_NONE;
+
+error:
+    metrics_exec(&span);
+    py_handle_error(x, "import %s", s->s_name);
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Evaluate a max symbol as a python expression
+ *
+ * @param x pointer to object structure
+ * @param s symbol of object to be evaluated
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_eval(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EVAL);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    char* py_argv = atom_getsym(argv)->s_name;
+    py_debug(x, "%s %s", s->s_name, py_argv);
+
+    PyObject* pval = PyRun_String(py_argv, Py_eval_input, x->python.globals,
+                                  x->python.globals);
+    metrics_exec(&span);
+
+    if (pval != NULL) {
+        py_handle_output(x, pval);
+        metrics_convert(&span);
+        py_gil_release(x, gstate);
+        metrics_end(x->python.metrics, &span, 1);
+        return MAX_ERR_NONE;
+    }
+    py_handle_error(x, "eval %s", py_argv);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief Execute a max symbol as one to many lines of python code
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_exec(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXEC);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    const char* py_argv = NULL;
+    PyObject* pval = NULL;
+    PyObject* before = NULL;
+
+    py_argv = atom_getsym(argv)->s_name;
+    if (py_argv == NULL) {
         goto error;
     }
 
+    before = py_reload_snapshot(x);
     pval = PyRun_String(py_argv, Py_file_input, x->python.globals, x->python.globals);
     if (pval == NULL) {
         goto error;
     }
     Py_DECREF(pval);
-    PyGILState_Release(gstate);
+    py_reload_track(x, before, NULL);
+    Py_XDECREF(before);
+    metrics_exec(&span);
+    py_gil_release(x, gstate);
 
     py_bang_success(x);
     py_debug(x, "exec %s", py_argv);
+    metrics_end(x->python.metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
+    metrics_exec(&span);
     py_handle_error(x, "exec %s", py_argv);
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1758,11 +2888,15 @@ error:
  */
 t_max_err py_execfile(t_py* x, t_symbol* s)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_EXECFILE);
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
 
+    PyObject* co = NULL;
     PyObject* pval = NULL;
-    FILE* fhandle = NULL;
+    PyObject* before = NULL;
 
     if (s != gensym("")) {
         // set x->editor.code_filepath
@@ -1781,32 +2915,38 @@ t_max_err py_execfile(t_py* x, t_symbol* s)
     // assume x->editor.code_filepath has be been set without errors
 
     py_debug(x, "pathname: %s", x->editor.code_filepath->s_name);
-    fhandle = fopen(x->editor.code_filepath->s_name, "r+");
 
-    if (fhandle == NULL) {
-        py_error(x, "could not open file");
+    // compiled once, then re-used while the file is unchanged
+    co = py_compile_file(x, x->editor.code_filepath->s_name);
+    if (co == NULL) {
         goto error;
     }
 
-    pval = PyRun_File(fhandle, x->editor.code_filepath->s_name, Py_file_input,
-                      x->python.globals, x->python.globals);
+    before = py_reload_snapshot(x);
+    pval = PyEval_EvalCode(co, x->python.globals, x->python.globals);
+    Py_DECREF(co);
     if (pval == NULL) {
-        fclose(fhandle);
         goto error;
     }
 
     // success cleanup
-    fclose(fhandle);
     Py_DECREF(pval);
-    PyGILState_Release(gstate);
+    py_reload_track(x, before, NULL);
+    Py_XDECREF(before);
+    metrics_exec(&span);
+    py_gil_release(x, gstate);
     py_bang_success(x);
+    metrics_end(x->python.metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
+    metrics_exec(&span);
     py_handle_error(x, "execfile");
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1829,8 +2969,11 @@ error:
  */
 t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_ASSIGN);
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
 
     char* varname = NULL;
     PyObject* list = NULL;
@@ -1872,15 +3015,19 @@ t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv)
         goto error;
     }
     // Py_XDECREF(list); // causes a crash (because it still exists?)
-    PyGILState_Release(gstate);
+    metrics_convert(&span);
+    py_gil_release(x, gstate);
     py_bang_success(x);
+    metrics_end(x->python.metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
+    metrics_convert(&span);
     py_handle_error(x, "assign %s", s->s_name);
     Py_XDECREF(list);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1895,7 +3042,10 @@ error:
  */
 t_max_err py_eval_text(t_py* x, long argc, t_atom* argv)
 {
-    PyGILState_STATE gstate = PyGILState_Ensure();
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_CODE);
+    PyGILState_STATE gstate = py_gil_ensure(x);
+    metrics_gil(&span);
 
     long textsize = 0;
     char* text = NULL;
@@ -1925,6 +3075,7 @@ t_max_err py_eval_text(t_py* x, long argc, t_atom* argv)
     sysmem_freeptr(new_text);
     sysmem_freeptr(text);
 
+    metrics_convert(&span);
     if (co == NULL) { // can be eval-co or exec-co or NULL here
         goto error;
     }
@@ -1932,6 +3083,7 @@ t_max_err py_eval_text(t_py* x, long argc, t_atom* argv)
     // sysmem_freeptr(text);
 
     pval = PyEval_EvalCode(co, x->python.globals, x->python.globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
@@ -1939,20 +3091,23 @@ t_max_err py_eval_text(t_py* x, long argc, t_atom* argv)
 
     if (!is_eval) {
         // bang for exec-type op
-        PyGILState_Release(gstate);
+        py_gil_release(x, gstate);
         py_bang_success(x);
     } else {
         py_handle_output(x, pval);
-        PyGILState_Release(gstate);
+        metrics_convert(&span);
+        py_gil_release(x, gstate);
     }
+    metrics_end(x->python.metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, "python code evaluation failed");
 
     // fail bang
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -1996,6 +3151,12 @@ t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv)
         return MAX_ERR_NONE;
     }
 
+    // dispatch messages bound to python callables via `bind`
+    t_py_binding* binding = NULL;
+    if (hashtab_lookup(x->python.bindings, s, (t_object**)&binding) == MAX_ERR_NONE) {
+        return py_bound_call(x, binding, argc, argv);
+    }
+
     // set symbol as first atom in new atoms array
     atom_setsym(atoms, s);
 
@@ -2039,7 +3200,7 @@ t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv)
 t_max_err py_func_to_list(t_py* x, const char* pyfunc_name, t_symbol* s, long argc, t_atom* argv)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     PyObject* pyfunc = NULL;
     PyObject* plist = NULL;
@@ -2082,7 +3243,7 @@ t_max_err py_func_to_list(t_py* x, const char* pyfunc_name, t_symbol* s, long ar
         Py_XDECREF(pval);
     }
 
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return MAX_ERR_NONE;
 
@@ -2091,7 +3252,7 @@ error:
     Py_XDECREF(plist);
     Py_XDECREF(pval);
     // fail bang
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
     return MAX_ERR_GENERIC;
 }
@@ -2111,7 +3272,7 @@ error:
 t_max_err py_func_to_atoms(t_py* x, const char* pyfunc_name, t_symbol* s, long argc, t_atom* argv)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     PyObject* pyfunc = NULL;
     PyObject* plist = NULL;
@@ -2162,7 +3323,7 @@ t_max_err py_func_to_atoms(t_py* x, const char* pyfunc_name, t_symbol* s, long a
     }
 
     Py_XDECREF(ptuple);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return MAX_ERR_NONE;
 
@@ -2172,7 +3333,7 @@ error:
     Py_XDECREF(ptuple);
     Py_XDECREF(pval);
     // fail bang
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
     return MAX_ERR_GENERIC;
 }
@@ -2189,7 +3350,7 @@ error:
 t_max_err py_func_to_pyobj(t_py* x, const char* pyfunc_name, PyObject* obj)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     PyObject* pyfunc = NULL;
     PyObject* pval = NULL;
@@ -2222,14 +3383,14 @@ t_max_err py_func_to_pyobj(t_py* x, const char* pyfunc_name, PyObject* obj)
         Py_XDECREF(pval);
     }
 
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, "%s call failed", pyfunc_name);
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
     return MAX_ERR_GENERIC;
 }
@@ -2250,7 +3411,7 @@ t_max_err py_func_to_text(t_py* x, const char* pyfunc_name, t_symbol* s, long ar
                           t_atom* argv)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     long textsize = 0;
     char* text = NULL;
@@ -2303,7 +3464,7 @@ t_max_err py_func_to_text(t_py* x, const char* pyfunc_name, t_symbol* s, long ar
     }
 
     Py_XDECREF(pstr);
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return MAX_ERR_NONE;
 
@@ -2312,7 +3473,7 @@ error:
     Py_XDECREF(pstr);
     Py_XDECREF(pval);
     // fail bang
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
     return MAX_ERR_GENERIC;
 }
@@ -2352,7 +3513,7 @@ t_max_err py_product(t_py* x, t_symbol* s, long argc, t_atom* argv)
 
 
 /**
- * @brief Pipe a max list through a functional pipeline
+ * @brief Run shell command from Max list
  *
  * @param x pointer to object structure
  * @param s symbol
@@ -2360,13 +3521,260 @@ t_max_err py_product(t_py* x, t_symbol* s, long argc, t_atom* argv)
  * @param argv atom argument vector
  * @return t_max_err error code
  */
-t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_shell(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return py_func_to_text(x, "pipe", s, argc, argv);
+    return py_func_to_text(x, "shell", s, argc, argv);
 }
 
 
-/**
+/*--------------------------------------------------------------------------*/
+/* Native Dispatch Methods */
+
+/**
+ * @brief Output the result of a native dispatch method and bang success
+ *
+ * @param x pointer to object structure
+ * @param pval result (reference is stolen)
+ */
+static void py_native_output(t_py* x, PyObject* pval)
+{
+    if (pval == Py_None) {
+        Py_DECREF(pval);
+    } else {
+        py_handle_output(x, pval); // this decrefs pval
+    }
+    py_bang_success(x);
+}
+
+/**
+ * @brief Call a function with a single argument
+ *
+ * @param func callable
+ * @param arg argument (borrowed)
+ * @return PyObject* new reference
+ */
+static PyObject* py_call_one(PyObject* func, PyObject* arg)
+{
+    PyObject* args[2] = {NULL, arg};
+    return PyObject_Vectorcall(func, args + 1,
+                               1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+}
+
+/**
+ * @brief Map a function over an iterable (`list(map(f, seq))`)
+ *
+ * @param func callable
+ * @param seq iterable
+ * @return PyObject* new reference to list
+ */
+static PyObject* py_map(PyObject* func, PyObject* seq)
+{
+    PyObject* iter = NULL;
+    PyObject* item = NULL;
+    PyObject* result = NULL;
+
+    iter = PyObject_GetIter(seq);
+    if (iter == NULL) {
+        return NULL;
+    }
+    result = PyList_New(0);
+    while (result != NULL && (item = PyIter_Next(iter)) != NULL) {
+        PyObject* pval = py_call_one(func, item);
+        Py_DECREF(item);
+        if (pval == NULL || PyList_Append(result, pval) != 0) {
+            Py_CLEAR(result);
+        }
+        Py_XDECREF(pval);
+    }
+    Py_DECREF(iter);
+    if (PyErr_Occurred()) {
+        Py_CLEAR(result);
+    }
+    return result;
+}
+
+/**
+ * @brief Reduce an iterable with a two-argument function (`functools.reduce`)
+ *
+ * @param func callable
+ * @param seq iterable
+ * @param initial initial accumulator value (borrowed)
+ * @return PyObject* new reference
+ */
+static PyObject* py_reduce(PyObject* func, PyObject* seq, PyObject* initial)
+{
+    PyObject* iter = NULL;
+    PyObject* item = NULL;
+    PyObject* accum = initial;
+
+    iter = PyObject_GetIter(seq);
+    if (iter == NULL) {
+        return NULL;
+    }
+    Py_INCREF(accum);
+    while (accum != NULL && (item = PyIter_Next(iter)) != NULL) {
+        PyObject* args[3] = {NULL, accum, item};
+        PyObject* pval = PyObject_Vectorcall(func, args + 1,
+                                             2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+        Py_DECREF(item);
+        Py_DECREF(accum);
+        accum = pval;
+    }
+    Py_DECREF(iter);
+    if (PyErr_Occurred()) {
+        Py_CLEAR(accum);
+    }
+    return accum;
+}
+
+/**
+ * @brief Split atoms into callables and translated values
+ *
+ * @param x pointer to object structure
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @param[out] funcs new references to callables (capacity argc)
+ * @param[out] nfuncs number of callables
+ * @param[out] vals new references to non-callable values (capacity argc)
+ * @param[out] nvals number of values
+ * @return t_max_err error code
+ */
+static t_max_err py_split_atoms(t_py* x, long argc, t_atom* argv,
+                                PyObject** funcs, long* nfuncs,
+                                PyObject** vals, long* nvals)
+{
+    *nfuncs = 0;
+    *nvals = 0;
+    for (long i = 0; i < argc; i++) {
+        PyObject* obj = py_atom_to_pyobj(x, argv + i);
+        if (obj == NULL) {
+            return MAX_ERR_GENERIC;
+        }
+        if (atom_gettype(argv + i) == A_SYM && PyCallable_Check(obj)) {
+            funcs[(*nfuncs)++] = obj;
+        } else {
+            vals[(*nvals)++] = obj;
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief Release an array of python object references
+ *
+ * @param objs array
+ * @param n number of references
+ */
+static void py_release_array(PyObject** objs, long n)
+{
+    for (long i = 0; i < n; i++) {
+        Py_XDECREF(objs[i]);
+    }
+}
+
+/**
+ * @brief Pipe a max list through a functional pipeline
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * Symbols resolving to callables form the pipeline, other atoms are the
+ * values: a single value is passed through each function in turn, several
+ * values are mapped over by each function (or passed as a list if mapping
+ * raises a TypeError, e.g. for `sum`). No text conversion or `eval` is used.
+ */
+t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_PIPE);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    PyObject* stack[2 * PY_STACK_ARGS];
+    PyObject** funcs = stack;
+    PyObject** vals = stack + PY_STACK_ARGS;
+    long nfuncs = 0;
+    long nvals = 0;
+    PyObject* val = NULL;
+
+    if (argc > PY_STACK_ARGS) {
+        funcs = (PyObject**)sysmem_newptr(2 * argc * sizeof(PyObject*));
+        if (funcs == NULL) {
+            goto error;
+        }
+        vals = funcs + argc;
+    }
+
+    if (py_split_atoms(x, argc, argv, funcs, &nfuncs, vals, &nvals) != MAX_ERR_NONE) {
+        goto error;
+    }
+
+    if (nfuncs == 0 || nvals == 0) {
+        py_error(x, "pipe needs at least one function and one value");
+        goto error;
+    }
+    metrics_convert(&span);
+
+    if (nvals == 1) {
+        val = vals[0];
+        Py_INCREF(val);
+        for (long i = 0; i < nfuncs && val != NULL; i++) {
+            PyObject* pval = py_call_one(funcs[i], val);
+            Py_DECREF(val);
+            val = pval;
+        }
+    } else {
+        val = PyList_New(nvals);
+        for (long i = 0; i < nvals && val != NULL; i++) {
+            Py_INCREF(vals[i]);
+            PyList_SET_ITEM(val, i, vals[i]);
+        }
+        for (long i = 0; i < nfuncs && val != NULL; i++) {
+            PyObject* pval = py_map(funcs[i], val);
+            if (pval == NULL && PyErr_ExceptionMatches(PyExc_TypeError)) {
+                PyErr_Clear();
+                pval = py_call_one(funcs[i], val);
+            }
+            Py_DECREF(val);
+            val = pval;
+        }
+    }
+
+    metrics_exec(&span);
+    if (val == NULL) {
+        goto error;
+    }
+
+    py_release_array(funcs, nfuncs);
+    py_release_array(vals, nvals);
+    if (funcs != stack) {
+        sysmem_freeptr(funcs);
+    }
+    py_native_output(x, val);
+    metrics_convert(&span);
+    py_gil_release(x, gstate);
+    metrics_end(x->python.metrics, &span, 1);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "pipe failed");
+    py_release_array(funcs, nfuncs);
+    py_release_array(vals, nvals);
+    if (funcs != NULL && funcs != stack) {
+        sysmem_freeptr(funcs);
+    }
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+
+/**
  * @brief Applies a max list to a set of left fold functions
  *
  * @param x pointer to object structure
@@ -2375,26 +3783,226 @@ t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv)
  * @param argv atom argument vector
  * @return t_max_err error code
  *
- * The first elem in the list is treated as the accumulator
+ * The first value in the list is treated as the accumulator. A single
+ * remaining value is treated as the sequence (e.g. a named list), several
+ * values form the sequence. With more than one function a list of the
+ * results of each fold is output.
  */
 t_max_err py_fold(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return py_func_to_text(x, "fold", s, argc, argv);
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_FOLD);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    PyObject* stack[2 * PY_STACK_ARGS];
+    PyObject** funcs = stack;
+    PyObject** vals = stack + PY_STACK_ARGS;
+    long nfuncs = 0;
+    long nvals = 0;
+    PyObject* seq = NULL;
+    PyObject* result = NULL;
+
+    if (argc > PY_STACK_ARGS) {
+        funcs = (PyObject**)sysmem_newptr(2 * argc * sizeof(PyObject*));
+        if (funcs == NULL) {
+            goto error;
+        }
+        vals = funcs + argc;
+    }
+
+    if (py_split_atoms(x, argc, argv, funcs, &nfuncs, vals, &nvals) != MAX_ERR_NONE) {
+        goto error;
+    }
+
+    if (nfuncs == 0 || nvals == 0) {
+        py_error(x, "fold needs at least one function and an initial value");
+        goto error;
+    }
+    metrics_convert(&span);
+
+    if (nvals == 2) {
+        seq = vals[1];
+        Py_INCREF(seq);
+    } else {
+        seq = PyList_New(nvals - 1);
+        for (long i = 1; i < nvals && seq != NULL; i++) {
+            Py_INCREF(vals[i]);
+            PyList_SET_ITEM(seq, i - 1, vals[i]);
+        }
+    }
+    if (seq == NULL) {
+        goto error;
+    }
+
+    if (nfuncs == 1) {
+        result = py_reduce(funcs[0], seq, vals[0]);
+    } else {
+        result = PyList_New(nfuncs);
+        for (long i = 0; i < nfuncs && result != NULL; i++) {
+            PyObject* pval = py_reduce(funcs[i], seq, vals[0]);
+            if (pval == NULL) {
+                Py_CLEAR(result);
+                break;
+            }
+            PyList_SET_ITEM(result, i, pval);
+        }
+    }
+    Py_DECREF(seq);
+
+    metrics_exec(&span);
+    if (result == NULL) {
+        goto error;
+    }
+
+    py_release_array(funcs, nfuncs);
+    py_release_array(vals, nvals);
+    if (funcs != stack) {
+        sysmem_freeptr(funcs);
+    }
+    py_native_output(x, result);
+    metrics_convert(&span);
+    py_gil_release(x, gstate);
+    metrics_end(x->python.metrics, &span, 1);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "fold failed");
+    py_release_array(funcs, nfuncs);
+    py_release_array(vals, nvals);
+    if (funcs != NULL && funcs != stack) {
+        sysmem_freeptr(funcs);
+    }
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
+    return MAX_ERR_GENERIC;
 }
 
 
 /**
- * @brief Run shell command from Max list
+ * @brief Call a python callable with atoms as arguments and output the result
  *
  * @param x pointer to object structure
- * @param s symbol
+ * @param func callable (borrowed)
+ * @param fname name of callable (for error messages)
  * @param argc atom argument count
  * @param argv atom argument vector
+ * @param span metrics span of the calling message (or NULL)
  * @return t_max_err error code
+ *
+ * Numbers are passed as int / float, symbols as the global they name or as
+ * strings and `key=value` symbols as keywords. The args are built in a stack
+ * array and passed with a single vectorcall. If a call with several
+ * positional args raises a TypeError, the args are retried as a single list
+ * (so `call sum 1 2 3` works).
+ *
+ * @note requires the GIL
  */
-t_max_err py_shell(t_py* x, t_symbol* s, long argc, t_atom* argv)
+t_max_err py_call_func(t_py* x, PyObject* func, const char* fname, long argc,
+                       t_atom* argv, t_metrics_span* span)
 {
-    return py_func_to_text(x, "shell", s, argc, argv);
+    PyObject* stack[PY_STACK_ARGS + 1];
+    PyObject** args = stack + 1; // args[-1] is free for PY_VECTORCALL_ARGUMENTS_OFFSET
+    PyObject** heap = NULL;
+    PyObject* kwnames = NULL;
+    PyObject* pval = NULL;
+    long nargs = 0;
+    long nkw = 0;
+    long n = 0;
+
+    Py_INCREF(func);
+
+    if (argc > PY_STACK_ARGS) {
+        heap = (PyObject**)sysmem_newptr((argc + 1) * sizeof(PyObject*));
+        if (heap == NULL) {
+            goto error;
+        }
+        args = heap + 1;
+    }
+
+    // positional args first, then keyword values (vectorcall convention)
+    for (long i = 0; i < argc; i++) {
+        if (atom_gettype(argv + i) == A_SYM && strchr(atom_getsym(argv + i)->s_name, '=')) {
+            nkw++;
+            continue;
+        }
+        if ((args[n] = py_atom_to_pyobj(x, argv + i)) == NULL) {
+            goto error;
+        }
+        n++;
+    }
+    nargs = n;
+
+    if (nkw > 0) {
+        kwnames = PyTuple_New(nkw);
+        if (kwnames == NULL) {
+            goto error;
+        }
+        for (long i = 0, k = 0; i < argc; i++) {
+            if (atom_gettype(argv + i) != A_SYM) {
+                continue;
+            }
+            const char* name = atom_getsym(argv + i)->s_name;
+            const char* eq = strchr(name, '=');
+            if (eq == NULL) {
+                continue;
+            }
+            PyObject* key = PyUnicode_FromStringAndSize(name, eq - name);
+            if (key == NULL) {
+                goto error;
+            }
+            PyTuple_SET_ITEM(kwnames, k++, key);
+            if ((args[n] = py_kwarg_to_pyobj(x, eq + 1)) == NULL) {
+                goto error;
+            }
+            n++;
+        }
+    }
+
+    metrics_convert(span);
+    pval = PyObject_Vectorcall(func, args, nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, kwnames);
+
+    if (pval == NULL && nkw == 0 && nargs > 1 && PyErr_ExceptionMatches(PyExc_TypeError)) {
+        PyErr_Clear();
+        PyObject* plist = PyList_New(nargs);
+        if (plist == NULL) {
+            goto error;
+        }
+        for (long i = 0; i < nargs; i++) {
+            Py_INCREF(args[i]);
+            PyList_SET_ITEM(plist, i, args[i]);
+        }
+        pval = py_call_one(func, plist);
+        Py_DECREF(plist);
+    }
+    metrics_exec(span);
+
+    if (pval == NULL) {
+        goto error;
+    }
+
+    py_release_array(args, n);
+    if (heap != NULL) {
+        sysmem_freeptr(heap);
+    }
+    Py_XDECREF(kwnames);
+    Py_DECREF(func);
+    py_native_output(x, pval);
+    metrics_convert(span);
+    return MAX_ERR_NONE;
+
+error:
+    py_handle_error(x, "call %s", fname);
+    py_release_array(args, n);
+    if (heap != NULL) {
+        sysmem_freeptr(heap);
+    }
+    Py_XDECREF(kwnames);
+    Py_DECREF(func);
+    py_bang_failure(x);
+    return MAX_ERR_GENERIC;
 }
 
 
@@ -2406,13 +4014,315 @@ t_max_err py_shell(t_py* x, t_symbol* s, long argc, t_atom* argv)
  * @param argc atom argument count
  * @param argv atom argument vector
  * @return t_max_err error code
+ *
+ * `call f 1 2 k=3` resolves `f` through the cached name lookup and calls it
+ * via `py_call_func`.
  */
 t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv)
 {
-    return py_func_to_text(x, "call", s, argc, argv);
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_CALL);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    PyObject* func = NULL;
+    const char* fname = "";
+    t_max_err err = MAX_ERR_GENERIC;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        py_error(x, "call needs the name of a callable");
+        goto error;
+    }
+    fname = atom_getsym(argv)->s_name;
+
+    func = py_lookup(x, atom_getsym(argv));
+    if (func == NULL || !PyCallable_Check(func)) {
+        PyErr_Format(PyExc_NameError, "'%s' is not a defined callable", fname);
+        goto error;
+    }
+
+    err = py_call_func(x, func, fname, argc - 1, argv + 1, &span);
+    Py_DECREF(func);
+    py_gil_release(x, gstate);
+    metrics_end(x->python.metrics, &span, err == MAX_ERR_NONE);
+    return err;
+
+error:
+    Py_XDECREF(func);
+    py_handle_error(x, "call %s", fname);
+    py_gil_release(x, gstate);
+    py_bang_failure(x);
+    metrics_end(x->python.metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+
+/**
+ * @brief Bind a message name to a python callable
+ *
+ * @param x pointer to object structure
+ * @param s symbol
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ *
+ * After `bind <name> <pyfunc>`, a `<name> [args]` message calls `pyfunc`
+ * like `call pyfunc [args]` but without resolving the name: the callable is
+ * cached in the binding. From python 3.12 the object's globals are watched
+ * and the cache is invalidated when the bound global is reassigned (e.g. by
+ * `exec`, `execfile` or `reload`); on older versions it is re-validated by
+ * one dict lookup per message. `bind <name>` removes the binding.
+ */
+t_max_err py_bind(t_py* x, t_symbol* s, long argc, t_atom* argv)
+{
+    PyGILState_STATE gstate;
+    t_py_binding* binding = NULL;
+    t_symbol* name = NULL;
+    t_symbol* target = NULL;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM
+        || (argc > 1 && atom_gettype(argv + 1) != A_SYM)) {
+        py_error(x, "usage: bind <name> [pyfunc]");
+        return MAX_ERR_GENERIC;
+    }
+    name = atom_getsym(argv);
+    target = (argc > 1) ? atom_getsym(argv + 1) : NULL;
+
+    gstate = py_gil_ensure(x);
+
+    if (hashtab_lookup(x->python.bindings, name, (t_object**)&binding) == MAX_ERR_NONE) {
+        hashtab_chuckkey(x->python.bindings, name);
+        Py_XDECREF(binding->func);
+        sysmem_freeptr(binding);
+        binding = NULL;
+    }
+
+    if (target == NULL) {
+        if (hashtab_getsize(x->python.bindings) == 0) {
+            py_bind_watch(x, 0);
+        }
+        py_gil_release(x, gstate);
+        py_debug(x, "unbound: %s", name->s_name);
+        return MAX_ERR_NONE;
+    }
+
+    binding = (t_py_binding*)sysmem_newptrclear(sizeof(t_py_binding));
+    if (binding == NULL) {
+        py_gil_release(x, gstate);
+        return MAX_ERR_OUT_OF_MEM;
+    }
+    binding->target = target;
+    hashtab_store(x->python.bindings, name, (t_object*)binding);
+
+    py_bind_track(target);
+    py_bind_watch(x, 1);
+
+    // resolve now to report undefined callables early
+    if (py_bound_func(x, binding) == NULL) {
+        py_error(x, "bind %s: '%s' is not (yet) a defined callable",
+                 name->s_name, target->s_name);
+    }
+    py_gil_release(x, gstate);
+    py_debug(x, "bound: %s -> %s", name->s_name, target->s_name);
+    return MAX_ERR_NONE;
 }
 
 
+/**
+ * @brief Register the root name of a bound (dotted) name for invalidation
+ *
+ * @param target name of the callable
+ *
+ * @note requires the GIL; a no-op before python 3.12
+ */
+void py_bind_track(t_symbol* target)
+{
+#if PY_HAVE_DICT_WATCHER
+    if (py_global_bound_keys == NULL) {
+        py_global_bound_keys = PySet_New(NULL);
+    }
+    PyObject* key = NULL;
+    const char* dot = strchr(target->s_name, '.');
+    key = dot ? PyUnicode_FromStringAndSize(target->s_name, dot - target->s_name)
+              : PyUnicode_FromString(target->s_name);
+    if (key == NULL || py_global_bound_keys == NULL
+        || PySet_Add(py_global_bound_keys, key) != 0) {
+        PyErr_Clear();
+    }
+    Py_XDECREF(key);
+#endif
+}
+
+
+/**
+ * @brief Start or stop watching the globals of an object for rebinding
+ *
+ * @param x pointer to object structure
+ * @param on 1 when the object has bindings, 0 when it has none left
+ *
+ * Only objects with bindings are watched, so writes to the globals of
+ * other objects do not reach `py_bind_watcher`. Until the globals are
+ * watched, bindings are re-validated on each message.
+ *
+ * @note requires the GIL; a no-op before python 3.12
+ */
+void py_bind_watch(t_py* x, int on)
+{
+#if PY_HAVE_DICT_WATCHER
+    if (on == x->python.watched || x->python.globals == NULL) {
+        return;
+    }
+    if (on) {
+        if (py_global_watcher_id < 0) {
+            py_global_watcher_id = PyDict_AddWatcher(py_bind_watcher);
+        }
+        if (py_global_watcher_id < 0
+            || PyDict_Watch(py_global_watcher_id, x->python.globals) < 0) {
+            PyErr_Clear();
+            py_error(x, "could not watch globals: bindings are re-validated per call");
+            return;
+        }
+    } else if (py_global_watcher_id >= 0
+               && PyDict_Unwatch(py_global_watcher_id, x->python.globals) < 0) {
+        PyErr_Clear();
+    }
+    x->python.watched = on;
+#endif
+}
+
+
+/**
+ * @brief Get the (cached) callable of a binding
+ *
+ * @param x pointer to object structure
+ * @param binding binding
+ * @return PyObject* borrowed reference to the callable or NULL
+ *
+ * @note requires the GIL
+ */
+PyObject* py_bound_func(t_py* x, t_py_binding* binding)
+{
+#if PY_HAVE_DICT_WATCHER
+    // only globals are watched: attributes of dotted targets may change
+    if (x->python.watched && binding->func != NULL
+        && binding->epoch == py_global_epoch
+        && strchr(binding->target->s_name, '.') == NULL) {
+        return binding->func;
+    }
+#endif
+    PyObject* func = py_lookup(x, binding->target);
+    if (func == NULL || !PyCallable_Check(func)) {
+        Py_XDECREF(func);
+        Py_CLEAR(binding->func);
+        return NULL;
+    }
+    Py_XDECREF(binding->func);
+    binding->func = func; // owned by the binding
+    binding->epoch = py_global_epoch;
+    return func;
+}
+
+
+/**
+ * @brief Dispatch a message to its bound python callable
+ *
+ * @param x pointer to object structure
+ * @param binding binding of the message selector
+ * @param argc atom argument count
+ * @param argv atom argument vector
+ * @return t_max_err error code
+ */
+t_max_err py_bound_call(t_py* x, t_py_binding* binding, long argc, t_atom* argv)
+{
+    t_metrics_span span;
+    metrics_begin(&span, METRICS_CALL);
+    PyGILState_STATE gstate;
+    gstate = py_gil_ensure(x);
+    metrics_gil(&span);
+
+    t_max_err err = MAX_ERR_GENERIC;
+    PyObject* func = py_bound_func(x, binding);
+
+    if (func == NULL) {
+        PyErr_Format(PyExc_NameError, "'%s' is not a defined callable",
+                     binding->target->s_name);
+        py_handle_error(x, "call %s", binding->target->s_name);
+        py_gil_release(x, gstate);
+        py_bang_failure(x);
+        metrics_end(x->python.metrics, &span, 0);
+        return MAX_ERR_GENERIC;
+    }
+
+    err = py_call_func(x, func, binding->target->s_name, argc, argv, &span);
+    py_gil_release(x, gstate);
+    metrics_end(x->python.metrics, &span, err == MAX_ERR_NONE);
+    return err;
+}
+
+
+/**
+ * @brief Release all bindings of an object
+ *
+ * @param x pointer to object structure
+ *
+ * @note requires the GIL
+ */
+void py_bind_clear(t_py* x)
+{
+    long kc = 0;
+    t_symbol** kv = NULL;
+    t_py_binding* binding = NULL;
+
+    if (x->python.bindings == NULL) {
+        return;
+    }
+
+    hashtab_getkeys(x->python.bindings, &kc, &kv);
+    for (long i = 0; i < kc; i++) {
+        if (hashtab_lookup(x->python.bindings, kv[i], (t_object**)&binding) == MAX_ERR_NONE) {
+            Py_XDECREF(binding->func);
+            sysmem_freeptr(binding);
+        }
+    }
+    if (kv) {
+        sysmem_freeptr(kv);
+    }
+    hashtab_clear(x->python.bindings);
+    py_bind_watch(x, 0);
+}
+
+#if PY_HAVE_DICT_WATCHER
+/**
+ * @brief Dict watcher of object globals which invalidates bound callables
+ *
+ * Bumps the binding epoch if a bound root name is (re)assigned or deleted, or
+ * the whole dict is cleared, so `py_bound_func` re-resolves on next use.
+ */
+static int py_bind_watcher(PyDict_WatchEvent event, PyObject* dict,
+                           PyObject* key, PyObject* new_value)
+{
+    switch (event) {
+    case PyDict_EVENT_ADDED:
+    case PyDict_EVENT_MODIFIED:
+    case PyDict_EVENT_DELETED:
+        if (py_global_bound_keys == NULL || PySet_GET_SIZE(py_global_bound_keys) == 0) {
+            return 0;
+        }
+        if (key != NULL && PySet_Contains(py_global_bound_keys, key) != 1) {
+            PyErr_Clear();
+            return 0;
+        }
+        break;
+    default:
+        break;
+    }
+    py_global_epoch++;
+    return 0;
+}
+#endif
+
+
 /*--------------------------------------------------------------------------*/
 /* Interobject Methods */
 
@@ -2668,15 +4578,17 @@ void py_doread(t_py* x, t_symbol* s, long argc, t_atom* argv)
 void py_run(t_py* x)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     PyObject* pval = NULL;
+    PyObject* before = NULL;
 
     if ((*(x->editor.code) != NULL) && (*(x->editor.code)[0] == '\0')) {
         // is empty string
         goto error;
     }
 
+    before = py_reload_snapshot(x);
     pval = PyRun_String(*(x->editor.code), Py_file_input, x->python.globals,
                         x->python.globals);
     if (pval == NULL) {
@@ -2685,14 +4597,17 @@ void py_run(t_py* x)
 
     // success cleanup
     Py_DECREF(pval);
-    PyGILState_Release(gstate);
+    py_reload_track(x, before, NULL);
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
     py_bang_success(x);
     return;
 
 error:
     py_handle_error(x, "run x->p_code failed");
     Py_XDECREF(pval);
-    PyGILState_Release(gstate);
+    Py_XDECREF(before);
+    py_gil_release(x, gstate);
     py_bang_failure(x);
 }
 
@@ -2749,7 +4664,7 @@ void py_okclose(t_py* x, char* s, short* result)
 t_max_err py_edsave(t_py* x, char** text, long size)
 {
     PyGILState_STATE gstate;
-    gstate = PyGILState_Ensure();
+    gstate = py_gil_ensure(x);
 
     PyObject* pval = NULL;
 
@@ -2766,14 +4681,14 @@ t_max_err py_edsave(t_py* x, char** text, long size)
         // success cleanup
         Py_DECREF(pval);
     }
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_debug(x, "py_edsave: returning 0");
     return MAX_ERR_NONE;
 
 error:
     py_handle_error(x, "py_edsave with (possible) execution failed");
     Py_XDECREF(pval); // not necessary
-    PyGILState_Release(gstate);
+    py_gil_release(x, gstate);
     py_debug(x, "py_edsave: returning 1");
     return MAX_ERR_GENERIC;
 }
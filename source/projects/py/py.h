@@ -41,20 +41,35 @@
 /* python */
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <marshal.h>
+
+/* system */
+#include <sys/stat.h>
 
 /* py default embedded module */
 #include "py_prelude.h"
 
+/* per-message latency metrics (shared with other python externals) */
+#include "../mamba/metrics.h"
+#include "../mamba/profile.h"
+#include "../mamba/memstats.h"
+#include "../mamba/codecache.h"
+
 /*--------------------------------------------------------------------------*/
 /* Constants */
 
 #define PY_MAX_ERROR 4096
 #define PY_MAX_ELEMS 1024
+#define PY_STACK_ARGS 16 // args passed without heap allocation by call / pipe / fold
+#define PY_LOOKUP_MAX 256 // cached name lookups per object before the cache is emptied
+#define PY_RELOAD_DELAY 100 // ms to wait for file changes to settle
 
 /*--------------------------------------------------------------------------*/
 /* Compile-time Options */
 
-#define PY_WITH_API 1
+#ifndef PY_WITH_API
+#define PY_WITH_API 1 // the cython `api` module (api.pyx), 0 builds without it
+#endif
 #define PY_CFG_ISOLATED 0
 #define PY_ATTRS_WITH_DEFAULTS 0
 #define PY_CHECK_REFS 0
@@ -64,7 +79,7 @@
 
 enum ARGUMENTS { A_NAME, NUM_ARGUMENTS };
 enum INLETS { I_INPUT, NUM_INLETS };
-enum OUTLETS { O_OUTPUT, O_FAILURE, O_SUCCESS, NUM_OUTLETS };
+enum OUTLETS { O_OUTPUT, O_FAILURE, O_SUCCESS, O_SCHED, NUM_OUTLETS };
 
 /*--------------------------------------------------------------------------*/
 /* Globals */
@@ -84,6 +99,8 @@ typedef struct t_py t_py;
 void* py_new(t_symbol* s, long argc, t_atom* argv);
 void py_free(t_py* x);
 void py_init(t_py* x);
+PyGILState_STATE py_gil_ensure(t_py* x);
+void py_gil_release(t_py* x, PyGILState_STATE state);
 
 /*--------------------------------------------------------------------------*/
 /* Attribute Getters / Setters and Helpers */
@@ -139,6 +156,29 @@ t_max_err py_handle_list_output(t_py* x, PyObject* plist);
 t_max_err py_handle_dict_output(t_py* x, PyObject* pdict);
 t_max_err py_handle_output(t_py* x, PyObject* pval);
 
+/*--------------------------------------------------------------------------*/
+/* Translators */
+
+PyObject* py_atoms_to_list(t_py* x, long argc, t_atom* argv, int start_from);
+PyObject* py_atom_to_pyobj(t_py* x, t_atom* atom);
+PyObject* py_lookup(t_py* x, t_symbol* sym);
+void py_lookup_clear(t_py* x);
+
+/*--------------------------------------------------------------------------*/
+/* Bytecode Cache */
+
+PyObject* py_compile_file(t_py* x, const char* path);
+
+/*--------------------------------------------------------------------------*/
+/* Hot Reload */
+
+PyObject* py_reload_snapshot(t_py* x);
+t_max_err py_reload_track(t_py* x, PyObject* before, const char* name);
+t_max_err py_reload_watch(t_py* x, const char* path);
+t_max_err py_reload(t_py* x);
+void py_reload_task(t_py* x);
+void py_filechanged(t_py* x, char* filename, short path);
+
 /*--------------------------------------------------------------------------*/
 /* Core Python Methods */
 
@@ -153,6 +193,7 @@ t_max_err py_execfile(t_py* x, t_symbol* s);
 t_max_err py_apply(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_assign(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_call(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_bind(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_code(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_pipe(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_product(t_py* x, t_symbol* s, long argc, t_atom* argv);
@@ -160,6 +201,18 @@ t_max_err py_fold(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_shell(t_py* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err py_anything(t_py* x, t_symbol* s, long argc, t_atom* argv);
 
+/*--------------------------------------------------------------------------*/
+/* Native Dispatch */
+
+typedef struct t_py_binding t_py_binding;
+
+t_max_err py_call_func(t_py* x, PyObject* func, const char* fname, long argc, t_atom* argv, t_metrics_span* span);
+void py_bind_track(t_symbol* target);
+PyObject* py_bound_func(t_py* x, t_py_binding* binding);
+t_max_err py_bound_call(t_py* x, t_py_binding* binding, long argc, t_atom* argv);
+void py_bind_clear(t_py* x);
+void py_bind_watch(t_py* x, int on);
+
 /*--------------------------------------------------------------------------*/
 /* Generic Python function wrappers */
 
@@ -173,6 +226,10 @@ t_max_err py_func_to_pyobj(t_py* x, const char* pyfunc_name, PyObject* obj);
 
 void py_count(t_py* x);
 void py_metadata(t_py* x);
+t_max_err py_metrics(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_trace(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_profile(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_memory(t_py* x, t_symbol* s, long argc, t_atom* argv);
 void py_assist(t_py* x, void* b, long m, long a, char* s);
 
 /*--------------------------------------------------------------------------*/
@@ -180,6 +237,11 @@ void py_assist(t_py* x, void* b, long m, long a, char* s);
 
 t_max_err py_task(t_py* x);
 t_max_err py_sched(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_every(t_py* x, t_symbol* s, long argc, t_atom* argv);
+t_max_err py_cancel(t_py* x, t_symbol* s, long argc, t_atom* argv);
+long py_sched_add(t_py* x, double delay, double period, long argc, t_atom* argv);
+void py_sched_clear(t_py* x);
+void py_sched_info(t_py* x);
 
 /*--------------------------------------------------------------------------*/
 /* Interobject Methods */
@@ -230,6 +292,43 @@ static inline PyCodeObject* PyFrame_GetCode(PyFrameObject* frame)
 }
 #endif
 
+// dict watchers invalidate `bind` caches when globals are reassigned
+#define PY_HAVE_DICT_WATCHER (PY_VERSION_HEX >= 0x030C0000)
+
+// vectorcall is used by call / pipe / fold
+#if PY_VERSION_HEX < 0x03080000
+#define PY_VECTORCALL_ARGUMENTS_OFFSET ((size_t)1 << (8 * sizeof(size_t) - 1))
+static inline PyObject* PyObject_Vectorcall(PyObject* callable, PyObject* const* args,
+                                            size_t nargsf, PyObject* kwnames)
+{
+    Py_ssize_t nargs = (Py_ssize_t)(nargsf & ~PY_VECTORCALL_ARGUMENTS_OFFSET);
+    Py_ssize_t nkw = kwnames ? PyTuple_GET_SIZE(kwnames) : 0;
+    PyObject* kwargs = NULL;
+    PyObject* result = NULL;
+    PyObject* pargs = PyTuple_New(nargs);
+    if (pargs == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < nargs; i++) {
+        Py_INCREF(args[i]);
+        PyTuple_SET_ITEM(pargs, i, args[i]);
+    }
+    if (nkw > 0 && (kwargs = PyDict_New()) != NULL) {
+        for (Py_ssize_t i = 0; i < nkw; i++) {
+            PyDict_SetItem(kwargs, PyTuple_GET_ITEM(kwnames, i), args[nargs + i]);
+        }
+    }
+    if (nkw == 0 || kwargs != NULL) {
+        result = PyObject_Call(callable, pargs, kwargs);
+    }
+    Py_DECREF(pargs);
+    Py_XDECREF(kwargs);
+    return result;
+}
+#elif PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
 #if PY_VERSION_HEX < 0x030A00B1 && !defined(Py_IsNone)
 #  define Py_Is(x, y) ((x) == (y))
 #  define Py_IsNone(x) Py_Is(x, Py_None)
@@ -2,6 +2,8 @@
 // generated by `py/scripts/py2c.py`
 
 static const char* PY_PRELUDE_MODULE =
+"\n"
+"\n"
 "import ast\n"
 "import os\n"
 "import subprocess\n"
@@ -9,6 +11,9 @@ static const char* PY_PRELUDE_MODULE =
 "import collections.abc\n"
 "import itertools\n"
 "import functools\n"
+"import importlib\n"
+"import sys\n"
+"import types\n"
 "from keyword import iskeyword as is_keyword\n"
 "from inspect import signature as __signature\n"
 "from typing import Any, Optional, Callable\n"
@@ -255,6 +260,107 @@ static const char* PY_PRELUDE_MODULE =
 "    f, args, kwds = __from_string(s, gdict)\n"
 "    return f(*args, **kwds)\n"
 "\n"
+"def __reload_snapshot() -> set:\n"
+"\n"
+"    return set(sys.modules)\n"
+"\n"
+"def __reload_is_user_module(mod: types.ModuleType) -> bool:\n"
+"\n"
+"    path = getattr(mod, \"__file__\", None)\n"
+"    if not path or not path.endswith(\".py\"):\n"
+"        return False\n"
+"    path = os.path.realpath(path)\n"
+"    for prefix in set([sys.prefix, sys.base_prefix, sys.exec_prefix]):\n"
+"        if path.startswith(os.path.realpath(prefix) + os.sep):\n"
+"            return False\n"
+"    return True\n"
+"\n"
+"def __reload_track(before: set, tracked: dict, name: Optional[str] = None) -> list:\n"
+"\n"
+"    names = set(sys.modules) - before\n"
+"    if name:\n"
+"        names.add(name)\n"
+"    paths = []\n"
+"    for name in names:\n"
+"        mod = sys.modules.get(name)\n"
+"        if name in tracked or mod is None or not __reload_is_user_module(mod):\n"
+"            continue\n"
+"        try:\n"
+"            tracked[name] = os.stat(mod.__file__).st_mtime_ns\n"
+"        except OSError:\n"
+"            continue\n"
+"        paths.append(mod.__file__)\n"
+"    return paths\n"
+"\n"
+"def __reload_deps(name: str, tracked: dict) -> set:\n"
+"\n"
+"    mod = sys.modules.get(name)\n"
+"    deps = set()\n"
+"    for val in (vars(mod).values() if mod else ()):\n"
+"        if isinstance(val, types.ModuleType):\n"
+"            dep = val.__name__\n"
+"        else:\n"
+"            dep = getattr(val, \"__module__\", None)\n"
+"        if dep in tracked and dep != name:\n"
+"            deps.add(dep)\n"
+"    return deps\n"
+"\n"
+"def __reload_order(changed: set, tracked: dict) -> list:\n"
+"\n"
+"    graph = {name: __reload_deps(name, tracked) for name in tracked}\n"
+"    affected = set(changed)\n"
+"    grown = True\n"
+"    while grown:\n"
+"        dependents = set(n for n, deps in graph.items() if deps & affected)\n"
+"        grown = not dependents <= affected\n"
+"        affected |= dependents\n"
+"    order = []\n"
+"\n"
+"    def visit(name, seen):\n"
+"        if name in order or name in seen:\n"
+"            return\n"
+"        seen.add(name)\n"
+"        for dep in sorted(graph[name] & affected):\n"
+"            visit(dep, seen)\n"
+"        order.append(name)\n"
+"\n"
+"    for name in sorted(affected):\n"
+"        visit(name, set())\n"
+"    return order\n"
+"\n"
+"def __reload(tracked: dict, gdict: Optional[dict] = None) -> list:\n"
+"\n"
+"    if not gdict:\n"
+"        gdict = globals()\n"
+"    changed = set()\n"
+"    for name, mtime in list(tracked.items()):\n"
+"        mod = sys.modules.get(name)\n"
+"        if mod is None:\n"
+"            del tracked[name]\n"
+"            continue\n"
+"        try:\n"
+"            current = os.stat(mod.__file__).st_mtime_ns\n"
+"        except OSError:\n"
+"            continue\n"
+"        if current != mtime:\n"
+"            tracked[name] = current\n"
+"            changed.add(name)\n"
+"    if not changed:\n"
+"        return []\n"
+"    order = __reload_order(changed, tracked)\n"
+"    for name in order:\n"
+"        importlib.reload(sys.modules[name])\n"
+"    for key, val in list(gdict.items()):\n"
+"        if isinstance(val, types.ModuleType):\n"
+"            continue  \n"
+"        modname = getattr(val, \"__module__\", None)\n"
+"        qualname = getattr(val, \"__qualname__\", None)\n"
+"        if modname in order and qualname and \".\" not in qualname:\n"
+"            new = getattr(sys.modules[modname], qualname, None)\n"
+"            if new is not None:\n"
+"                gdict[key] = new\n"
+"    return order\n"
+"\n"
 "def edit(path: str) -> None:\n"
 "\n"
 "    editor = os.getenv(\"EDITOR\", EDITOR)\n"
@@ -273,4 +379,5 @@ static const char* PY_PRELUDE_MODULE =
 "    name = func.__qualname__\n"
 "    signature = str(__signature(func))\n"
 "    return f\"<function {name}{signature}>\"\n"
+"\n"
 "\n";
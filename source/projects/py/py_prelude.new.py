@@ -11,6 +11,9 @@ import shlex
 import collections.abc
 import itertools
 import functools
+import importlib
+import sys
+import types
 from keyword import iskeyword as is_keyword
 from inspect import signature as __signature
 from typing import Any, Optional, Callable
@@ -420,6 +423,127 @@ def apply(s: str, gdict: Optional[dict] = None) -> Any:
     return f(*args, **kwds)
 
 
+# ---------------------------------------------------------
+# hot-reload
+
+
+def __reload_snapshot() -> set:
+    """names of the currently loaded modules"""
+    return set(sys.modules)
+
+
+def __reload_is_user_module(mod: types.ModuleType) -> bool:
+    """True if the module is python source outside of the python installation"""
+    path = getattr(mod, "__file__", None)
+    if not path or not path.endswith(".py"):
+        return False
+    path = os.path.realpath(path)
+    for prefix in set([sys.prefix, sys.base_prefix, sys.exec_prefix]):
+        if path.startswith(os.path.realpath(prefix) + os.sep):
+            return False
+    return True
+
+
+def __reload_track(before: set, tracked: dict, name: Optional[str] = None) -> list:
+    """add user modules loaded since `before` (and `name`) to `tracked`
+
+    `tracked` maps module names to the mtime (ns) of their file when they
+    were loaded. Returns the paths of the newly tracked module files.
+    """
+    names = set(sys.modules) - before
+    if name:
+        names.add(name)
+    paths = []
+    for name in names:
+        mod = sys.modules.get(name)
+        if name in tracked or mod is None or not __reload_is_user_module(mod):
+            continue
+        try:
+            tracked[name] = os.stat(mod.__file__).st_mtime_ns
+        except OSError:
+            continue
+        paths.append(mod.__file__)
+    return paths
+
+
+def __reload_deps(name: str, tracked: dict) -> set:
+    """tracked modules which module `name` refers to in its namespace"""
+    mod = sys.modules.get(name)
+    deps = set()
+    for val in (vars(mod).values() if mod else ()):
+        if isinstance(val, types.ModuleType):
+            dep = val.__name__
+        else:
+            dep = getattr(val, "__module__", None)
+        if dep in tracked and dep != name:
+            deps.add(dep)
+    return deps
+
+
+def __reload_order(changed: set, tracked: dict) -> list:
+    """changed modules and their dependents, dependencies first"""
+    graph = {name: __reload_deps(name, tracked) for name in tracked}
+    affected = set(changed)
+    grown = True
+    while grown:
+        dependents = set(n for n, deps in graph.items() if deps & affected)
+        grown = not dependents <= affected
+        affected |= dependents
+    order = []
+
+    def visit(name, seen):
+        if name in order or name in seen:
+            return
+        seen.add(name)
+        for dep in sorted(graph[name] & affected):
+            visit(dep, seen)
+        order.append(name)
+
+    for name in sorted(affected):
+        visit(name, set())
+    return order
+
+
+def __reload(tracked: dict, gdict: Optional[dict] = None) -> list:
+    """reload changed tracked modules and their dependents
+
+    Names in `gdict` bound to functions or classes of a reloaded module
+    (e.g. via `from mod import func`) are rebound to the new definitions,
+    so callables looked up by name (`call`, `sched`, ...) pick them up.
+    Returns the names of the reloaded modules in reload order.
+    """
+    if not gdict:
+        gdict = globals()
+    changed = set()
+    for name, mtime in list(tracked.items()):
+        mod = sys.modules.get(name)
+        if mod is None:
+            del tracked[name]
+            continue
+        try:
+            current = os.stat(mod.__file__).st_mtime_ns
+        except OSError:
+            continue
+        if current != mtime:
+            tracked[name] = current
+            changed.add(name)
+    if not changed:
+        return []
+    order = __reload_order(changed, tracked)
+    for name in order:
+        importlib.reload(sys.modules[name])
+    for key, val in list(gdict.items()):
+        if isinstance(val, types.ModuleType):
+            continue  # reloaded in place
+        modname = getattr(val, "__module__", None)
+        qualname = getattr(val, "__qualname__", None)
+        if modname in order and qualname and "." not in qualname:
+            new = getattr(sys.modules[modname], qualname, None)
+            if new is not None:
+                gdict[key] = new
+    return order
+
+
 # ---------------------------------------------------------
 # misc funcs
 
@@ -3,11 +3,12 @@
 """py2c -- Convert a python source file into a c-header"""
 
 import io
+import os
 import re
 import tokenize
 
 inputs = {
-    'py_prelude.py' : 'PY_PRELUDE_MODULE',
+    'py_prelude.new.py' : 'PY_PRELUDE_MODULE',
     # 'fn.py'     : 'PY_FUNCTIONAL_MODULE',
 }
 
@@ -82,33 +83,63 @@ def remove_multiple_empty_lines(contents):
     # ref: https://stackoverflow.com/questions/28901452/reduce-multiple-blank-lines-to-single-pythonically
     return re.sub(r'\n\s*\n', '\n\n', contents)
 
+def extract_section(lines, section):
+    """Returns the named section of 'lines' plus the imports it uses
+
+    Sections are delimited by a rule comment followed by a comment
+    naming the section, e.g. '# ---...' then '# hot-reload'.
+    """
+    body = []
+    inside = False
+    for i, line in enumerate(lines):
+        if line.startswith("# ---"):
+            if inside:
+                break
+            following = lines[i + 1].strip() if i + 1 < len(lines) else ""
+            inside = following == f"# {section}"
+        if inside:
+            body.append(line)
+    if not body:
+        raise SystemExit(f"py2c: section '{section}' not found")
+    text = "".join(body)
+    imports = []
+    for line in lines:
+        if line.startswith(("import ", "from ")):
+            names = line.split(" import ")[-1] if line.startswith("from ") else line[7:]
+            names = [n.split(" as ")[-1].strip().split(".")[0] for n in names.split(",")]
+            if any(re.search(rf"\b{re.escape(n)}\b", text) for n in names):
+                imports.append(line)
+    return imports + ["\n"] + body
+
+
+def convert(filename, varname, section=None,
+            strip_docstrings=True, strip_multiple_lines=True):
+    with open(filename) as f:
+        lines = f.readlines()
+    _lines = []
+    for line in lines:
+        if line.startswith("if __name__ == "):
+            break
+        _lines.append(line)
+    if section:
+        _lines = extract_section(_lines, section)
+    contents = "".join(_lines)
+
+    if strip_docstrings:
+        contents = remove_comments_and_docstrings(contents)
+    if strip_multiple_lines:
+        contents = remove_multiple_empty_lines(contents)
+    return to_cstr(contents, varname)
+
+
 def main(strip_docstrings=True, strip_multiple_lines=True):
     with open(OUTPUT, 'w') as outfile:
         print("// py_prelude.h: pure python functions for the `py` external", file=outfile)
         print("// generated by `py/scripts/py2c.py`", file=outfile)
         for filename in inputs:
-            with open(filename) as f:
-                lines = f.readlines()
-                _lines = []
-                include = True
-                for line in lines:
-                    if line.startswith("if __name__ == "):
-                        include = False
-                    if include:
-                        _lines.append(line)
-                contents = "".join(_lines)
-
-                if strip_docstrings:
-                    contents = remove_comments_and_docstrings(contents)
-                if strip_multiple_lines:
-                    contents = remove_multiple_empty_lines(contents)
-                print(to_cstr(contents, inputs[filename]), 
-                    file=outfile)
-
-
-if __name__ == '__main__':
-    import argparse
-    main()
+            print(convert(filename, inputs[filename], None,
+                          strip_docstrings, strip_multiple_lines),
+                file=outfile)
 
 
 if __name__ == '__main__':
@@ -120,9 +151,24 @@ if __name__ == '__main__':
     )
     parser.add_argument('-d', '--rm-docs', action='store_false', help="Remove comments and docstrings")
     parser.add_argument('-e', '--rm-empty-lines', action='store_false', help="Remove multiple empty lines")
+    parser.add_argument('-i', '--input', help="convert this file instead of the prelude")
+    parser.add_argument('-o', '--output', help="header to write (with --input)")
+    parser.add_argument('-n', '--name', help="name of the c-string variable (with --input)")
+    parser.add_argument('-s', '--section', help="only convert this section of --input")
 
     args = parser.parse_args()
-    main(
-        strip_docstrings=args.rm_docs,
-        strip_multiple_lines=args.rm_empty_lines
-    )
+    if args.input:
+        if not (args.output and args.name):
+            parser.error("--input requires --output and --name")
+        with open(args.output, 'w') as outfile:
+            print(f"// {os.path.basename(args.output)}: generated by `py/scripts/py2c.py`", file=outfile)
+            print(f"// from `{os.path.basename(args.input)}`" +
+                  (f" (section: {args.section})" if args.section else ""), file=outfile)
+            print(convert(args.input, args.name, args.section,
+                          args.rm_docs, args.rm_empty_lines),
+                file=outfile)
+    else:
+        main(
+            strip_docstrings=args.rm_docs,
+            strip_multiple_lines=args.rm_empty_lines
+        )
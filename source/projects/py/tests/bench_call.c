@@ -0,0 +1,155 @@
+/* bench_call.c -- call dispatch of the `py` external
+ *
+ * Runs the py external (included below, linked with the fake Max runtime
+ * of ../../mamba/tests/fakemax.c) and measures, for a message with three
+ * int args sent to a `py` object whose globals define f(a, b, c):
+ *
+ *  - call:  `call f 1 2 3`, i.e. py_call -> py_lookup -> py_call_func
+ *  - bound: `fb 1 2 3` after `bind fb f`, i.e. py_anything -> py_bound_call
+ *           -> py_bound_func -> py_call_func
+ *
+ * each once with a stable global and once with `f` reassigned (to another
+ * function) before every message, which invalidates the cached callable of
+ * the binding: a dict watcher from python 3.12, the per-message dict lookup
+ * on older versions. The cost of the reassignment itself is measured apart
+ * and subtracted.
+ *
+ * The outlets of the fake runtime print to stdout, which is silenced: the
+ * results are written to stderr.
+ *
+ * make bench_call && ./bench_call
+ */
+
+#include "../py.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#define N_CALLS 200000
+#define N_ARGS 3
+
+static long failures = 0; // messages which did not reach f
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double elapsed)
+{
+    fprintf(stderr, "%-28s %10.0f calls/sec  (%.3f us/call)\n", name,
+            N_CALLS / elapsed, elapsed * 1e6 / N_CALLS);
+}
+
+/** send `<sel> <sym>...` to the object's method `m` */
+static void send(t_py* x, t_max_err (*m)(t_py*, t_symbol*, long, t_atom*),
+                 const char* sel, long argc, const char** syms)
+{
+    t_atom argv[2];
+
+    for (long i = 0; i < argc; i++) {
+        atom_setsym(argv + i, gensym(syms[i]));
+    }
+    m(x, gensym(sel), argc, argv);
+}
+
+/** rebind the global `f` to `funcs[i % 2]`: f itself or its copy g */
+static void reassign(t_py* x, PyObject** funcs, int i)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyDict_SetItemString(x->python.globals, "f", funcs[i % 2]);
+    PyGILState_Release(gstate);
+}
+
+static double bench_reassign(t_py* x, PyObject** funcs)
+{
+    double start = now();
+    for (int i = 0; i < N_CALLS; i++) {
+        reassign(x, funcs, i);
+    }
+    return now() - start;
+}
+
+static double bench_call(t_py* x, PyObject** funcs)
+{
+    t_atom args[N_ARGS + 1];
+
+    atom_setsym(args, gensym("f"));
+    for (int j = 0; j < N_ARGS; j++) {
+        atom_setlong(args + j + 1, j + 1);
+    }
+    double start = now();
+    for (int i = 0; i < N_CALLS; i++) {
+        if (funcs) {
+            reassign(x, funcs, i);
+        }
+        failures += py_call(x, gensym("call"), N_ARGS + 1, args) != MAX_ERR_NONE;
+    }
+    return now() - start;
+}
+
+static double bench_bound(t_py* x, PyObject** funcs)
+{
+    t_atom args[N_ARGS];
+    t_symbol* name = gensym("fb");
+
+    for (int j = 0; j < N_ARGS; j++) {
+        atom_setlong(args + j, j + 1);
+    }
+    double start = now();
+    for (int i = 0; i < N_CALLS; i++) {
+        if (funcs) {
+            reassign(x, funcs, i);
+        }
+        failures += py_anything(x, name, N_ARGS, args) != MAX_ERR_NONE;
+    }
+    return now() - start;
+}
+
+int main(int argc, char* argv[])
+{
+    PyObject* funcs[2];
+    PyGILState_STATE gstate;
+    double base;
+    t_py* x;
+
+    freopen("/dev/null", "w", stdout);
+
+    ext_main(NULL);
+    x = (t_py*)py_new(gensym("py"), 0, NULL);
+    send(x, py_exec, "exec", 1, (const char*[]){"def f(a, b, c): return a + b + c"});
+    send(x, py_exec, "exec", 1, (const char*[]){"def g(a, b, c): return a + b + c"});
+    send(x, py_bind, "bind", 2, (const char*[]){"fb", "f"});
+
+    gstate = PyGILState_Ensure();
+    funcs[0] = PyDict_GetItemString(x->python.globals, "f");
+    funcs[1] = PyDict_GetItemString(x->python.globals, "g");
+    Py_INCREF(funcs[0]);
+    Py_INCREF(funcs[1]);
+    PyGILState_Release(gstate);
+
+    fprintf(stderr, "python %s: %d messages to f(a, b, c)\n\n", PY_VERSION,
+            N_CALLS);
+    report("call f 1 2 3", bench_call(x, NULL));
+    report("fb 1 2 3 (bound)", bench_bound(x, NULL));
+
+    base = bench_reassign(x, funcs);
+    fprintf(stderr, "\nwith f reassigned before each message (%.3f us/reassign"
+                    " subtracted):\n", base * 1e6 / N_CALLS);
+    report("call f 1 2 3", bench_call(x, funcs) - base);
+    report("fb 1 2 3 (bound)", bench_bound(x, funcs) - base);
+
+    gstate = PyGILState_Ensure();
+    Py_DECREF(funcs[0]);
+    Py_DECREF(funcs[1]);
+    PyGILState_Release(gstate);
+    object_free(x);
+
+    if (failures) {
+        fprintf(stderr, "bench_call: %ld messages failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+import ast
+import os
+import sys
+from pathlib import Path
+
+from builder.trace import ImportTracer, PRELUDE
+
+
+def prelude_imports():
+    """top-level names of the modules imported by the py prelude"""
+    names = set()
+    for node in ast.parse(PRELUDE.read_text(encoding="utf8")).body:
+        if isinstance(node, ast.Import):
+            names.update(alias.name.split(".")[0] for alias in node.names)
+        elif isinstance(node, ast.ImportFrom):
+            names.add(node.module.split(".")[0])
+    return names
+
+
+def test_trace_keeps_prelude_imports(tmp_path):
+    script = tmp_path / "empty.py"
+    script.write_text("", encoding="utf8")
+    tracer = ImportTracer(sys.executable, Path(os.__file__).parent, [script])
+    tracer.trace()
+    assert "subprocess" in prelude_imports()
+    unused = set(name.split(".")[0] for name in tracer.unused_packages())
+    assert not prelude_imports() & unused
@@ -6,6 +6,25 @@
 /*--------------------------------------------------------------------------*/
 /* Datastructures */
 
+/**
+ * @brief Python callable returned to javascript as an integer handle
+ *
+ * The handle is `gen << PYJS_HANDLE_INDEX_BITS | (slot index + 1)`. A slot
+ * is free when `func` is NULL; releasing it bumps `gen`, so a handle kept
+ * after its release is rejected rather than reaching the slot's next
+ * callable. Handles stay below 2^53: exact as javascript numbers.
+ */
+#define PYJS_HANDLE_INDEX_BITS 20
+#define PYJS_HANDLE_INDEX_MASK ((1L << PYJS_HANDLE_INDEX_BITS) - 1)
+#define PYJS_HANDLE_GEN_MASK   0x7fffffffL
+#define PYJS_HANDLE_MAX_SLOTS  PYJS_HANDLE_INDEX_MASK
+
+typedef struct t_pyjs_handle {
+    PyObject* func;            /*!< callable (strong reference) */
+    long refs;                 /*!< `func`/`retain` count minus `release` */
+    long gen;                  /*!< generation, bumped when released */
+} t_pyjs_handle;
+
 struct t_pyjs {
     /* object header */
     t_object p_ob;             /*!< object header */
@@ -15,8 +34,32 @@ struct t_pyjs {
     t_symbol* p_pythonpath;    /*!< path to python directory */
     t_symbol* p_code_filepath; /*!< python filepath */
     t_bool p_debug;            /*!< bool to switch per-object debug state */
+    /* javascript bridge */
+    PyObject* p_json_dumps;    /*!< cached json.dumps */
+    t_buffer_ref* p_buffer_ref; /*!< target of eval_to_buffer */
+    t_dictionary* p_dict;      /*!< registered result of eval_to_dict */
+    t_symbol* p_dict_name;     /*!< registered name of p_dict */
+    /* callable handles */
+    t_pyjs_handle* p_handles;  /*!< slots of callables returned by `func` */
+    long p_handles_len;        /*!< number of slots */
+    /* instrumentation */
+    t_metrics* p_metrics;      /*!< per-message latency metrics */
 };
 
+/**
+ * @brief Read-only view of a python sequence for bulk conversion
+ *
+ * Buffer-protocol objects (array.array, memoryview, numpy arrays) with a
+ * native numeric format are read in place; other sequences are read
+ * through PySequence_Fast without creating an iterator.
+ */
+typedef struct t_pyjs_seq {
+    Py_buffer view;            /*!< contiguous buffer, if view.obj != NULL */
+    char code;                 /*!< struct format code of the view */
+    PyObject* fast;            /*!< list or tuple otherwise */
+    Py_ssize_t size;           /*!< number of items */
+} t_pyjs_seq;
+
 /*--------------------------------------------------------------------------*/
 /* Globals */
 
@@ -40,6 +83,15 @@ void ext_main(void* module_ref)
     class_addmethod(c, (method)pyjs_execfile,     "execfile",     A_SYM, 0);
     class_addmethod(c, (method)pyjs_code,         "code",         A_GIMMEBACK, 0);
     class_addmethod(c, (method)pyjs_eval_to_json, "eval_to_json", A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_eval_to_buffer, "eval_to_buffer", A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_eval_to_dict, "eval_to_dict", A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_func,         "func",         A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_call,         "call",         A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_retain,       "retain",       A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_release,      "release",      A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_metrics,      "metrics",      A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_trace,        "trace",        A_GIMMEBACK, 0);
+    class_addmethod(c, (method)pyjs_profile,      "profile",      A_GIMMEBACK, 0);
 
     /* attributes */
     CLASS_ATTR_SYM(c, "name",       0, t_pyjs, p_name);
@@ -82,6 +134,13 @@ void* pyjs_new(t_symbol* s, long argc, t_atom* argv)
         x->p_pythonpath = gensym("");
         x->p_debug = 1;
         x->p_code_filepath = gensym("");
+        x->p_json_dumps = NULL;
+        x->p_buffer_ref = NULL;
+        x->p_dict = NULL;
+        x->p_dict_name = NULL;
+        x->p_handles = NULL;
+        x->p_handles_len = 0;
+        x->p_metrics = metrics_new();
 
         /* process @arg attributes */
         attr_args_process(x, argc, argv);
@@ -99,6 +158,20 @@ void* pyjs_new(t_symbol* s, long argc, t_atom* argv)
  */
 void pyjs_free(t_pyjs* x)
 {
+    if (x->p_buffer_ref) {
+        object_free(x->p_buffer_ref);
+    }
+    if (x->p_dict) {
+        object_free(x->p_dict);
+    }
+    for (long i = 0; i < x->p_handles_len; i++) {
+        Py_XDECREF(x->p_handles[i].func);
+    }
+    if (x->p_handles) {
+        sysmem_freeptr(x->p_handles);
+    }
+    metrics_free(x->p_metrics);
+    Py_XDECREF(x->p_json_dumps);
     Py_XDECREF(x->p_globals);
     pyjs_log(x, "will be deleted");
 
@@ -108,6 +181,7 @@ void pyjs_free(t_pyjs* x)
      */
     pyjs_global_obj_count--;
     if (pyjs_global_obj_count == 0) {
+        profile_free();
         Py_FinalizeEx(); // or Py_Finalize()
     }
 }
@@ -412,6 +486,145 @@ void pyjs_handle_error(t_pyjs* x, char* fmt, ...)
 }
 
 
+/**
+ * @brief      Open a bulk view of a sequence or buffer-protocol object
+ *
+ * @param      seq   view to initialize, release with `pyjs_seq_close`
+ * @param      pval  python object
+ *
+ * @return     The t_max_err error (with a python error set).
+ */
+static t_max_err pyjs_seq_open(t_pyjs_seq* seq, PyObject* pval)
+{
+    seq->view.obj = NULL;
+    seq->fast = NULL;
+    seq->code = 0;
+    seq->size = 0;
+
+    if (PyObject_CheckBuffer(pval) && !PyBytes_Check(pval)
+        && !PyByteArray_Check(pval)) {
+        if (PyObject_GetBuffer(pval, &seq->view,
+                               PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0) {
+            const char* fmt = seq->view.format ? seq->view.format : "B";
+            if (*fmt == '@') {
+                fmt++;
+            }
+            if (fmt[0] && !fmt[1] && strchr("bBhHiIlLqQfd?", fmt[0])) {
+                seq->code = fmt[0];
+                seq->size = seq->view.len / seq->view.itemsize;
+                return MAX_ERR_NONE;
+            }
+            PyBuffer_Release(&seq->view);
+        }
+        // non-contiguous or non-numeric: read it as a sequence
+        PyErr_Clear();
+    }
+
+    seq->fast = PySequence_Fast(pval, "expected a sequence");
+    if (seq->fast == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+    seq->size = PySequence_Fast_GET_SIZE(seq->fast);
+    return MAX_ERR_NONE;
+}
+
+static void pyjs_seq_close(t_pyjs_seq* seq)
+{
+    if (seq->view.obj) {
+        PyBuffer_Release(&seq->view);
+    }
+    Py_CLEAR(seq->fast);
+}
+
+/**
+ * @brief      Read item `i` of a buffer view
+ *
+ * @return     1 if the item is a float (in `*f`), 0 if an integer (in `*l`)
+ */
+static int pyjs_seq_read_view(const t_pyjs_seq* seq, Py_ssize_t i, double* f,
+                              t_atom_long* l)
+{
+    const char* p = (const char*)seq->view.buf + i * seq->view.itemsize;
+
+#define PYJS_READ(type, dst) { type v; memcpy(&v, p, sizeof(v)); *dst = v; }
+    switch (seq->code) {
+    case 'f': PYJS_READ(float, f); return 1;
+    case 'd': PYJS_READ(double, f); return 1;
+    case 'b': PYJS_READ(signed char, l); return 0;
+    case 'B': PYJS_READ(unsigned char, l); return 0;
+    case '?': PYJS_READ(unsigned char, l); return 0;
+    case 'h': PYJS_READ(short, l); return 0;
+    case 'H': PYJS_READ(unsigned short, l); return 0;
+    case 'i': PYJS_READ(int, l); return 0;
+    case 'I': PYJS_READ(unsigned int, l); return 0;
+    case 'l': PYJS_READ(long, l); return 0;
+    case 'L': PYJS_READ(unsigned long, l); return 0;
+    case 'q': PYJS_READ(long long, l); return 0;
+    default:  PYJS_READ(unsigned long long, l); return 0;
+    }
+#undef PYJS_READ
+}
+
+/**
+ * @brief      Convert item `i` to an atom
+ *
+ * @return     1 if set, 0 if the item has no atom type (skipped), -1 on error
+ */
+static int pyjs_seq_atom(const t_pyjs_seq* seq, Py_ssize_t i, t_atom* atom)
+{
+    PyObject* item = NULL;
+    double f;
+    t_atom_long l;
+
+    if (seq->view.obj) {
+        if (pyjs_seq_read_view(seq, i, &f, &l)) {
+            atom_setfloat(atom, f);
+        } else {
+            atom_setlong(atom, l);
+        }
+        return 1;
+    }
+
+    item = PySequence_Fast_GET_ITEM(seq->fast, i); // borrowed
+    if (PyFloat_Check(item)) {
+        atom_setfloat(atom, PyFloat_AS_DOUBLE(item));
+        return 1;
+    }
+    if (PyLong_Check(item)) {
+        l = PyLong_AsLongLong(item);
+        if (l == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+        atom_setlong(atom, l);
+        return 1;
+    }
+    if (PyUnicode_Check(item)) {
+        const char* unicode_item = PyUnicode_AsUTF8(item);
+        if (unicode_item == NULL) {
+            return -1;
+        }
+        atom_setsym(atom, gensym(unicode_item));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief      Convert item `i` to a sample value
+ *
+ * @return     the value, or -1.0 with a python error set
+ */
+static double pyjs_seq_float(const t_pyjs_seq* seq, Py_ssize_t i)
+{
+    double f;
+    t_atom_long l;
+
+    if (seq->view.obj) {
+        return pyjs_seq_read_view(seq, i, &f, &l) ? f : (double)l;
+    }
+    return PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq->fast, i));
+}
+
 /**
  * @brief      Handler to output python float as max float
  *
@@ -528,113 +741,64 @@ error:
  * @brief      Handler to output python list as max list
  *
  * @param      x      pointer to object struct
- * @param      plist  python list object
+ * @param      plist  python sequence or buffer-protocol object
  * @param      rv     atom vector to populate in-place
  *
  * @return     The t_max_err error.
+ *
+ * Buffer-protocol objects with a numeric format (array.array, memoryview,
+ * numpy arrays) are copied straight from memory; lists and tuples are read
+ * without an iterator. Items without an atom type are skipped.
  */
 t_max_err pyjs_handle_list_output(t_pyjs* x, PyObject* plist, t_atom* rv)
 {
+    t_pyjs_seq seq = {0};
+    t_atom* atoms = NULL;
+    long ac = 0;
+    int res;
+
     if (plist == NULL) {
         goto error;
     }
 
-    if (PySequence_Check(plist) && !PyUnicode_Check(plist)
-        && !PyBytes_Check(plist) && !PyByteArray_Check(plist)) {
-        PyObject* iter = NULL;
-        PyObject* item = NULL;
-        int i = 0;
-
-        t_atom atoms_static[PY_MAX_ELEMS];
-        t_atom* atoms = NULL;
-        int is_dynamic = 0;
-
-        Py_ssize_t seq_size = PySequence_Length(plist);
-
-        if (seq_size == 0) {
-            pyjs_error(x, "cannot convert py list of length 0 to atoms");
-            goto error;
-        }
+    if (pyjs_seq_open(&seq, plist) != MAX_ERR_NONE) {
+        goto error;
+    }
 
-        if (seq_size > PY_MAX_ELEMS) {
-            pyjs_log(x, "dynamically increasing size of atom array");
-            atoms = atom_dynamic_start(atoms_static, PY_MAX_ELEMS,
-                                       seq_size + 1);
-            is_dynamic = 1;
+    if (seq.size == 0) {
+        pyjs_error(x, "cannot convert py list of length 0 to atoms");
+        goto error;
+    }
 
-        } else {
-            atoms = atoms_static;
-        }
+    atoms = (t_atom*)sysmem_newptr(sizeof(t_atom) * seq.size);
+    if (atoms == NULL) {
+        pyjs_error(x, "cannot allocate %ld atoms", (long)seq.size);
+        goto error;
+    }
 
-        if ((iter = PyObject_GetIter(plist)) == NULL) {
+    for (Py_ssize_t i = 0; i < seq.size; i++) {
+        if ((res = pyjs_seq_atom(&seq, i, atoms + ac)) < 0) {
             goto error;
         }
-
-        while ((item = PyIter_Next(iter)) != NULL) {
-
-            if (PyFloat_Check(item)) {
-                float float_item = PyFloat_AsDouble(item);
-                if (float_item == -1.0) {
-                    if (PyErr_Occurred()) {
-                        goto error;
-                    }
-                }
-                atom_setfloat(atoms + i, float_item);
-                pyjs_log(x, "%d float: %f\n", i, float_item);
-                i++;
-            }
-
-            if (PyLong_Check(item)) {
-                long long_item = PyLong_AsLong(item);
-                if (long_item == -1) {
-                    if (PyErr_Occurred()) {
-                        goto error;
-                    }
-                }
-                atom_setlong(atoms + i, long_item);
-                pyjs_log(x, "%d long: %ld\n", i, long_item);
-                i++;
-            }
-
-            // only for numpy int64 (not recognized by PyLong_Check)
-            // if (PyNumber_Check(item)) {
-            //     long long_item = PyLong_AsLong(item);
-            //     if (long_item == -1) {
-            //         if (PyErr_Occurred())
-            //             goto error;
-            //     }
-            //     atom_setlong(atoms + i, long_item);
-            //     pyjs_log(x, "%d long: %ld\n", i, long_item);
-            //     i++;
-            // }
-
-            if (PyUnicode_Check(item)) {
-                const char* unicode_item = PyUnicode_AsUTF8(item);
-                if (unicode_item == NULL) {
-                    goto error;
-                }
-                atom_setsym(atoms + i, gensym(unicode_item));
-                pyjs_log(x, "%d unicode: %s\n", i, unicode_item);
-                i++;
-            }
-            Py_DECREF(item);
-        }
-
-        atom_setobj(
-            rv,
-            object_new(gensym("nobox"), gensym("atomarray"), (long)i, atoms));
-        pyjs_log(x, "end iter op: %d", i);
-        if (is_dynamic) {
-            pyjs_log(x, "restoring to static atom array");
-            atom_dynamic_end(atoms_static, atoms);
-        }
+        ac += res;
     }
 
+    atom_setobj(
+        rv,
+        object_new(gensym("nobox"), gensym("atomarray"), ac, atoms));
+    pyjs_log(x, "list output: %ld atoms", ac);
+
+    sysmem_freeptr(atoms);
+    pyjs_seq_close(&seq);
     Py_XDECREF(plist);
     return MAX_ERR_NONE;
 
 error:
     pyjs_handle_error(x, "pyjs_handle_list_output failed");
+    if (atoms) {
+        sysmem_freeptr(atoms);
+    }
+    pyjs_seq_close(&seq);
     Py_XDECREF(plist);
     return MAX_ERR_GENERIC;
 }
@@ -734,8 +898,8 @@ t_max_err pyjs_handle_output(t_pyjs* x, PyObject* pval, t_atom* rv)
         return pyjs_handle_string_output(x, pval, rv);
     }
 
-    if (PySequence_Check(pval) && !PyBytes_Check(pval)
-             && !PyByteArray_Check(pval)) {
+    if ((PySequence_Check(pval) || PyObject_CheckBuffer(pval))
+        && !PyBytes_Check(pval) && !PyByteArray_Check(pval)) {
         return pyjs_handle_list_output(x, pval, rv);
     }
 
@@ -776,7 +940,9 @@ t_max_err pyjs_code(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
     PyObject* pval = NULL;
     t_max_err err;
     int is_eval = 1;
+    t_metrics_span span;
 
+    metrics_begin(&span, METRICS_CODE);
     err = atom_gettext(argc, argv, &textsize, &text,
                        OBEX_UTIL_ATOM_GETTEXT_DEFAULT);
     if (err == MAX_ERR_NONE && textsize && text) {
@@ -798,8 +964,10 @@ t_max_err pyjs_code(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
         goto error;
     }
     sysmem_freeptr(text);
+    metrics_convert(&span);
 
     pval = PyEval_EvalCode(co, x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
@@ -807,14 +975,17 @@ t_max_err pyjs_code(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
 
     if (is_eval) {
         pyjs_handle_output(x, pval, rv);
+        metrics_convert(&span);
     } else {
         Py_XDECREF(pval);
     }
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     pyjs_handle_error(x, "pyjs code failed");
     Py_XDECREF(pval);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -829,9 +1000,12 @@ error:
 t_max_err pyjs_import(t_pyjs* x, t_symbol* s)
 {
     PyObject* x_module = NULL;
+    t_metrics_span span;
 
+    metrics_begin(&span, METRICS_IMPORT);
     if (s != gensym("")) {
         x_module = PyImport_ImportModule(s->s_name);
+        metrics_exec(&span);
 
         if (x_module == NULL) {
             goto error;
@@ -839,11 +1013,13 @@ t_max_err pyjs_import(t_pyjs* x, t_symbol* s)
 
         PyDict_SetItemString(x->p_globals, s->s_name, x_module);
         pyjs_log(x, "imported: %s", s->s_name);
+        metrics_end(x->p_metrics, &span, 1);
         return MAX_ERR_NONE;
     }
 
 error:
     pyjs_handle_error(x, "import %s", s->s_name);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -862,17 +1038,23 @@ error:
 t_max_err pyjs_eval(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
                     t_atom* rv)
 {
+    t_metrics_span span;
     char* py_argv = atom_getsym(argv)->s_name;
     pyjs_log(x, "%s %s", s->s_name, py_argv);
 
+    metrics_begin(&span, METRICS_EVAL);
     PyObject* pval = PyRun_String(py_argv, Py_eval_input, x->p_globals,
                                   x->p_globals);
+    metrics_exec(&span);
 
     if (pval != NULL) {
         pyjs_handle_output(x, pval, rv);
+        metrics_convert(&span);
+        metrics_end(x->p_metrics, &span, 1);
         return MAX_ERR_NONE;
     } else {
         pyjs_handle_error(x, "eval %s", py_argv);
+        metrics_end(x->p_metrics, &span, 0);
         return MAX_ERR_GENERIC;
     }
 }
@@ -889,7 +1071,9 @@ t_max_err pyjs_execfile(t_pyjs* x, t_symbol* s)
 {
     PyObject* pval = NULL;
     FILE* fhandle = NULL;
+    t_metrics_span span;
 
+    metrics_begin(&span, METRICS_EXECFILE);
     if (s != gensym("")) {
         // set x->p_code_filepath
         pyjs_locate_path_from_symbol(x, s);
@@ -912,6 +1096,7 @@ t_max_err pyjs_execfile(t_pyjs* x, t_symbol* s)
 
     pval = PyRun_File(fhandle, x->p_code_filepath->s_name, Py_file_input,
                       x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         fclose(fhandle);
         goto error;
@@ -920,11 +1105,13 @@ t_max_err pyjs_execfile(t_pyjs* x, t_symbol* s)
     // success cleanup
     fclose(fhandle);
     Py_DECREF(pval);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     pyjs_handle_error(x, "execfile failed");
     Py_XDECREF(pval);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -939,7 +1126,9 @@ error:
 t_max_err pyjs_exec(t_pyjs* x, t_symbol* s)
 {
     PyObject* pval = NULL;
+    t_metrics_span span;
 
+    metrics_begin(&span, METRICS_EXEC);
     if (s == gensym("")) {
         pyjs_log(x, "no input given");
         goto error;
@@ -947,6 +1136,7 @@ t_max_err pyjs_exec(t_pyjs* x, t_symbol* s)
 
     pval = PyRun_String(s->s_name, Py_single_input, x->p_globals,
                         x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
@@ -954,11 +1144,13 @@ t_max_err pyjs_exec(t_pyjs* x, t_symbol* s)
     // success cleanup
     Py_DECREF(pval);
     pyjs_log(x, "exec %s", s->s_name);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
     pyjs_handle_error(x, "exec %s", s->s_name);
     Py_XDECREF(pval);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
 
@@ -979,33 +1171,30 @@ t_max_err pyjs_eval_to_json(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
     t_atom atoms[PY_MAX_ELEMS];
     PyObject* pval = NULL;
     PyObject* json_module = NULL;
-    PyObject* json_dict = NULL;
-    PyObject* json_dumps = NULL;
     PyObject* json_pstr = NULL;
+    t_metrics_span span;
 
     char* cstring = atom_getsym(argv)->s_name;
 
+    metrics_begin(&span, METRICS_EVAL);
     pval = PyRun_String(cstring, Py_eval_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
     if (pval == NULL) {
         goto error;
     }
 
-    json_module = PyImport_ImportModule("json");
-    if (json_module == NULL) {
-        goto error;
-    }
-
-    json_dict = PyModule_GetDict(json_module); // borrowed ref
-    if (json_dict == NULL) {
-        goto error;
-    }
-
-    json_dumps = PyDict_GetItemString(json_dict, "dumps"); // borrowed ref
-    if (json_dumps == NULL) {
-        goto error;
+    if (x->p_json_dumps == NULL) {
+        json_module = PyImport_ImportModule("json");
+        if (json_module == NULL) {
+            goto error;
+        }
+        x->p_json_dumps = PyObject_GetAttrString(json_module, "dumps");
+        if (x->p_json_dumps == NULL) {
+            goto error;
+        }
     }
 
-    json_pstr = PyObject_CallFunctionObjArgs(json_dumps, pval, NULL);
+    json_pstr = PyObject_CallFunctionObjArgs(x->p_json_dumps, pval, NULL);
     if (json_pstr == NULL) {
         goto error;
     }
@@ -1023,6 +1212,8 @@ t_max_err pyjs_eval_to_json(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
     Py_XDECREF(json_module);
     Py_XDECREF(json_pstr);
 
+    metrics_convert(&span);
+    metrics_end(x->p_metrics, &span, 1);
     return MAX_ERR_NONE;
 
 error:
@@ -1030,5 +1221,694 @@ error:
     Py_XDECREF(pval);
     Py_XDECREF(json_module);
     Py_XDECREF(json_pstr);
+    metrics_end(x->p_metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief      Evaluates python code and writes the result into a buffer~
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  The count of arguments
+ * @param      argv  buffer~ name followed by python expression
+ * @param      rv    atom vector to populate in-place (frame count)
+ *
+ * @return     The t_max_err error.
+ *
+ * The buffer~ is resized to the length of the result and the values are
+ * written to its first channel, so javascript can read them back with
+ * `Buffer.peek` without any string conversion.
+ */
+t_max_err pyjs_eval_to_buffer(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                              t_atom* rv)
+{
+    t_pyjs_seq seq = {0};
+    t_atom atoms[1];
+    t_atom size;
+    PyObject* pval = NULL;
+    t_buffer_obj* buffer = NULL;
+    float* samples = NULL;
+    long nchans;
+    t_metrics_span span;
+
+    if (argc < 2 || atom_gettype(argv) != A_SYM
+        || atom_gettype(argv + 1) != A_SYM) {
+        pyjs_error(x, "eval_to_buffer: expected <buffer~ name> <expression>");
+        return MAX_ERR_GENERIC;
+    }
+
+    t_symbol* buffer_name = atom_getsym(argv);
+    char* cstring = atom_getsym(argv + 1)->s_name;
+
+    metrics_begin(&span, METRICS_EVAL);
+    pval = PyRun_String(cstring, Py_eval_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
+    if (pval == NULL) {
+        goto error;
+    }
+
+    if (pyjs_seq_open(&seq, pval) != MAX_ERR_NONE) {
+        goto error;
+    }
+
+    // check items before resizing so a bad result leaves the buffer~ alone
+    for (Py_ssize_t i = 0; seq.fast && i < seq.size; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(seq.fast, i);
+        if (!PyFloat_Check(item) && !PyLong_Check(item)) {
+            PyErr_Format(PyExc_TypeError, "item %zd is %s, not a number", i,
+                         Py_TYPE(item)->tp_name);
+            goto error;
+        }
+    }
+
+    if (x->p_buffer_ref == NULL) {
+        x->p_buffer_ref = buffer_ref_new((t_object*)x, buffer_name);
+    } else {
+        buffer_ref_set(x->p_buffer_ref, buffer_name);
+    }
+
+    buffer = buffer_ref_getobject(x->p_buffer_ref);
+    if (buffer == NULL) {
+        pyjs_error(x, "eval_to_buffer: no buffer~ named %s",
+                   buffer_name->s_name);
+        goto error;
+    }
+
+    if (buffer_getframecount(buffer) != seq.size) {
+        atom_setlong(&size, seq.size);
+        buffer_edit_begin(buffer);
+        object_method_typed(buffer, gensym("sizeinsamps"), 1, &size, NULL);
+        buffer_edit_end(buffer, 1);
+    }
+
+    nchans = buffer_getchannelcount(buffer);
+    samples = buffer_locksamples(buffer);
+    if (samples == NULL) {
+        pyjs_error(x, "eval_to_buffer: could not lock %s",
+                   buffer_name->s_name);
+        goto error;
+    }
+
+    for (Py_ssize_t i = 0; i < seq.size; i++) {
+        double f = pyjs_seq_float(&seq, i);
+        if (f == -1.0 && PyErr_Occurred()) {
+            buffer_unlocksamples(buffer);
+            goto error;
+        }
+        samples[i * nchans] = (float)f;
+    }
+
+    buffer_setdirty(buffer);
+    buffer_unlocksamples(buffer);
+
+    atom_setlong(atoms, seq.size);
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+
+    pyjs_seq_close(&seq);
+    Py_XDECREF(pval);
+    metrics_convert(&span);
+    metrics_end(x->p_metrics, &span, 1);
+    return MAX_ERR_NONE;
+
+error:
+    pyjs_handle_error(x, "pyjs_eval_to_buffer failed");
+    pyjs_seq_close(&seq);
+    Py_XDECREF(pval);
+    metrics_end(x->p_metrics, &span, 0);
     return MAX_ERR_GENERIC;
 }
+
+/**
+ * @brief      Evaluates python code and returns the name of a dictionary
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array (python expression)
+ * @param      rv    atom vector to populate in-place (dictionary name)
+ *
+ * @return     The t_max_err error.
+ *
+ * The result (a python dict) is copied into a registered dictionary owned
+ * by this object, which javascript opens with `new Dict(name)`. The
+ * dictionary is reused, so its contents are only valid until the next call.
+ */
+t_max_err pyjs_eval_to_dict(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                            t_atom* rv)
+{
+    t_atom atoms[1];
+    PyObject* pval = NULL;
+    t_metrics_span span;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        pyjs_error(x, "eval_to_dict: expected <expression>");
+        return MAX_ERR_GENERIC;
+    }
+
+    char* cstring = atom_getsym(argv)->s_name;
+
+    metrics_begin(&span, METRICS_EVAL);
+    pval = PyRun_String(cstring, Py_eval_input, x->p_globals, x->p_globals);
+    metrics_exec(&span);
+    if (pval == NULL) {
+        goto error;
+    }
+
+    if (!PyDict_Check(pval)) {
+        PyErr_Format(PyExc_TypeError, "expected a dict, got %s",
+                     Py_TYPE(pval)->tp_name);
+        goto error;
+    }
+
+    if (x->p_dict == NULL) {
+        x->p_dict = dictionary_new();
+        x->p_dict_name = NULL;
+        x->p_dict = dictobj_register(x->p_dict, &x->p_dict_name);
+    } else {
+        dictionary_clear(x->p_dict);
+    }
+
+    if (pyjs_dict_from_py(x, pval, x->p_dict) != MAX_ERR_NONE) {
+        goto error;
+    }
+
+    atom_setsym(atoms, x->p_dict_name);
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+
+    Py_XDECREF(pval);
+    metrics_convert(&span);
+    metrics_end(x->p_metrics, &span, 1);
+    return MAX_ERR_NONE;
+
+error:
+    pyjs_handle_error(x, "pyjs_eval_to_dict failed");
+    Py_XDECREF(pval);
+    metrics_end(x->p_metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief      Copies a python dict into a max dictionary
+ *
+ * @param      x      pointer to object struct
+ * @param      pdict  python dict (borrowed)
+ * @param      d      dictionary to append to
+ *
+ * @return     The t_max_err error (with a python error set).
+ *
+ * Nested dicts become sub-dictionaries, sequences become atom lists,
+ * `None` becomes the symbol `null` and other values their `str()`.
+ */
+t_max_err pyjs_dict_from_py(t_pyjs* x, PyObject* pdict, t_dictionary* d)
+{
+    PyObject* pkey = NULL;
+    PyObject* pval = NULL;
+    Py_ssize_t pos = 0;
+
+    while (PyDict_Next(pdict, &pos, &pkey, &pval)) { // borrowed refs
+        PyObject* pkey_str = PyObject_Str(pkey);
+        if (pkey_str == NULL) {
+            return MAX_ERR_GENERIC;
+        }
+        const char* ckey = PyUnicode_AsUTF8(pkey_str);
+        if (ckey == NULL) {
+            Py_DECREF(pkey_str);
+            return MAX_ERR_GENERIC;
+        }
+        t_symbol* key = gensym(ckey);
+        Py_DECREF(pkey_str);
+
+        if (PyLong_Check(pval)) { // includes bool
+            t_atom_long l = PyLong_AsLongLong(pval);
+            if (l == -1 && PyErr_Occurred()) {
+                return MAX_ERR_GENERIC;
+            }
+            dictionary_appendlong(d, key, l);
+
+        } else if (PyFloat_Check(pval)) {
+            dictionary_appendfloat(d, key, PyFloat_AS_DOUBLE(pval));
+
+        } else if (PyUnicode_Check(pval)) {
+            const char* cval = PyUnicode_AsUTF8(pval);
+            if (cval == NULL) {
+                return MAX_ERR_GENERIC;
+            }
+            dictionary_appendstring(d, key, cval);
+
+        } else if (pval == Py_None) {
+            dictionary_appendsym(d, key, gensym("null"));
+
+        } else if (PyDict_Check(pval)) {
+            t_dictionary* sub = dictionary_new();
+            if (pyjs_dict_from_py(x, pval, sub) != MAX_ERR_NONE) {
+                object_free(sub);
+                return MAX_ERR_GENERIC;
+            }
+            dictionary_appenddictionary(d, key, (t_object*)sub);
+
+        } else if ((PySequence_Check(pval) || PyObject_CheckBuffer(pval))
+                   && !PyBytes_Check(pval) && !PyByteArray_Check(pval)) {
+            t_pyjs_seq seq = {0};
+            t_atom* atoms = NULL;
+            long ac = 0;
+            int res = 0;
+
+            if (pyjs_seq_open(&seq, pval) != MAX_ERR_NONE) {
+                return MAX_ERR_GENERIC;
+            }
+            atoms = (t_atom*)sysmem_newptr(sizeof(t_atom) * (seq.size + 1));
+            for (Py_ssize_t i = 0; atoms && i < seq.size; i++) {
+                if ((res = pyjs_seq_atom(&seq, i, atoms + ac)) < 0) {
+                    break;
+                }
+                ac += res;
+            }
+            if (atoms && res >= 0) {
+                dictionary_appendatoms(d, key, ac, atoms);
+            }
+            if (atoms) {
+                sysmem_freeptr(atoms);
+            }
+            pyjs_seq_close(&seq);
+            if (atoms == NULL || res < 0) {
+                if (!PyErr_Occurred()) {
+                    PyErr_NoMemory();
+                }
+                return MAX_ERR_GENERIC;
+            }
+
+        } else {
+            PyObject* pstr = PyObject_Str(pval);
+            if (pstr == NULL) {
+                return MAX_ERR_GENERIC;
+            }
+            const char* cval = PyUnicode_AsUTF8(pstr);
+            if (cval == NULL) {
+                Py_DECREF(pstr);
+                return MAX_ERR_GENERIC;
+            }
+            dictionary_appendstring(d, key, cval);
+            Py_DECREF(pstr);
+        }
+    }
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Callable Handles */
+
+/**
+ * @brief      Handle of a slot in its current generation
+ */
+static t_atom_long pyjs_handle_id(t_pyjs* x, t_pyjs_handle* slot)
+{
+    return ((t_atom_long)slot->gen << PYJS_HANDLE_INDEX_BITS)
+        | (t_atom_long)(slot - x->p_handles + 1);
+}
+
+/**
+ * @brief      Get the slot of a handle given as first atom
+ *
+ * @param      x     pointer to object struct
+ * @param      msg   method name for error messages
+ * @param[in]  argc  atom argument count
+ * @param      argv  atom argument vector
+ *
+ * @return     slot or NULL (with an error posted)
+ */
+static t_pyjs_handle* pyjs_handle_lookup(t_pyjs* x, const char* msg,
+                                         long argc, t_atom* argv)
+{
+    t_atom_long id;
+    t_atom_long index;
+    t_pyjs_handle* slot;
+
+    if (argc < 1 || atom_gettype(argv) != A_LONG) {
+        pyjs_error(x, "%s: expected a handle", msg);
+        return NULL;
+    }
+    id = atom_getlong(argv);
+    index = (id & PYJS_HANDLE_INDEX_MASK) - 1;
+    if (id < 1 || index < 0 || index >= x->p_handles_len) {
+        pyjs_error(x, "%s: invalid handle %lld", msg, (long long)id);
+        return NULL;
+    }
+    slot = x->p_handles + index;
+    // a released handle, whether or not its slot was reused since
+    if (slot->func == NULL || (id >> PYJS_HANDLE_INDEX_BITS) != slot->gen) {
+        pyjs_error(x, "%s: released handle %lld", msg, (long long)id);
+        return NULL;
+    }
+    return slot;
+}
+
+/**
+ * @brief      Return a handle to a python callable
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  expression evaluating to a callable
+ * @param      rv    atom vector to populate in-place (handle)
+ *
+ * @return     The t_max_err error.
+ *
+ * The expression is compiled once, here. The callable stays alive until
+ * the handle is released as many times as it was returned by `func` or
+ * passed to `retain`; asking for the same callable again returns the same
+ * handle.
+ */
+t_max_err pyjs_func(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                    t_atom* rv)
+{
+    t_atom atoms[1];
+    PyObject* pval = NULL;
+    t_pyjs_handle* slot = NULL;
+
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        pyjs_error(x, "func: expected <expression>");
+        return MAX_ERR_GENERIC;
+    }
+
+    char* cstring = atom_getsym(argv)->s_name;
+
+    pval = PyRun_String(cstring, Py_eval_input, x->p_globals, x->p_globals);
+    if (pval == NULL) {
+        goto error;
+    }
+
+    if (!PyCallable_Check(pval)) {
+        PyErr_Format(PyExc_TypeError, "'%s' is not callable",
+                     Py_TYPE(pval)->tp_name);
+        goto error;
+    }
+
+    for (long i = 0; i < x->p_handles_len; i++) {
+        if (x->p_handles[i].func == pval) {
+            slot = x->p_handles + i;
+            Py_DECREF(pval);
+            break;
+        }
+    }
+
+    if (slot == NULL) {
+        for (long i = 0; i < x->p_handles_len; i++) {
+            if (x->p_handles[i].func == NULL) {
+                slot = x->p_handles + i;
+                break;
+            }
+        }
+    }
+
+    if (slot == NULL) {
+        long len = x->p_handles_len ? x->p_handles_len * 2 : 8;
+        t_pyjs_handle* handles = NULL;
+        if (x->p_handles_len >= PYJS_HANDLE_MAX_SLOTS) {
+            PyErr_SetString(PyExc_MemoryError, "too many handles");
+            goto error;
+        }
+        if (len > PYJS_HANDLE_MAX_SLOTS) {
+            len = PYJS_HANDLE_MAX_SLOTS;
+        }
+        handles = (t_pyjs_handle*)sysmem_newptrclear(
+            sizeof(t_pyjs_handle) * len);
+        if (handles == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        if (x->p_handles) {
+            memcpy(handles, x->p_handles,
+                   sizeof(t_pyjs_handle) * x->p_handles_len);
+            sysmem_freeptr(x->p_handles);
+        }
+        slot = handles + x->p_handles_len;
+        x->p_handles = handles;
+        x->p_handles_len = len;
+    }
+
+    if (slot->func == NULL) {
+        slot->func = pval; // steals
+        slot->refs = 0;
+    }
+    slot->refs++;
+
+    atom_setlong(atoms, pyjs_handle_id(x, slot));
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+    pyjs_log(x, "func %s -> %lld", cstring,
+             (long long)pyjs_handle_id(x, slot));
+    return MAX_ERR_NONE;
+
+error:
+    pyjs_handle_error(x, "func %s", cstring);
+    Py_XDECREF(pval);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief      Call a python callable by handle
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  handle followed by the arguments of the call
+ * @param      rv    atom vector to populate in-place
+ *
+ * @return     The t_max_err error.
+ *
+ * Arguments are converted to python int, float or str and passed with a
+ * single vectorcall: no source text is parsed or compiled.
+ */
+t_max_err pyjs_call(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                    t_atom* rv)
+{
+    PyObject* stack[16];
+    PyObject** args = stack;
+    PyObject* pval = NULL;
+    t_pyjs_handle* slot = NULL;
+    long nargs = argc - 1;
+    long i = 0;
+    t_max_err err;
+    t_metrics_span span;
+
+    if ((slot = pyjs_handle_lookup(x, "call", argc, argv)) == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+    metrics_begin(&span, METRICS_CALL);
+
+    // slot 0 is reserved for PY_VECTORCALL_ARGUMENTS_OFFSET
+    if (nargs + 1 > (long)(sizeof(stack) / sizeof(stack[0]))) {
+        args = (PyObject**)sysmem_newptr(sizeof(PyObject*) * (nargs + 1));
+        if (args == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+    }
+
+    for (i = 0; i < nargs; i++) {
+        t_atom* atom = argv + i + 1;
+        switch (atom_gettype(atom)) {
+        case A_LONG:
+            args[i + 1] = PyLong_FromLongLong(atom_getlong(atom));
+            break;
+        case A_FLOAT:
+            args[i + 1] = PyFloat_FromDouble(atom_getfloat(atom));
+            break;
+        case A_SYM:
+            args[i + 1] = PyUnicode_FromString(atom_getsym(atom)->s_name);
+            break;
+        default:
+            args[i + 1] = NULL;
+            PyErr_Format(PyExc_TypeError, "argument %ld has no python type",
+                         i + 1);
+        }
+        if (args[i + 1] == NULL) {
+            goto error;
+        }
+    }
+
+    metrics_convert(&span);
+    pval = PyObject_Vectorcall(slot->func, args + 1,
+                               nargs | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    metrics_exec(&span);
+
+    for (i = 0; i < nargs; i++) {
+        Py_DECREF(args[i + 1]);
+    }
+    if (args != stack) {
+        sysmem_freeptr(args);
+    }
+
+    if (pval == NULL) {
+        pyjs_handle_error(x, "call %lld", (long long)atom_getlong(argv));
+        metrics_end(x->p_metrics, &span, 0);
+        return MAX_ERR_GENERIC;
+    }
+    if (pval == Py_None) {
+        Py_DECREF(pval);
+        metrics_end(x->p_metrics, &span, 1);
+        return MAX_ERR_NONE;
+    }
+    err = pyjs_handle_output(x, pval, rv);
+    metrics_convert(&span);
+    metrics_end(x->p_metrics, &span, err == MAX_ERR_NONE);
+    return err;
+
+error:
+    pyjs_handle_error(x, "call %lld", (long long)atom_getlong(argv));
+    while (i-- > 0) {
+        Py_DECREF(args[i + 1]);
+    }
+    if (args != stack) {
+        sysmem_freeptr(args);
+    }
+    metrics_end(x->p_metrics, &span, 0);
+    return MAX_ERR_GENERIC;
+}
+
+/**
+ * @brief      Add a reference to a handle
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  handle
+ * @param      rv    unused
+ *
+ * @return     The t_max_err error.
+ */
+t_max_err pyjs_retain(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                      t_atom* rv)
+{
+    t_pyjs_handle* slot = pyjs_handle_lookup(x, "retain", argc, argv);
+    if (slot == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+    slot->refs++;
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Drop a reference to a handle
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  handle
+ * @param      rv    unused
+ *
+ * @return     The t_max_err error.
+ *
+ * When the last reference is dropped the callable is released and the
+ * handle becomes invalid: its slot may be reused by a later `func`, under a
+ * new handle.
+ */
+t_max_err pyjs_release(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                       t_atom* rv)
+{
+    t_pyjs_handle* slot = pyjs_handle_lookup(x, "release", argc, argv);
+    if (slot == NULL) {
+        return MAX_ERR_GENERIC;
+    }
+    if (--slot->refs == 0) {
+        pyjs_log(x, "released %lld", (long long)pyjs_handle_id(x, slot));
+        Py_CLEAR(slot->func);
+        slot->gen = (slot->gen + 1) & PYJS_HANDLE_GEN_MASK;
+    }
+    return MAX_ERR_NONE;
+}
+
+/*--------------------------------------------------------------------------*/
+/* Instrumentation */
+
+/**
+ * @brief      Return the latency metrics of this object as a dictionary
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  `reset` to clear the metrics
+ * @param      rv    atom vector to populate in-place (dictionary name)
+ *
+ * @return     The t_max_err error.
+ *
+ * javascript opens the result with `new Dict(name)`. The dictionary is
+ * reused, so its contents are only valid until the next call.
+ */
+t_max_err pyjs_metrics(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                       t_atom* rv)
+{
+    t_atom atoms[1];
+    t_symbol* name = metrics_message(x->p_metrics, x->p_name, argc, argv,
+                                     NULL);
+
+    if (name == NULL) {
+        return MAX_ERR_NONE;
+    }
+    atom_setsym(atoms, name);
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Record a Chrome trace of the python messages of pyjs objects
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  `start [python]`, `stop` or `write [path]`
+ * @param      rv    atom vector to populate in-place (path after `write`)
+ *
+ * @return     The t_max_err error.
+ *
+ * python always runs on the main thread here, which holds the GIL, so the
+ * profile function for `start python` is attached (or removed) right away.
+ */
+t_max_err pyjs_trace(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                     t_atom* rv)
+{
+    t_atom atoms[1];
+    t_symbol* path = trace_message((t_object*)x, "pyjs", argc, argv);
+
+    trace_python_attach();
+    if (path == NULL) {
+        return MAX_ERR_NONE;
+    }
+    atom_setsym(atoms, path);
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+    return MAX_ERR_NONE;
+}
+
+/**
+ * @brief      Sample the python stacks for a flamegraph
+ *
+ * @param      x     pointer to object struct
+ * @param      s     method symbol
+ * @param[in]  argc  atom argument count
+ * @param      argv  `start [interval_ms]`, `stop` or `dump [path]`
+ * @param      rv    atom vector to populate in-place (path after `dump`)
+ *
+ * @return     The t_max_err error.
+ *
+ * The main thread holds the GIL between messages, so samples are only
+ * taken while pyjs runs python.
+ */
+t_max_err pyjs_profile(t_pyjs* x, t_symbol* s, long argc, t_atom* argv,
+                       t_atom* rv)
+{
+    t_atom atoms[1];
+    t_symbol* path = profile_message((t_object*)x, "pyjs", argc, argv);
+
+    if (path == NULL) {
+        return MAX_ERR_NONE;
+    }
+    atom_setsym(atoms, path);
+    atom_setobj(rv,
+                object_new(gensym("nobox"), gensym("atomarray"), 1, atoms));
+    return MAX_ERR_NONE;
+}
@@ -19,7 +19,13 @@
  * - Loading Python scripts from files 
  * - Importing Python modules
  * - Converting Python objects to JSON for JavaScript interop
+ * - Calling Python functions from JavaScript through integer handles
+ * - Returning numeric sequences, `buffer~` contents and dictionaries to
+ *   JavaScript without a JSON round-trip
  * - Support for Python packages via PYTHONPATH
+ * - Per-message latency metrics returned as a dictionary (`metrics`)
+ * - Chrome trace of messages and python calls written to a file (`trace`)
+ * - Sampling profiler writing folded stacks for flamegraphs (`profile`)
  * 
  * Note that the external structure is not directly exposed at the header level.
  * 
@@ -31,10 +37,16 @@
 
 #include "ext.h"
 #include "ext_obex.h"
+#include "ext_buffer.h"
+#include "ext_dictobj.h"
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
+/* metrics, tracing and profiling (shared with other python externals) */
+#include "../mamba/metrics.h"
+#include "../mamba/profile.h"
+
 /*--------------------------------------------------------------------------*/
 /* Constants */
 
@@ -50,6 +62,11 @@
 #define _PY_VER CONCAT(PY_MAJOR_VERSION, CONCAT(., PY_MINOR_VERSION))
 #define PY_VER STR(_PY_VER)
 
+// vectorcall is used by `call`
+#if PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
 /*--------------------------------------------------------------------------*/
 /* Datastructures */
 
@@ -73,12 +90,22 @@ t_max_err pyjs_exec(t_pyjs* x, t_symbol* s);
 t_max_err pyjs_execfile(t_pyjs* x, t_symbol* s);
 t_max_err pyjs_eval(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
 t_max_err pyjs_eval_to_json(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_eval_to_buffer(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_eval_to_dict(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
 t_max_err pyjs_code(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_func(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_call(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_retain(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_release(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_metrics(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_trace(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
+t_max_err pyjs_profile(t_pyjs* x, t_symbol* s, long argc, t_atom* argv, t_atom* rv);
 t_max_err pyjs_handle_output(t_pyjs* x, PyObject* pval, t_atom* rv);
 t_max_err pyjs_handle_float_output(t_pyjs* x, PyObject* pfloat, t_atom* rv);
 t_max_err pyjs_handle_long_output(t_pyjs* x, PyObject* plong, t_atom* rv);
 t_max_err pyjs_handle_list_output(t_pyjs* x, PyObject* plist, t_atom* rv);
 t_max_err pyjs_handle_dict_output(t_pyjs* x, PyObject* pdict, t_atom* rv);
+t_max_err pyjs_dict_from_py(t_pyjs* x, PyObject* pdict, t_dictionary* d);
 
 
 #endif // PYJS_H
@@ -0,0 +1,86 @@
+/* bench_bridge.c -- cost of returning a 10k-element result to js
+ *
+ * Runs the pyjs external (included below, linked with the fake Max runtime
+ * of ../../mamba/tests/fakemax.c) and times its methods on a python
+ * expression yielding 10000 floats:
+ *
+ *  1. eval_to_json on a list (json.dumps + symbol of the text; parsing
+ *     the json on the js side is not included)
+ *  2. eval on a list (PySequence_Fast into an atomarray)
+ *  3. eval on an array.array('d') (buffer protocol into an atomarray)
+ *  4. eval_to_buffer on an array.array('d') (buffer protocol into the
+ *     samples of a buffer~)
+ *
+ * Each round includes evaluating the expression and freeing the returned
+ * atomarray.
+ *
+ * make bench_bridge && ./bench_bridge
+ */
+
+#include "../pyjs.c"
+
+#include "fakemax.h"
+
+#include <time.h>
+
+#define N_ROUNDS 1000
+#define N_ELEMS 10000
+
+typedef t_max_err (*t_pyjs_gimmeback)(t_pyjs* x, t_symbol* s, long argc,
+                                      t_atom* argv, t_atom* rv);
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(t_pyjs* x, const char* name, t_pyjs_gimmeback method,
+                  const char* arg0, const char* arg1)
+{
+    t_atom argv[2];
+    t_atom rv;
+    long argc = 0;
+    double start;
+
+    atom_setsym(argv + argc++, gensym(arg0));
+    if (arg1) {
+        atom_setsym(argv + argc++, gensym(arg1));
+    }
+
+    start = now();
+    for (int i = 0; i < N_ROUNDS; i++) {
+        if (method(x, gensym(name), argc, argv, &rv) != MAX_ERR_NONE) {
+            fprintf(stderr, "%s failed\n", name);
+            exit(1);
+        }
+        object_free(atom_getobj(&rv));
+    }
+    printf("%-34s %10.1f us/round-trip\n", name, (now() - start) * 1e6 / N_ROUNDS);
+}
+
+int main(void)
+{
+    t_buffer_obj* buffer;
+    t_pyjs* x;
+
+    ext_main(NULL);
+    x = (t_pyjs*)pyjs_new(gensym("pyjs"), 0, NULL);
+    x->p_debug = 0;
+    buffer = fakemax_buffer_new(gensym("buf"), 0, 1);
+
+    pyjs_exec(x, gensym("import array; "
+                        "data = [i * 0.5 for i in range(10000)]; "
+                        "arr = array.array('d', data)"));
+
+    printf("%d elements, %d rounds\n", N_ELEMS, N_ROUNDS);
+    bench(x, "eval_to_json data", pyjs_eval_to_json, "data", NULL);
+    bench(x, "eval data (list)", pyjs_eval, "data", NULL);
+    bench(x, "eval arr (array.array)", pyjs_eval, "arr", NULL);
+    bench(x, "eval_to_buffer buf arr", pyjs_eval_to_buffer, "buf", "arr");
+
+    object_free(x);
+    fakemax_buffer_free(buffer);
+    return 0;
+}
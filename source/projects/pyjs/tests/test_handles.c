@@ -0,0 +1,143 @@
+/* test_handles.c -- callable handles of pyjs (func, call, retain, release)
+ *
+ * Runs the pyjs external (included below, linked with the fake Max runtime
+ * of ../../mamba/tests/fakemax.c) and checks that:
+ *
+ *  - `func` returns one counted handle per callable, `call` reaches it
+ *  - the callable is dropped with the last `release`
+ *  - a released handle is rejected, also once `func` has reused its slot
+ *    for another callable
+ *
+ * make test_handles && ./test_handles
+ */
+
+#include "../pyjs.c"
+
+#include "fakemax.h"
+
+#include <assert.h>
+
+
+static t_atom_long test_func(t_pyjs* x, const char* expr)
+{
+    t_atom arg;
+    t_atom rv;
+    long ac = 0;
+    t_atom* av = NULL;
+    t_atom_long id;
+
+    atom_setsym(&arg, gensym(expr));
+    assert(pyjs_func(x, gensym("func"), 1, &arg, &rv) == MAX_ERR_NONE);
+    atomarray_getatoms(atom_getobj(&rv), &ac, &av);
+    assert(ac == 1 && atom_gettype(av) == A_LONG);
+    id = atom_getlong(av);
+    object_free(atom_getobj(&rv));
+    return id;
+}
+
+static t_max_err test_call(t_pyjs* x, t_atom_long id, long arg, long* result)
+{
+    t_atom argv[2];
+    t_atom rv;
+    long ac = 0;
+    t_atom* av = NULL;
+    t_max_err err;
+
+    atom_setlong(argv, id);
+    atom_setlong(argv + 1, arg);
+    err = pyjs_call(x, gensym("call"), 2, argv, &rv);
+    if (err == MAX_ERR_NONE) {
+        atomarray_getatoms(atom_getobj(&rv), &ac, &av);
+        assert(ac == 1);
+        if (result) {
+            *result = (long)atom_getlong(av);
+        }
+        object_free(atom_getobj(&rv));
+    }
+    return err;
+}
+
+static t_max_err test_handle_method(t_pyjs* x, const char* name,
+                                    t_atom_long id)
+{
+    t_atom arg;
+    t_atom rv;
+
+    atom_setlong(&arg, id);
+    if (strcmp(name, "retain") == 0) {
+        return pyjs_retain(x, gensym(name), 1, &arg, &rv);
+    }
+    return pyjs_release(x, gensym(name), 1, &arg, &rv);
+}
+
+
+static void test_counting(t_pyjs* x)
+{
+    t_atom_long h1, h2;
+    long result = 0;
+
+    h1 = test_func(x, "inc");
+    h2 = test_func(x, "inc");
+    assert(h1 == h2);
+    assert(test_call(x, h1, 41, &result) == MAX_ERR_NONE && result == 42);
+
+    // func twice + retain once: released by the third release
+    assert(test_handle_method(x, "retain", h1) == MAX_ERR_NONE);
+    assert(test_handle_method(x, "release", h1) == MAX_ERR_NONE);
+    assert(test_handle_method(x, "release", h1) == MAX_ERR_NONE);
+    assert(test_call(x, h1, 1, &result) == MAX_ERR_NONE && result == 2);
+    assert(test_handle_method(x, "release", h1) == MAX_ERR_NONE);
+
+    assert(test_call(x, h1, 1, NULL) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "release", h1) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "retain", h1) == MAX_ERR_GENERIC);
+}
+
+static void test_stale(t_pyjs* x)
+{
+    t_atom_long old, h;
+    long result = 0;
+
+    old = test_func(x, "inc");
+    assert(test_handle_method(x, "release", old) == MAX_ERR_NONE);
+
+    // the freed slot is reused for another callable under a new handle
+    h = test_func(x, "dec");
+    assert(h != old);
+    assert((h & PYJS_HANDLE_INDEX_MASK) == (old & PYJS_HANDLE_INDEX_MASK));
+
+    // the old handle neither calls nor releases the new callable
+    assert(test_call(x, old, 1, NULL) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "release", old) == MAX_ERR_GENERIC);
+    assert(test_call(x, h, 1, &result) == MAX_ERR_NONE && result == 0);
+    assert(test_handle_method(x, "release", h) == MAX_ERR_NONE);
+}
+
+static void test_invalid(t_pyjs* x)
+{
+    assert(test_handle_method(x, "release", 0) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "release", -1) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "release", 1000) == MAX_ERR_GENERIC);
+    assert(test_handle_method(x, "release", PYJS_HANDLE_INDEX_MASK + 1)
+           == MAX_ERR_GENERIC);
+}
+
+
+int main(void)
+{
+    t_pyjs* x;
+
+    ext_main(NULL);
+    x = (t_pyjs*)pyjs_new(gensym("pyjs"), 0, NULL);
+    x->p_debug = 0;
+
+    pyjs_exec(x, gensym("inc = lambda n: n + 1; dec = lambda n: n - 1"));
+
+    test_counting(x);
+    test_stale(x);
+    test_invalid(x);
+
+    object_free(x);
+    printf("test_handles: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+
+"""embed_assets -- Convert the zedit webroot into a c-header of precompressed assets
+
+usage: embed_assets.py <webroot> <output.h>
+
+Each file under <webroot> is embedded as-is together with gzip and (if the
+`brotli` module or command is available) brotli encoded copies. A
+compressed copy is kept only when it is meaningfully smaller than the
+original. Every variant gets a strong ETag derived from the content hash
+and encoding, so zedit can answer `If-None-Match` with `304 Not Modified`
+and pick the `Content-Encoding` from `Accept-Encoding` without touching
+the disk.
+"""
+
+import gzip
+import hashlib
+import mimetypes
+import os
+import shutil
+import subprocess
+import sys
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+
+# already compressed formats are served as-is
+SKIP_COMPRESSION = {
+    '.png', '.jpg', '.jpeg', '.gif', '.ico', '.webp', '.woff', '.woff2', '.gz', '.br', '.zip',
+}
+
+# keep a compressed variant only if it saves at least this fraction
+MIN_SAVING = 0.1
+
+MIME_TYPES = {
+    '.js': 'text/javascript; charset=utf-8',
+    '.mjs': 'text/javascript; charset=utf-8',
+    '.css': 'text/css; charset=utf-8',
+    '.html': 'text/html; charset=utf-8',
+    '.txt': 'text/plain; charset=utf-8',
+    '.json': 'application/json',
+    '.svg': 'image/svg+xml',
+    '.map': 'application/json',
+}
+
+
+def compress_gzip(data):
+    # mtime=0 keeps the output (and the build) reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def compress_brotli(data):
+    if brotli is not None:
+        return brotli.compress(data, quality=11)
+    if shutil.which('brotli'):
+        return subprocess.run(['brotli', '-c', '-q', '11'], input=data,
+                              stdout=subprocess.PIPE, check=True).stdout
+    return None
+
+
+def mime_type(path):
+    ext = os.path.splitext(path)[1].lower()
+    if ext in MIME_TYPES:
+        return MIME_TYPES[ext]
+    return mimetypes.guess_type(path)[0] or 'application/octet-stream'
+
+
+def c_array(name, data):
+    lines = ['static const unsigned char %s[%d] = {' % (name, max(len(data), 1))]
+    for i in range(0, len(data), 16):
+        lines.append('    ' + ','.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    if not data:
+        lines.append('    0x00,')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def collect(webroot):
+    assets = []
+    for root, dirs, files in os.walk(webroot, followlinks=True):
+        dirs[:] = sorted(d for d in dirs if not d.startswith('.'))
+        for name in sorted(files):
+            if name.startswith('.'):
+                continue
+            path = os.path.join(root, name)
+            uri = '/' + os.path.relpath(path, webroot).replace(os.sep, '/')
+            with open(path, 'rb') as f:
+                assets.append((uri, f.read()))
+    # sorted by uri for the binary search in zedit.c
+    return sorted(assets)
+
+
+def variant(data, compressed):
+    if compressed is None or len(compressed) > len(data) * (1.0 - MIN_SAVING):
+        return None
+    return compressed
+
+
+def main(webroot, output):
+    out = [
+        '// generated by scripts/embed_assets.py -- do not edit',
+        '',
+        '#ifndef ZEDIT_ASSETS_H',
+        '#define ZEDIT_ASSETS_H',
+        '',
+        '#include <stddef.h>',
+        '',
+        'typedef struct _zedit_asset {',
+        '    const char* uri;             // request path, e.g. /js/editor.min.js',
+        '    const char* mime;            // Content-Type',
+        '    const char* etag[3];         // strong ETags of the identity, gzip and br variants',
+        '    const unsigned char* data[3];// variants, NULL if not worth compressing',
+        '    size_t size[3];',
+        '} t_zedit_asset;',
+        '',
+        'enum { ZEDIT_ENC_IDENTITY, ZEDIT_ENC_GZIP, ZEDIT_ENC_BR };',
+        '',
+    ]
+    entries = []
+    total = [0, 0, 0]
+    for n, (uri, data) in enumerate(collect(webroot)):
+        ext = os.path.splitext(uri)[1].lower()
+        variants = [data, None, None]
+        if ext not in SKIP_COMPRESSION:
+            variants[1] = variant(data, compress_gzip(data))
+            variants[2] = variant(data, compress_brotli(data))
+        digest = hashlib.sha256(data).hexdigest()[:20]
+        etags, names, sizes = [], [], []
+        for enc, (suffix, v) in enumerate(zip(('', '-gz', '-br'), variants)):
+            if v is None:
+                etags.append('NULL')
+                names.append('NULL')
+                sizes.append('0')
+                continue
+            name = 'zedit_asset_%d_%d' % (n, enc)
+            out.append(c_array(name, v))
+            etags.append('"\\"%s%s\\""' % (digest, suffix))
+            names.append(name)
+            sizes.append(str(len(v)))
+            total[enc] += len(v)
+        entries.append('    {"%s", "%s", {%s}, {%s}, {%s}},' % (
+            uri, mime_type(uri), ', '.join(etags), ', '.join(names), ', '.join(sizes)))
+    out += [
+        '',
+        'static const t_zedit_asset zedit_assets[] = {',
+    ] + entries + [
+        '};',
+        '',
+        '#define ZEDIT_ASSETS_COUNT (sizeof(zedit_assets) / sizeof(zedit_assets[0]))',
+        '',
+        '#endif // ZEDIT_ASSETS_H',
+        '',
+    ]
+    with open(output, 'w') as f:
+        f.write('\n'.join(out))
+    print('embedded %d assets: %d bytes, gzip %d, brotli %d' % (
+        len(entries), total[0], total[1], total[2]))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip().splitlines()[2])
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,208 @@
+/* bench_latency.c -- request latency of the zedit webserver
+ *
+ * Runs the zedit external (included below, linked with the fake Max
+ * runtime of ../../mamba/tests/fakemax.c): its mongoose loop on the server
+ * thread and its python worker, and measures from a blocking client:
+ *
+ *  - http: GET /api/hello answered directly by the server thread
+ *  - ws:   `eval None` over the websocket until its `done` frame, i.e.
+ *          server thread -> python worker -> reply queue -> wakeup of the
+ *          server thread (the REPL path, without the cost of the code)
+ *
+ * with the idle poll timeout (`sleeptime`) at 10 ms and at the default
+ * 1000 ms. The loop is woken up by the worker, so the ws latency should
+ * not depend on it.
+ *
+ * make bench_latency && ./bench_latency
+ */
+
+#include "../zedit.c"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define N_REQUESTS 500
+#define BENCH_PORT 8000 // s_listening_address
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return (d > 0) - (d < 0);
+}
+
+// -- blocking client ---------------------------------------------------------
+
+static int client_connect(void)
+{
+    struct sockaddr_in sa = {0};
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(BENCH_PORT);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        perror("connect");
+        exit(1);
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// read until the end of the http headers (responses here are tiny)
+static void read_headers(int fd, char* buf, size_t size)
+{
+    size_t n = 0;
+    buf[0] = '\0';
+    while (strstr(buf, "\r\n\r\n") == NULL && n < size - 1) {
+        ssize_t k = recv(fd, buf + n, size - 1 - n, 0);
+        if (k <= 0) {
+            exit(1);
+        }
+        n += (size_t)k;
+        buf[n] = '\0';
+    }
+}
+
+static double http_roundtrip(int fd)
+{
+    char buf[1024];
+    const char* req = "GET /api/hello HTTP/1.1\r\nHost: x\r\n\r\n";
+    double t0 = now_ms();
+
+    send(fd, req, strlen(req), 0);
+    read_headers(fd, buf, sizeof(buf));
+    // body: {"status":1}\n, may have arrived with the headers
+    if (strstr(buf, "}\n") == NULL) {
+        recv(fd, buf, sizeof(buf), 0);
+    }
+    return now_ms() - t0;
+}
+
+static int ws_connect(void)
+{
+    char buf[1024];
+    int fd = client_connect();
+    const char* req = "GET /ws HTTP/1.1\r\nHost: x\r\nUpgrade: websocket\r\n"
+                      "Connection: Upgrade\r\nSec-WebSocket-Version: 13\r\n"
+                      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+
+    send(fd, req, strlen(req), 0);
+    read_headers(fd, buf, sizeof(buf));
+    return fd;
+}
+
+// read one unmasked server frame (replies here are < 126 bytes)
+static void ws_read_frame(int fd, char* data, size_t size)
+{
+    unsigned char header[2];
+    size_t len, got = 0;
+
+    if (recv(fd, header, 2, MSG_WAITALL) != 2) {
+        exit(1);
+    }
+    len = header[1] & 127;
+    if (len >= size) {
+        exit(1);
+    }
+    while (got < len) {
+        ssize_t k = recv(fd, data + got, len - got, 0);
+        if (k <= 0) {
+            exit(1);
+        }
+        got += (size_t)k;
+    }
+    data[len] = '\0';
+}
+
+static double ws_roundtrip(int fd)
+{
+    const char* msg = "{\"id\":1,\"op\":\"eval\",\"code\":\"None\"}";
+    unsigned char frame[128];
+    char reply[128];
+    size_t len = strlen(msg);
+    double t0;
+
+    // masked text frame, zero mask
+    frame[0] = 0x81;
+    frame[1] = 0x80 | (unsigned char)len;
+    memset(frame + 2, 0, 4);
+    memcpy(frame + 6, msg, len);
+
+    t0 = now_ms();
+    send(fd, frame, len + 6, 0);
+    // `queued` from the server thread, then `done` from the worker
+    do {
+        ws_read_frame(fd, reply, sizeof(reply));
+    } while (strstr(reply, "\"done\"") == NULL);
+    return now_ms() - t0;
+}
+
+static void report(const char* name, double* samples, int n)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    qsort(samples, n, sizeof(double), cmp_double);
+    fprintf(stderr, "  %-5s mean %7.3f ms  p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms\n", name,
+           sum / n, samples[n / 2], samples[n * 99 / 100], samples[n - 1]);
+}
+
+static void bench(t_zedit* x, long sleeptime)
+{
+    static double samples[N_REQUESTS];
+    int fd;
+
+    zedit_sleeptime(x, sleeptime);
+    fprintf(stderr, "sleeptime %ld ms\n", sleeptime);
+
+    fd = client_connect();
+    for (int i = 0; i < N_REQUESTS; i++) {
+        samples[i] = http_roundtrip(fd);
+    }
+    close(fd);
+    report("http", samples, N_REQUESTS);
+
+    fd = ws_connect();
+    for (int i = 0; i < N_REQUESTS; i++) {
+        samples[i] = ws_roundtrip(fd);
+    }
+    close(fd);
+    report("ws", samples, N_REQUESTS);
+}
+
+int main(void)
+{
+    t_zedit* x;
+
+    // the fake max console (a post per http request) goes to stdout
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        return 1;
+    }
+
+    ext_main(NULL);
+    x = (t_zedit*)zedit_new();
+    zedit_start(x);
+    usleep(200000);
+
+    fprintf(stderr, "%d requests each\n", N_REQUESTS);
+    bench(x, 10);
+    bench(x, 1000);
+
+    object_free(x);
+    return 0;
+}
@@ -0,0 +1,154 @@
+/* test_zedit.c -- python worker of zedit, run outside Max
+ *
+ * Links zedit.c (included below, to reach its statics) with the fake Max
+ * runtime of ../../mamba/tests/fakemax.c, runs jobs on the worker thread
+ * and checks the frames it queues for the websocket clients:
+ *
+ *  - eval results, tracebacks and `done` status
+ *  - `interrupt` stops a running job and the next job runs normally
+ *  - an interrupt which arrives after the last check of a job is not
+ *    raised in the next job
+ *
+ * make test_zedit && ./test_zedit
+ */
+
+#include "../zedit.c"
+
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_TIMEOUT_MS 5000
+
+static t_zedit* test_x = NULL;
+static char test_frames[8192];
+
+/**
+ * @brief Collect the frames of a job until its `done` frame
+ *
+ * @param x zedit object
+ * @param id job id
+ * @return const char* `done` status: "ok" or "error"
+ *
+ * The frames of the job are concatenated in test_frames.
+ */
+static const char* test_wait_done(t_zedit* x, long id)
+{
+    char done[64];
+    t_zedit_msg* msg;
+    const char* status = NULL;
+
+    snprintf(done, sizeof(done), "{\"id\":%ld,\"type\":\"done\"", id);
+    test_frames[0] = '\0';
+
+    for (int waited = 0; status == NULL && waited < TEST_TIMEOUT_MS; waited++) {
+        systhread_mutex_lock(x->x_out_mutex);
+        msg = x->x_out_head;
+        x->x_out_head = NULL;
+        x->x_out_tail = NULL;
+        systhread_mutex_unlock(x->x_out_mutex);
+
+        while (msg != NULL) {
+            t_zedit_msg* next = msg->next;
+            strncat(test_frames, msg->json,
+                    sizeof(test_frames) - strlen(test_frames) - 1);
+            if (strncmp(msg->json, done, strlen(done)) == 0) {
+                status = strstr(msg->json, "\"ok\"") ? "ok" : "error";
+            }
+            free(msg->json);
+            sysmem_freeptr(msg);
+            msg = next;
+        }
+        if (status == NULL) {
+            usleep(1000);
+        }
+    }
+    assert(status != NULL && "timed out waiting for the job");
+    return status;
+}
+
+/**
+ * @brief `late_interrupt()`: interrupts the job which calls it, from C
+ *
+ * Used as `__str__` of an exception, it runs while the traceback is
+ * printed, after the job has executed its last bytecode (before python
+ * 3.13, whose traceback printer is python code and raises it right away).
+ */
+static PyObject* test_interrupt_fn(PyObject* self, PyObject* unused)
+{
+    zedit_interrupt(test_x);
+    return PyUnicode_FromString("late");
+}
+
+static PyMethodDef test_interrupt_fn_def = {
+    "late_interrupt", test_interrupt_fn, METH_NOARGS, NULL};
+
+
+static void test_eval(t_zedit* x)
+{
+    zedit_submit(x, 0, 1, ZEDIT_MODE_SINGLE, "1 + 1");
+    assert(strcmp(test_wait_done(x, 1), "ok") == 0);
+    assert(strstr(test_frames, "\"type\":\"result\",\"data\":\"2\""));
+
+    zedit_submit(x, 0, 2, ZEDIT_MODE_FILE, "print('hello')");
+    assert(strcmp(test_wait_done(x, 2), "ok") == 0);
+    assert(strstr(test_frames, "\"type\":\"stdout\",\"data\":\"hello\""));
+}
+
+static void test_error(t_zedit* x)
+{
+    zedit_submit(x, 0, 3, ZEDIT_MODE_SINGLE, "1 / 0");
+    assert(strcmp(test_wait_done(x, 3), "error") == 0);
+    assert(strstr(test_frames, "ZeroDivisionError"));
+}
+
+static void test_interrupt(t_zedit* x)
+{
+    zedit_submit(x, 0, 4, ZEDIT_MODE_FILE, "while True: pass");
+    usleep(100 * 1000);
+    zedit_interrupt(x);
+    assert(strcmp(test_wait_done(x, 4), "error") == 0);
+    assert(strstr(test_frames, "KeyboardInterrupt"));
+
+    zedit_submit(x, 0, 5, ZEDIT_MODE_SINGLE, "'after'");
+    assert(strcmp(test_wait_done(x, 5), "ok") == 0);
+}
+
+static void test_late_interrupt(t_zedit* x)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyObject* fn = PyCFunction_New(&test_interrupt_fn_def, NULL);
+    assert(fn != NULL);
+    PyDict_SetItemString(x->py->p_globals, "late_interrupt", fn);
+    Py_DECREF(fn);
+    PyGILState_Release(gstate);
+
+    zedit_submit(x, 0, 6, ZEDIT_MODE_FILE,
+                 "class Late(Exception):\n"
+                 "    __str__ = late_interrupt\n"
+                 "raise Late\n");
+    assert(strcmp(test_wait_done(x, 6), "error") == 0);
+    assert(strstr(test_frames, "Late"));
+
+    // the pending KeyboardInterrupt must not leak into this job
+    zedit_submit(x, 0, 7, ZEDIT_MODE_SINGLE, "1 + 1");
+    assert(strcmp(test_wait_done(x, 7), "ok") == 0);
+    assert(!strstr(test_frames, "KeyboardInterrupt"));
+}
+
+
+int main(void)
+{
+    ext_main(NULL);
+    test_x = (t_zedit*)zedit_new();
+    zedit_worker_start(test_x);
+
+    test_eval(test_x);
+    test_error(test_x);
+    test_interrupt(test_x);
+    test_late_interrupt(test_x);
+
+    object_free(test_x);
+    printf("test_zedit: all tests passed\n");
+    return 0;
+}
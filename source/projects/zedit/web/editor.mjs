@@ -103,22 +103,91 @@ $(function () {
         term.echo(JSON.stringify(json));
     };
 
+    // streaming repl over a websocket: output frames carry the id of the
+    // request which produced them, partial lines are buffered until a
+    // newline or the final `done` frame.
+    let repl_id = 0;
+    let repl_pending = {};
+    let repl_socket = null;
+
+    let repl_echo = function (term, text, type) {
+        text = $.terminal.escape_brackets(text);
+        term.echo(type === "stderr" ? "[[;red;]" + text + "]" : text);
+    };
+
+    let repl_flush = function (req, all) {
+        let lines = req.buffer.split("\n");
+        req.buffer = all ? "" : lines.pop();
+        if (all && lines[lines.length - 1] === "") {
+            lines.pop();
+        }
+        lines.forEach((line) => repl_echo(req.term, line, req.type));
+    };
+
+    let repl_receive = function (event) {
+        let msg = JSON.parse(event.data);
+        let req = repl_pending[msg.id];
+        if (req === undefined) {
+            return;
+        }
+        if (msg.type === "stdout" || msg.type === "stderr") {
+            if (req.type !== msg.type) {
+                repl_flush(req, true);
+                req.type = msg.type;
+            }
+            req.buffer += msg.data;
+            repl_flush(req, false);
+        } else if (msg.type === "result") {
+            repl_flush(req, true);
+            repl_echo(req.term, msg.data, "result");
+        } else if (msg.type === "done") {
+            repl_flush(req, true);
+            delete repl_pending[msg.id];
+        }
+    };
+
+    let repl_connect = function () {
+        let scheme = location.protocol === "https:" ? "wss://" : "ws://";
+        repl_socket = new WebSocket(scheme + location.host + "/ws");
+        repl_socket.onmessage = repl_receive;
+        repl_socket.onclose = () => {
+            repl_socket = null;
+        };
+    };
+
     let repl_send = function (code, term) {
-        fetch("/api/repl/send", {
-            method: "POST",
-            body: JSON.stringify({
-                content: code,
-            }),
-
-            headers: {
-                "Content-type": "application/json; charset=UTF-8",
-            },
-        })
-            .then((response) => response.json())
-            // .then((json) => console.log(json));
-            .then((json) => repl_respond(json, term));
+        if (repl_socket === null || repl_socket.readyState !== WebSocket.OPEN) {
+            // fall back to a one-shot post (output goes to open sockets)
+            fetch("/api/repl/send", {
+                method: "POST",
+                body: JSON.stringify({
+                    content: code,
+                }),
+
+                headers: {
+                    "Content-type": "application/json; charset=UTF-8",
+                },
+            })
+                .then((response) => response.json())
+                .then((json) => repl_respond(json, term));
+            if (repl_socket === null) {
+                repl_connect();
+            }
+            return;
+        }
+        let id = ++repl_id;
+        repl_pending[id] = { term: term, buffer: "", type: "stdout" };
+        repl_socket.send(JSON.stringify({ id: id, op: "eval", code: code }));
     };
 
+    let repl_interrupt = function () {
+        if (repl_socket !== null && repl_socket.readyState === WebSocket.OPEN) {
+            repl_socket.send(JSON.stringify({ id: 0, op: "interrupt" }));
+        }
+    };
+
+    repl_connect();
+
     $("#terminal").terminal(
         [
             {
@@ -187,7 +256,7 @@ $(function () {
         {
             keymap: {
                 "CTRL-C": function (e, original) {
-                    this.echo("my shortcut");
+                    repl_interrupt();
                 },
                 TAB: function (e, original) {
                     this.insert("    ");
@@ -18,8 +18,23 @@
 
 #include "mongoose.h"
 
+#ifdef ZEDIT_EMBED_ASSETS
+#include "zedit_assets.h" // generated by scripts/embed_assets.py
+#endif
+
 #define PY_MAX_ELEMS 1024
 
+// websocket repl
+#define ZEDIT_WS_URI "/ws"
+#define ZEDIT_MODE_SINGLE Py_single_input // `eval`: echo expression results
+#define ZEDIT_MODE_FILE Py_file_input     // `exec`: run a block of statements
+
+#if defined(_WIN32)
+#define zedit_closesocket(s) closesocket(s)
+#else
+#define zedit_closesocket(s) close(s)
+#endif
+
 // static global constants
 #if defined RELEASE
 static const char* s_listening_address = "http://localhost:8000";
@@ -36,6 +51,23 @@ static const char* s_ssi_pattern = "#.shtml";
 static const char* s_root_dir = NULL;
 
 
+// code submitted by a client, run in order by the python worker
+typedef struct _zedit_job {
+    struct _zedit_job* next;
+    unsigned long conn;        // requesting connection id, 0 for all clients
+    long id;                   // client message id, echoed in all replies
+    int mode;                  // ZEDIT_MODE_SINGLE or ZEDIT_MODE_FILE
+    char* code;                // python source (owned)
+} t_zedit_job;
+
+// json text frame waiting to be sent by the server thread
+typedef struct _zedit_msg {
+    struct _zedit_msg* next;
+    unsigned long conn;        // target connection id, 0 for all clients
+    char* json;                // frame payload (malloc'ed by mg_mprintf)
+} t_zedit_msg;
+
+
 typedef struct _zedit {
     t_object x_ob;             // standard max object
     t_systhread x_systhread;   // thread reference
@@ -44,10 +76,31 @@ typedef struct _zedit {
     void* x_qelem;             // for message passing between threads
     void* x_outlet;            // the only outlet
     long x_foo;                // simple data to pass between threads
-    int x_sleeptime;           // how many milliseconds to sleep
+    int x_sleeptime;           // idle poll timeout of the webserver loop (ms)
     int x_is_running;          // status of zediter
     t_string* x_root_dir;      // root path to statically serve from
     t_py* py;                  // python interpreter type instance
+    PyThreadState* x_tstate;   // main thread state while the GIL is released
+
+    // python worker
+    t_systhread x_worker;          // runs submitted code off the server thread
+    t_systhread_mutex x_job_mutex; // protects the job queue
+    t_systhread_cond x_job_cond;   // signalled on new jobs and on cancel
+    t_zedit_job* x_job_head;       // pending jobs (fifo)
+    t_zedit_job* x_job_tail;
+    int x_worker_cancel;           // worker cancel flag (under x_job_mutex)
+    unsigned long x_worker_ident;  // python thread ident of the worker
+    t_zedit_job* x_job;            // job being run (only changed with the GIL)
+    PyObject* x_stdout;            // stream objects installed during a job
+    PyObject* x_stderr;
+    PyObject* x_displayhook;
+
+    // output to websocket clients
+    t_systhread_mutex x_out_mutex; // protects the output queue
+    t_zedit_msg* x_out_head;       // frames to send (fifo)
+    t_zedit_msg* x_out_tail;
+    int x_wakeup;                  // write end of the loop wakeup pipe, -1 if none
+    int x_wakeup_pending;          // a wakeup byte is in flight (under x_out_mutex)
 } t_zedit;
 
 
@@ -87,11 +140,28 @@ t_max_err zedit_pipe(t_zedit* x, t_symbol* s, long argc, t_atom* argv);
 t_max_err zedit_exec_file_input(t_zedit* x, const char* code);
 t_max_err zedit_exec_single_input(t_zedit* x, const char* code);
 
+// python worker
+void zedit_worker_start(t_zedit* x);
+void zedit_worker_stop(t_zedit* x);
+void* zedit_workerproc(t_zedit* x);
+t_max_err zedit_submit(t_zedit* x, unsigned long conn, long id, int mode, const char* code);
+void zedit_interrupt(t_zedit* x);
+void zedit_run_job(t_zedit* x, t_zedit_job* job);
+
+// websocket output
+void zedit_send(t_zedit* x, unsigned long conn, long id, const char* type,
+                const char* data, size_t len);
+void zedit_drain(t_zedit* x, struct mg_mgr* mgr);
+void zedit_wakeup(t_zedit* x);
+
 
 // web
 // void do_build_objects(t_zedit* x, t_symbol *s, short argc, t_atom *argv);
 void handle_event_http_message(struct mg_connection *c, int ev, void *ev_data, void *fn_data);
+void handle_event_ws_message(struct mg_connection *c, int ev, void *ev_data, void *fn_data);
+int zedit_serve_asset(struct mg_connection *c, struct mg_http_message *hm);
 static void fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data);
+static void zedit_wakeup_fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data);
 t_string* get_path_to_webroot(t_class* klass);
 
 
@@ -119,6 +189,153 @@ t_string* get_path_to_webroot(t_class* klass);
 //     }
 // }
 
+#ifdef ZEDIT_EMBED_ASSETS
+
+/**
+ * @brief Find an embedded asset by uri (the table is sorted by uri)
+ */
+static const t_zedit_asset* zedit_asset_find(const char* uri)
+{
+    size_t lo = 0;
+    size_t hi = ZEDIT_ASSETS_COUNT;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = strcmp(uri, zedit_assets[mid].uri);
+        if (cmp == 0) {
+            return &zedit_assets[mid];
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Check if an Accept-Encoding header accepts a content coding
+ *
+ * Tokens are matched exactly; `;q=0` excludes a coding.
+ */
+static int zedit_accepts(struct mg_str* header, const char* coding)
+{
+    size_t n = strlen(coding);
+    size_t i = 0;
+
+    while (header && i < header->len) {
+        size_t start, end;
+        while (i < header->len && (header->ptr[i] == ' ' || header->ptr[i] == ',')) {
+            i++;
+        }
+        start = i;
+        while (i < header->len && header->ptr[i] != ',' && header->ptr[i] != ';'
+               && header->ptr[i] != ' ') {
+            i++;
+        }
+        end = i;
+        while (i < header->len && header->ptr[i] != ',') {
+            i++;
+        }
+        if (end - start == n && strncmp(header->ptr + start, coding, n) == 0) {
+            struct mg_str params = mg_str_n(header->ptr + end, i - end);
+            const char* q = mg_strstr(params, mg_str("q="));
+            char qval[8] = {0};
+            size_t qlen;
+            if (q == NULL) {
+                return 1;
+            }
+            q += 2;
+            qlen = (size_t)(params.ptr + params.len - q);
+            memcpy(qval, q, qlen < sizeof(qval) - 1 ? qlen : sizeof(qval) - 1);
+            return atof(qval) > 0.0;
+        }
+    }
+    return 0;
+}
+
+#endif // ZEDIT_EMBED_ASSETS
+
+
+/**
+ * @brief Serve a GET or HEAD request from the assets embedded at build time
+ *
+ * @param c connection
+ * @param hm http request
+ * @return int 1 if the request was answered, 0 if the uri is not embedded
+ *
+ * The brotli or gzip variant is sent if the client accepts it. Assets are
+ * sent with `Cache-Control: no-cache` and a strong ETag, so browsers
+ * revalidate on each patch open and get a `304 Not Modified` without a
+ * body while the asset is unchanged.
+ */
+int zedit_serve_asset(struct mg_connection *c, struct mg_http_message *hm)
+{
+#ifdef ZEDIT_EMBED_ASSETS
+    char uri[MAX_PATH_CHARS];
+    const t_zedit_asset* asset = NULL;
+    struct mg_str* accept = NULL;
+    struct mg_str* inm = NULL;
+    int head = mg_vcasecmp(&hm->method, "HEAD") == 0;
+    int enc = ZEDIT_ENC_IDENTITY;
+    static const char* codings[] = { NULL, "gzip", "br" };
+
+    if (!head && mg_vcasecmp(&hm->method, "GET") != 0) {
+        return 0;
+    }
+    if (hm->uri.len == 0 || hm->uri.len + sizeof("index.html") > sizeof(uri)) {
+        return 0;
+    }
+    memcpy(uri, hm->uri.ptr, hm->uri.len);
+    uri[hm->uri.len] = '\0';
+    if (uri[hm->uri.len - 1] == '/') {
+        strncat(uri, "index.html", sizeof(uri) - hm->uri.len - 1);
+    }
+    if ((asset = zedit_asset_find(uri)) == NULL) {
+        return 0;
+    }
+
+    accept = mg_http_get_header(hm, "Accept-Encoding");
+    if (asset->data[ZEDIT_ENC_BR] && zedit_accepts(accept, "br")) {
+        enc = ZEDIT_ENC_BR;
+    } else if (asset->data[ZEDIT_ENC_GZIP] && zedit_accepts(accept, "gzip")) {
+        enc = ZEDIT_ENC_GZIP;
+    }
+
+    inm = mg_http_get_header(hm, "If-None-Match");
+    if (inm && (mg_strstr(*inm, mg_str(asset->etag[enc])) || mg_vcmp(inm, "*") == 0)) {
+        mg_printf(c, "HTTP/1.1 304 Not Modified\r\n"
+                     "ETag: %s\r\n"
+                     "Vary: Accept-Encoding\r\n"
+                     "Cache-Control: no-cache\r\n\r\n", asset->etag[enc]);
+        return 1;
+    }
+
+    mg_printf(c, "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: %s\r\n"
+                 "%s%s%s"
+                 "ETag: %s\r\n"
+                 "Vary: Accept-Encoding\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Content-Length: %lu\r\n\r\n",
+              asset->mime,
+              codings[enc] ? "Content-Encoding: " : "",
+              codings[enc] ? codings[enc] : "",
+              codings[enc] ? "\r\n" : "",
+              asset->etag[enc],
+              (unsigned long)asset->size[enc]);
+    if (!head) {
+        mg_send(c, asset->data[enc], asset->size[enc]);
+    }
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+
 // http message handler
 void handle_event_http_message(struct mg_connection *c, int ev, void *ev_data, void *fn_data)
 {
@@ -144,10 +361,11 @@ void handle_event_http_message(struct mg_connection *c, int ev, void *ev_data, v
             (code = mg_json_get_str(hm->body, "$.content")))) {
             // Success! create JSON response
             mg_http_reply(c, 200, "Content-Type: application/json\r\n",
-                          "{%Q:%g}\n",
+                          "{%Q:%Q}\n",
                           "result", "OK SAVED");
 
-            zedit_exec_file_input((t_zedit*)c->fn_data, code);
+            // output goes to all websocket clients
+            zedit_submit((t_zedit*)c->fn_data, 0, 0, ZEDIT_MODE_FILE, code);
             post("code: %s", code);
             free(code);
         } else {
@@ -165,16 +383,21 @@ void handle_event_http_message(struct mg_connection *c, int ev, void *ev_data, v
             mg_http_reply(c, 200, "Content-Type: application/json\r\n",
                           "{%Q:%Q}\n",
                           "result", "OK");
-            zedit_exec_single_input((t_zedit*)c->fn_data, code);
+            zedit_submit((t_zedit*)c->fn_data, 0, 0, ZEDIT_MODE_SINGLE, code);
             post("code: %s", code);
             free(code);
         } else {
             mg_http_reply(c, 500, NULL, "Parameters missing\n");
         }
 
+    } else if (mg_http_match_uri(hm, ZEDIT_WS_URI)) {
+        // streaming repl: see handle_event_ws_message
+        mg_ws_upgrade(c, hm, NULL);
     } else if (mg_http_match_uri(hm, "/api/items/*")) {
         mg_http_reply(c, 200, "", "{\"result\": \"%.*s\"}\n", (int) hm->uri.len,
                 hm->uri.ptr);
+    } else if (zedit_serve_asset(c, hm)) {
+        // answered from memory
     } else {
         // mg_http_reply(c, 500, NULL, "\n");
         // OR
@@ -194,6 +417,52 @@ void handle_event_http_message(struct mg_connection *c, int ev, void *ev_data, v
 }
 
 
+/**
+ * @brief Handle a websocket repl request
+ *
+ * Requests are json text frames `{"id": 1, "op": "eval", "code": "1 + 1"}`
+ * where `op` is `eval` (single input: expression results are echoed),
+ * `exec` (a block of statements) or `interrupt` (raise KeyboardInterrupt
+ * in the running code). The code is queued for the python worker and
+ * acknowledged with `{"id": 1, "type": "queued"}`. The worker then streams
+ * `stdout`, `stderr` and `result` frames with the same id, followed by
+ * `{"id": 1, "type": "done", "data": "ok" | "error"}`.
+ */
+void handle_event_ws_message(struct mg_connection *c, int ev, void *ev_data, void *fn_data)
+{
+    t_zedit* x = (t_zedit*)c->fn_data;
+    struct mg_ws_message *wm = (struct mg_ws_message*)ev_data;
+    long id = mg_json_get_long(wm->data, "$.id", 0);
+    char* op = mg_json_get_str(wm->data, "$.op");
+    char* code = mg_json_get_str(wm->data, "$.code");
+    char* reply = NULL;
+
+    if (op != NULL && strcmp(op, "interrupt") == 0) {
+        zedit_interrupt(x);
+        reply = mg_mprintf("{%Q:%ld,%Q:%Q}", "id", id, "type", "interrupted");
+    } else if (code == NULL) {
+        reply = mg_mprintf("{%Q:%ld,%Q:%Q,%Q:%Q}", "id", id, "type", "done",
+                           "data", "missing code");
+    } else {
+        int mode = (op != NULL && strcmp(op, "exec") == 0) ? ZEDIT_MODE_FILE
+                                                           : ZEDIT_MODE_SINGLE;
+        if (zedit_submit(x, c->id, id, mode, code) == MAX_ERR_NONE) {
+            reply = mg_mprintf("{%Q:%ld,%Q:%Q}", "id", id, "type", "queued");
+        } else {
+            reply = mg_mprintf("{%Q:%ld,%Q:%Q,%Q:%Q}", "id", id, "type", "done",
+                               "data", "worker not running");
+        }
+    }
+
+    if (reply) {
+        mg_ws_send(c, reply, strlen(reply), WEBSOCKET_OP_TEXT);
+        free(reply);
+    }
+    free(op);
+    free(code);
+}
+
+
 // zedit main function
 static void fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data)
 {
@@ -255,7 +524,7 @@ static void fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data)
         break;
 
     case MG_EV_WS_MSG: // Websocket msg, text or bin ->sstruct mg_ws_message *
-        post("MG_EV_WS_MSG");
+        handle_event_ws_message(c, ev, ev_data, fn_data);
         break;
 
     case MG_EV_WS_CTL: // Websocket control msg -> struct mg_ws_message *
@@ -423,6 +692,7 @@ void zedit_start(t_zedit* x)
         post("Mongoose version : v%s", MG_VERSION);
         post("Listening on     : %s", s_listening_address);
         post("Web root         : [%s]", s_root_dir);
+        zedit_worker_start(x);
         systhread_create((method)zedit_threadproc, x, 0, 0, 0,
                          &x->x_systhread);
         x->x_is_running = true;
@@ -436,6 +706,8 @@ void zedit_foo(t_zedit* x, long foo)
     systhread_mutex_unlock(x->x_mutex);
 }
 
+// the loop is woken up by output and shutdown, so this only bounds the
+// interval of mongoose housekeeping (timers, MG_EV_POLL) while idle
 void zedit_sleeptime(t_zedit* x, long sleeptime)
 {
     if (sleeptime < 10)
@@ -452,10 +724,12 @@ void zedit_stop(t_zedit* x)
     if (x->x_systhread) {
         post("stopping webserver thread");
         x->x_systhread_cancel = true;         // tell the thread to stop
+        zedit_wakeup(x);                      // interrupt a blocking poll
         systhread_join(x->x_systhread, &ret); // wait for the thread to stop
         x->x_systhread = NULL;
         x->x_is_running = false;
     }
+    zedit_worker_stop(x);
 }
 
 
@@ -476,15 +750,33 @@ void* zedit_threadproc(t_zedit* x)
     while (1) {
 
         struct mg_mgr mgr;
+        int wakeup;
         mg_log_set(s_debug_level);
         mg_mgr_init(&mgr); // Init manager
         // mg_http_listen(&mgr, s_listening_address, fn, &mgr); // Setup listener
         mg_http_listen(&mgr, s_listening_address, fn, x); // Setup listener
 
-        for (;;) {
-            mg_mgr_poll(&mgr, 1000); // Event loop
-            if (x->x_systhread_cancel)
-                break;
+        // other threads write to this socket to interrupt mg_mgr_poll
+        wakeup = mg_mkpipe(&mgr, zedit_wakeup_fn, x, true);
+        if (wakeup < 0) {
+            error("zedit: no wakeup pipe, output is sent every %d ms", x->x_sleeptime);
+        }
+        systhread_mutex_lock(x->x_out_mutex);
+        x->x_wakeup = wakeup;
+        x->x_wakeup_pending = false;
+        systhread_mutex_unlock(x->x_out_mutex);
+
+        while (!x->x_systhread_cancel) {
+            // blocks until there is network i/o or a wakeup
+            mg_mgr_poll(&mgr, x->x_sleeptime); // Event loop
+            zedit_drain(x, &mgr);
+        }
+
+        systhread_mutex_lock(x->x_out_mutex);
+        x->x_wakeup = -1;
+        systhread_mutex_unlock(x->x_out_mutex);
+        if (wakeup >= 0) {
+            zedit_closesocket(wakeup);
         }
         mg_mgr_free(&mgr); // Cleanup
         break;
@@ -518,6 +810,477 @@ void zedit_qfn(t_zedit* x)
     outlet_int(x->x_outlet, myfoo);
 }
 
+// -------------------------------------------------------------------------------------
+// python worker
+//
+// Code from http and websocket requests runs on a dedicated worker thread,
+// so the server thread keeps serving files while a long cell runs. The
+// worker redirects sys.stdout, sys.stderr and sys.displayhook for the
+// duration of each job and streams what they receive to the requesting
+// client as json frames. The frames are queued and sent by the server
+// thread, which owns the mongoose connections.
+
+
+/**
+ * @brief Queue a json frame for the server thread
+ *
+ * @param x pointer to object struct
+ * @param conn target connection id, 0 for all websocket clients
+ * @param id client message id
+ * @param type frame type: queued, stdout, stderr, result, done
+ * @param data frame data or NULL
+ * @param len length of data in bytes
+ */
+void zedit_send(t_zedit* x, unsigned long conn, long id, const char* type,
+                const char* data, size_t len)
+{
+    t_zedit_msg* msg = (t_zedit_msg*)sysmem_newptr(sizeof(t_zedit_msg));
+    if (msg == NULL) {
+        return;
+    }
+
+    if (data) {
+        msg->json = mg_mprintf("{%Q:%ld,%Q:%Q,%Q:%.*Q}", "id", id,
+                               "type", type, "data", (int)len, data);
+    } else {
+        msg->json = mg_mprintf("{%Q:%ld,%Q:%Q}", "id", id, "type", type);
+    }
+    msg->conn = conn;
+    msg->next = NULL;
+
+    systhread_mutex_lock(x->x_out_mutex);
+    if (x->x_out_tail) {
+        x->x_out_tail->next = msg;
+    } else {
+        x->x_out_head = msg;
+    }
+    x->x_out_tail = msg;
+    systhread_mutex_unlock(x->x_out_mutex);
+
+    zedit_wakeup(x);
+}
+
+
+/**
+ * @brief Interrupt the blocking poll of the webserver loop
+ *
+ * @param x pointer to object struct
+ *
+ * Can be called from any thread. Only one wakeup byte is in flight until
+ * the loop drains, so bursts of output cost one wakeup.
+ */
+void zedit_wakeup(t_zedit* x)
+{
+    systhread_mutex_lock(x->x_out_mutex);
+    if (x->x_wakeup >= 0 && !x->x_wakeup_pending) {
+        x->x_wakeup_pending = true;
+        send(x->x_wakeup, "w", 1, 0);
+    }
+    systhread_mutex_unlock(x->x_out_mutex);
+}
+
+
+/**
+ * @brief Handler of the read end of the wakeup pipe: discards the bytes
+ */
+static void zedit_wakeup_fn(struct mg_connection *c, int ev, void *ev_data, void *fn_data)
+{
+    if (ev == MG_EV_READ) {
+        c->recv.len = 0;
+    }
+}
+
+
+/**
+ * @brief Send all queued frames (server thread)
+ *
+ * @param x pointer to object struct
+ * @param mgr mongoose manager owning the connections
+ */
+void zedit_drain(t_zedit* x, struct mg_mgr* mgr)
+{
+    t_zedit_msg* msg;
+    t_zedit_msg* next;
+
+    systhread_mutex_lock(x->x_out_mutex);
+    msg = x->x_out_head;
+    x->x_out_head = NULL;
+    x->x_out_tail = NULL;
+    x->x_wakeup_pending = false;
+    systhread_mutex_unlock(x->x_out_mutex);
+
+    for (; msg != NULL; msg = next) {
+        next = msg->next;
+        for (struct mg_connection* c = mgr->conns; c != NULL; c = c->next) {
+            if (c->is_websocket && msg->json
+                && (msg->conn == 0 || msg->conn == c->id)) {
+                mg_ws_send(c, msg->json, strlen(msg->json), WEBSOCKET_OP_TEXT);
+            }
+        }
+        free(msg->json);
+        sysmem_freeptr(msg);
+    }
+}
+
+
+/**
+ * @brief `write` method of the stdout and stderr streams
+ */
+static PyObject* zedit_stream_write(t_zedit* x, PyObject* arg, const char* type)
+{
+    Py_ssize_t len = 0;
+    const char* data = NULL;
+
+    if (!PyUnicode_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "write() argument must be str, not %s",
+                     Py_TYPE(arg)->tp_name);
+        return NULL;
+    }
+    data = PyUnicode_AsUTF8AndSize(arg, &len);
+    if (data == NULL) {
+        return NULL;
+    }
+    if (x->x_job && len > 0) {
+        zedit_send(x, x->x_job->conn, x->x_job->id, type, data, (size_t)len);
+    }
+    return PyLong_FromSsize_t(PyUnicode_GetLength(arg));
+}
+
+static PyObject* zedit_stdout_write(PyObject* self, PyObject* arg)
+{
+    return zedit_stream_write((t_zedit*)PyCapsule_GetPointer(self, NULL), arg, "stdout");
+}
+
+static PyObject* zedit_stderr_write(PyObject* self, PyObject* arg)
+{
+    return zedit_stream_write((t_zedit*)PyCapsule_GetPointer(self, NULL), arg, "stderr");
+}
+
+static PyObject* zedit_stream_flush(PyObject* self, PyObject* unused)
+{
+    Py_RETURN_NONE;
+}
+
+
+/**
+ * @brief `sys.displayhook` replacement: sends the repr of results
+ */
+static PyObject* zedit_displayhook(PyObject* self, PyObject* obj)
+{
+    t_zedit* x = (t_zedit*)PyCapsule_GetPointer(self, NULL);
+    PyObject* repr = NULL;
+    Py_ssize_t len = 0;
+    const char* data = NULL;
+
+    if (obj == Py_None) {
+        Py_RETURN_NONE;
+    }
+    // like the default hook, keep the last result in builtins._
+    if (PyDict_SetItemString(PyEval_GetBuiltins(), "_", obj) != 0) {
+        return NULL;
+    }
+    repr = PyObject_Repr(obj);
+    if (repr == NULL) {
+        return NULL;
+    }
+    data = PyUnicode_AsUTF8AndSize(repr, &len);
+    if (data && x->x_job) {
+        zedit_send(x, x->x_job->conn, x->x_job->id, "result", data, (size_t)len);
+    }
+    Py_DECREF(repr);
+    if (data == NULL) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef zedit_stdout_def = {"write", zedit_stdout_write, METH_O, NULL};
+static PyMethodDef zedit_stderr_def = {"write", zedit_stderr_write, METH_O, NULL};
+static PyMethodDef zedit_flush_def = {"flush", zedit_stream_flush, METH_NOARGS, NULL};
+static PyMethodDef zedit_displayhook_def = {"displayhook", zedit_displayhook, METH_O, NULL};
+
+
+/**
+ * @brief Create a file-like stream object (requires the GIL)
+ */
+static PyObject* zedit_stream_new(PyObject* capsule, PyMethodDef* write_def)
+{
+    PyObject* types = NULL;
+    PyObject* namespace = NULL;
+    PyObject* kwds = NULL;
+    PyObject* write = NULL;
+    PyObject* flush = NULL;
+    PyObject* args = NULL;
+    PyObject* stream = NULL;
+
+    if ((types = PyImport_ImportModule("types")) == NULL) {
+        goto error;
+    }
+    if ((namespace = PyObject_GetAttrString(types, "SimpleNamespace")) == NULL) {
+        goto error;
+    }
+    write = PyCFunction_New(write_def, capsule);
+    flush = PyCFunction_New(&zedit_flush_def, capsule);
+    args = PyTuple_New(0);
+    kwds = Py_BuildValue("{sOsOss}", "write", write, "flush", flush,
+                         "encoding", "utf-8");
+    if (write == NULL || flush == NULL || args == NULL || kwds == NULL) {
+        goto error;
+    }
+    stream = PyObject_Call(namespace, args, kwds);
+
+error:
+    Py_XDECREF(types);
+    Py_XDECREF(namespace);
+    Py_XDECREF(write);
+    Py_XDECREF(flush);
+    Py_XDECREF(args);
+    Py_XDECREF(kwds);
+    return stream;
+}
+
+
+/**
+ * @brief Start the python worker thread
+ *
+ * @param x pointer to object struct
+ */
+void zedit_worker_start(t_zedit* x)
+{
+    if (x->x_worker) {
+        return;
+    }
+    x->x_worker_cancel = false;
+    systhread_create((method)zedit_workerproc, x, 0, 0, 0, &x->x_worker);
+}
+
+
+/**
+ * @brief Stop the python worker thread
+ *
+ * @param x pointer to object struct
+ *
+ * A running job is interrupted; pending jobs are dropped.
+ */
+void zedit_worker_stop(t_zedit* x)
+{
+    unsigned int ret;
+    t_zedit_job* job;
+
+    if (x->x_worker == NULL) {
+        return;
+    }
+
+    systhread_mutex_lock(x->x_job_mutex);
+    x->x_worker_cancel = true;
+    systhread_cond_signal(x->x_job_cond);
+    systhread_mutex_unlock(x->x_job_mutex);
+
+    zedit_interrupt(x);
+    systhread_join(x->x_worker, &ret);
+    x->x_worker = NULL;
+
+    while ((job = x->x_job_head) != NULL) {
+        x->x_job_head = job->next;
+        sysmem_freeptr(job->code);
+        sysmem_freeptr(job);
+    }
+    x->x_job_tail = NULL;
+}
+
+
+/**
+ * @brief Queue code for the python worker
+ *
+ * @param x pointer to object struct
+ * @param conn requesting connection id, 0 to send output to all clients
+ * @param id client message id
+ * @param mode ZEDIT_MODE_SINGLE or ZEDIT_MODE_FILE
+ * @param code python source (copied)
+ * @return t_max_err error code
+ */
+t_max_err zedit_submit(t_zedit* x, unsigned long conn, long id, int mode, const char* code)
+{
+    t_zedit_job* job = NULL;
+    size_t len = strlen(code);
+
+    if (x->x_worker == NULL) {
+        error("zedit: python worker is not running");
+        return MAX_ERR_GENERIC;
+    }
+
+    job = (t_zedit_job*)sysmem_newptr(sizeof(t_zedit_job));
+    if (job == NULL) {
+        return MAX_ERR_OUT_OF_MEM;
+    }
+    job->code = (char*)sysmem_newptr(len + 1);
+    if (job->code == NULL) {
+        sysmem_freeptr(job);
+        return MAX_ERR_OUT_OF_MEM;
+    }
+    memcpy(job->code, code, len + 1);
+    job->conn = conn;
+    job->id = id;
+    job->mode = mode;
+    job->next = NULL;
+
+    systhread_mutex_lock(x->x_job_mutex);
+    if (x->x_job_tail) {
+        x->x_job_tail->next = job;
+    } else {
+        x->x_job_head = job;
+    }
+    x->x_job_tail = job;
+    systhread_cond_signal(x->x_job_cond);
+    systhread_mutex_unlock(x->x_job_mutex);
+
+    return MAX_ERR_NONE;
+}
+
+
+/**
+ * @brief Raise KeyboardInterrupt in the job being run, if any
+ *
+ * @param x pointer to object struct
+ */
+void zedit_interrupt(t_zedit* x)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    if (x->x_job && x->x_worker_ident) {
+        PyThreadState_SetAsyncExc(x->x_worker_ident, PyExc_KeyboardInterrupt);
+    }
+    PyGILState_Release(gstate);
+}
+
+
+/**
+ * @brief Run a job with redirected output (worker thread)
+ *
+ * @param x pointer to object struct
+ * @param job job to run
+ */
+void zedit_run_job(t_zedit* x, t_zedit_job* job)
+{
+    PyObject* saved_stdout = NULL;
+    PyObject* saved_stderr = NULL;
+    PyObject* saved_displayhook = NULL;
+    PyObject* pval = NULL;
+    const char* status = "ok";
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+
+    saved_stdout = PySys_GetObject("stdout"); // borrowed
+    saved_stderr = PySys_GetObject("stderr"); // borrowed
+    saved_displayhook = PySys_GetObject("displayhook"); // borrowed
+    Py_XINCREF(saved_stdout);
+    Py_XINCREF(saved_stderr);
+    Py_XINCREF(saved_displayhook);
+    PySys_SetObject("stdout", x->x_stdout);
+    PySys_SetObject("stderr", x->x_stderr);
+    PySys_SetObject("displayhook", x->x_displayhook);
+    x->x_job = job;
+
+    pval = PyRun_String(job->code, job->mode, x->py->p_globals, x->py->p_globals);
+    if (pval == NULL) {
+        status = "error";
+        if (PyErr_ExceptionMatches(PyExc_SystemExit)) {
+            // PyErr_Print would exit the process
+            PyErr_Clear();
+            zedit_send(x, job->conn, job->id, "stderr", "SystemExit\n", 11);
+        } else {
+            // print the traceback to the redirected sys.stderr
+            PyObject *ptype, *pvalue, *ptraceback;
+            PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+            PyErr_NormalizeException(&ptype, &pvalue, &ptraceback);
+            PyErr_Display(ptype, pvalue, ptraceback);
+            Py_XDECREF(ptype);
+            Py_XDECREF(pvalue);
+            Py_XDECREF(ptraceback);
+        }
+    }
+    Py_XDECREF(pval);
+
+    // an interrupt which arrived after the last check of the job (e.g.
+    // while its traceback was printed) is still pending in the thread
+    // state kept by the worker: drop it, or the next job would raise it
+    x->x_job = NULL;
+    PyThreadState_SetAsyncExc(x->x_worker_ident, NULL);
+    PySys_SetObject("stdout", saved_stdout);
+    PySys_SetObject("stderr", saved_stderr);
+    PySys_SetObject("displayhook", saved_displayhook);
+    Py_XDECREF(saved_stdout);
+    Py_XDECREF(saved_stderr);
+    Py_XDECREF(saved_displayhook);
+
+    PyGILState_Release(gstate);
+
+    zedit_send(x, job->conn, job->id, "done", status, strlen(status));
+}
+
+
+/**
+ * @brief Python worker thread: runs queued jobs in order
+ *
+ * @param x pointer to object struct
+ */
+void* zedit_workerproc(t_zedit* x)
+{
+    t_zedit_job* job = NULL;
+    PyObject* capsule = NULL;
+    PyThreadState* tstate = NULL;
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    x->x_worker_ident = PyThread_get_thread_ident();
+    capsule = PyCapsule_New(x, NULL, NULL);
+    if (capsule) {
+        x->x_stdout = zedit_stream_new(capsule, &zedit_stdout_def);
+        x->x_stderr = zedit_stream_new(capsule, &zedit_stderr_def);
+        x->x_displayhook = PyCFunction_New(&zedit_displayhook_def, capsule);
+        Py_DECREF(capsule);
+    }
+    if (x->x_stdout == NULL || x->x_stderr == NULL || x->x_displayhook == NULL) {
+        py_handle_error(x->py, (char*)"zedit worker");
+        systhread_mutex_lock(x->x_job_mutex);
+        x->x_worker_cancel = true;
+        systhread_mutex_unlock(x->x_job_mutex);
+    }
+    // keep the thread state between jobs (thread-local python state
+    // persists like in a REPL), but not the GIL
+    tstate = PyEval_SaveThread();
+
+    while (1) {
+        systhread_mutex_lock(x->x_job_mutex);
+        while (x->x_job_head == NULL && !x->x_worker_cancel) {
+            systhread_cond_wait(x->x_job_cond, x->x_job_mutex);
+        }
+        if (x->x_worker_cancel) {
+            systhread_mutex_unlock(x->x_job_mutex);
+            break;
+        }
+        job = x->x_job_head;
+        x->x_job_head = job->next;
+        if (x->x_job_head == NULL) {
+            x->x_job_tail = NULL;
+        }
+        systhread_mutex_unlock(x->x_job_mutex);
+
+        zedit_run_job(x, job);
+        sysmem_freeptr(job->code);
+        sysmem_freeptr(job);
+    }
+
+    PyEval_RestoreThread(tstate);
+    Py_CLEAR(x->x_stdout);
+    Py_CLEAR(x->x_stderr);
+    Py_CLEAR(x->x_displayhook);
+    x->x_worker_ident = 0;
+    PyGILState_Release(gstate);
+
+    systhread_exit(0);
+    return NULL;
+}
+
+
 void zedit_assist(t_zedit* x, void* b, long m, long a, char* s)
 {
     if (m == 1)
@@ -528,9 +1291,21 @@ void zedit_assist(t_zedit* x, void* b, long m, long a, char* s)
 
 void zedit_free(t_zedit* x)
 {
+    t_zedit_msg* msg;
+
     // stop our thread if it is still running
     zedit_stop(x);
 
+    // drop unsent output
+    while ((msg = x->x_out_head) != NULL) {
+        x->x_out_head = msg->next;
+        free(msg->json);
+        sysmem_freeptr(msg);
+    }
+    systhread_mutex_free(x->x_out_mutex);
+    systhread_mutex_free(x->x_job_mutex);
+    systhread_cond_free(x->x_job_cond);
+
     // free our qelem
     if (x->x_qelem)
         qelem_free(x->x_qelem);
@@ -539,7 +1314,12 @@ void zedit_free(t_zedit* x)
     if (x->x_mutex)
         systhread_mutex_free(x->x_mutex);
 
-    // cleanup python
+    // cleanup python (finalizing needs the GIL back)
+    if (x->x_tstate) {
+        PyEval_RestoreThread(x->x_tstate);
+    } else {
+        PyGILState_Ensure();
+    }
     py_free(x->py);
 }
 
@@ -561,6 +1341,27 @@ void* zedit_new(void)
 
     x->py = py_init(zedit_class); // This is all that is need to init the `py` obj
 
+    // release the GIL taken by initialization so the worker can run python;
+    // the py_* methods acquire it as needed
+    x->x_tstate = PyGILState_Check() ? PyEval_SaveThread() : NULL;
+
+    x->x_worker = NULL;
+    systhread_mutex_new(&x->x_job_mutex, 0);
+    systhread_cond_new(&x->x_job_cond, 0);
+    x->x_job_head = NULL;
+    x->x_job_tail = NULL;
+    x->x_worker_cancel = false;
+    x->x_worker_ident = 0;
+    x->x_job = NULL;
+    x->x_stdout = NULL;
+    x->x_stderr = NULL;
+    x->x_displayhook = NULL;
+    systhread_mutex_new(&x->x_out_mutex, 0);
+    x->x_out_head = NULL;
+    x->x_out_tail = NULL;
+    x->x_wakeup = -1;
+    x->x_wakeup_pending = false;
+
     // set global
     s_root_dir = string_getptr(x->x_root_dir);
     post("webroot: %s", s_root_dir);